@@ -1,6 +1,7 @@
 #!/usr/bin/env python2
 
 import os
+import re
 import sys
 import platform
 
@@ -23,13 +24,17 @@ thrift_description = [
         "name": "fd", 
         "path": "src/dist/failure_detector", 
         "file_move": {
-            ".types.h _types.h": "include/dsn/dist/failure_detector"
+            ".types.h _types.h .codec.h": "include/dsn/dist/failure_detector"
         },
         "include_fix": {
             "_types.h": {
                 "add": ["<dsn/service_api_cpp.h>"],
                 "remove": ["\"dsn_types.h\""]
             },
+            ".codec.h": {
+                "add": ["<dsn/dist/failure_detector/fd_types.h>"],
+                "remove": ["\"fd_types.h\""]
+            },
             "_types.cpp": {
                 "add": ["<dsn/dist/failure_detector/fd_types.h>"],
                 "remove": ["\"fd_types.h\""]
@@ -44,7 +49,7 @@ thrift_description = [
         "name": "replication", 
         "path": "src/dist/replication", 
         "file_move": {
-            ".types.h _types.h": "include/dsn/dist/replication",
+            ".types.h _types.h .codec.h": "include/dsn/dist/replication",
             "_types.cpp": "src/dist/replication/client_lib"
         },
         "include_fix": {
@@ -52,6 +57,10 @@ thrift_description = [
                 "add": ["<dsn/cpp/serialization_helper/dsn.layer2_types.h>"],
                 "remove": ["\"dsn_types.h\"", "\"dsn.layer2_types.h\""]
             },
+            ".codec.h": {
+                "add": ["<dsn/dist/replication/replication_types.h>", "<dsn/cpp/serialization_helper/dsn.layer2.codec.h>"],
+                "remove": ["\"replication_types.h\"", "\"dsn.layer2.codec.h\""]
+            },
             "_types.cpp": {
                 "add": ["<dsn/dist/replication/replication_types.h>"],
                 "remove": ["\"replication_types.h\""]
@@ -74,13 +83,17 @@ thrift_description = [
         "name": "nfs", 
         "path": "src/apps/nfs",
         "file_move": {
-            ".types.h _types.h": "include/dsn/tool/nfs"
+            ".types.h _types.h .codec.h": "include/dsn/tool/nfs"
         },
         "include_fix": {
             "_types.h": {
                 "add": ["<dsn/service_api_cpp.h>"],
                 "remove": ["\"dsn_types.h\""]
             },
+            ".codec.h": {
+                "add": ["<dsn/tool/nfs/nfs_types.h>"],
+                "remove": ["\"nfs_types.h\""]
+            },
             "_types.cpp": {
                 "add": ["<dsn/tool/nfs.h>"],
                 "remove": ["\"nfs_types.h\""]
@@ -99,12 +112,16 @@ thrift_description = [
         "name": "cli", 
         "path": "src/apps/cli",
         "file_move": {
-            ".types.h _types.h": "include/dsn/tool/cli"
+            ".types.h _types.h .codec.h": "include/dsn/tool/cli"
         },
         "include_fix": {
             "_types.h": {
                 "remove": ["\"dsn_types.h\""]
             },
+            ".codec.h": {
+                "add": ["<dsn/tool/cli/cli_types.h>"],
+                "remove": ["\"cli_types.h\""]
+            },
             "_types.cpp": {
                 "add": ["<dsn/tool/cli.h>"],
                 "remove": ["\"cli_types.h\""]
@@ -235,6 +252,343 @@ def toggle_serialization_in_cpp(thrift_name):
     os.rename(new_file, cpp_file)
     os.chdir("..")
 
+'''
+the binary codec generator, which generates specializations of dsn::thrift_binary_codec
+(see include/dsn/cpp/serialization_helper/thrift_binary_codec.h) for the structs in
+a thrift file, so that marshall_thrift_binary does not go through the virtual TProtocol,
+as well as the view types <name>_view of the structs, which are decoded without heap
+allocations (e.g., for the request handlers of high-qps services)
+'''
+def strip_thrift_comments(text):
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    text = re.sub(r"(//|#)[^\n]*", "", text)
+    return text
+
+def find_matched(text, pos, left, right):
+    # pos is at the left char, returns the position of the matched right char
+    depth = 0
+    for i in range(pos, len(text)):
+        if text[i] == left:
+            depth += 1
+        elif text[i] == right:
+            depth -= 1
+            if depth == 0:
+                return i
+    raise CompileError("unmatched '%s' in thrift file"%(left))
+
+def parse_thrift_fields(body):
+    # returns [(id, requiredness, name, type)], where type has no spaces, e.g., map<string,i32>
+    fields = []
+    field_begin = re.compile(r"(-?\d+)\s*:\s*")
+    pos = 0
+    while True:
+        m = field_begin.search(body, pos)
+        if m is None:
+            break
+        fid = int(m.group(1))
+        pos = m.end()
+
+        req = "default"
+        m = re.match(r"(required|optional)\s+", body[pos:])
+        if m is not None:
+            req = m.group(1)
+            pos += m.end()
+
+        # the type, which may be a container, e.g., map<string, list<i32>>
+        m = re.match(r"[\w.]+\s*", body[pos:])
+        if m is None:
+            raise CompileError("invalid field %d in thrift file"%(fid))
+        type_begin = pos
+        pos += m.end()
+        if pos < len(body) and body[pos] == "<":
+            pos = find_matched(body, pos, "<", ">") + 1
+        ftype = re.sub(r"\s+", "", body[type_begin:pos])
+
+        m = re.match(r"\s*(\w+)", body[pos:])
+        if m is None:
+            raise CompileError("invalid field %d in thrift file"%(fid))
+        name = m.group(1)
+        pos += m.end()
+
+        # skip the default value, e.g., = {1:2, 3:4}
+        m = re.match(r"\s*=\s*", body[pos:])
+        if m is not None:
+            pos += m.end()
+            if pos < len(body) and body[pos] in "{[":
+                pos = find_matched(body, pos, body[pos], "}" if body[pos] == "{" else "]") + 1
+
+        fields.append((fid, req, name, ftype))
+    return fields
+
+def parse_thrift_file(thrift_file):
+    # returns (cpp namespace, [included thrift names], [(struct name, fields)], [enum names])
+    text = strip_thrift_comments(open(thrift_file, "r").read())
+
+    m = re.search(r"namespace\s+cpp\s+([\w.]+)", text)
+    namespace = "::" + m.group(1).replace(".", "::") if m is not None else ""
+
+    includes = [os.path.basename(i)[:-len(".thrift")] for i in re.findall(r"include\s+\"([^\"]+\.thrift)\"", text)]
+    # dsn.thrift only has place holders for the types in thrift_binary_codec.h
+    includes = [i for i in includes if i != "dsn"]
+
+    structs = []
+    struct_begin = re.compile(r"\b(struct|exception)\s+(\w+)[^{;]*\{")
+    pos = 0
+    while True:
+        m = struct_begin.search(text, pos)
+        if m is None:
+            break
+        end = find_matched(text, m.end() - 1, "{", "}")
+        structs.append((m.group(2), parse_thrift_fields(text[m.end():end])))
+        pos = end + 1
+
+    enums = re.findall(r"\benum\s+(\w+)\s*\{", text)
+
+    return namespace, includes, structs, enums
+
+# the view types, see thrift_binary_codec.h, whose fields are (cpp type, wire type, initializer)
+view_field_types = {
+    "bool": ("bool", "T_BOOL", "false"),
+    "byte": ("int8_t", "T_BYTE", "0"),
+    "i8": ("int8_t", "T_BYTE", "0"),
+    "i16": ("int16_t", "T_I16", "0"),
+    "i32": ("int32_t", "T_I32", "0"),
+    "i64": ("int64_t", "T_I64", "0"),
+    "double": ("double", "T_DOUBLE", "0"),
+    "string": ("::dsn::blob", "T_STRING", None),
+    "binary": ("::dsn::blob", "T_STRING", None),
+    # the place holders in dsn.thrift, which are structs on the wire
+    "dsn.blob": ("::dsn::blob", "T_STRUCT", None),
+    "dsn.rpc_address": ("::dsn::rpc_address", "T_STRUCT", None),
+    "dsn.gpid": ("::dsn::gpid", "T_STRUCT", None),
+    "dsn.task_code": ("::dsn::task_code", "T_STRUCT", None),
+    "dsn.error_code": ("::dsn::error_code", "T_STRUCT", None),
+}
+
+def split_type_args(args):
+    # e.g., "string,list<i32>" => ["string", "list<i32>"]
+    result = []
+    depth = 0
+    begin = 0
+    for i in range(len(args)):
+        if args[i] == "<":
+            depth += 1
+        elif args[i] == ">":
+            depth -= 1
+        elif args[i] == "," and depth == 0:
+            result.append(args[begin:i])
+            begin = i + 1
+    result.append(args[begin:])
+    return result
+
+def template_type(name, args):
+    # e.g., std::pair< int32_t, ::dsn::blob>, and no ">>" for nested ones
+    return "%s< %s%s>"%(name, args, " " if args.endswith(">") else "")
+
+def view_field_type(ftype, namespace, views, enums):
+    # returns (cpp type, wire type, initializer) of the field in the view types,
+    # or None when the type is not supported (e.g., the structs in other thrift files)
+    if ftype in view_field_types:
+        return view_field_types[ftype]
+
+    m = re.match(r"(list|set|map)<(.*)>$", ftype)
+    if m is not None:
+        args = [view_field_type(a, namespace, views, enums) for a in split_type_args(m.group(2))]
+        if None in args:
+            return None
+        if m.group(1) == "map":
+            element = template_type("std::pair", args[0][0] + ", " + args[1][0])
+        else:
+            element = args[0][0]
+        return (template_type("::dsn::arena_vector", element), "T_" + m.group(1).upper(), template_type("::dsn::arena_allocator", element) + "(arena)")
+
+    if ftype in views:
+        return ("%s::%s_view"%(namespace, ftype), "T_STRUCT", "arena")
+    if ftype in enums:
+        enum_type = "%s::%s::type"%(namespace, ftype)
+        return (enum_type, "T_I32", "static_cast< %s>(0)"%(enum_type))
+    return None
+
+def generate_struct_read(lines, cpp_name, fields, read_field):
+    # read_field(fid, fname) returns the expression which reads field fname
+    required = [f for f in fields if f[1] == "required"]
+
+    lines.append("        static void read(binary_reader& r, /*out*/ %s& v)"%(cpp_name))
+    lines.append("        {")
+    for fid, req, fname, ftype in required:
+        lines.append("            bool isset_%s = false;"%(fname))
+    lines.append("            ::apache::thrift::protocol::TType type;")
+    lines.append("            int16_t id;")
+    lines.append("            while (thrift_binary::read_field_begin(r, type, id))")
+    lines.append("            {")
+    lines.append("                switch (id)")
+    lines.append("                {")
+    for fid, req, fname, ftype in fields:
+        isset = "isset_%s"%(fname) if req == "required" else "v.__isset.%s"%(fname)
+        lines.append("                case %d:"%(fid))
+        lines.append("                    if (%s)"%(read_field(fid, fname)))
+        lines.append("                        %s = true;"%(isset))
+        lines.append("                    break;")
+    lines.append("                default:")
+    lines.append("                    thrift_binary::skip(r, type);")
+    lines.append("                    break;")
+    lines.append("                }")
+    lines.append("            }")
+    for fid, req, fname, ftype in required:
+        lines.append("            if (!isset_%s)"%(fname))
+        lines.append("                throw ::apache::thrift::protocol::TProtocolException(::apache::thrift::protocol::TProtocolException::INVALID_DATA);")
+    lines.append("        }")
+
+def open_namespace(lines, namespace):
+    if namespace != "":
+        lines.append(" ".join(["namespace %s {"%(n) for n in namespace[2:].split("::")]))
+
+def close_namespace(lines, namespace):
+    if namespace != "":
+        lines.append(" ".join(["}" for n in namespace[2:].split("::")]))
+
+def generate_binary_codec(thrift_file, codec_file, types_include):
+    namespace, includes, structs, enums = parse_thrift_file(thrift_file)
+
+    # the view types of the structs whose fields are all supported, see view_field_type
+    views = []
+    view_names = []
+    for name, fields in structs:
+        view_fields = [view_field_type(f[3], namespace, view_names, enums) for f in fields]
+        if None not in view_fields:
+            views.append((name, fields, view_fields))
+            view_names.append(name)
+
+    lines = []
+    lines.append("/**")
+    lines.append(" * Autogenerated by compile_thrift.py")
+    lines.append(" *")
+    lines.append(" * DO NOT EDIT UNLESS YOU ARE SURE THAT YOU KNOW WHAT YOU ARE DOING")
+    lines.append(" *  @generated")
+    lines.append(" */")
+    lines.append("# pragma once")
+    lines.append("# include %s"%(types_include))
+    for i in includes:
+        lines.append("# include \"%s.codec.h\""%(i))
+    lines.append("# include <dsn/cpp/serialization_helper/thrift_binary_codec.h>")
+    lines.append("")
+    lines.append("namespace dsn {")
+
+    for name, fields in structs:
+        cpp_name = "%s::%s"%(namespace, name)
+
+        lines.append("")
+        lines.append("    template<>")
+        lines.append("    struct thrift_binary_codec< %s>"%(cpp_name))
+        lines.append("    {")
+        lines.append("        static const bool enabled = true;")
+        lines.append("")
+        lines.append("        static void write(binary_writer& w, const %s& v)"%(cpp_name))
+        lines.append("        {")
+        for fid, req, fname, ftype in fields:
+            if req == "optional":
+                lines.append("            if (v.__isset.%s)"%(fname))
+                lines.append("                thrift_binary::write_field(w, %d, v.%s);"%(fid, fname))
+            else:
+                lines.append("            thrift_binary::write_field(w, %d, v.%s);"%(fid, fname))
+        lines.append("            thrift_binary::write_field_stop(w);")
+        lines.append("        }")
+        lines.append("")
+        generate_struct_read(lines, cpp_name, fields,
+            lambda fid, fname: "thrift_binary::read_field(r, type, v.%s)"%(fname))
+        lines.append("    };")
+
+    lines.append("}")
+
+    if len(views) > 0:
+        # the view types, which are only decoded from the thrift binary format,
+        # see thrift_binary_codec.h
+        lines.append("")
+        open_namespace(lines, namespace)
+        for name, fields, view_fields in views:
+            view_name = name + "_view"
+            isset_fields = [f for f in fields if f[1] != "required"]
+            inits = ["%s(%s)"%(f[2], vf[2]) for f, vf in zip(fields, view_fields) if vf[2] is not None]
+            uses_arena = len([i for i in inits if "arena" in i]) > 0
+
+            lines.append("")
+            if len(isset_fields) > 0:
+                lines.append("    typedef struct _%s__isset {"%(view_name))
+                lines.append("        _%s__isset() : %s {}"%(view_name, ", ".join(["%s(false)"%(f[2]) for f in isset_fields])))
+                for f in isset_fields:
+                    lines.append("        bool %s;"%(f[2]))
+                lines.append("    } _%s__isset;"%(view_name))
+                lines.append("")
+            lines.append("    struct %s"%(view_name))
+            lines.append("    {")
+            lines.append("        explicit %s(::dsn::request_arena* %s = ::dsn::request_arena::current())"%(view_name, "arena" if uses_arena else "/*arena*/"))
+            if len(inits) > 0:
+                lines.append("            : %s"%(", ".join(inits)))
+            lines.append("        {")
+            lines.append("        }")
+            accessors = [f for f in fields if f[3] in ("string", "binary")]
+            if len(accessors) > 0:
+                lines.append("")
+                for f in accessors:
+                    lines.append("        ::dsn::string_view %s_view() const { return ::dsn::string_view(%s); }"%(f[2], f[2]))
+            lines.append("")
+            for f, vf in zip(fields, view_fields):
+                lines.append("        %s %s;"%(vf[0], f[2]))
+            if len(isset_fields) > 0:
+                lines.append("")
+                lines.append("        _%s__isset __isset;"%(view_name))
+            lines.append("    };")
+        close_namespace(lines, namespace)
+
+        lines.append("")
+        lines.append("namespace dsn {")
+        for name, fields, view_fields in views:
+            cpp_name = "%s::%s_view"%(namespace, name)
+            wire_types = dict([(f[0], vf[1]) for f, vf in zip(fields, view_fields)])
+
+            lines.append("")
+            lines.append("    template<>")
+            lines.append("    struct thrift_binary_codec< %s>"%(cpp_name))
+            lines.append("    {")
+            lines.append("        static const bool enabled = true;")
+            lines.append("")
+            generate_struct_read(lines, cpp_name, fields,
+                lambda fid, fname: "thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::%s, v.%s)"%(wire_types[fid], fname))
+            lines.append("    };")
+        lines.append("}")
+
+        lines.append("")
+        open_namespace(lines, namespace)
+        for name, fields, view_fields in views:
+            view_name = name + "_view"
+            lines.append("")
+            lines.append("    inline void unmarshall(::dsn::binary_reader& reader, %s& value, dsn_msg_serialize_format fmt)"%(view_name))
+            lines.append("    {")
+            lines.append("        dassert(fmt == DSF_THRIFT_BINARY, \"%s can only be decoded from DSF_THRIFT_BINARY\");"%(view_name))
+            lines.append("        ::dsn::thrift_binary::unmarshall(reader, value);")
+            lines.append("    }")
+        close_namespace(lines, namespace)
+
+    codec_fd = open(codec_file, "w")
+    codec_fd.write("\n".join(lines) + "\n")
+    codec_fd.close()
+
+def add_codec_include(types_file, thrift_name):
+    # the codec specializations must be seen before GENERATED_TYPE_SERIALIZATION
+    tmp_result = types_file + ".swapfile"
+    from_fd, to_fd = open(types_file, "r"), open(tmp_result, "w")
+
+    for line in from_fd:
+        to_fd.write(line)
+        if "include" in line and ("%s_types.h"%(thrift_name)) in line:
+            to_fd.write("#include \"%s.codec.h\"\n"%(thrift_name))
+
+    from_fd.close()
+    to_fd.close()
+
+    os.remove(types_file)
+    os.rename(tmp_result, types_file)
+
 def compile_thrift_file(thrift_info):
     thrift_name = thrift_info["name"]
     print ">>>compiling thrift file %s.thrift ..."%(thrift_name)
@@ -257,6 +611,10 @@ def compile_thrift_file(thrift_info):
     os.system("cp build/%s_types.cpp output"%(thrift_name))
     os.system("rm -rf build")
 
+    #### then the non-virtual binary codec used by marshall_thrift_binary
+    generate_binary_codec(thrift_name + ".thrift", "output/%s.codec.h"%(thrift_name), "\"%s_types.h\""%(thrift_name))
+    add_codec_include("output/%s.types.h"%(thrift_name), thrift_name)
+
     if "include_fix" in thrift_info:
         fix_include(thrift_name, thrift_info["include_fix"])
 
@@ -110,6 +110,10 @@ with which they control the application in many aspects in a declarative approac
   ; is already greater than its timeout value
   rpc_request_dropped_before_execution_when_timeout = false
 
+  ; whether to keep the blobs decoded from the requests in a per-thread arena
+  ; which is reset after each request is handled (see ::dsn::request_arena)
+  rpc_request_arena_enabled = false
+
   ; for how long (ms) the request will be resent if no response 
   ; is received yet, 0 for disable this feature
   rpc_request_resend_timeout_milliseconds = 0
@@ -666,6 +670,7 @@ extern DSN_API dsn_message_t dsn_msg_create_received_request(
 typedef enum dsn_msg_parameter_type_t
 {
     MSG_PARAM_NONE = 0,           ///< nothing  
+    MSG_PARAM_CLIENT_ID = 1,      ///< client id for per-client fair queuing and rate limiting on the server
 } dsn_msg_parameter_type_t;
 
 /*! RPC message context */
@@ -791,6 +796,26 @@ extern DSN_API void          dsn_msg_write_next(
 /*! commit the write buffer after the message content is written with the real written size */
 extern DSN_API void          dsn_msg_write_commit(dsn_message_t msg, size_t size);
 
+/*!
+ append a buffer to the message by reference without copy
+
+ \param msg      message handle
+ \param ptr      the buffer content
+ \param size     the buffer size
+ \param release  invoked with release_context when the message no longer uses the buffer,
+                 or nullptr when the buffer is guaranteed valid until the message is released
+ \param release_context context for release
+
+ it must not be called between dsn_msg_write_next and dsn_msg_write_commit.
+ */
+extern DSN_API void          dsn_msg_write_append(
+                                dsn_message_t msg,
+                                const void* ptr,
+                                size_t size,
+                                void (*release)(void*),
+                                void* release_context
+                                );
+
 /*!
  get message read buffer
 
@@ -841,6 +866,10 @@ extern DSN_API void          dsn_rpc_reply(dsn_message_t response, dsn_error_t e
 /*! forward the request to another server instead */
 extern DSN_API void          dsn_rpc_forward(dsn_message_t request, dsn_address_t addr);
 
+/*! the ::dsn::request_arena of the request being handled by the current thread when 
+    rpc_request_arena_enabled is set for its task code, or nullptr otherwise */
+extern DSN_API void*         dsn_rpc_get_request_arena();
+
 
 /*@}*/
 
@@ -955,6 +984,7 @@ typedef enum dsn_ctrl_code_t
     CTL_BATCH_WRITE = 1,            ///< (batch) set write batch size
     CTL_MAX_CON_READ_OP_COUNT = 2,  ///< (throttling) maximum concurrent read ops
     CTL_MAX_CON_WRITE_OP_COUNT = 3, ///< (throttling) maximum concurrent write ops
+    CTL_READ_COALESCE_BYTES = 4,    ///< (batch) max bytes of adjacent pending reads merged into one read, 0 for no merge
 } dsn_ctrl_code_t;
 
 /*!
@@ -964,6 +994,12 @@ typedef enum dsn_ctrl_code_t
  \param flag      flags such as O_RDONLY | O_BINARY used by ::open 
  \param pmode     permission mode used by ::open
 
+ with O_DIRECT, the reads and writes whose buffers, offsets or sizes are not aligned
+ to [aio] direct_io_alignment are still allowed: the reads and the writes of unaligned
+ buffers go through aligned bounce buffers, and the writes of unaligned ranges (e.g.,
+ the tail of a log) read and rewrite their partial head and tail blocks, one at a time
+ per file; buffers allocated by \ref dsn_aligned_malloc avoid the copies
+
  \return file handle
  */
 extern DSN_API dsn_handle_t dsn_file_open(
@@ -982,6 +1018,35 @@ extern DSN_API dsn_error_t  dsn_file_flush(
                                 dsn_handle_t file
                                 );
 
+/*!
+ flush the file asynchronously
+
+ concurrent flushes of the same file are committed together by one flush issued
+ from a disk flush thread, and completed together with its error code; every
+ flush covers the writes completed before it is called
+
+ \param file  file handle
+ \param cb    callback aio task to be executed on completion
+ */
+extern DSN_API void         dsn_file_flush_async(
+                                dsn_handle_t file,
+                                dsn_task_t cb
+                                );
+
+/*!
+ control the io scheduling of the given file, see \ref dsn_ctrl_code_t;
+ the defaults are from the [aio] section of the config
+
+ \param file  file handle
+ \param code  what to control
+ \param param new value
+ */
+extern DSN_API void         dsn_file_ctrl(
+                                dsn_handle_t file,
+                                dsn_ctrl_code_t code,
+                                int param
+                                );
+
 /*! get native handle: HANDLE for windows, int for non-windows */
 extern DSN_API void*        dsn_file_native_handle(dsn_handle_t file);
 
@@ -405,6 +405,11 @@ Memory Management
 /*! high-performance malloc for transient objects, i.e., their life-time is short */
 extern DSN_API void*         dsn_transient_malloc(uint32_t size);
 
+/*! high-performance malloc for transient objects living longer (e.g., waiting for rpc replies),
+    which are allocated from separate smaller blocks so that they don't pin the blocks of the
+    short-lived ones, paired with \ref dsn_transient_free */
+extern DSN_API void*         dsn_transient_malloc_long(uint32_t size);
+
 /*! high-performance free for transient objects, paired with \ref dsn_transient_malloc */
 extern DSN_API void          dsn_transient_free(void* ptr);
 
@@ -414,6 +419,13 @@ extern DSN_API void*         dsn_malloc(uint32_t size);
 /*! common free, paird with dsn_malloc to ensure malloc/free are done by dsn.core */
 extern DSN_API void          dsn_free(void* ptr);
 
+/*! malloc with the start address aligned to alignment (a power of 2), e.g., for the
+    buffers of direct io (O_DIRECT), paired with \ref dsn_aligned_free */
+extern DSN_API void*         dsn_aligned_malloc(uint32_t size, uint32_t alignment);
+
+/*! free the memory allocated by \ref dsn_aligned_malloc */
+extern DSN_API void          dsn_aligned_free(void* ptr);
+
 /*@}*/
 
 # ifdef __cplusplus
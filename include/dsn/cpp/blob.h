@@ -39,6 +39,7 @@
 # include <memory>
 # include <vector>
 # include <cstring>
+# include <dsn/cpp/inline_vector.h>
 
 #ifdef DSN_USE_THRIFT_SERIALIZATION
 # include <thrift/protocol/TProtocol.h>
@@ -52,6 +53,15 @@ namespace dsn
         return std::shared_ptr<T>(new T[size], std::default_delete<T[]>());
     }
 
+    // see dsn_aligned_malloc, e.g., for the buffers of direct io
+    inline std::shared_ptr<char> make_aligned_shared_array(size_t size, size_t alignment)
+    {
+        return std::shared_ptr<char>(
+            static_cast<char*>(dsn_aligned_malloc(static_cast<uint32_t>(size), static_cast<uint32_t>(alignment))),
+            [](char* p) { dsn_aligned_free(p); }
+            );
+    }
+
     class blob
     {
     public:
@@ -257,6 +267,10 @@ namespace dsn
         void write(const blob& val);
         void write_empty(int sz);
 
+        // write the content of the blob (without the length prefix), writers on top of
+        // messages (e.g., rpc_write_stream) may append large blobs by reference instead
+        virtual void append(const blob& val);
+
         bool next(void** data, int* size);
         bool backup(int count);
 
@@ -274,8 +288,12 @@ namespace dsn
         void commit();
         virtual void create_new_buffer(size_t size, /*out*/blob& bb);
 
+        // called by subclasses after sz bytes are appended to the underlying sink
+        // by reference, the current buffer is closed and later writes go to a new one
+        void seal_buffer(int appended_size);
+
     private:
-        std::vector<blob>  _buffers;
+        inline_vector<blob, 2> _buffers;
 
         char*              _current_buffer;
         int                _current_offset;
@@ -313,7 +331,7 @@ namespace dsn
     inline void binary_writer::get_buffers(/*out*/ std::vector<blob>& buffers)
     {
         commit();
-        buffers = _buffers;
+        buffers.assign(_buffers.begin(), _buffers.end());
     }
 
     inline blob binary_writer::get_first_buffer() const
@@ -330,9 +348,13 @@ namespace dsn
 
     inline void binary_writer::write(const blob& val)
     {
-        // TODO: optimization by not memcpy
         int len = val.length();
         write((const char*)&len, sizeof(int));
-        if (len > 0) write((const char*)val.data(), len);
+        if (len > 0) append(val);
+    }
+
+    inline void binary_writer::append(const blob& val)
+    {
+        write((const char*)val.data(), static_cast<int>(val.length()));
     }
 }
@@ -69,6 +69,7 @@ namespace dsn {
     };
 
     typedef callocator_object<dsn_transient_malloc, dsn_transient_free> transient_object;
+    typedef callocator_object<dsn_transient_malloc_long, dsn_transient_free> long_transient_object;
 
     template <typename T, t_allocate a, t_deallocate d>
     class callocator : public std::allocator<T>
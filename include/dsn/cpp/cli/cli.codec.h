@@ -0,0 +1,113 @@
+/**
+ * Autogenerated by compile_thrift.py
+ *
+ * DO NOT EDIT UNLESS YOU ARE SURE THAT YOU KNOW WHAT YOU ARE DOING
+ *  @generated
+ */
+# pragma once
+# include <dsn/cpp/cli/cli_types.h>
+# include <dsn/cpp/serialization_helper/thrift_binary_codec.h>
+
+namespace dsn {
+
+    template<>
+    struct thrift_binary_codec< ::dsn::command>
+    {
+        static const bool enabled = true;
+
+        static void write(binary_writer& w, const ::dsn::command& v)
+        {
+            thrift_binary::write_field(w, 1, v.cmd);
+            thrift_binary::write_field(w, 2, v.arguments);
+            thrift_binary::write_field_stop(w);
+        }
+
+        static void read(binary_reader& r, /*out*/ ::dsn::command& v)
+        {
+            ::apache::thrift::protocol::TType type;
+            int16_t id;
+            while (thrift_binary::read_field_begin(r, type, id))
+            {
+                switch (id)
+                {
+                case 1:
+                    if (thrift_binary::read_field(r, type, v.cmd))
+                        v.__isset.cmd = true;
+                    break;
+                case 2:
+                    if (thrift_binary::read_field(r, type, v.arguments))
+                        v.__isset.arguments = true;
+                    break;
+                default:
+                    thrift_binary::skip(r, type);
+                    break;
+                }
+            }
+        }
+    };
+}
+
+namespace dsn {
+
+    typedef struct _command_view__isset {
+        _command_view__isset() : cmd(false), arguments(false) {}
+        bool cmd;
+        bool arguments;
+    } _command_view__isset;
+
+    struct command_view
+    {
+        explicit command_view(::dsn::request_arena* arena = ::dsn::request_arena::current())
+            : arguments(::dsn::arena_allocator< ::dsn::blob>(arena))
+        {
+        }
+
+        ::dsn::string_view cmd_view() const { return ::dsn::string_view(cmd); }
+
+        ::dsn::blob cmd;
+        ::dsn::arena_vector< ::dsn::blob> arguments;
+
+        _command_view__isset __isset;
+    };
+}
+
+namespace dsn {
+
+    template<>
+    struct thrift_binary_codec< ::dsn::command_view>
+    {
+        static const bool enabled = true;
+
+        static void read(binary_reader& r, /*out*/ ::dsn::command_view& v)
+        {
+            ::apache::thrift::protocol::TType type;
+            int16_t id;
+            while (thrift_binary::read_field_begin(r, type, id))
+            {
+                switch (id)
+                {
+                case 1:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_STRING, v.cmd))
+                        v.__isset.cmd = true;
+                    break;
+                case 2:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_LIST, v.arguments))
+                        v.__isset.arguments = true;
+                    break;
+                default:
+                    thrift_binary::skip(r, type);
+                    break;
+                }
+            }
+        }
+    };
+}
+
+namespace dsn {
+
+    inline void unmarshall(::dsn::binary_reader& reader, command_view& value, dsn_msg_serialize_format fmt)
+    {
+        dassert(fmt == DSF_THRIFT_BINARY, "command_view can only be decoded from DSF_THRIFT_BINARY");
+        ::dsn::thrift_binary::unmarshall(reader, value);
+    }
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <dsn/cpp/cli/cli_types.h>
+#include <dsn/cpp/cli/cli.codec.h>
 #include <dsn/service_api_cpp.h>
 #include <dsn/cpp/serialization.h>
 
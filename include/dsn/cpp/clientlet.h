@@ -480,6 +480,20 @@ namespace dsn
             return tsk;
         }
 
+        template<typename TCallback>
+        task_ptr flush(
+            dsn_handle_t fh,
+            dsn_task_code_t callback_code,
+            clientlet* svc,
+            TCallback&& callback,
+            int hash = 0
+            )
+        {
+            auto tsk = create_aio_task(callback_code, svc, std::forward<TCallback>(callback), hash);
+            dsn_file_flush_async(fh, tsk->native_handle());
+            return tsk;
+        }
+
         void copy_remote_files_impl(
             ::dsn::rpc_address remote,
             const std::string& source_dir,
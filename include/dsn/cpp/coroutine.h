@@ -0,0 +1,509 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ *
+ * -=- Robust Distributed System Nucleus (rDSN) -=-
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     stackless coroutine helpers (awaitables) atop rpc and aio tasks
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# pragma once
+
+//
+// the helpers are only available when the compiler supports coroutines,
+// i.e., -std=c++2a/c++20, or -fcoroutines-ts (clang), or /await (msvc);
+// DSN_HAS_COROUTINE is defined in that case
+//
+# if defined(__cpp_impl_coroutine) || defined(__cpp_coroutines)
+
+# define DSN_HAS_COROUTINE 1
+
+# include <dsn/service_api_c.h>
+# include <dsn/cpp/auto_codes.h>
+# include <dsn/cpp/address.h>
+# include <dsn/cpp/serialization.h>
+# include <dsn/cpp/optional.h>
+# include <atomic>
+# include <chrono>
+# include <exception>
+# include <utility>
+
+# if defined(__cpp_impl_coroutine)
+# include <coroutine>
+# else
+# include <experimental/coroutine>
+# endif
+
+namespace dsn
+{
+    /*!
+    @addtogroup tasking
+    @{
+    */
+
+    //
+    // a coroutine returns task<T> can co_await rpc calls, aio operations, or other
+    // task<T>s, without blocking the worker thread or allocating a callback object
+    // for each hop, e.g.,
+    //
+    //    coro::task<int> get_value(rpc_address server, const std::string& key)
+    //    {
+    //        auto resp = co_await coro::rpc::call<int>(server, RPC_GET, key);
+    //        co_return resp.first == ERR_OK ? resp.second : -1;
+    //    }
+    //
+    //    coro::spawn(get_value(server, "k1"));
+    //
+    // the continuation after co_await runs inside the completion task:
+    //  - rpc: the response task, which is enqueued into the caller's pool
+    //  - aio: the aio task, which is enqueued into the pool of the given callback code
+    // use co_await coro::switch_to(code) to move to another pool explicitly
+    //
+    // note it is named coro::task as ::dsn::task is the core task class
+    //
+    namespace coro
+    {
+# if defined(__cpp_impl_coroutine)
+        namespace stdcoro = ::std;
+# else
+        namespace stdcoro = ::std::experimental;
+# endif
+
+        template<typename T> class task;
+
+        namespace detail
+        {
+            // resume the awaiter when the coroutine finishes, unless the awaiter has not
+            // suspended yet (see task_base::await_suspend)
+            struct final_awaiter
+            {
+                bool await_ready() const noexcept { return false; }
+
+                template<typename TPromise>
+                void await_suspend(stdcoro::coroutine_handle<TPromise> h) noexcept
+                {
+                    auto& p = h.promise();
+                    if (p.completed.exchange(true, std::memory_order_acq_rel))
+                        p.continuation.resume();
+                }
+
+                void await_resume() const noexcept {}
+            };
+
+            struct promise_base
+            {
+                stdcoro::coroutine_handle<> continuation;
+                std::exception_ptr          exception;
+                // set by the first of the awaiter (suspended) and the coroutine (finished)
+                std::atomic<bool>           completed { false };
+
+                stdcoro::suspend_always initial_suspend() const noexcept { return {}; }
+                final_awaiter final_suspend() const noexcept { return {}; }
+                void unhandled_exception() { exception = std::current_exception(); }
+
+                void rethrow_if_exception()
+                {
+                    if (exception)
+                        std::rethrow_exception(exception);
+                }
+            };
+
+            // awaiting a task starts it (tasks are lazy) on the current thread, and the
+            // awaiter continues without suspension if the task finishes synchronously,
+            // so that loops over such tasks do not grow the stack (the symmetric
+            // transfer is not a guaranteed tail call in unoptimized builds)
+            template<typename TPromise>
+            class task_base
+            {
+            public:
+                typedef stdcoro::coroutine_handle<TPromise> handle_t;
+
+                task_base(task_base&& r) noexcept : _handle(r._handle) { r._handle = nullptr; }
+                task_base(const task_base&) = delete;
+                task_base& operator = (const task_base&) = delete;
+
+                ~task_base()
+                {
+                    if (_handle)
+                        _handle.destroy();
+                }
+
+                bool await_ready() const noexcept { return false; }
+
+                bool await_suspend(stdcoro::coroutine_handle<> awaiter) noexcept
+                {
+                    _handle.promise().continuation = awaiter;
+                    _handle.resume();
+                    return !_handle.promise().completed.exchange(true, std::memory_order_acq_rel);
+                }
+
+            protected:
+                explicit task_base(handle_t h) : _handle(h) {}
+
+                handle_t _handle;
+            };
+
+            struct detached_task
+            {
+                struct promise_type
+                {
+                    detached_task get_return_object() { return detached_task(); }
+                    stdcoro::suspend_never initial_suspend() const noexcept { return {}; }
+                    stdcoro::suspend_never final_suspend() const noexcept { return {}; }
+                    void return_void() {}
+                    void unhandled_exception() { std::terminate(); }
+                };
+            };
+        }
+
+        namespace detail
+        {
+            template<typename T>
+            struct task_promise : public promise_base
+            {
+                ::dsn::optional<T> result;
+
+                task<T> get_return_object();
+
+                template<typename U>
+                void return_value(U&& v)
+                {
+                    result.reset(std::forward<U>(v));
+                }
+            };
+
+            template<>
+            struct task_promise<void> : public promise_base
+            {
+                task<void> get_return_object();
+
+                void return_void() {}
+            };
+        }
+
+        template<typename T>
+        class task : public detail::task_base<detail::task_promise<T>>
+        {
+        public:
+            typedef detail::task_promise<T> promise_type;
+
+            explicit task(typename detail::task_base<promise_type>::handle_t h)
+                : detail::task_base<promise_type>(h) {}
+            task(task&& r) noexcept = default;
+
+            T await_resume()
+            {
+                auto& p = this->_handle.promise();
+                p.rethrow_if_exception();
+                return std::move(p.result.unwrap());
+            }
+        };
+
+        template<>
+        class task<void> : public detail::task_base<detail::task_promise<void>>
+        {
+        public:
+            typedef detail::task_promise<void> promise_type;
+
+            explicit task(detail::task_base<promise_type>::handle_t h)
+                : detail::task_base<promise_type>(h) {}
+            task(task&& r) noexcept = default;
+
+            void await_resume()
+            {
+                this->_handle.promise().rethrow_if_exception();
+            }
+        };
+
+        namespace detail
+        {
+            template<typename T>
+            inline task<T> task_promise<T>::get_return_object()
+            {
+                return task<T>(stdcoro::coroutine_handle<task_promise<T>>::from_promise(*this));
+            }
+
+            inline task<void> task_promise<void>::get_return_object()
+            {
+                return task<void>(stdcoro::coroutine_handle<task_promise<void>>::from_promise(*this));
+            }
+        }
+
+        namespace detail
+        {
+            inline detached_task run_detached(task<void> t)
+            {
+                co_await t;
+            }
+        }
+
+        // start a coroutine without waiting for it, it runs on the current
+        // thread until its first suspension point
+        inline void spawn(task<void>&& t)
+        {
+            detail::run_detached(std::move(t));
+        }
+
+        // continue the current coroutine on the pool of the given task code
+        class switch_awaiter
+        {
+        public:
+            switch_awaiter(dsn_task_code_t code, int hash) : _code(code), _hash(hash) {}
+
+            bool await_ready() const noexcept { return false; }
+
+            void await_suspend(stdcoro::coroutine_handle<> h)
+            {
+                _handle = h;
+                dsn_task_t t = dsn_task_create(_code, &switch_awaiter::exec, this, _hash, nullptr);
+                dsn_task_call(t, 0);
+            }
+
+            void await_resume() const noexcept {}
+
+        private:
+            static void exec(void* ctx)
+            {
+                static_cast<switch_awaiter*>(ctx)->_handle.resume();
+            }
+
+        private:
+            dsn_task_code_t             _code;
+            int                         _hash;
+            stdcoro::coroutine_handle<> _handle;
+        };
+
+        inline switch_awaiter switch_to(dsn_task_code_t code, int hash = 0)
+        {
+            return switch_awaiter(code, hash);
+        }
+
+        namespace rpc
+        {
+            // co_await returns std::pair<error_code, TResponse>
+            template<typename TResponse>
+            class rpc_awaiter
+            {
+            public:
+                rpc_awaiter(::dsn::rpc_address server, dsn_message_t request, int reply_thread_hash)
+                    : _server(server), _request(request), _reply_thread_hash(reply_thread_hash)
+                {
+                }
+
+                bool await_ready() const noexcept { return false; }
+
+                void await_suspend(stdcoro::coroutine_handle<> h)
+                {
+                    _handle = h;
+                    dsn_task_t t = dsn_rpc_create_response_task(_request, &rpc_awaiter::on_response,
+                        this, _reply_thread_hash, nullptr);
+                    dsn_rpc_call(_server.c_addr(), t);
+                }
+
+                std::pair< ::dsn::error_code, TResponse> await_resume()
+                {
+                    return std::move(_result);
+                }
+
+            private:
+                static void on_response(dsn_error_t err, dsn_message_t req, dsn_message_t resp, void* ctx)
+                {
+                    auto a = static_cast<rpc_awaiter*>(ctx);
+                    a->_result.first = err;
+                    if (err == ERR_OK)
+                    {
+                        ::dsn::unmarshall(resp, a->_result.second);
+                    }
+                    a->_handle.resume();
+                }
+
+            private:
+                ::dsn::rpc_address                      _server;
+                dsn_message_t                           _request;
+                int                                     _reply_thread_hash;
+                stdcoro::coroutine_handle<>             _handle;
+                std::pair< ::dsn::error_code, TResponse> _result;
+            };
+
+            // co_await returns std::pair<error_code, dsn_message_t>, and the caller
+            // must call dsn_msg_release_ref on the non-null response
+            template<>
+            class rpc_awaiter<dsn_message_t>
+            {
+            public:
+                rpc_awaiter(::dsn::rpc_address server, dsn_message_t request, int reply_thread_hash)
+                    : _server(server), _request(request), _reply_thread_hash(reply_thread_hash)
+                {
+                    _result.second = nullptr;
+                }
+
+                bool await_ready() const noexcept { return false; }
+
+                void await_suspend(stdcoro::coroutine_handle<> h)
+                {
+                    _handle = h;
+                    dsn_task_t t = dsn_rpc_create_response_task(_request, &rpc_awaiter::on_response,
+                        this, _reply_thread_hash, nullptr);
+                    dsn_rpc_call(_server.c_addr(), t);
+                }
+
+                std::pair< ::dsn::error_code, dsn_message_t> await_resume() const
+                {
+                    return _result;
+                }
+
+            private:
+                static void on_response(dsn_error_t err, dsn_message_t req, dsn_message_t resp, void* ctx)
+                {
+                    auto a = static_cast<rpc_awaiter*>(ctx);
+                    a->_result.first = err;
+                    if (resp != nullptr)
+                    {
+                        dsn_msg_add_ref(resp); // released by the caller
+                        a->_result.second = resp;
+                    }
+                    a->_handle.resume();
+                }
+
+            private:
+                ::dsn::rpc_address                          _server;
+                dsn_message_t                               _request;
+                int                                         _reply_thread_hash;
+                stdcoro::coroutine_handle<>                 _handle;
+                std::pair< ::dsn::error_code, dsn_message_t> _result;
+            };
+
+            inline rpc_awaiter<dsn_message_t> call(
+                ::dsn::rpc_address server,
+                dsn_message_t request,
+                int reply_thread_hash = 0
+                )
+            {
+                return rpc_awaiter<dsn_message_t>(server, request, reply_thread_hash);
+            }
+
+            template<typename TResponse, typename TRequest>
+            rpc_awaiter<TResponse> call(
+                ::dsn::rpc_address server,
+                dsn_task_code_t code,
+                TRequest&& req,
+                std::chrono::milliseconds timeout = std::chrono::milliseconds(0),
+                int thread_hash = 0, ///< if thread_hash == 0 && partition_hash != 0, thread_hash is computed from partition_hash
+                uint64_t partition_hash = 0,
+                int reply_thread_hash = 0
+                )
+            {
+                dsn_message_t msg = dsn_msg_create_request(code, static_cast<int>(timeout.count()), thread_hash, partition_hash);
+                ::dsn::marshall(msg, std::forward<TRequest>(req));
+                return rpc_awaiter<TResponse>(server, msg, reply_thread_hash);
+            }
+        }
+
+        namespace file
+        {
+            // co_await returns std::pair<error_code, size_t>, i.e., error and transferred size
+            class aio_awaiter
+            {
+            public:
+                aio_awaiter(bool is_write, dsn_handle_t fh, char* buffer, int count, uint64_t offset,
+                    dsn_task_code_t callback_code, int hash)
+                    : _is_write(is_write), _fh(fh), _buffer(buffer), _count(count), _offset(offset),
+                    _callback_code(callback_code), _hash(hash)
+                {
+                    _result.second = 0;
+                }
+
+                bool await_ready() const noexcept { return false; }
+
+                void await_suspend(stdcoro::coroutine_handle<> h)
+                {
+                    _handle = h;
+                    dsn_task_t t = dsn_file_create_aio_task(_callback_code, &aio_awaiter::on_complete,
+                        this, _hash, nullptr);
+                    if (_is_write)
+                        dsn_file_write(_fh, _buffer, _count, _offset, t);
+                    else
+                        dsn_file_read(_fh, _buffer, _count, _offset, t);
+                }
+
+                std::pair< ::dsn::error_code, size_t> await_resume() const
+                {
+                    return _result;
+                }
+
+            private:
+                static void on_complete(dsn_error_t err, size_t size, void* ctx)
+                {
+                    auto a = static_cast<aio_awaiter*>(ctx);
+                    a->_result.first = err;
+                    a->_result.second = size;
+                    a->_handle.resume();
+                }
+
+            private:
+                bool                                  _is_write;
+                dsn_handle_t                          _fh;
+                char*                                 _buffer;
+                int                                   _count;
+                uint64_t                              _offset;
+                dsn_task_code_t                       _callback_code;
+                int                                   _hash;
+                stdcoro::coroutine_handle<>           _handle;
+                std::pair< ::dsn::error_code, size_t> _result;
+            };
+
+            inline aio_awaiter read(
+                dsn_handle_t fh,
+                char* buffer,
+                int count,
+                uint64_t offset,
+                dsn_task_code_t callback_code,
+                int hash = 0
+                )
+            {
+                return aio_awaiter(false, fh, buffer, count, offset, callback_code, hash);
+            }
+
+            inline aio_awaiter write(
+                dsn_handle_t fh,
+                const char* buffer,
+                int count,
+                uint64_t offset,
+                dsn_task_code_t callback_code,
+                int hash = 0
+                )
+            {
+                return aio_awaiter(true, fh, const_cast<char*>(buffer), count, offset, callback_code, hash);
+            }
+        }
+    }
+    /*@}*/
+}
+
+# endif // coroutine support
@@ -0,0 +1,228 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ *
+ * -=- Robust Distributed System Nucleus (rDSN) -=-
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     move-only type-erased callable with an inline buffer
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# pragma once
+
+# include <cstddef>
+# include <new>
+# include <type_traits>
+# include <utility>
+
+namespace dsn
+{
+    //
+    // inline_function is a replacement of std::function for task callbacks:
+    //  - callables no larger than InlineBytes are stored inside the object without
+    //    heap allocation, larger ones fall back to the heap
+    //  - it is move-only, so move-only callables (e.g., lambdas capturing
+    //    std::unique_ptr or moved messages/blobs) can be stored
+    //
+    template<typename TSignature, size_t InlineBytes = 6 * sizeof(void*)>
+    class inline_function;
+
+    template<typename TReturn, typename... TArgs, size_t InlineBytes>
+    class inline_function<TReturn(TArgs...), InlineBytes>
+    {
+    public:
+        inline_function() noexcept : _ops(nullptr) {}
+        inline_function(std::nullptr_t) noexcept : _ops(nullptr) {}
+
+        template<typename TFunction, typename = typename std::enable_if<
+            !std::is_same<typename std::decay<TFunction>::type, inline_function>::value>::type>
+        inline_function(TFunction&& f) : _ops(nullptr)
+        {
+            assign(std::forward<TFunction>(f));
+        }
+
+        inline_function(inline_function&& r) noexcept : _ops(nullptr)
+        {
+            move_from(r);
+        }
+
+        inline_function(const inline_function&) = delete;
+        inline_function& operator = (const inline_function&) = delete;
+
+        ~inline_function()
+        {
+            reset();
+        }
+
+        inline_function& operator = (inline_function&& r) noexcept
+        {
+            if (this != &r)
+            {
+                reset();
+                move_from(r);
+            }
+            return *this;
+        }
+
+        inline_function& operator = (std::nullptr_t) noexcept
+        {
+            reset();
+            return *this;
+        }
+
+        template<typename TFunction, typename = typename std::enable_if<
+            !std::is_same<typename std::decay<TFunction>::type, inline_function>::value>::type>
+        inline_function& operator = (TFunction&& f)
+        {
+            reset();
+            assign(std::forward<TFunction>(f));
+            return *this;
+        }
+
+        explicit operator bool() const noexcept { return _ops != nullptr; }
+
+        // whether the callable is stored in the inline buffer (for testing)
+        bool is_inline() const noexcept { return _ops != nullptr && _ops->is_inline; }
+
+        TReturn operator()(TArgs... args)
+        {
+            return _ops->invoke(&_storage, std::forward<TArgs>(args)...);
+        }
+
+        void reset() noexcept
+        {
+            if (_ops != nullptr)
+            {
+                _ops->destroy(&_storage);
+                _ops = nullptr;
+            }
+        }
+
+    private:
+        struct ops_t
+        {
+            TReturn (*invoke)(void* storage, TArgs&&... args);
+            void    (*move)(void* from, void* to);    // move to the target and destroy the source
+            void    (*destroy)(void* storage);
+            bool    is_inline;
+        };
+
+        typedef typename std::aligned_storage<InlineBytes, alignof(std::max_align_t)>::type storage_t;
+
+        template<typename F>
+        struct fits_inline
+        {
+            static constexpr bool value = sizeof(F) <= sizeof(storage_t)
+                && alignof(F) <= alignof(storage_t)
+                && std::is_nothrow_move_constructible<F>::value;
+        };
+
+        template<typename F>
+        struct inline_ops
+        {
+            static TReturn invoke(void* s, TArgs&&... args)
+            {
+                return (*static_cast<F*>(s))(std::forward<TArgs>(args)...);
+            }
+
+            static void move(void* from, void* to)
+            {
+                new (to) F(std::move(*static_cast<F*>(from)));
+                static_cast<F*>(from)->~F();
+            }
+
+            static void destroy(void* s)
+            {
+                static_cast<F*>(s)->~F();
+            }
+
+            static const ops_t* get()
+            {
+                static const ops_t ops = { &invoke, &move, &destroy, true };
+                return &ops;
+            }
+        };
+
+        template<typename F>
+        struct heap_ops
+        {
+            static TReturn invoke(void* s, TArgs&&... args)
+            {
+                return (**static_cast<F**>(s))(std::forward<TArgs>(args)...);
+            }
+
+            static void move(void* from, void* to)
+            {
+                *static_cast<F**>(to) = *static_cast<F**>(from);
+            }
+
+            static void destroy(void* s)
+            {
+                delete *static_cast<F**>(s);
+            }
+
+            static const ops_t* get()
+            {
+                static const ops_t ops = { &invoke, &move, &destroy, false };
+                return &ops;
+            }
+        };
+
+        template<typename TFunction>
+        typename std::enable_if<fits_inline<typename std::decay<TFunction>::type>::value>::type
+            assign(TFunction&& f)
+        {
+            typedef typename std::decay<TFunction>::type F;
+            new (&_storage) F(std::forward<TFunction>(f));
+            _ops = inline_ops<F>::get();
+        }
+
+        template<typename TFunction>
+        typename std::enable_if<!fits_inline<typename std::decay<TFunction>::type>::value>::type
+            assign(TFunction&& f)
+        {
+            typedef typename std::decay<TFunction>::type F;
+            *reinterpret_cast<F**>(&_storage) = new F(std::forward<TFunction>(f));
+            _ops = heap_ops<F>::get();
+        }
+
+        void move_from(inline_function& r) noexcept
+        {
+            if (r._ops != nullptr)
+            {
+                r._ops->move(&r._storage, &_storage);
+                _ops = r._ops;
+                r._ops = nullptr;
+            }
+        }
+
+    private:
+        const ops_t* _ops;
+        storage_t    _storage;
+    };
+}
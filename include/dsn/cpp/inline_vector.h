@@ -0,0 +1,231 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     vector with inline capacity for a few elements
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# pragma once
+
+# include <cstddef>
+# include <cstdlib>
+# include <iterator>
+# include <new>
+# include <type_traits>
+# include <utility>
+
+namespace dsn
+{
+    //
+    // inline_vector is a replacement of std::vector for the small lists on hot paths
+    // (e.g., the buffers of a message): the first InlineCount elements are stored
+    // inside the object without heap allocation, and all elements move to the heap
+    // when more are added
+    //
+    template<typename T, size_t InlineCount>
+    class inline_vector
+    {
+    public:
+        typedef T                                     value_type;
+        typedef size_t                                size_type;
+        typedef T&                                    reference;
+        typedef const T&                              const_reference;
+        typedef T*                                    iterator;
+        typedef const T*                              const_iterator;
+        typedef std::reverse_iterator<iterator>       reverse_iterator;
+        typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+        inline_vector() : _data(inline_data()), _size(0), _capacity(InlineCount) {}
+
+        inline_vector(const inline_vector& r) : inline_vector()
+        {
+            reserve(r._size);
+            for (size_t i = 0; i < r._size; i++)
+                new (_data + i) T(r._data[i]);
+            _size = r._size;
+        }
+
+        inline_vector(inline_vector&& r) : inline_vector()
+        {
+            move_from(r);
+        }
+
+        ~inline_vector()
+        {
+            clear();
+            if (!is_inline())
+                ::free(_data);
+        }
+
+        inline_vector& operator = (const inline_vector& r)
+        {
+            if (this != &r)
+            {
+                clear();
+                reserve(r._size);
+                for (size_t i = 0; i < r._size; i++)
+                    new (_data + i) T(r._data[i]);
+                _size = r._size;
+            }
+            return *this;
+        }
+
+        inline_vector& operator = (inline_vector&& r)
+        {
+            if (this != &r)
+            {
+                clear();
+                move_from(r);
+            }
+            return *this;
+        }
+
+        size_t size() const { return _size; }
+        size_t capacity() const { return _capacity; }
+        bool   empty() const { return _size == 0; }
+        // whether the elements are stored inline (for testing)
+        bool   is_inline() const { return _data == inline_data(); }
+
+        T*       data() { return _data; }
+        const T* data() const { return _data; }
+
+        T&       operator[](size_t i) { return _data[i]; }
+        const T& operator[](size_t i) const { return _data[i]; }
+        T&       front() { return _data[0]; }
+        const T& front() const { return _data[0]; }
+        T&       back() { return _data[_size - 1]; }
+        const T& back() const { return _data[_size - 1]; }
+
+        iterator               begin() { return _data; }
+        const_iterator         begin() const { return _data; }
+        iterator               end() { return _data + _size; }
+        const_iterator         end() const { return _data + _size; }
+        reverse_iterator       rbegin() { return reverse_iterator(end()); }
+        const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+        reverse_iterator       rend() { return reverse_iterator(begin()); }
+        const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+        void push_back(const T& v) { emplace_back(v); }
+        void push_back(T&& v) { emplace_back(std::move(v)); }
+
+        template<typename... TArgs>
+        T& emplace_back(TArgs&&... args)
+        {
+            if (_size == _capacity)
+            {
+                // v may refer to an element of this vector
+                T v(std::forward<TArgs>(args)...);
+                reserve(_capacity * 2);
+                new (_data + _size) T(std::move(v));
+            }
+            else
+            {
+                new (_data + _size) T(std::forward<TArgs>(args)...);
+            }
+            return _data[_size++];
+        }
+
+        void pop_back()
+        {
+            _data[--_size].~T();
+        }
+
+        void resize(size_t n)
+        {
+            while (_size > n)
+                pop_back();
+
+            reserve(n);
+            while (_size < n)
+                emplace_back();
+        }
+
+        void clear()
+        {
+            while (_size > 0)
+                pop_back();
+        }
+
+        void reserve(size_t n)
+        {
+            if (n <= _capacity)
+                return;
+
+            T* data = static_cast<T*>(::malloc(n * sizeof(T)));
+            if (data == nullptr)
+                throw std::bad_alloc();
+
+            for (size_t i = 0; i < _size; i++)
+            {
+                new (data + i) T(std::move(_data[i]));
+                _data[i].~T();
+            }
+
+            if (!is_inline())
+                ::free(_data);
+            _data = data;
+            _capacity = n;
+        }
+
+    private:
+        T* inline_data() const { return reinterpret_cast<T*>(const_cast<storage_t*>(&_storage)); }
+
+        void move_from(inline_vector& r)
+        {
+            if (r.is_inline())
+            {
+                for (size_t i = 0; i < r._size; i++)
+                    new (_data + i) T(std::move(r._data[i]));
+                _size = r._size;
+                r.clear();
+            }
+            else
+            {
+                if (!is_inline())
+                    ::free(_data);
+                _data = r._data;
+                _size = r._size;
+                _capacity = r._capacity;
+                r._data = r.inline_data();
+                r._size = 0;
+                r._capacity = InlineCount;
+            }
+        }
+
+    private:
+        typedef typename std::aligned_storage<sizeof(T) * InlineCount, alignof(T)>::type storage_t;
+
+        T*        _data;
+        size_t    _size;
+        size_t    _capacity;
+        storage_t _storage;
+    };
+}
@@ -0,0 +1,311 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     parallel_for, parallel_reduce and fork/join groups on the task engine
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# pragma once
+
+# include <dsn/service_api_c.h>
+# include <dsn/utility/autoref_ptr.h>
+# include <dsn/utility/synchronize.h>
+# include <dsn/cpp/inline_function.h>
+# include <algorithm>
+# include <atomic>
+# include <condition_variable>
+# include <deque>
+# include <mutex>
+# include <thread>
+# include <vector>
+
+namespace dsn
+{
+    /*!
+    @addtogroup tasking
+    @{
+    */
+
+    //
+    // the range is split into chunks, which are claimed one by one by the caller
+    // and by up to (parallelism - 1) helper tasks enqueued with the given task code;
+    // the caller keeps executing chunks until none is left, and then only waits for
+    // the chunks being executed by the helpers, so it never blocks on a chunk queued
+    // behind itself (no deadlock even when called from a worker of the same pool)
+    //
+    // parallelism = 0 for std::thread::hardware_concurrency(), which is usually set
+    // to the worker count of the pool of the task code;
+    // grain_size = 0 for splitting the range into (parallelism * 4) chunks
+    //
+    namespace detail
+    {
+        class parallel_work : public ref_counter
+        {
+        public:
+            template<typename TBody>
+            parallel_work(size_t chunk_count, TBody&& body)
+                : _next(0), _pending(chunk_count), _chunk_count(chunk_count), _body(std::forward<TBody>(body))
+            {
+            }
+
+            // claim and execute chunks until none is left
+            void run_chunks()
+            {
+                while (true)
+                {
+                    size_t c = _next.fetch_add(1, std::memory_order_relaxed);
+                    if (c >= _chunk_count)
+                        return;
+
+                    _body(c);
+                    if (_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                        _done.notify();
+                }
+            }
+
+            void run(dsn_task_code_t code, int parallelism)
+            {
+                int helpers = static_cast<int>(std::min(static_cast<size_t>(parallelism), _chunk_count)) - 1;
+                for (int i = 0; i < helpers; i++)
+                {
+                    add_ref(); // released in exec
+                    dsn_task_t t = dsn_task_create(code, &parallel_work::exec, this, i + 1, nullptr);
+                    dsn_task_call(t, 0);
+                }
+
+                run_chunks();
+
+                // the last finished chunk notifies, even when it is executed by the caller
+                if (_chunk_count > 0)
+                    _done.wait();
+            }
+
+        private:
+            static void exec(void* ctx)
+            {
+                auto work = static_cast<parallel_work*>(ctx);
+                work->run_chunks();
+                work->release_ref();
+            }
+
+        private:
+            std::atomic<size_t>            _next;
+            std::atomic<size_t>            _pending;
+            size_t                         _chunk_count;
+            utils::notify_event            _done;
+
+            // only called for claimed chunks, which are all done before run() returns,
+            // so it may refer to the caller's stack
+            inline_function<void(size_t)>  _body;
+        };
+
+        inline int parallelism_or_default(int parallelism)
+        {
+            if (parallelism > 0)
+                return parallelism;
+            int n = static_cast<int>(std::thread::hardware_concurrency());
+            return n > 0 ? n : 1;
+        }
+
+        template<typename TIndex>
+        size_t chunk_size_of(TIndex begin, TIndex end, size_t grain_size, int parallelism)
+        {
+            if (grain_size > 0)
+                return grain_size;
+            size_t count = static_cast<size_t>(end - begin);
+            size_t chunks = static_cast<size_t>(parallelism) * 4;
+            return count < chunks ? 1 : (count + chunks - 1) / chunks;
+        }
+    }
+
+    // call fn(i) for each i in [begin, end)
+    template<typename TIndex, typename TFunction>
+    void parallel_for(
+        dsn_task_code_t code,
+        TIndex begin,
+        TIndex end,
+        TFunction&& fn,
+        size_t grain_size = 0,
+        int parallelism = 0
+        )
+    {
+        if (end <= begin)
+            return;
+
+        parallelism = detail::parallelism_or_default(parallelism);
+        size_t chunk_size = detail::chunk_size_of(begin, end, grain_size, parallelism);
+        size_t count = static_cast<size_t>(end - begin);
+        size_t chunk_count = (count + chunk_size - 1) / chunk_size;
+
+        ::dsn::ref_ptr<detail::parallel_work> work(new detail::parallel_work(chunk_count, [&](size_t c)
+        {
+            TIndex b = begin + static_cast<TIndex>(c * chunk_size);
+            TIndex e = (c + 1 == chunk_count) ? end : b + static_cast<TIndex>(chunk_size);
+            for (TIndex i = b; i < e; ++i)
+                fn(i);
+        }));
+        work->run(code, parallelism);
+    }
+
+    // partials are computed as map(chunk_begin, chunk_end) -> T in parallel, and then
+    // combined in the chunk order with reduce(T, T) -> T on the caller, starting from identity
+    template<typename TIndex, typename T, typename TMap, typename TReduce>
+    T parallel_reduce(
+        dsn_task_code_t code,
+        TIndex begin,
+        TIndex end,
+        T identity,
+        TMap&& map,
+        TReduce&& reduce,
+        size_t grain_size = 0,
+        int parallelism = 0
+        )
+    {
+        if (end <= begin)
+            return identity;
+
+        parallelism = detail::parallelism_or_default(parallelism);
+        size_t chunk_size = detail::chunk_size_of(begin, end, grain_size, parallelism);
+        size_t count = static_cast<size_t>(end - begin);
+        size_t chunk_count = (count + chunk_size - 1) / chunk_size;
+
+        std::vector<T> partials(chunk_count, identity);
+        ::dsn::ref_ptr<detail::parallel_work> work(new detail::parallel_work(chunk_count, [&](size_t c)
+        {
+            TIndex b = begin + static_cast<TIndex>(c * chunk_size);
+            TIndex e = (c + 1 == chunk_count) ? end : b + static_cast<TIndex>(chunk_size);
+            partials[c] = map(b, e);
+        }));
+        work->run(code, parallelism);
+
+        T result = std::move(identity);
+        for (auto& p : partials)
+            result = reduce(std::move(result), std::move(p));
+        return result;
+    }
+
+    //
+    // fork_join_group runs the forked jobs on the pool of the given task code, and
+    // join() executes the jobs not yet picked up by any worker on the caller before
+    // waiting for the rest, e.g.,
+    //
+    //    fork_join_group g(LPC_REBUILD_INDEX);
+    //    for (auto& p : partitions)
+    //        g.fork([&p]() { p.rebuild_index(); });
+    //    g.join();
+    //
+    // a group can be reused after join(), but fork() and join() must be called
+    // by the same thread
+    //
+    class fork_join_group
+    {
+    public:
+        explicit fork_join_group(dsn_task_code_t code, int hash = 0)
+            : _code(code), _hash(hash), _state(new state())
+        {
+        }
+
+        ~fork_join_group()
+        {
+            join();
+        }
+
+        template<typename TFunction>
+        void fork(TFunction&& fn)
+        {
+            {
+                std::lock_guard<std::mutex> l(_state->lock);
+                _state->jobs.emplace_back(std::forward<TFunction>(fn));
+                _state->pending++;
+            }
+
+            _state->add_ref(); // released in exec
+            dsn_task_t t = dsn_task_create(_code, &fork_join_group::exec, _state.get(), _hash, nullptr);
+            dsn_task_call(t, 0);
+        }
+
+        void join()
+        {
+            while (_state->run_one())
+                ;
+
+            std::unique_lock<std::mutex> l(_state->lock);
+            _state->cond.wait(l, [this]() { return _state->pending == 0; });
+        }
+
+    private:
+        struct state : public ref_counter
+        {
+            std::mutex                            lock;
+            std::condition_variable               cond;
+            std::deque<inline_function<void()>>   jobs;
+            int                                   pending = 0;
+
+            // return false when no job is left
+            bool run_one()
+            {
+                inline_function<void()> job;
+                {
+                    std::lock_guard<std::mutex> l(lock);
+                    if (jobs.empty())
+                        return false;
+                    job = std::move(jobs.front());
+                    jobs.pop_front();
+                }
+
+                job();
+
+                bool done;
+                {
+                    std::lock_guard<std::mutex> l(lock);
+                    done = (--pending == 0);
+                }
+                if (done)
+                    cond.notify_all();
+                return true;
+            }
+        };
+
+        static void exec(void* ctx)
+        {
+            auto s = static_cast<state*>(ctx);
+            s->run_one();
+            s->release_ref();
+        }
+
+    private:
+        dsn_task_code_t  _code;
+        int              _hash;
+        ref_ptr<state>   _state;
+    };
+
+    /*@}*/
+}
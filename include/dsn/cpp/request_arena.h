@@ -0,0 +1,261 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     arena for the objects decoded while an rpc request is handled
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# pragma once
+
+# include <dsn/service_api_c.h>
+# include <dsn/cpp/blob.h>
+# include <dsn/cpp/inline_vector.h>
+# include <cstddef>
+# include <cstdint>
+# include <functional>
+# include <map>
+# include <memory>
+# include <new>
+# include <string>
+# include <vector>
+
+namespace dsn
+{
+    //
+    // request_arena is a bump allocator whose memory is released all at once by reset():
+    // - when rpc_request_arena_enabled is set for a task code, each thread keeps an arena
+    //   which is current while a request of that code is handled (see current()),
+    //   and is reset after the handler returns
+    // - blob fields decoded from small messages are copied into the arena instead of
+    //   separately allocated buffers (see binary_reader::read(blob&) and the thrift
+    //   blob readers), i.e., blob serves as the string view of the request
+    // - blobs share the ownership of their chunks, so they are still valid after reset
+    //   (e.g., when saved by the handler), which only pins the chunks they reference;
+    //   note a retained blob pins its whole chunk (up to max_chunk_bytes) however small
+    //   it is, so handlers which keep decoded blobs after the request (e.g., in a store
+    //   or a cache) should copy them out with detach_request_blob()
+    // - the other memory (allocate(), arena_allocator) must not be used after reset
+    //
+    class request_arena
+    {
+    public:
+        explicit request_arena(size_t initial_chunk_bytes = 4096, size_t max_chunk_bytes = 64 * 1024)
+            : _initial_chunk_bytes(initial_chunk_bytes), _max_chunk_bytes(max_chunk_bytes),
+            _next(nullptr), _remain(0), _allocated_bytes(0)
+        {
+        }
+
+        request_arena(const request_arena&) = delete;
+        request_arena& operator = (const request_arena&) = delete;
+
+        // the arena of the request being handled by the current thread, nullptr if none
+        static request_arena* current()
+        {
+            return static_cast<request_arena*>(dsn_rpc_get_request_arena());
+        }
+
+        void* allocate(size_t size, size_t align = alignof(std::max_align_t))
+        {
+            size_t pad = static_cast<size_t>(-reinterpret_cast<uintptr_t>(_next)) & (align - 1);
+            if (size + pad > _remain)
+            {
+                new_chunk(size + align);
+                pad = static_cast<size_t>(-reinterpret_cast<uintptr_t>(_next)) & (align - 1);
+            }
+
+            char* p = _next + pad;
+            _next = p + size;
+            _remain -= size + pad;
+            _allocated_bytes += size;
+            return p;
+        }
+
+        // the blob shares the ownership of the arena chunk, no allocation is needed
+        // unless the current chunk is full; empty blobs do not reference any chunk
+        blob copy_blob(const char* data, size_t size)
+        {
+            if (size == 0)
+                return blob();
+
+            if (size > _remain)
+                new_chunk(size);
+
+            char* p = _next;
+            memcpy(p, data, size);
+            _next += size;
+            _remain -= size;
+            _allocated_bytes += size;
+            return blob(_chunks.back(), static_cast<int>(p - _chunks.back().get()), static_cast<unsigned int>(size));
+        }
+
+        // release all memory at once, the largest chunk which is not referenced by
+        // blobs is kept for the next request
+        void reset()
+        {
+            std::shared_ptr<char> kept;
+            size_t kept_bytes = 0;
+            for (size_t i = 0; i < _chunks.size(); i++)
+            {
+                if (_chunks[i].use_count() == 1 && _chunk_sizes[i] > kept_bytes)
+                {
+                    kept = std::move(_chunks[i]);
+                    kept_bytes = _chunk_sizes[i];
+                }
+            }
+
+            _chunks.clear();
+            _chunk_sizes.clear();
+            _allocated_bytes = 0;
+            if (kept)
+            {
+                _next = kept.get();
+                _remain = kept_bytes;
+                _chunks.push_back(std::move(kept));
+                _chunk_sizes.push_back(kept_bytes);
+            }
+            else
+            {
+                _next = nullptr;
+                _remain = 0;
+            }
+        }
+
+        size_t allocated_bytes() const { return _allocated_bytes; }
+        size_t chunk_count() const { return _chunks.size(); }
+
+    private:
+        void new_chunk(size_t min_size)
+        {
+            // chunks grow so that the arena quickly fits the requests of the thread
+            size_t sz = _chunk_sizes.size() == 0 ? _initial_chunk_bytes : _chunk_sizes.back() * 2;
+            if (sz > _max_chunk_bytes)
+                sz = _max_chunk_bytes;
+            if (sz < min_size)
+                sz = min_size;
+
+            _chunks.push_back(make_shared_array<char>(sz));
+            _chunk_sizes.push_back(sz);
+            _next = _chunks.back().get();
+            _remain = sz;
+        }
+
+    private:
+        size_t _initial_chunk_bytes;
+        size_t _max_chunk_bytes;
+        inline_vector<std::shared_ptr<char>, 4> _chunks;
+        inline_vector<size_t, 4> _chunk_sizes;
+        char*  _next;
+        size_t _remain;
+        size_t _allocated_bytes;
+    };
+
+    //
+    // allocator for containers whose memory lives in an arena, which defaults to
+    // the current request arena, and falls back to the heap when there is none;
+    // deallocation is a no-op for arena memory
+    //
+    template<typename T>
+    class arena_allocator
+    {
+    public:
+        typedef T value_type;
+
+        arena_allocator() noexcept : _arena(request_arena::current()) {}
+        explicit arena_allocator(request_arena* arena) noexcept : _arena(arena) {}
+
+        template<typename U>
+        arena_allocator(const arena_allocator<U>& r) noexcept : _arena(r.arena()) {}
+
+        T* allocate(size_t n)
+        {
+            if (_arena != nullptr)
+                return static_cast<T*>(_arena->allocate(n * sizeof(T), alignof(T)));
+            else
+                return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(T* p, size_t) noexcept
+        {
+            if (_arena == nullptr)
+                ::operator delete(p);
+        }
+
+        request_arena* arena() const noexcept { return _arena; }
+
+    private:
+        request_arena* _arena;
+    };
+
+    template<typename T, typename U>
+    inline bool operator == (const arena_allocator<T>& l, const arena_allocator<U>& r) noexcept
+    {
+        return l.arena() == r.arena();
+    }
+
+    template<typename T, typename U>
+    inline bool operator != (const arena_allocator<T>& l, const arena_allocator<U>& r) noexcept
+    {
+        return l.arena() != r.arena();
+    }
+
+    typedef std::basic_string<char, std::char_traits<char>, arena_allocator<char> > arena_string;
+
+    template<typename T>
+    using arena_vector = std::vector<T, arena_allocator<T> >;
+
+    template<typename TKey, typename TValue, typename TCompare = std::less<TKey> >
+    using arena_map = std::map<TKey, TValue, TCompare, arena_allocator<std::pair<const TKey, TValue> > >;
+
+    // copy to a blob which lives in the current request arena if any, or in a new buffer
+    inline blob copy_to_request_blob(const char* data, size_t size)
+    {
+        request_arena* arena = request_arena::current();
+        if (arena != nullptr)
+            return arena->copy_blob(data, size);
+
+        std::shared_ptr<char> buffer(make_shared_array<char>(size));
+        memcpy(buffer.get(), data, size);
+        return blob(std::move(buffer), 0, static_cast<unsigned int>(size));
+    }
+
+    // copy a blob decoded from a request into its own buffer, for the handlers which keep
+    // it after the request, as the decoded blob references an arena chunk or the request
+    // message, and would pin all of it otherwise
+    inline blob detach_request_blob(const blob& b)
+    {
+        if (b.length() == 0)
+            return blob();
+
+        std::shared_ptr<char> buffer(make_shared_array<char>(b.length()));
+        memcpy(buffer.get(), b.data(), b.length());
+        return blob(std::move(buffer), 0, b.length());
+    }
+}
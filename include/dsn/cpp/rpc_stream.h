@@ -73,10 +73,26 @@ namespace dsn
             bool r = dsn_msg_read_next(msg, &ptr, &size);
             dassert(r, "read msg must have one segment of buffer ready");
 
-            blob bb((const char*)ptr, 0, (int)size);
-            init(bb);
+            if (size >= zero_copy_min_bytes)
+            {
+                // blobs read from large messages (e.g., by binary_reader::read(blob&) and
+                // thrift blob fields) reference the message buffer without copy, which is
+                // kept alive by a reference to the message
+                dsn_msg_add_ref(msg);
+                std::shared_ptr<char> holder((char*)ptr, [msg](char*) { dsn_msg_release_ref(msg); });
+                init(blob(std::move(holder), 0, (int)size));
+            }
+            else
+            {
+                blob bb((const char*)ptr, 0, (int)size);
+                init(bb);
+            }
         }
 
+        // smaller messages are copied when blobs are read, which is cheaper than
+        // sharing the message buffer
+        static const size_t zero_copy_min_bytes = 4096;
+
         ~rpc_read_stream()
         {
             if (native_handle())
@@ -132,6 +148,28 @@ namespace dsn
             binary_writer::flush();
             commit_buffer();
         }
+
+        // large blobs are appended to the message by reference (e.g., a 4 MB blob field
+        // is sent without copy), the others are copied into the message buffer
+        virtual void append(const blob& val) override
+        {
+            if (val.length() < append_by_ref_min_bytes || !val.has_holder())
+            {
+                binary_writer::append(val);
+                return;
+            }
+
+            binary_writer::commit();
+            commit_buffer();
+
+            dsn_msg_write_append(native_handle(), val.data(), (size_t)val.length(),
+                [](void* holder) { delete (std::shared_ptr<char>*)holder; },
+                new std::shared_ptr<char>(val.buffer())
+                );
+            seal_buffer((int)val.length());
+        }
+
+        static const size_t append_by_ref_min_bytes = 4096;
         
     private:
         virtual void create_new_buffer(size_t size, /*out*/blob& bb) override
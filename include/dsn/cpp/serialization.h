@@ -69,10 +69,12 @@ namespace dsn
 
 #define THRIFT_MARSHALLER \
         case DSF_THRIFT_BINARY: marshall_thrift_binary(writer, value); break; \
+        case DSF_THRIFT_COMPACT: marshall_thrift_compact(writer, value); break; \
         case DSF_THRIFT_JSON: marshall_thrift_json(writer, value); break;
 
 #define THRIFT_UNMARSHALLER \
         case DSF_THRIFT_BINARY: unmarshall_thrift_binary(reader, value); break; \
+        case DSF_THRIFT_COMPACT: unmarshall_thrift_compact(reader, value); break; \
         case DSF_THRIFT_JSON: unmarshall_thrift_json(reader, value); break;
 
     //the following 2 functions is for thrift basic type serialization
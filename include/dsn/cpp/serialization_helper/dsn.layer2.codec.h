@@ -0,0 +1,540 @@
+/**
+ * Autogenerated by compile_thrift.py
+ *
+ * DO NOT EDIT UNLESS YOU ARE SURE THAT YOU KNOW WHAT YOU ARE DOING
+ *  @generated
+ */
+# pragma once
+# include <dsn/cpp/serialization_helper/dsn.layer2_types.h>
+# include <dsn/cpp/serialization_helper/thrift_binary_codec.h>
+
+namespace dsn {
+
+    template<>
+    struct thrift_binary_codec< ::dsn::partition_configuration>
+    {
+        static const bool enabled = true;
+
+        static void write(binary_writer& w, const ::dsn::partition_configuration& v)
+        {
+            thrift_binary::write_field(w, 1, v.pid);
+            thrift_binary::write_field(w, 2, v.ballot);
+            thrift_binary::write_field(w, 3, v.max_replica_count);
+            thrift_binary::write_field(w, 4, v.primary);
+            thrift_binary::write_field(w, 5, v.secondaries);
+            thrift_binary::write_field(w, 6, v.last_drops);
+            thrift_binary::write_field(w, 7, v.last_committed_decree);
+            thrift_binary::write_field_stop(w);
+        }
+
+        static void read(binary_reader& r, /*out*/ ::dsn::partition_configuration& v)
+        {
+            ::apache::thrift::protocol::TType type;
+            int16_t id;
+            while (thrift_binary::read_field_begin(r, type, id))
+            {
+                switch (id)
+                {
+                case 1:
+                    if (thrift_binary::read_field(r, type, v.pid))
+                        v.__isset.pid = true;
+                    break;
+                case 2:
+                    if (thrift_binary::read_field(r, type, v.ballot))
+                        v.__isset.ballot = true;
+                    break;
+                case 3:
+                    if (thrift_binary::read_field(r, type, v.max_replica_count))
+                        v.__isset.max_replica_count = true;
+                    break;
+                case 4:
+                    if (thrift_binary::read_field(r, type, v.primary))
+                        v.__isset.primary = true;
+                    break;
+                case 5:
+                    if (thrift_binary::read_field(r, type, v.secondaries))
+                        v.__isset.secondaries = true;
+                    break;
+                case 6:
+                    if (thrift_binary::read_field(r, type, v.last_drops))
+                        v.__isset.last_drops = true;
+                    break;
+                case 7:
+                    if (thrift_binary::read_field(r, type, v.last_committed_decree))
+                        v.__isset.last_committed_decree = true;
+                    break;
+                default:
+                    thrift_binary::skip(r, type);
+                    break;
+                }
+            }
+        }
+    };
+
+    template<>
+    struct thrift_binary_codec< ::dsn::configuration_query_by_index_request>
+    {
+        static const bool enabled = true;
+
+        static void write(binary_writer& w, const ::dsn::configuration_query_by_index_request& v)
+        {
+            thrift_binary::write_field(w, 1, v.app_name);
+            thrift_binary::write_field(w, 2, v.partition_indices);
+            thrift_binary::write_field_stop(w);
+        }
+
+        static void read(binary_reader& r, /*out*/ ::dsn::configuration_query_by_index_request& v)
+        {
+            ::apache::thrift::protocol::TType type;
+            int16_t id;
+            while (thrift_binary::read_field_begin(r, type, id))
+            {
+                switch (id)
+                {
+                case 1:
+                    if (thrift_binary::read_field(r, type, v.app_name))
+                        v.__isset.app_name = true;
+                    break;
+                case 2:
+                    if (thrift_binary::read_field(r, type, v.partition_indices))
+                        v.__isset.partition_indices = true;
+                    break;
+                default:
+                    thrift_binary::skip(r, type);
+                    break;
+                }
+            }
+        }
+    };
+
+    template<>
+    struct thrift_binary_codec< ::dsn::configuration_query_by_index_response>
+    {
+        static const bool enabled = true;
+
+        static void write(binary_writer& w, const ::dsn::configuration_query_by_index_response& v)
+        {
+            thrift_binary::write_field(w, 1, v.err);
+            thrift_binary::write_field(w, 2, v.app_id);
+            thrift_binary::write_field(w, 3, v.partition_count);
+            thrift_binary::write_field(w, 4, v.is_stateful);
+            thrift_binary::write_field(w, 5, v.partitions);
+            thrift_binary::write_field_stop(w);
+        }
+
+        static void read(binary_reader& r, /*out*/ ::dsn::configuration_query_by_index_response& v)
+        {
+            ::apache::thrift::protocol::TType type;
+            int16_t id;
+            while (thrift_binary::read_field_begin(r, type, id))
+            {
+                switch (id)
+                {
+                case 1:
+                    if (thrift_binary::read_field(r, type, v.err))
+                        v.__isset.err = true;
+                    break;
+                case 2:
+                    if (thrift_binary::read_field(r, type, v.app_id))
+                        v.__isset.app_id = true;
+                    break;
+                case 3:
+                    if (thrift_binary::read_field(r, type, v.partition_count))
+                        v.__isset.partition_count = true;
+                    break;
+                case 4:
+                    if (thrift_binary::read_field(r, type, v.is_stateful))
+                        v.__isset.is_stateful = true;
+                    break;
+                case 5:
+                    if (thrift_binary::read_field(r, type, v.partitions))
+                        v.__isset.partitions = true;
+                    break;
+                default:
+                    thrift_binary::skip(r, type);
+                    break;
+                }
+            }
+        }
+    };
+
+    template<>
+    struct thrift_binary_codec< ::dsn::app_info>
+    {
+        static const bool enabled = true;
+
+        static void write(binary_writer& w, const ::dsn::app_info& v)
+        {
+            thrift_binary::write_field(w, 1, v.status);
+            thrift_binary::write_field(w, 2, v.app_type);
+            thrift_binary::write_field(w, 3, v.app_name);
+            thrift_binary::write_field(w, 4, v.app_id);
+            thrift_binary::write_field(w, 5, v.partition_count);
+            thrift_binary::write_field(w, 6, v.envs);
+            thrift_binary::write_field(w, 7, v.is_stateful);
+            thrift_binary::write_field(w, 8, v.max_replica_count);
+            thrift_binary::write_field_stop(w);
+        }
+
+        static void read(binary_reader& r, /*out*/ ::dsn::app_info& v)
+        {
+            ::apache::thrift::protocol::TType type;
+            int16_t id;
+            while (thrift_binary::read_field_begin(r, type, id))
+            {
+                switch (id)
+                {
+                case 1:
+                    if (thrift_binary::read_field(r, type, v.status))
+                        v.__isset.status = true;
+                    break;
+                case 2:
+                    if (thrift_binary::read_field(r, type, v.app_type))
+                        v.__isset.app_type = true;
+                    break;
+                case 3:
+                    if (thrift_binary::read_field(r, type, v.app_name))
+                        v.__isset.app_name = true;
+                    break;
+                case 4:
+                    if (thrift_binary::read_field(r, type, v.app_id))
+                        v.__isset.app_id = true;
+                    break;
+                case 5:
+                    if (thrift_binary::read_field(r, type, v.partition_count))
+                        v.__isset.partition_count = true;
+                    break;
+                case 6:
+                    if (thrift_binary::read_field(r, type, v.envs))
+                        v.__isset.envs = true;
+                    break;
+                case 7:
+                    if (thrift_binary::read_field(r, type, v.is_stateful))
+                        v.__isset.is_stateful = true;
+                    break;
+                case 8:
+                    if (thrift_binary::read_field(r, type, v.max_replica_count))
+                        v.__isset.max_replica_count = true;
+                    break;
+                default:
+                    thrift_binary::skip(r, type);
+                    break;
+                }
+            }
+        }
+    };
+}
+
+namespace dsn {
+
+    typedef struct _partition_configuration_view__isset {
+        _partition_configuration_view__isset() : pid(false), ballot(false), max_replica_count(false), primary(false), secondaries(false), last_drops(false), last_committed_decree(false) {}
+        bool pid;
+        bool ballot;
+        bool max_replica_count;
+        bool primary;
+        bool secondaries;
+        bool last_drops;
+        bool last_committed_decree;
+    } _partition_configuration_view__isset;
+
+    struct partition_configuration_view
+    {
+        explicit partition_configuration_view(::dsn::request_arena* arena = ::dsn::request_arena::current())
+            : ballot(0), max_replica_count(0), secondaries(::dsn::arena_allocator< ::dsn::rpc_address>(arena)), last_drops(::dsn::arena_allocator< ::dsn::rpc_address>(arena)), last_committed_decree(0)
+        {
+        }
+
+        ::dsn::gpid pid;
+        int64_t ballot;
+        int32_t max_replica_count;
+        ::dsn::rpc_address primary;
+        ::dsn::arena_vector< ::dsn::rpc_address> secondaries;
+        ::dsn::arena_vector< ::dsn::rpc_address> last_drops;
+        int64_t last_committed_decree;
+
+        _partition_configuration_view__isset __isset;
+    };
+
+    typedef struct _configuration_query_by_index_request_view__isset {
+        _configuration_query_by_index_request_view__isset() : app_name(false), partition_indices(false) {}
+        bool app_name;
+        bool partition_indices;
+    } _configuration_query_by_index_request_view__isset;
+
+    struct configuration_query_by_index_request_view
+    {
+        explicit configuration_query_by_index_request_view(::dsn::request_arena* arena = ::dsn::request_arena::current())
+            : partition_indices(::dsn::arena_allocator< int32_t>(arena))
+        {
+        }
+
+        ::dsn::string_view app_name_view() const { return ::dsn::string_view(app_name); }
+
+        ::dsn::blob app_name;
+        ::dsn::arena_vector< int32_t> partition_indices;
+
+        _configuration_query_by_index_request_view__isset __isset;
+    };
+
+    typedef struct _configuration_query_by_index_response_view__isset {
+        _configuration_query_by_index_response_view__isset() : err(false), app_id(false), partition_count(false), is_stateful(false), partitions(false) {}
+        bool err;
+        bool app_id;
+        bool partition_count;
+        bool is_stateful;
+        bool partitions;
+    } _configuration_query_by_index_response_view__isset;
+
+    struct configuration_query_by_index_response_view
+    {
+        explicit configuration_query_by_index_response_view(::dsn::request_arena* arena = ::dsn::request_arena::current())
+            : app_id(0), partition_count(0), is_stateful(false), partitions(::dsn::arena_allocator< ::dsn::partition_configuration_view>(arena))
+        {
+        }
+
+        ::dsn::error_code err;
+        int32_t app_id;
+        int32_t partition_count;
+        bool is_stateful;
+        ::dsn::arena_vector< ::dsn::partition_configuration_view> partitions;
+
+        _configuration_query_by_index_response_view__isset __isset;
+    };
+
+    typedef struct _app_info_view__isset {
+        _app_info_view__isset() : status(false), app_type(false), app_name(false), app_id(false), partition_count(false), envs(false), is_stateful(false), max_replica_count(false) {}
+        bool status;
+        bool app_type;
+        bool app_name;
+        bool app_id;
+        bool partition_count;
+        bool envs;
+        bool is_stateful;
+        bool max_replica_count;
+    } _app_info_view__isset;
+
+    struct app_info_view
+    {
+        explicit app_info_view(::dsn::request_arena* arena = ::dsn::request_arena::current())
+            : status(static_cast< ::dsn::app_status::type>(0)), app_id(0), partition_count(0), envs(::dsn::arena_allocator< std::pair< ::dsn::blob, ::dsn::blob> >(arena)), is_stateful(false), max_replica_count(0)
+        {
+        }
+
+        ::dsn::string_view app_type_view() const { return ::dsn::string_view(app_type); }
+        ::dsn::string_view app_name_view() const { return ::dsn::string_view(app_name); }
+
+        ::dsn::app_status::type status;
+        ::dsn::blob app_type;
+        ::dsn::blob app_name;
+        int32_t app_id;
+        int32_t partition_count;
+        ::dsn::arena_vector< std::pair< ::dsn::blob, ::dsn::blob> > envs;
+        bool is_stateful;
+        int32_t max_replica_count;
+
+        _app_info_view__isset __isset;
+    };
+}
+
+namespace dsn {
+
+    template<>
+    struct thrift_binary_codec< ::dsn::partition_configuration_view>
+    {
+        static const bool enabled = true;
+
+        static void read(binary_reader& r, /*out*/ ::dsn::partition_configuration_view& v)
+        {
+            ::apache::thrift::protocol::TType type;
+            int16_t id;
+            while (thrift_binary::read_field_begin(r, type, id))
+            {
+                switch (id)
+                {
+                case 1:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_STRUCT, v.pid))
+                        v.__isset.pid = true;
+                    break;
+                case 2:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_I64, v.ballot))
+                        v.__isset.ballot = true;
+                    break;
+                case 3:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_I32, v.max_replica_count))
+                        v.__isset.max_replica_count = true;
+                    break;
+                case 4:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_STRUCT, v.primary))
+                        v.__isset.primary = true;
+                    break;
+                case 5:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_LIST, v.secondaries))
+                        v.__isset.secondaries = true;
+                    break;
+                case 6:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_LIST, v.last_drops))
+                        v.__isset.last_drops = true;
+                    break;
+                case 7:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_I64, v.last_committed_decree))
+                        v.__isset.last_committed_decree = true;
+                    break;
+                default:
+                    thrift_binary::skip(r, type);
+                    break;
+                }
+            }
+        }
+    };
+
+    template<>
+    struct thrift_binary_codec< ::dsn::configuration_query_by_index_request_view>
+    {
+        static const bool enabled = true;
+
+        static void read(binary_reader& r, /*out*/ ::dsn::configuration_query_by_index_request_view& v)
+        {
+            ::apache::thrift::protocol::TType type;
+            int16_t id;
+            while (thrift_binary::read_field_begin(r, type, id))
+            {
+                switch (id)
+                {
+                case 1:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_STRING, v.app_name))
+                        v.__isset.app_name = true;
+                    break;
+                case 2:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_LIST, v.partition_indices))
+                        v.__isset.partition_indices = true;
+                    break;
+                default:
+                    thrift_binary::skip(r, type);
+                    break;
+                }
+            }
+        }
+    };
+
+    template<>
+    struct thrift_binary_codec< ::dsn::configuration_query_by_index_response_view>
+    {
+        static const bool enabled = true;
+
+        static void read(binary_reader& r, /*out*/ ::dsn::configuration_query_by_index_response_view& v)
+        {
+            ::apache::thrift::protocol::TType type;
+            int16_t id;
+            while (thrift_binary::read_field_begin(r, type, id))
+            {
+                switch (id)
+                {
+                case 1:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_STRUCT, v.err))
+                        v.__isset.err = true;
+                    break;
+                case 2:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_I32, v.app_id))
+                        v.__isset.app_id = true;
+                    break;
+                case 3:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_I32, v.partition_count))
+                        v.__isset.partition_count = true;
+                    break;
+                case 4:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_BOOL, v.is_stateful))
+                        v.__isset.is_stateful = true;
+                    break;
+                case 5:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_LIST, v.partitions))
+                        v.__isset.partitions = true;
+                    break;
+                default:
+                    thrift_binary::skip(r, type);
+                    break;
+                }
+            }
+        }
+    };
+
+    template<>
+    struct thrift_binary_codec< ::dsn::app_info_view>
+    {
+        static const bool enabled = true;
+
+        static void read(binary_reader& r, /*out*/ ::dsn::app_info_view& v)
+        {
+            ::apache::thrift::protocol::TType type;
+            int16_t id;
+            while (thrift_binary::read_field_begin(r, type, id))
+            {
+                switch (id)
+                {
+                case 1:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_I32, v.status))
+                        v.__isset.status = true;
+                    break;
+                case 2:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_STRING, v.app_type))
+                        v.__isset.app_type = true;
+                    break;
+                case 3:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_STRING, v.app_name))
+                        v.__isset.app_name = true;
+                    break;
+                case 4:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_I32, v.app_id))
+                        v.__isset.app_id = true;
+                    break;
+                case 5:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_I32, v.partition_count))
+                        v.__isset.partition_count = true;
+                    break;
+                case 6:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_MAP, v.envs))
+                        v.__isset.envs = true;
+                    break;
+                case 7:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_BOOL, v.is_stateful))
+                        v.__isset.is_stateful = true;
+                    break;
+                case 8:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_I32, v.max_replica_count))
+                        v.__isset.max_replica_count = true;
+                    break;
+                default:
+                    thrift_binary::skip(r, type);
+                    break;
+                }
+            }
+        }
+    };
+}
+
+namespace dsn {
+
+    inline void unmarshall(::dsn::binary_reader& reader, partition_configuration_view& value, dsn_msg_serialize_format fmt)
+    {
+        dassert(fmt == DSF_THRIFT_BINARY, "partition_configuration_view can only be decoded from DSF_THRIFT_BINARY");
+        ::dsn::thrift_binary::unmarshall(reader, value);
+    }
+
+    inline void unmarshall(::dsn::binary_reader& reader, configuration_query_by_index_request_view& value, dsn_msg_serialize_format fmt)
+    {
+        dassert(fmt == DSF_THRIFT_BINARY, "configuration_query_by_index_request_view can only be decoded from DSF_THRIFT_BINARY");
+        ::dsn::thrift_binary::unmarshall(reader, value);
+    }
+
+    inline void unmarshall(::dsn::binary_reader& reader, configuration_query_by_index_response_view& value, dsn_msg_serialize_format fmt)
+    {
+        dassert(fmt == DSF_THRIFT_BINARY, "configuration_query_by_index_response_view can only be decoded from DSF_THRIFT_BINARY");
+        ::dsn::thrift_binary::unmarshall(reader, value);
+    }
+
+    inline void unmarshall(::dsn::binary_reader& reader, app_info_view& value, dsn_msg_serialize_format fmt)
+    {
+        dassert(fmt == DSF_THRIFT_BINARY, "app_info_view can only be decoded from DSF_THRIFT_BINARY");
+        ::dsn::thrift_binary::unmarshall(reader, value);
+    }
+}
@@ -4,6 +4,7 @@
 
 
 # include <dsn/cpp/serialization_helper/dsn.layer2_types.h>
+# include <dsn/cpp/serialization_helper/dsn.layer2.codec.h>
 
 # include <dsn/utility/enum_helper.h>
 
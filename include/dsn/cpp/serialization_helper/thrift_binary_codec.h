@@ -0,0 +1,762 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     non-virtual thrift binary codec for the types generated by compile_thrift.py
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# pragma once
+
+# include <dsn/cpp/blob.h>
+# include <dsn/cpp/request_arena.h>
+# include <dsn/cpp/string_view.h>
+# include <dsn/cpp/address.h>
+# include <dsn/cpp/auto_codes.h>
+
+# include <thrift/Thrift.h>
+# include <thrift/protocol/TProtocol.h>
+# include <thrift/protocol/TProtocolException.h>
+# include <thrift/transport/TTransportException.h>
+
+# ifndef _WIN32
+# include <arpa/inet.h> // htonl etc., which come with thrift/windows/config.h on windows
+# endif
+
+# include <algorithm>
+# include <cstring>
+# include <map>
+# include <set>
+# include <string>
+# include <type_traits>
+# include <utility>
+# include <vector>
+
+namespace dsn
+{
+    //
+    // thrift_binary_codec<T> encodes T in the same wire format as TBinaryProtocol,
+    // but with inlined, non-virtual field writers/readers on top of binary_writer and
+    // binary_reader. compile_thrift.py generates the specializations for the thrift
+    // structs into <name>.codec.h, i.e.,
+    //
+    //   template<> struct thrift_binary_codec<T>
+    //   {
+    //       static const bool enabled = true;
+    //       static void write(binary_writer& w, const T& v);
+    //       static void read(binary_reader& r, /*out*/ T& v);
+    //   };
+    //
+    // marshall_thrift_binary and unmarshall_thrift_binary use the codec when it is
+    // enabled for the type, or the TProtocol path otherwise.
+    //
+    // the view types (<name>_view) generated along with the codecs are decoded without
+    // heap allocations, see the views in thrift_binary below.
+    //
+    template<typename T>
+    struct thrift_binary_codec
+    {
+        static const bool enabled = false;
+    };
+
+    namespace thrift_binary
+    {
+        using ::apache::thrift::protocol::TType;
+        using ::apache::thrift::protocol::TProtocolException;
+        using ::apache::thrift::transport::TTransportException;
+
+        // the limit of nested containers and structs when skipping unknown fields,
+        // the same as the default of TProtocol
+        const int max_skip_depth = 64;
+
+        //------------------- wire types -------------------
+        template<typename T, typename = void>
+        struct thrift_type { static const TType value = ::apache::thrift::protocol::T_STRUCT; };
+
+        template<typename T>
+        struct thrift_type<T, typename std::enable_if<std::is_enum<T>::value>::type> { static const TType value = ::apache::thrift::protocol::T_I32; };
+
+        template<> struct thrift_type<bool, void> { static const TType value = ::apache::thrift::protocol::T_BOOL; };
+        template<> struct thrift_type<int8_t, void> { static const TType value = ::apache::thrift::protocol::T_BYTE; };
+        template<> struct thrift_type<int16_t, void> { static const TType value = ::apache::thrift::protocol::T_I16; };
+        template<> struct thrift_type<int32_t, void> { static const TType value = ::apache::thrift::protocol::T_I32; };
+        template<> struct thrift_type<int64_t, void> { static const TType value = ::apache::thrift::protocol::T_I64; };
+        template<> struct thrift_type<double, void> { static const TType value = ::apache::thrift::protocol::T_DOUBLE; };
+        template<> struct thrift_type<std::string, void> { static const TType value = ::apache::thrift::protocol::T_STRING; };
+
+        template<typename T>
+        struct thrift_type<std::vector<T>, void> { static const TType value = ::apache::thrift::protocol::T_LIST; };
+
+        template<typename T>
+        struct thrift_type<std::set<T>, void> { static const TType value = ::apache::thrift::protocol::T_SET; };
+
+        template<typename TKey, typename TValue>
+        struct thrift_type<std::map<TKey, TValue>, void> { static const TType value = ::apache::thrift::protocol::T_MAP; };
+
+        // primitive lists are encoded and decoded in bulk
+        template<typename T>
+        struct is_bulk_primitive
+        {
+            static const bool value = std::is_same<T, int16_t>::value
+                || std::is_same<T, int32_t>::value
+                || std::is_same<T, int64_t>::value
+                || std::is_same<T, double>::value;
+        };
+
+        //------------------- byte order -------------------
+        inline uint16_t to_wire(int16_t v) { return htons(static_cast<uint16_t>(v)); }
+        inline uint32_t to_wire(int32_t v) { return htonl(static_cast<uint32_t>(v)); }
+        inline uint64_t to_wire(int64_t v) { return htonll(static_cast<uint64_t>(v)); }
+        inline uint64_t to_wire(double v)
+        {
+            uint64_t bits;
+            memcpy(&bits, &v, sizeof(bits));
+            return htonll(bits);
+        }
+
+        inline void from_wire(uint16_t w, int16_t& v) { v = static_cast<int16_t>(ntohs(w)); }
+        inline void from_wire(uint32_t w, int32_t& v) { v = static_cast<int32_t>(ntohl(w)); }
+        inline void from_wire(uint64_t w, int64_t& v) { v = static_cast<int64_t>(ntohll(w)); }
+        inline void from_wire(uint64_t w, double& v)
+        {
+            uint64_t bits = ntohll(w);
+            memcpy(&v, &bits, sizeof(v));
+        }
+
+        template<typename T>
+        struct wire_of { typedef decltype(to_wire(T())) type; };
+
+        //------------------- write -------------------
+        inline void write_byte(binary_writer& w, int8_t v)
+        {
+            w.write((const char*)&v, 1);
+        }
+
+        template<typename T>
+        inline void write_primitive(binary_writer& w, T v)
+        {
+            auto wv = to_wire(v);
+            w.write((const char*)&wv, static_cast<int>(sizeof(wv)));
+        }
+
+        inline void write_size(binary_writer& w, size_t sz)
+        {
+            write_primitive(w, static_cast<int32_t>(sz));
+        }
+
+        inline void write_field_begin(binary_writer& w, TType type, int16_t id)
+        {
+            char hdr[3];
+            uint16_t wid = to_wire(id);
+            hdr[0] = static_cast<char>(type);
+            memcpy(hdr + 1, &wid, sizeof(wid));
+            w.write(hdr, 3);
+        }
+
+        inline void write_field_stop(binary_writer& w)
+        {
+            write_byte(w, static_cast<int8_t>(::apache::thrift::protocol::T_STOP));
+        }
+
+        inline void write_value(binary_writer& w, bool v) { write_byte(w, v ? 1 : 0); }
+        inline void write_value(binary_writer& w, int8_t v) { write_byte(w, v); }
+        inline void write_value(binary_writer& w, int16_t v) { write_primitive(w, v); }
+        inline void write_value(binary_writer& w, int32_t v) { write_primitive(w, v); }
+        inline void write_value(binary_writer& w, int64_t v) { write_primitive(w, v); }
+        inline void write_value(binary_writer& w, double v) { write_primitive(w, v); }
+
+        inline void write_value(binary_writer& w, const std::string& v)
+        {
+            write_size(w, v.length());
+            if (v.length() > 0)
+                w.write(v.data(), static_cast<int>(v.length()));
+        }
+
+        // large blobs may be appended by reference, see rpc_write_stream
+        inline void write_value(binary_writer& w, const blob& v)
+        {
+            write_size(w, v.length());
+            if (v.length() > 0)
+                w.append(v);
+        }
+
+        // the same as rpc_address::write etc. with TBinaryProtocol
+        inline void write_value(binary_writer& w, const rpc_address& v)
+        {
+            dassert(v.type() == HOST_TYPE_INVALID || v.type() == HOST_TYPE_IPV4,
+                "only invalid or ipv4 can be serialized to binary");
+            write_primitive(w, static_cast<int64_t>(v.c_addr().u.value));
+        }
+
+        inline void write_value(binary_writer& w, const gpid& v)
+        {
+            write_primitive(w, static_cast<int64_t>(v.value()));
+        }
+
+        inline void write_c_string(binary_writer& w, const char* s)
+        {
+            size_t len = strlen(s);
+            write_size(w, len);
+            if (len > 0)
+                w.write(s, static_cast<int>(len));
+        }
+
+        inline void write_value(binary_writer& w, const task_code& v) { write_c_string(w, v.to_string()); }
+        inline void write_value(binary_writer& w, const error_code& v) { write_c_string(w, v.to_string()); }
+
+        template<typename T>
+        inline typename std::enable_if<std::is_enum<T>::value>::type write_value(binary_writer& w, T v)
+        {
+            write_primitive(w, static_cast<int32_t>(v));
+        }
+
+        template<typename T>
+        inline typename std::enable_if<thrift_binary_codec<T>::enabled>::type write_value(binary_writer& w, const T& v)
+        {
+            thrift_binary_codec<T>::write(w, v);
+        }
+
+        template<typename T>
+        inline typename std::enable_if<is_bulk_primitive<T>::value>::type write_elements(binary_writer& w, const std::vector<T>& v)
+        {
+            // convert to the wire format chunk by chunk to save per-element writes
+            typedef typename wire_of<T>::type wire_t;
+            const size_t chunk = 64;
+            wire_t buffer[chunk];
+            for (size_t i = 0; i < v.size(); i += chunk)
+            {
+                size_t n = std::min(chunk, v.size() - i);
+                for (size_t j = 0; j < n; j++)
+                    buffer[j] = to_wire(v[i + j]);
+                w.write((const char*)buffer, static_cast<int>(n * sizeof(wire_t)));
+            }
+        }
+
+        inline void write_elements(binary_writer& w, const std::vector<int8_t>& v)
+        {
+            if (!v.empty())
+                w.write((const char*)v.data(), static_cast<int>(v.size()));
+        }
+
+        inline void write_elements(binary_writer& w, const std::vector<bool>& v)
+        {
+            for (bool e : v)
+                write_value(w, e);
+        }
+
+        template<typename T>
+        inline typename std::enable_if<!is_bulk_primitive<T>::value>::type write_elements(binary_writer& w, const std::vector<T>& v)
+        {
+            for (auto& e : v)
+                write_value(w, e);
+        }
+
+        template<typename T>
+        inline void write_value(binary_writer& w, const std::vector<T>& v)
+        {
+            write_byte(w, static_cast<int8_t>(thrift_type<T>::value));
+            write_size(w, v.size());
+            write_elements(w, v);
+        }
+
+        template<typename T>
+        inline void write_value(binary_writer& w, const std::set<T>& v)
+        {
+            write_byte(w, static_cast<int8_t>(thrift_type<T>::value));
+            write_size(w, v.size());
+            for (auto& e : v)
+                write_value(w, e);
+        }
+
+        template<typename TKey, typename TValue>
+        inline void write_value(binary_writer& w, const std::map<TKey, TValue>& v)
+        {
+            write_byte(w, static_cast<int8_t>(thrift_type<TKey>::value));
+            write_byte(w, static_cast<int8_t>(thrift_type<TValue>::value));
+            write_size(w, v.size());
+            for (auto& kv : v)
+            {
+                write_value(w, kv.first);
+                write_value(w, kv.second);
+            }
+        }
+
+        template<typename T>
+        inline void write_field(binary_writer& w, int16_t id, const T& v)
+        {
+            write_field_begin(w, thrift_type<T>::value, id);
+            write_value(w, v);
+        }
+
+        //------------------- read -------------------
+        inline void ensure_remaining(binary_reader& r, uint64_t sz)
+        {
+            if (sz > static_cast<uint64_t>(r.get_remaining_size()))
+            {
+                throw TTransportException(TTransportException::END_OF_FILE,
+                    "no more data to read after end-of-buffer");
+            }
+        }
+
+        inline void read_bytes(binary_reader& r, void* buffer, size_t sz)
+        {
+            ensure_remaining(r, sz);
+            r.read((char*)buffer, static_cast<int>(sz));
+        }
+
+        inline void skip_bytes(binary_reader& r, size_t sz)
+        {
+            ensure_remaining(r, sz);
+            r.skip(static_cast<int>(sz));
+        }
+
+        inline int8_t read_byte(binary_reader& r)
+        {
+            int8_t v;
+            read_bytes(r, &v, 1);
+            return v;
+        }
+
+        template<typename T>
+        inline void read_primitive(binary_reader& r, T& v)
+        {
+            typename wire_of<T>::type wv;
+            read_bytes(r, &wv, sizeof(wv));
+            from_wire(wv, v);
+        }
+
+        inline uint32_t read_size(binary_reader& r)
+        {
+            int32_t sz;
+            read_primitive(r, sz);
+            if (sz < 0)
+                throw TProtocolException(TProtocolException::NEGATIVE_SIZE);
+            return static_cast<uint32_t>(sz);
+        }
+
+        // return false on the stop field
+        inline bool read_field_begin(binary_reader& r, TType& type, int16_t& id)
+        {
+            type = static_cast<TType>(read_byte(r));
+            if (type == ::apache::thrift::protocol::T_STOP)
+            {
+                id = 0;
+                return false;
+            }
+            read_primitive(r, id);
+            return true;
+        }
+
+        inline void skip(binary_reader& r, TType type, int depth = 0)
+        {
+            if (depth >= max_skip_depth)
+                throw TProtocolException(TProtocolException::DEPTH_LIMIT);
+
+            switch (type)
+            {
+            case ::apache::thrift::protocol::T_BOOL:
+            case ::apache::thrift::protocol::T_BYTE:
+                skip_bytes(r, 1);
+                break;
+            case ::apache::thrift::protocol::T_I16:
+                skip_bytes(r, 2);
+                break;
+            case ::apache::thrift::protocol::T_I32:
+                skip_bytes(r, 4);
+                break;
+            case ::apache::thrift::protocol::T_I64:
+            case ::apache::thrift::protocol::T_DOUBLE:
+                skip_bytes(r, 8);
+                break;
+            case ::apache::thrift::protocol::T_STRING:
+                skip_bytes(r, read_size(r));
+                break;
+            case ::apache::thrift::protocol::T_STRUCT:
+            {
+                TType ftype;
+                int16_t fid;
+                while (read_field_begin(r, ftype, fid))
+                    skip(r, ftype, depth + 1);
+                break;
+            }
+            case ::apache::thrift::protocol::T_MAP:
+            {
+                TType ktype = static_cast<TType>(read_byte(r));
+                TType vtype = static_cast<TType>(read_byte(r));
+                uint32_t sz = read_size(r);
+                for (uint32_t i = 0; i < sz; i++)
+                {
+                    skip(r, ktype, depth + 1);
+                    skip(r, vtype, depth + 1);
+                }
+                break;
+            }
+            case ::apache::thrift::protocol::T_SET:
+            case ::apache::thrift::protocol::T_LIST:
+            {
+                TType etype = static_cast<TType>(read_byte(r));
+                uint32_t sz = read_size(r);
+                for (uint32_t i = 0; i < sz; i++)
+                    skip(r, etype, depth + 1);
+                break;
+            }
+            default:
+                throw TProtocolException(TProtocolException::INVALID_DATA);
+            }
+        }
+
+        inline void read_value(binary_reader& r, bool& v) { v = (read_byte(r) != 0); }
+        inline void read_value(binary_reader& r, int8_t& v) { v = read_byte(r); }
+        inline void read_value(binary_reader& r, int16_t& v) { read_primitive(r, v); }
+        inline void read_value(binary_reader& r, int32_t& v) { read_primitive(r, v); }
+        inline void read_value(binary_reader& r, int64_t& v) { read_primitive(r, v); }
+        inline void read_value(binary_reader& r, double& v) { read_primitive(r, v); }
+
+        inline void read_value(binary_reader& r, std::string& v)
+        {
+            uint32_t sz = read_size(r);
+            ensure_remaining(r, sz);
+            v.resize(sz);
+            if (sz > 0)
+                r.read(&v[0], static_cast<int>(sz));
+        }
+
+        // reference the read buffer without copy when it is shared, see binary_reader_transport::read_blob
+        inline void read_value(binary_reader& r, blob& v)
+        {
+            uint32_t sz = read_size(r);
+            ensure_remaining(r, sz);
+
+            blob remaining = r.get_remaining_buffer();
+            if (remaining.has_holder())
+            {
+                v = remaining.range(0, sz);
+                r.skip(static_cast<int>(sz));
+            }
+            else
+            {
+                // copied into the request arena when there is one
+                v = copy_to_request_blob(remaining.data(), sz);
+                r.skip(static_cast<int>(sz));
+            }
+        }
+
+        inline void read_value(binary_reader& r, rpc_address& v)
+        {
+            int64_t value;
+            read_primitive(r, value);
+            v.c_addr_ptr()->u.value = static_cast<uint64_t>(value);
+            dassert(v.type() == HOST_TYPE_INVALID || v.type() == HOST_TYPE_IPV4,
+                "only invalid or ipv4 can be deserialized from binary");
+        }
+
+        inline void read_value(binary_reader& r, gpid& v)
+        {
+            int64_t value;
+            read_primitive(r, value);
+            v.raw().value = static_cast<uint64_t>(value);
+        }
+
+        inline void read_value(binary_reader& r, task_code& v)
+        {
+            std::string name;
+            read_value(r, name);
+            v = task_code(dsn_task_code_from_string(name.c_str(), TASK_CODE_INVALID));
+        }
+
+        inline void read_value(binary_reader& r, error_code& v)
+        {
+            std::string name;
+            read_value(r, name);
+            v = error_code(dsn_error_from_string(name.c_str(), ERR_UNKNOWN));
+        }
+
+        template<typename T>
+        inline typename std::enable_if<std::is_enum<T>::value>::type read_value(binary_reader& r, T& v)
+        {
+            int32_t value;
+            read_primitive(r, value);
+            v = static_cast<T>(value);
+        }
+
+        template<typename T>
+        inline typename std::enable_if<thrift_binary_codec<T>::enabled>::type read_value(binary_reader& r, T& v)
+        {
+            thrift_binary_codec<T>::read(r, v);
+        }
+
+        // also for the arena_vectors of the view types, see below
+        template<typename T, typename TAlloc>
+        inline typename std::enable_if<is_bulk_primitive<T>::value>::type read_elements(binary_reader& r, std::vector<T, TAlloc>& v, uint32_t sz)
+        {
+            typedef typename wire_of<T>::type wire_t;
+            static_assert(sizeof(wire_t) == sizeof(T), "wire size must be the same as the value size");
+
+            ensure_remaining(r, static_cast<uint64_t>(sz) * sizeof(T));
+
+            // copy in bulk and convert the byte order in place
+            v.resize(sz);
+            if (sz > 0)
+                r.read((char*)v.data(), static_cast<int>(sz * sizeof(T)));
+            for (auto& e : v)
+            {
+                wire_t wv;
+                memcpy(&wv, &e, sizeof(wv));
+                from_wire(wv, e);
+            }
+        }
+
+        inline void read_elements(binary_reader& r, std::vector<int8_t>& v, uint32_t sz)
+        {
+            ensure_remaining(r, sz);
+            v.resize(sz);
+            if (sz > 0)
+                r.read((char*)v.data(), static_cast<int>(sz));
+        }
+
+        inline void read_elements(binary_reader& r, std::vector<bool>& v, uint32_t sz)
+        {
+            v.resize(sz);
+            for (uint32_t i = 0; i < sz; i++)
+                v[i] = (read_byte(r) != 0);
+        }
+
+        template<typename T>
+        inline typename std::enable_if<!is_bulk_primitive<T>::value>::type read_elements(binary_reader& r, std::vector<T>& v, uint32_t sz)
+        {
+            // each element takes at least one byte
+            ensure_remaining(r, sz);
+            v.resize(sz);
+            for (auto& e : v)
+                read_value(r, e);
+        }
+
+        template<typename T>
+        inline void read_value(binary_reader& r, std::vector<T>& v)
+        {
+            v.clear();
+            read_byte(r); // element type
+            uint32_t sz = read_size(r);
+            read_elements(r, v, sz);
+        }
+
+        template<typename T>
+        inline void read_value(binary_reader& r, std::set<T>& v)
+        {
+            v.clear();
+            read_byte(r); // element type
+            uint32_t sz = read_size(r);
+            for (uint32_t i = 0; i < sz; i++)
+            {
+                T e;
+                read_value(r, e);
+                v.insert(std::move(e));
+            }
+        }
+
+        template<typename TKey, typename TValue>
+        inline void read_value(binary_reader& r, std::map<TKey, TValue>& v)
+        {
+            v.clear();
+            read_byte(r); // key type
+            read_byte(r); // value type
+            uint32_t sz = read_size(r);
+            for (uint32_t i = 0; i < sz; i++)
+            {
+                TKey key;
+                read_value(r, key);
+                read_value(r, v[key]);
+            }
+        }
+
+        // read the field if the type matches, or skip it
+        template<typename T>
+        inline bool read_field(binary_reader& r, TType type, T& v)
+        {
+            if (type == thrift_type<T>::value)
+            {
+                read_value(r, v);
+                return true;
+            }
+            else
+            {
+                skip(r, type);
+                return false;
+            }
+        }
+
+        //------------------- views -------------------
+        //
+        // compile_thrift.py also generates a view type <name>_view for each struct, which
+        // is decoded by thrift_binary_codec< <name>_view> (there is no write) without heap
+        // allocations when there is a request arena (see request_arena):
+        // - string and binary fields are blobs, which reference the request message when
+        //   it is shared, or are copied into the current request arena (see read_value(blob&)),
+        //   and <field>_view() returns them as string_view; either way they pin the memory
+        //   they reference, see detach_request_blob for the handlers which keep them
+        // - list<T> and set<T> are arena_vector<T>, and map<K, V> is
+        //   arena_vector<std::pair<K, V> >, all in the wire order
+        // - struct fields are the views of the structs
+        // the containers live in the arena given to the view constructor, which defaults to
+        // the current request arena, or on the heap when there is none
+        //
+        template<typename T>
+        inline void read_value(binary_reader& r, arena_vector<T>& v);
+
+        template<typename TKey, typename TValue>
+        inline void read_value(binary_reader& r, arena_vector<std::pair<TKey, TValue> >& v);
+
+        template<typename TKey, typename TValue>
+        inline void read_value(binary_reader& r, std::pair<TKey, TValue>& v);
+
+        // the elements of arena_vectors, so that the nested views and containers use
+        // the same arena
+        template<typename T, typename = void>
+        struct arena_element
+        {
+            static T make(request_arena*) { return T(); }
+        };
+
+        template<typename T>
+        struct arena_element<T, typename std::enable_if<std::is_class<T>::value && std::is_constructible<T, request_arena*>::value>::type>
+        {
+            static T make(request_arena* arena) { return T(arena); }
+        };
+
+        template<typename T>
+        struct arena_element<arena_vector<T>, void>
+        {
+            static arena_vector<T> make(request_arena* arena) { return arena_vector<T>(arena_allocator<T>(arena)); }
+        };
+
+        template<typename TKey, typename TValue>
+        struct arena_element<std::pair<TKey, TValue>, void>
+        {
+            static std::pair<TKey, TValue> make(request_arena* arena)
+            {
+                return std::pair<TKey, TValue>(arena_element<TKey>::make(arena), arena_element<TValue>::make(arena));
+            }
+        };
+
+        inline void read_elements(binary_reader& r, arena_vector<int8_t>& v, uint32_t sz)
+        {
+            ensure_remaining(r, sz);
+            v.resize(sz);
+            if (sz > 0)
+                r.read((char*)v.data(), static_cast<int>(sz));
+        }
+
+        inline void read_elements(binary_reader& r, arena_vector<bool>& v, uint32_t sz)
+        {
+            ensure_remaining(r, sz);
+            v.resize(sz);
+            for (uint32_t i = 0; i < sz; i++)
+                v[i] = (read_byte(r) != 0);
+        }
+
+        template<typename T>
+        inline typename std::enable_if<!is_bulk_primitive<T>::value>::type read_elements(binary_reader& r, arena_vector<T>& v, uint32_t sz)
+        {
+            // each element takes at least one byte
+            ensure_remaining(r, sz);
+            request_arena* arena = v.get_allocator().arena();
+            v.reserve(sz);
+            for (uint32_t i = 0; i < sz; i++)
+            {
+                v.push_back(arena_element<T>::make(arena));
+                read_value(r, v.back());
+            }
+        }
+
+        // for both list<T> and set<T>
+        template<typename T>
+        inline void read_value(binary_reader& r, arena_vector<T>& v)
+        {
+            v.clear();
+            read_byte(r); // element type
+            uint32_t sz = read_size(r);
+            read_elements(r, v, sz);
+        }
+
+        template<typename TKey, typename TValue>
+        inline void read_value(binary_reader& r, arena_vector<std::pair<TKey, TValue> >& v)
+        {
+            v.clear();
+            read_byte(r); // key type
+            read_byte(r); // value type
+            uint32_t sz = read_size(r);
+            read_elements(r, v, sz);
+        }
+
+        template<typename TKey, typename TValue>
+        inline void read_value(binary_reader& r, std::pair<TKey, TValue>& v)
+        {
+            read_value(r, v.first);
+            read_value(r, v.second);
+        }
+
+        // read the field if the type matches the given one, or skip it, as the wire types
+        // of the view fields cannot be told from their types (e.g., list and set)
+        template<typename T>
+        inline bool read_field_as(binary_reader& r, TType type, TType expected, T& v)
+        {
+            if (type == expected)
+            {
+                read_value(r, v);
+                return true;
+            }
+            else
+            {
+                skip(r, type);
+                return false;
+            }
+        }
+
+        //------------------- marshall -------------------
+        // the same envelope as marshall_thrift_internal, i.e., a struct with the value as field 0
+        template<typename T>
+        inline void marshall(binary_writer& w, const T& v)
+        {
+            write_field_begin(w, ::apache::thrift::protocol::T_STRUCT, 0);
+            thrift_binary_codec<T>::write(w, v);
+            write_field_stop(w);
+        }
+
+        template<typename T>
+        inline void unmarshall(binary_reader& r, /*out*/ T& v)
+        {
+            TType type;
+            int16_t id;
+            read_field_begin(r, type, id);
+            thrift_binary_codec<T>::read(r, v);
+            read_field_begin(r, type, id);
+        }
+    }
+}
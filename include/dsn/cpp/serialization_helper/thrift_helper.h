@@ -38,9 +38,11 @@
 
 # include <dsn/cpp/rpc_stream.h>
 # include <dsn/cpp/address.h>
+# include <dsn/cpp/serialization_helper/thrift_binary_codec.h>
 
 # include <thrift/Thrift.h>
 # include <thrift/protocol/TBinaryProtocol.h>
+# include <thrift/protocol/TCompactProtocol.h>
 # include <thrift/protocol/TJSONProtocol.h>
 # include <thrift/protocol/TVirtualProtocol.h>
 # include <thrift/transport/TVirtualTransport.h>
@@ -75,6 +77,30 @@ namespace dsn {
             return (uint32_t)l;
         }
 
+        // read len bytes as a blob, which references the read buffer without copy
+        // when the buffer is shared (e.g., large messages, see rpc_read_stream)
+        void read_blob(/*out*/ blob& bb, uint32_t len)
+        {
+            if (static_cast<int>(len) > _reader.get_remaining_size())
+            {
+                throw TTransportException(TTransportException::END_OF_FILE,
+                    "no more data to read after end-of-buffer");
+            }
+
+            blob remaining = _reader.get_remaining_buffer();
+            if (remaining.has_holder())
+            {
+                bb = remaining.range(0, len);
+                _reader.skip(static_cast<int>(len));
+            }
+            else
+            {
+                // copied into the request arena when there is one
+                bb = copy_to_request_blob(remaining.data(), len);
+                _reader.skip(static_cast<int>(len));
+            }
+        }
+
     private:
         binary_reader& _reader;
     };
@@ -98,6 +124,13 @@ namespace dsn {
             _writer.write((const char*)buf, static_cast<int>(len));
         }
 
+        // write the blob content, which may be appended by reference without copy
+        // when the writer is on top of a message (see rpc_write_stream)
+        void write_blob(const blob& bb)
+        {
+            _writer.append(bb);
+        }
+
     private:
         binary_writer& _writer;
     };
@@ -505,15 +538,52 @@ namespace dsn {
 
     inline uint32_t blob::read(apache::thrift::protocol::TProtocol *iprot)
     {
-        //for optimization, it is dangerous if the oprot is not a binary proto
-        apache::thrift::protocol::TBinaryProtocol* binary_proto = static_cast<apache::thrift::protocol::TBinaryProtocol*>(iprot);
+        apache::thrift::protocol::TBinaryProtocol* binary_proto = dynamic_cast<apache::thrift::protocol::TBinaryProtocol*>(iprot);
+        if (binary_proto == nullptr)
+        {
+            // other protocols (e.g., json and compact) have their own binary encodings
+            std::string str;
+            uint32_t xfer = iprot->readBinary(str);
+            blob_string(*this).assign(str.data(), str.length());
+            return xfer;
+        }
+
+        // zero-copy when reading from a message
+        auto trans = dynamic_cast< ::dsn::binary_reader_transport*>(binary_proto->getTransport().get());
+        if (trans != nullptr)
+        {
+            int32_t size;
+            uint32_t xfer = binary_proto->readI32(size);
+            if (size < 0)
+            {
+                throw ::apache::thrift::protocol::TProtocolException(::apache::thrift::protocol::TProtocolException::NEGATIVE_SIZE);
+            }
+            trans->read_blob(*this, static_cast<uint32_t>(size));
+            return xfer + static_cast<uint32_t>(size);
+        }
+
         blob_string str(*this);
         return binary_proto->readString<blob_string>(str);
     }
 
     inline uint32_t blob::write(apache::thrift::protocol::TProtocol *oprot) const
     {
-        apache::thrift::protocol::TBinaryProtocol* binary_proto = static_cast<apache::thrift::protocol::TBinaryProtocol*>(oprot);
+        apache::thrift::protocol::TBinaryProtocol* binary_proto = dynamic_cast<apache::thrift::protocol::TBinaryProtocol*>(oprot);
+        if (binary_proto == nullptr)
+        {
+            return oprot->writeBinary(_length > 0 ? std::string(_data, _length) : std::string());
+        }
+
+        // zero-copy for large blobs when writing to a message
+        auto trans = dynamic_cast< ::dsn::binary_writer_transport*>(binary_proto->getTransport().get());
+        if (trans != nullptr)
+        {
+            uint32_t xfer = binary_proto->writeI32(static_cast<int32_t>(_length));
+            if (_length > 0)
+                trans->write_blob(*this);
+            return xfer + _length;
+        }
+
         return binary_proto->writeString<blob_string>(blob_string(const_cast<blob&>(*this)));
     }
 
@@ -726,7 +796,7 @@ namespace dsn {
     }
 
     template<typename T>
-    inline void marshall_thrift_binary(binary_writer& writer, const T& val)
+    inline void marshall_thrift_binary_protocol(binary_writer& writer, const T& val)
     {
         ::dsn::binary_writer_transport trans(writer);
         boost::shared_ptr< ::dsn::binary_writer_transport> transport(&trans, [](::dsn::binary_writer_transport*) {});
@@ -735,6 +805,29 @@ namespace dsn {
         proto.getTransport()->flush();
     }
 
+    // the generated codec (see thrift_binary_codec) encodes the same bytes as TBinaryProtocol
+    template<typename T>
+    inline typename std::enable_if<thrift_binary_codec<T>::enabled>::type marshall_thrift_binary(binary_writer& writer, const T& val)
+    {
+        thrift_binary::marshall(writer, val);
+    }
+
+    template<typename T>
+    inline typename std::enable_if<!thrift_binary_codec<T>::enabled>::type marshall_thrift_binary(binary_writer& writer, const T& val)
+    {
+        marshall_thrift_binary_protocol(writer, val);
+    }
+
+    template<typename T>
+    inline void marshall_thrift_compact(binary_writer& writer, const T& val)
+    {
+        ::dsn::binary_writer_transport trans(writer);
+        boost::shared_ptr< ::dsn::binary_writer_transport> transport(&trans, [](::dsn::binary_writer_transport*) {});
+        ::apache::thrift::protocol::TCompactProtocol proto(transport);
+        marshall_thrift_internal(val, &proto);
+        proto.getTransport()->flush();
+    }
+
     template<typename T>
     inline void marshall_thrift_json(binary_writer& writer, const T& val)
     {
@@ -746,7 +839,7 @@ namespace dsn {
     }
 
     template<typename T>
-    inline void unmarshall_thrift_binary(binary_reader& reader, T &val)
+    inline void unmarshall_thrift_binary_protocol(binary_reader& reader, T &val)
     {
         ::dsn::binary_reader_transport trans(reader);
         boost::shared_ptr< ::dsn::binary_reader_transport> transport(&trans, [](::dsn::binary_reader_transport*) {});
@@ -754,6 +847,27 @@ namespace dsn {
         unmarshall_thrift_internal(val, &proto);
     }
 
+    template<typename T>
+    inline typename std::enable_if<thrift_binary_codec<T>::enabled>::type unmarshall_thrift_binary(binary_reader& reader, T &val)
+    {
+        thrift_binary::unmarshall(reader, val);
+    }
+
+    template<typename T>
+    inline typename std::enable_if<!thrift_binary_codec<T>::enabled>::type unmarshall_thrift_binary(binary_reader& reader, T &val)
+    {
+        unmarshall_thrift_binary_protocol(reader, val);
+    }
+
+    template<typename T>
+    inline void unmarshall_thrift_compact(binary_reader& reader, T &val)
+    {
+        ::dsn::binary_reader_transport trans(reader);
+        boost::shared_ptr< ::dsn::binary_reader_transport> transport(&trans, [](::dsn::binary_reader_transport*) {});
+        ::apache::thrift::protocol::TCompactProtocol proto(transport);
+        unmarshall_thrift_internal(val, &proto);
+    }
+
     template<typename T>
     inline void unmarshall_thrift_json(binary_reader& reader, T &val)
     {
@@ -0,0 +1,95 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+/*
+ * Description:
+ *     non-owning view of a character range
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# pragma once
+
+# include <dsn/cpp/blob.h>
+# include <cstddef>
+# include <cstring>
+# include <ostream>
+# include <string>
+
+namespace dsn
+{
+    //
+    // string_view references the characters of a string, a blob or a plain buffer without
+    // owning them (e.g., the string fields of the thrift view types, see thrift_binary_codec),
+    // so it is only valid while the referenced memory is; use to_string() to keep a copy
+    //
+    class string_view
+    {
+    public:
+        typedef const char* const_iterator;
+
+        string_view() : _data(nullptr), _length(0) {}
+        string_view(const char* data, size_t length) : _data(data), _length(length) {}
+        string_view(const char* s) : _data(s), _length(s == nullptr ? 0 : strlen(s)) {}
+        string_view(const std::string& s) : _data(s.data()), _length(s.length()) {}
+        string_view(const blob& b) : _data(b.data()), _length(b.length()) {}
+
+        const char* data() const { return _data; }
+        size_t size() const { return _length; }
+        size_t length() const { return _length; }
+        bool empty() const { return _length == 0; }
+
+        const_iterator begin() const { return _data; }
+        const_iterator end() const { return _data + _length; }
+        char operator [] (size_t i) const { return _data[i]; }
+
+        std::string to_string() const { return _length == 0 ? std::string() : std::string(_data, _length); }
+
+        int compare(string_view r) const
+        {
+            size_t n = _length < r._length ? _length : r._length;
+            int c = n == 0 ? 0 : memcmp(_data, r._data, n);
+            if (c != 0)
+                return c;
+            return _length < r._length ? -1 : (_length > r._length ? 1 : 0);
+        }
+
+    private:
+        const char* _data;
+        size_t      _length;
+    };
+
+    // not members, so that both sides convert, e.g., std::string == string_view
+    inline bool operator == (string_view l, string_view r) { return l.length() == r.length() && l.compare(r) == 0; }
+    inline bool operator != (string_view l, string_view r) { return !(l == r); }
+    inline bool operator < (string_view l, string_view r) { return l.compare(r) < 0; }
+
+    inline std::ostream& operator << (std::ostream& os, string_view s)
+    {
+        return os.write(s.data(), static_cast<std::streamsize>(s.size()));
+    }
+}
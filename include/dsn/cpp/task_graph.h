@@ -0,0 +1,416 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     task dependency graph (DAG) over lpc, aio and rpc tasks
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# pragma once
+
+# include <dsn/cpp/clientlet.h>
+# include <dsn/cpp/perf_counter_.h>
+# include <dsn/cpp/inline_function.h>
+# include <dsn/utility/autoref_ptr.h>
+# include <dsn/utility/synchronize.h>
+# include <algorithm>
+# include <atomic>
+# include <memory>
+# include <mutex>
+# include <string>
+# include <vector>
+
+namespace dsn
+{
+    /*!
+    @addtogroup tasking
+    @{
+    */
+
+    //
+    // critical path statistics of a kind of task graphs, recorded as perf counters
+    // in the "profiler" section together with the task profiling counters:
+    //   <name>.critical_path(ns): time of the nodes on the critical path, i.e., execution
+    //       time for lpc nodes, and from issue to completion for aio/rpc nodes
+    //   <name>.latency(ns): from run() to the completion of the last node, the
+    //       difference from the above is the time spent in queues and networks
+    // it should live longer than the graphs using it, e.g., as a member of the app
+    //
+    class task_graph_profile
+    {
+    public:
+        void init(const char* graph_name)
+        {
+            std::string name(graph_name);
+            _critical_path_ns.init("profiler", (name + ".critical_path(ns)").c_str(),
+                COUNTER_TYPE_NUMBER_PERCENTILES, "execution time of the nodes on the critical path of the task graph");
+            _latency_ns.init("profiler", (name + ".latency(ns)").c_str(),
+                COUNTER_TYPE_NUMBER_PERCENTILES, "latency of the task graph");
+        }
+
+        void record(uint64_t critical_path_ns, uint64_t latency_ns)
+        {
+            _critical_path_ns.set(critical_path_ns);
+            _latency_ns.set(latency_ns);
+        }
+
+    private:
+        perf_counter_ _critical_path_ns;
+        perf_counter_ _latency_ns;
+    };
+
+    //
+    // nodes are lpc, aio or rpc tasks, and edges are dependencies; each node is
+    // launched as soon as all its dependencies complete, so independent stages
+    // overlap, e.g.,
+    //
+    //    task_graph_ptr g(new task_graph("compaction", &_compaction_profile));
+    //    auto r1 = g->add_aio_read("read1", fh1, buf1, sz, 0, LPC_AIO_DONE);
+    //    auto r2 = g->add_aio_read("read2", fh2, buf2, sz, 0, LPC_AIO_DONE);
+    //    auto m = g->add_lpc("merge", LPC_MERGE, [&]() { merge(buf1, buf2, out); });
+    //    auto w = g->add_aio_write("write", fh3, out, sz, 0, LPC_AIO_DONE);
+    //    g->add_dependency(m, r1);
+    //    g->add_dependency(m, r2);
+    //    g->add_dependency(w, m);
+    //    g->run([](error_code err) { ... });
+    //
+    // when a node fails, its (transitive) successors are not launched and complete
+    // with the same error, and the graph completes with the first error;
+    // nodes and dependencies must be added before run(), and a graph runs only once;
+    // a graph must be allocated on the heap and held by task_graph_ptr, as the
+    // pending nodes keep references to it
+    //
+    class task_graph : public ref_counter
+    {
+    public:
+        typedef int node_id;
+
+        // async nodes complete by calling it exactly once
+        class completion
+        {
+        public:
+            completion(task_graph* g, node_id id) : _graph(g), _id(id) {}
+            void operator()(error_code err) const { _graph->on_node_done(_id, err); }
+            node_id id() const { return _id; }
+
+        private:
+            ref_ptr<task_graph> _graph;
+            node_id             _id;
+        };
+
+        typedef inline_function<void(const completion&)> launcher;
+        typedef inline_function<void(error_code)>        graph_callback;
+
+    public:
+        explicit task_graph(const char* name, task_graph_profile* profile = nullptr)
+            : _name(name), _profile(profile), _remaining(0), _started(false),
+            _start_ts_ns(0), _latency_ns(0), _critical_path_ns(0)
+        {
+        }
+
+        // lpc node, completes when fn returns
+        template<typename TFunction>
+        node_id add_lpc(const char* name, dsn_task_code_t code, TFunction&& fn, int hash = 0)
+        {
+            auto body = std::make_shared<typename std::decay<TFunction>::type>(std::forward<TFunction>(fn));
+            return add_node(name, [this, code, hash, body](const completion& done)
+            {
+                tasking::enqueue(code, nullptr, [this, body, done]()
+                {
+                    _nodes[done.id()]->start_ts_ns = dsn_now_ns();
+                    (*body)();
+                    done(ERR_OK);
+                }, hash);
+            });
+        }
+
+        // generic async node, launch(done) starts the work, and done(err) must be
+        // called once when the work completes, e.g., in an rpc response callback
+        node_id add_async(const char* name, launcher&& launch)
+        {
+            return add_node(name, std::move(launch));
+        }
+
+        // aio nodes, the buffers must be valid until the nodes complete
+        node_id add_aio_read(const char* name, dsn_handle_t fh, char* buffer, int count, uint64_t offset,
+            dsn_task_code_t callback_code, int hash = 0)
+        {
+            return add_node(name, [=](const completion& done)
+            {
+                file::read(fh, buffer, count, offset, callback_code, nullptr,
+                    [done](error_code err, size_t) { done(err); }, hash);
+            });
+        }
+
+        node_id add_aio_write(const char* name, dsn_handle_t fh, const char* buffer, int count, uint64_t offset,
+            dsn_task_code_t callback_code, int hash = 0)
+        {
+            return add_node(name, [=](const completion& done)
+            {
+                file::write(fh, buffer, count, offset, callback_code, nullptr,
+                    [done](error_code err, size_t) { done(err); }, hash);
+            });
+        }
+
+        // rpc node, completes after callback(err, request, response) returns; the request
+        // is sent when the node is launched
+        template<typename TCallback>
+        node_id add_rpc_call(const char* name, ::dsn::rpc_address server, dsn_message_t request,
+            TCallback&& callback, int reply_thread_hash = 0)
+        {
+            auto cb = std::make_shared<typename std::decay<TCallback>::type>(std::forward<TCallback>(callback));
+            return add_node(name, [=](const completion& done)
+            {
+                rpc::call(server, request, nullptr, [cb, done](error_code err, dsn_message_t req, dsn_message_t resp)
+                {
+                    (*cb)(err, req, resp);
+                    done(err);
+                }, reply_thread_hash);
+            });
+        }
+
+        // node 'to' is launched after node 'from' completes
+        void add_dependency(node_id to, node_id from)
+        {
+            dassert(!_started, "cannot add dependencies to graph %s after it is started", _name.c_str());
+            dassert(to != from && valid(to) && valid(from), "invalid dependency %d -> %d", from, to);
+            _nodes[from]->successors.push_back(to);
+            _nodes[to]->predecessors.push_back(from);
+            _nodes[to]->pending_inputs++;
+        }
+
+        // callback is executed on the thread completing the last node
+        void run(graph_callback&& callback = nullptr)
+        {
+            dassert(!_started, "task graph %s can only run once", _name.c_str());
+            dassert(is_acyclic(), "task graph %s has cycles", _name.c_str());
+
+            _started = true;
+            _callback = std::move(callback);
+            _remaining.store(static_cast<int>(_nodes.size()), std::memory_order_relaxed);
+            _start_ts_ns = dsn_now_ns();
+
+            if (_nodes.empty())
+            {
+                complete();
+                return;
+            }
+
+            std::vector<node_id> roots;
+            for (auto& n : _nodes)
+            {
+                if (n->pending_inputs.load(std::memory_order_relaxed) == 0)
+                    roots.push_back(n->id);
+            }
+
+            for (auto id : roots)
+                launch(id, ERR_OK);
+        }
+
+        void wait()
+        {
+            _done.wait();
+            _done.notify(); // so that wait() can be called again
+        }
+
+        // valid after completion
+        error_code error() const { return _error; }
+        const std::vector<node_id>& critical_path() const { return _critical_path; }
+        uint64_t critical_path_ns() const { return _critical_path_ns; }
+        uint64_t latency_ns() const { return _latency_ns; }
+        const char* node_name(node_id id) const { return _nodes[id]->name.c_str(); }
+        size_t node_count() const { return _nodes.size(); }
+
+    private:
+        struct node
+        {
+            node_id              id;
+            std::string          name;
+            launcher             launch;
+            std::vector<node_id> successors;
+            std::vector<node_id> predecessors;
+            std::atomic<int>     pending_inputs;
+            error_code           input_error;   // first error of the inputs
+            uint64_t             start_ts_ns;
+            uint64_t             end_ts_ns;
+
+            node() : pending_inputs(0), start_ts_ns(0), end_ts_ns(0) {}
+        };
+
+        bool valid(node_id id) const { return id >= 0 && id < static_cast<int>(_nodes.size()); }
+
+        node_id add_node(const char* name, launcher&& launch)
+        {
+            dassert(!_started, "cannot add nodes to graph %s after it is started", _name.c_str());
+            std::unique_ptr<node> n(new node());
+            n->id = static_cast<node_id>(_nodes.size());
+            n->name = name;
+            n->launch = std::move(launch);
+            _nodes.push_back(std::move(n));
+            return _nodes.back()->id;
+        }
+
+        void launch(node_id id, error_code input_error)
+        {
+            auto& n = *_nodes[id];
+            n.start_ts_ns = dsn_now_ns();
+            if (input_error != ERR_OK)
+                on_node_done(id, input_error);
+            else
+                n.launch(completion(this, id));
+        }
+
+        void on_node_done(node_id id, error_code err)
+        {
+            auto& n = *_nodes[id];
+            dassert(n.end_ts_ns == 0, "node %s of task graph %s completes more than once",
+                n.name.c_str(), _name.c_str());
+            n.end_ts_ns = dsn_now_ns();
+
+            if (err != ERR_OK)
+            {
+                std::lock_guard<std::mutex> l(_lock);
+                if (_error == ERR_OK)
+                    _error = err;
+            }
+
+            for (auto s : n.successors)
+            {
+                auto& succ = *_nodes[s];
+                if (err != ERR_OK)
+                {
+                    std::lock_guard<std::mutex> l(_lock);
+                    if (succ.input_error == ERR_OK)
+                        succ.input_error = err;
+                }
+
+                if (succ.pending_inputs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    error_code input_error;
+                    {
+                        std::lock_guard<std::mutex> l(_lock);
+                        input_error = succ.input_error;
+                    }
+                    launch(s, input_error);
+                }
+            }
+
+            if (_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                complete();
+        }
+
+        // walk back from the last completed node through the inputs completed last
+        void complete()
+        {
+            ref_ptr<task_graph> hold(this); // the callback may release the graph
+            uint64_t now = dsn_now_ns();
+            _latency_ns = now - _start_ts_ns;
+            _critical_path_ns = 0;
+            _critical_path.clear();
+
+            node_id last = -1;
+            for (auto& n : _nodes)
+            {
+                if (last == -1 || n->end_ts_ns > _nodes[last]->end_ts_ns)
+                    last = n->id;
+            }
+
+            while (last != -1)
+            {
+                auto& n = *_nodes[last];
+                _critical_path.push_back(last);
+                _critical_path_ns += n.end_ts_ns - n.start_ts_ns;
+
+                node_id prev = -1;
+                for (auto p : n.predecessors)
+                {
+                    if (prev == -1 || _nodes[p]->end_ts_ns > _nodes[prev]->end_ts_ns)
+                        prev = p;
+                }
+                last = prev;
+            }
+            std::reverse(_critical_path.begin(), _critical_path.end());
+
+            if (_profile)
+                _profile->record(_critical_path_ns, _latency_ns);
+
+            if (_callback)
+                _callback(_error);
+
+            _done.notify();
+        }
+
+        bool is_acyclic() const
+        {
+            std::vector<int> inputs(_nodes.size());
+            std::vector<node_id> ready;
+            for (auto& n : _nodes)
+            {
+                inputs[n->id] = static_cast<int>(n->predecessors.size());
+                if (inputs[n->id] == 0)
+                    ready.push_back(n->id);
+            }
+
+            size_t visited = 0;
+            while (!ready.empty())
+            {
+                auto id = ready.back();
+                ready.pop_back();
+                visited++;
+                for (auto s : _nodes[id]->successors)
+                {
+                    if (--inputs[s] == 0)
+                        ready.push_back(s);
+                }
+            }
+            return visited == _nodes.size();
+        }
+
+    private:
+        std::string                         _name;
+        task_graph_profile*                 _profile;
+        std::vector<std::unique_ptr<node>>  _nodes;
+        std::atomic<int>                    _remaining;
+        bool                                _started;
+        std::mutex                          _lock;
+        error_code                          _error;
+        graph_callback                      _callback;
+        utils::notify_event                 _done;
+
+        uint64_t                            _start_ts_ns;
+        uint64_t                            _latency_ns;
+        uint64_t                            _critical_path_ns;
+        std::vector<node_id>                _critical_path;
+    };
+
+    typedef ref_ptr<task_graph> task_graph_ptr;
+
+    /*@}*/
+}
@@ -45,6 +45,7 @@
 # include <dsn/utility/synchronize.h>
 # include <dsn/utility/link.h>
 # include <dsn/cpp/callocator.h>
+# include <dsn/cpp/inline_function.h>
 # include <set>
 # include <map>
 # include <thread>
@@ -272,8 +273,10 @@ namespace dsn
             return r;
         }
 
+        // binder: THandler& => callable without arguments
+        template<typename TBinder>
         void bind_and_enqueue(
-            std::function<std::function<void()> (THandler&)> binder,
+            TBinder&& binder,
             int delay_milliseconds = 0
             )
         {
@@ -297,8 +300,8 @@ namespace dsn
         }
 
     private:
-        std::function<void()> _bound_handler;
-        THandler              _handler;
+        inline_function<void()> _bound_handler;
+        THandler                _handler;
     };
 
     // ------- inlined implementation ----------
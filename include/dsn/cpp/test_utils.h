@@ -39,6 +39,7 @@
 # include <dsn/service_api_cpp.h>
 # include <dsn/tool-api/task.h>
 # include <dsn/tool-api/task_worker.h>
+# include <dsn/cpp/request_arena.h>
 # include <gtest/gtest.h>
 # include <iostream>
 
@@ -57,12 +58,15 @@ DEFINE_TASK_CODE_RPC(RPC_TEST_HASH2, TASK_PRIORITY_COMMON, THREAD_POOL_TEST_SERV
 DEFINE_TASK_CODE_RPC(RPC_TEST_HASH3, TASK_PRIORITY_COMMON, THREAD_POOL_TEST_SERVER)
 DEFINE_TASK_CODE_RPC(RPC_TEST_HASH4, TASK_PRIORITY_COMMON, THREAD_POOL_TEST_SERVER)
 DEFINE_TASK_CODE_RPC(RPC_TEST_STRING_COMMAND, TASK_PRIORITY_COMMON, THREAD_POOL_TEST_SERVER)
+DEFINE_TASK_CODE_RPC(RPC_TEST_ARENA, TASK_PRIORITY_COMMON, THREAD_POOL_TEST_SERVER)
 
 DEFINE_TASK_CODE_AIO(LPC_AIO_TEST, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
 DEFINE_TASK_CODE(LPC_TEST_HASH, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
 DEFINE_TASK_CODE_AIO(LPC_AIO_TEST_READ, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
 DEFINE_TASK_CODE_AIO(LPC_AIO_TEST_WRITE, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
 DEFINE_TASK_CODE_AIO(LPC_AIO_TEST_NFS, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
+DEFINE_TASK_CODE_AIO(LPC_AIO_TEST_FLUSH, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
+DEFINE_TASK_CODE_AIO(LPC_AIO_TEST_BATCH, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
 
 extern void run_all_unit_tests_when_necessary();
 
@@ -82,6 +86,18 @@ public:
         replier(std::move(r));
     }
 
+    // rpc_request_arena_enabled is set for RPC_TEST_ARENA in the test config
+    void on_rpc_arena_test(const ::dsn::blob& data, ::dsn::rpc_replier<std::string>& replier)
+    {
+        auto arena = ::dsn::request_arena::current();
+        if (arena == nullptr)
+            replier(std::string("no arena"));
+        else if (arena->allocated_bytes() < data.length())
+            replier(std::string("not in arena"));
+        else
+            replier(std::string(data.data(), data.length()));
+    }
+
     void on_rpc_string_test(dsn_message_t message) {
         std::string command;
         ::dsn::unmarshall(message, command);
@@ -125,6 +141,7 @@ public:
             register_async_rpc_handler(RPC_TEST_HASH4, "rpc.test.hash4", &test_client::on_rpc_test);
 
             register_rpc_handler(RPC_TEST_STRING_COMMAND, "rpc.test.string.command", &test_client::on_rpc_string_test);
+            register_async_rpc_handler(RPC_TEST_ARENA, "rpc.test.arena", &test_client::on_rpc_arena_test);
         }
 
         // client
@@ -51,7 +51,15 @@ public:
     admission_controller(task_queue* q, std::vector<std::string>& sargs) : _queue(q) {}
     virtual ~admission_controller() {}
     
+    // called for rpc requests before they are put into the bound queue,
+    // and the rejected ones are replied with ERR_BUSY
     virtual bool is_task_accepted(task* task) = 0;
+
+    // called by the workers right before and after executing a task from the bound
+    // queue (the task is still valid in both), or only on_task_end when the queue
+    // drops a task without executing it
+    virtual void on_task_begin(task* task) {}
+    virtual void on_task_end(task* task) {}
         
     task_queue* bound_queue() const { return _queue; }
     
@@ -73,15 +73,36 @@ public:
     virtual ~aio_provider() {}
     DSN_API service_node* node() const;
 
+    // the provider of the disk engine of the current thread, nullptr if there is none
+    DSN_API static aio_provider* get_current();
+
     // return DSN_INVALID_FILE_HANDLE if failed
     virtual dsn_handle_t open(const char* file_name, int flag, int pmode) = 0;
     virtual error_code   close(dsn_handle_t fh) = 0;
     virtual error_code   flush(dsn_handle_t fh) = 0;
     virtual void         aio(aio_task* aio) = 0;
+
+    // flush the file data and only the metadata needed for reading it back (e.g., fdatasync)
+    virtual error_code   flush_data(dsn_handle_t fh) { return flush(fh); }
+
+    // start writing back the dirty pages in the range without waiting for them (e.g.,
+    // sync_file_range), so that the later flush has less to do
+    virtual void         writeback_hint(dsn_handle_t fh, uint64_t offset, uint64_t size) {}
+
     virtual disk_aio*    prepare_aio_context(aio_task*) = 0;
 
     virtual void start(io_modifer& ctx) = 0;
 
+    // whether aio() writes the scattered buffers in aio_task::_unmerged_write_buffers
+    // directly (e.g., with pwritev), otherwise the disk engine merges them into
+    // disk_aio::buffer before calling aio()
+    virtual bool vectored_write_supported() const { return false; }
+
+    // the transient memory blocks holding message and batched write buffers are reported
+    // when they are allocated from and before they are returned to the heap, e.g., for
+    // registering them to the kernel as fixed io buffers
+    virtual void on_transient_block(void* ptr, size_t size, bool allocated) {}
+
 protected:
     DSN_API void complete_io(aio_task* aio, error_code err, uint32_t bytes, int delay_milliseconds = 0);
 
@@ -44,6 +44,7 @@
 # include <dsn/cpp/address.h>
 # include <dsn/cpp/blob.h>
 # include <dsn/cpp/safe_string.h>
+# include <dsn/cpp/inline_vector.h>
 # include <dsn/utility/link.h>
 # include <dsn/tool-api/global_config.h>
 
@@ -99,14 +100,18 @@ namespace dsn
         } server;
     } message_header;
 
+    class message_memory_budget;
+
     class message_ex :
         public ref_counter, 
-        public extensible_object<message_ex, 4>,
-        public transient_object
+        public extensible_object<message_ex, 4>
     {
     public:
+        // most messages have one or two buffers (e.g., header + body)
+        typedef inline_vector<blob, 2> buffer_list;
+
         message_header         *header;
-        safe_vector<blob>      buffers; // header included for *send* message, 
+        buffer_list            buffers; // header included for *send* message, 
                                         // header not included for *recieved*
 
         // by rpc and network
@@ -120,10 +125,18 @@ namespace dsn
         // by message queuing
         dlink                  dl;
 
+        // by memory accounting, see message_memory_budget
+        message_memory_budget  *budget;
+        uint32_t               budget_bytes;
+
     public:        
         //message_ex(blob bb, bool parse_hdr = true); // read 
         DSN_API ~message_ex();
 
+        // message_ex objects are allocated from a slab pool, see slab_pool.h
+        DSN_API static void* operator new(size_t size);
+        DSN_API static void operator delete(void* p, size_t size);
+
         //
         // utility routines
         //
@@ -67,6 +67,7 @@ class disk_engine;
 class env_provider;
 class nfs_node;
 class timer_service;
+class request_arena;
 class task;
 
 struct __tls_dsn__
@@ -289,26 +290,40 @@ struct rpc_handler_info
 };
 
 class service_node;
-class rpc_request_task : public task, public transient_object
+class rpc_request_task : public task
 {
 public:
     rpc_request_task(message_ex* request, rpc_handler_info* h, service_node* node);
     ~rpc_request_task();
 
+    // allocated from a slab pool, see slab_pool.h
+    DSN_API static void* operator new(size_t size);
+    DSN_API static void operator delete(void* p, size_t size);
+
     message_ex*  get_request() const { return _request; }
+    uint64_t     enqueue_ts_ns() const { return _enqueue_ts_ns; }
 
     DSN_API void enqueue() override;
 
     void  exec() override
     {
-        if (0 == _enqueue_ts_ns
+        if (!spec().rpc_request_dropped_before_execution_when_timeout
             || dsn_now_ns() - _enqueue_ts_ns < 
             static_cast<uint64_t>(_request->header->client.timeout_ms) * 1000000ULL)
         {
-            _handler->run(_request);
+            if (spec().rpc_request_arena_enabled)
+                exec_with_arena();
+            else
+                _handler->run(_request);
         }
     }
 
+    // the arena of the request being handled by the current thread, see request_arena
+    DSN_API static request_arena* get_current_arena();
+
+private:
+    DSN_API void exec_with_arena();
+
 protected:
     message_ex      *_request;
     rpc_handler_info* _handler;
@@ -323,9 +338,13 @@ typedef void(*dsn_rpc_response_handler_replace_t)(
     void* context,
     uint64_t replace_context
     );
-class rpc_response_task : public task, public transient_object
+class rpc_response_task : public task
 {
 public:
+    // allocated from a slab pool, see slab_pool.h
+    DSN_API static void* operator new(size_t size);
+    DSN_API static void operator delete(void* p, size_t size);
+
     DSN_API rpc_response_task(
         message_ex* request, 
         dsn_rpc_response_handler_t cb,
@@ -373,7 +392,8 @@ enum aio_type
 {
     AIO_Invalid,
     AIO_Read,
-    AIO_Write
+    AIO_Write,
+    AIO_Flush
 };
 
 class disk_engine;
@@ -435,6 +455,7 @@ public:
             _merged_write_buffer_holder.assign(buffer, 0, _aio->buffer_size);
             _aio->buffer = buffer.get();
             copy_to(buffer.get());
+            _unmerged_write_buffers.clear();
         }
     }
 
@@ -43,6 +43,7 @@ namespace dsn {
 
 class task_worker;
 class task_worker_pool;
+class service_node;
 class admission_controller;
 
 /*!
@@ -78,6 +79,8 @@ public:
     int               increase_count(int count = 1) { _queue_length_counter->add(count);  return _queue_length.fetch_add(count, std::memory_order_relaxed) + count;}
     const safe_string & get_name() { return _name; }    
     task_worker_pool* pool() const { return _pool; }
+    const threadpool_spec& pool_spec() const { return *_spec; }
+    DSN_API service_node* node() const;
     bool              is_shared() const { return _worker_count > 1; }
     int               worker_count() const { return _worker_count; }
     task_worker*      owner_worker() const { return _owner_worker; } // when not is_shared()
@@ -87,6 +90,10 @@ public:
     admission_controller* controller() const { return _controller; }
     void set_controller(admission_controller* controller) { _controller = controller; }
 
+protected:
+    // reply ERR_BUSY to a rpc request rejected by the queue
+    DSN_API static void reply_busy(task* request_task);
+
 private:
     friend class task_worker_pool;
     void set_owner_worker(task_worker* worker) { _owner_worker = worker; }
@@ -101,6 +108,7 @@ private:
     int                    _worker_count;
     std::atomic<int>       _queue_length;
     mutable perf_counter_ptr  _queue_length_counter;
+    perf_counter_ptr       _rate_limit_rejected_counter;
     threadpool_spec*       _spec;
     volatile int           _virtual_queue_length;
 };
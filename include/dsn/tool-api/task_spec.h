@@ -45,6 +45,7 @@
 # include <dsn/utility/join_point.h>
 # include <dsn/utility/extensible_object.h>
 # include <dsn/utility/exp_delay.h>
+# include <dsn/utility/token_bucket.h>
 # include <dsn/utility/dlib.h>
 # include <dsn/tool-api/perf_counter.h>
 
@@ -202,6 +203,7 @@ public:
     safe_string            name;    
     dsn_task_code_t        rpc_paired_code;
     shared_exp_delay       rpc_request_delayer;
+    utils::token_bucket    rpc_request_rate_limiter; // shared by all queues, see rpc_request_rate_limit
     // ]
 
     // configurable [
@@ -224,6 +226,9 @@ public:
     throttling_mode_t      rpc_request_throttling_mode; // 
     safe_vector<int>       rpc_request_delays_milliseconds; // see exp_delay for delaying recving
     bool                   rpc_request_dropped_before_execution_when_timeout;
+    bool                   rpc_request_arena_enabled;
+    uint64_t               rpc_request_rate_limit; // requests per second, 0 for unlimited
+    uint64_t               rpc_request_rate_burst; // 0 for the same as rpc_request_rate_limit
 
     // layer 2 configurations
     bool                   rpc_request_layer2_handler_required; // need layer 2 handler
@@ -294,6 +299,9 @@ CONFIG_BEGIN(task_spec)
     CONFIG_FLD_ENUM(throttling_mode_t, rpc_request_throttling_mode, TM_NONE, TM_INVALID, false, "throttling mode for rpc requets: TM_NONE, TM_REJECT, TM_DELAY when queue length > pool.queue_length_throttling_threshold")
     CONFIG_FLD_INT_LIST(rpc_request_delays_milliseconds, "how many milliseconds to delay recving rpc session for when queue length ~= [1.0, 1.2, 1.4, 1.6, 1.8, >=2.0] x pool.queue_length_throttling_threshold, e.g., 0, 0, 1, 2, 5, 10")
     CONFIG_FLD(bool, bool, rpc_request_dropped_before_execution_when_timeout, false, "whether to drop a request right before execution when its queueing time is already greater than its timeout value")    
+    CONFIG_FLD(bool, bool, rpc_request_arena_enabled, false, "whether to keep the blobs decoded from the requests in a per-thread arena which is reset after each request is handled")
+    CONFIG_FLD(uint64_t, uint64, rpc_request_rate_limit, 0, "max accepted requests per second of this kind in this process (token bucket), the others are rejected with ERR_BUSY, 0 for unlimited")
+    CONFIG_FLD(uint64_t, uint64, rpc_request_rate_burst, 0, "token bucket size of rpc_request_rate_limit, i.e., how many requests can be accepted in a burst, 0 for the same as rpc_request_rate_limit")
 
     // layer 2 configurations
     CONFIG_FLD(bool, bool, rpc_request_layer2_handler_required, false, "whether this request needs to be handled by a layer2 handler (e.g., replicated or partitioned)")
@@ -310,8 +318,17 @@ struct threadpool_spec
     worker_priority_t       worker_priority;
     bool                    worker_share_core;
     uint64_t                worker_affinity_mask;
+    safe_string             worker_affinity_cpus; // e.g., "0-15,64-79" or "node:0"; overrides worker_affinity_mask
+    safe_vector<int>        worker_affinity_cpu_list; // parsed from worker_affinity_cpus when loaded
+    bool                    worker_numa_memory_binding;
     int                     dequeue_batch_size;
     bool                    partitioned;         // false by default
+    bool                    elastic;             // worker_count is the max worker count when true
+    int                     elastic_min_worker_count;
+    int                     elastic_queue_delay_target_ms;
+    int                     elastic_check_interval_ms;
+    int                     elastic_grow_check_count;
+    int                     elastic_park_check_count;
     safe_string             queue_factory_name;
     safe_string             worker_factory_name;
     safe_list<safe_string>  queue_aspects;
@@ -320,6 +337,8 @@ struct threadpool_spec
     bool                    enable_virtual_queue_throttling;
     safe_string             admission_controller_factory_name;
     safe_string             admission_controller_arguments;
+    uint64_t                client_rate_limit;   // requests per second per client, 0 for unlimited
+    uint64_t                client_rate_burst;
 
     threadpool_spec(const dsn_threadpool_code_t& code) : name(dsn_threadpool_code_to_string(code)), pool_code(code) {}
     threadpool_spec(const threadpool_spec& source) = default;
@@ -336,7 +355,15 @@ CONFIG_BEGIN(threadpool_spec)
     CONFIG_FLD_ENUM(worker_priority_t, worker_priority, THREAD_xPRIORITY_NORMAL, THREAD_xPRIORITY_INVALID, false, "thread priority")
     CONFIG_FLD(bool, bool, worker_share_core, true, "whether the threads share all assigned cores")
     CONFIG_FLD(uint64_t, uint64, worker_affinity_mask, 0, "what CPU cores are assigned to this pool, 0 for all")
+    CONFIG_FLD_STRING(worker_affinity_cpus, "", "what CPU cores are assigned to this pool as a cpuset list (e.g., 0-15,64-79) or numa nodes (e.g., node:0,1), which overrides worker_affinity_mask and supports more than 64 cores")
+    CONFIG_FLD(bool, bool, worker_numa_memory_binding, true, "whether to prefer allocating worker-local memory (e.g., transient memory blocks) on the numa node of the worker when its cores are all on one node")
     CONFIG_FLD(bool, bool, partitioned, false, "whethe the threads share a single queue(partitioned=false) or not; the latter is usually for workload hash partitioning for avoiding locking")
+    CONFIG_FLD(bool, bool, elastic, false, "whether the active worker count changes between elastic_min_worker_count and worker_count according to the queueing delay, only for non-partitioned pools")
+    CONFIG_FLD(int, uint64, elastic_min_worker_count, 1, "elastic: min active worker count")
+    CONFIG_FLD(int, uint64, elastic_queue_delay_target_ms, 10, "elastic: one more worker is activated when the estimated queueing delay keeps above this value, and one is parked when it keeps below 1/4 of this value")
+    CONFIG_FLD(int, uint64, elastic_check_interval_ms, 100, "elastic: interval (ms) of checking the queueing delay")
+    CONFIG_FLD(int, uint64, elastic_grow_check_count, 3, "elastic: how many consecutive checks above the target before activating one more worker")
+    CONFIG_FLD(int, uint64, elastic_park_check_count, 50, "elastic: how many consecutive checks below 1/4 of the target before parking one worker")
     CONFIG_FLD_STRING(queue_factory_name, "", "task queue provider name")
     CONFIG_FLD_STRING(worker_factory_name, "", "task worker provider name")
     CONFIG_FLD_STRING_LIST(queue_aspects, "task queue aspects names, usually for tooling purpose")
@@ -345,6 +372,8 @@ CONFIG_BEGIN(threadpool_spec)
     CONFIG_FLD(bool, bool, enable_virtual_queue_throttling, false, "throttling: whether to enable throttling with virtual queues")        
     CONFIG_FLD_STRING(admission_controller_factory_name, "", "customized admission controller for the task queues")
     CONFIG_FLD_STRING(admission_controller_arguments, "", "arguments for the cusotmized admission controller")
+    CONFIG_FLD(uint64_t, uint64, client_rate_limit, 0, "max accepted rpc requests per second from each client (token bucket), the others are rejected with ERR_BUSY, 0 for unlimited; only enforced by queues with per-client flows, e.g., dsn::tools::fair_task_queue")
+    CONFIG_FLD(uint64_t, uint64, client_rate_burst, 0, "token bucket size of client_rate_limit, 0 for the same as client_rate_limit")
 CONFIG_END
 
 } // end namespace
@@ -40,7 +40,9 @@
 # include <dsn/utility/synchronize.h>
 # include <dsn/utility/dlib.h>
 # include <dsn/tool-api/perf_counter.h>
+# include <atomic>
 # include <thread>
+# include <vector>
 
 namespace dsn {
  
@@ -77,6 +79,9 @@ public:
     int native_tid() const { return _native_tid; }
     task_worker_pool* pool() const { return _owner_pool; }
     task_queue* queue() const { return _input_queue; }
+    const std::vector<int>& affinity_cpus() const { return _affinity_cpus; }
+    int numa_node() const { return _numa_node; }
+    int processed_task_count() const { return _processed_task_count.load(std::memory_order_relaxed); }
     DSN_API const threadpool_spec& pool_spec() const;
     DSN_API static task_worker* current();
 
@@ -89,12 +94,24 @@ private:
     std::thread      *_thread;
     bool             _is_running;
     utils::notify_event _started;
-    int              _processed_task_count;
+    std::atomic<int> _processed_task_count; // written by the worker, read by e.g. elastic pools
+    std::vector<int> _affinity_cpus; // empty for not pinned
+    int              _numa_node;     // -1 when the cores span multiple nodes or unknown
 
 public:
     DSN_API static void set_name(const char* name);
     DSN_API static void set_priority(worker_priority_t pri);
     DSN_API static void set_affinity(uint64_t affinity);
+    DSN_API static void set_affinity(const std::vector<int>& cpus);
+
+    // cpuset list (e.g., "0-15,64-79") or numa nodes (e.g., "node:0,1")
+    DSN_API static bool parse_affinity_cpus(const char* spec, /*out*/ std::vector<int>& cpus);
+    // -1 when unknown or the cpus span multiple numa nodes
+    DSN_API static int  numa_node_of_cpus(const std::vector<int>& cpus);
+    // prefer allocating memory of the current thread on the given numa node
+    DSN_API static void bind_memory_to_numa_node(int node);
+    // pin the current non-worker thread (e.g., network/aio threads), return numa node or -1
+    DSN_API static int  pin_current_thread(const char* affinity_cpus, bool numa_memory_binding);
 
 private:
     void run_internal();
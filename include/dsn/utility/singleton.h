@@ -62,7 +62,7 @@ public:
             if (nullptr == _instance)
             {
                 auto tmp = new T();
-                std::atomic_thread_fence(std::memory_order::memory_order_seq_cst);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
                 _instance = tmp;
             }            
 
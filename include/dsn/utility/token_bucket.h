@@ -0,0 +1,113 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     token bucket for request rate limiting
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# pragma once
+
+# include <dsn/utility/synchronize.h>
+# include <cstdint>
+# include <algorithm>
+
+namespace dsn
+{
+    namespace utils
+    {
+        //
+        // tokens are refilled at rate/s up to burst, and each accepted request consumes one or more tokens;
+        // a bucket with zero rate is unlimited
+        //
+        class token_bucket
+        {
+        public:
+            token_bucket(uint64_t rate = 0, uint64_t burst = 0)
+            {
+                reset(rate, burst);
+            }
+
+            // burst = 0 for the same as the rate (i.e., one second of tokens)
+            void reset(uint64_t rate, uint64_t burst)
+            {
+                auto_lock<ex_lock_nr_spin> l(_lock);
+                _rate = rate;
+                _burst = (burst == 0 ? rate : burst);
+                _tokens = static_cast<double>(_burst);
+                _last_ns = 0;
+            }
+
+            bool unlimited() const { return _rate == 0; }
+            uint64_t rate() const { return _rate; }
+            uint64_t burst() const { return _burst; }
+
+            bool try_consume(uint64_t now_ns, uint64_t tokens = 1)
+            {
+                if (_rate == 0)
+                    return true;
+
+                auto_lock<ex_lock_nr_spin> l(_lock);
+                refill(now_ns);
+                if (_tokens < static_cast<double>(tokens))
+                    return false;
+
+                _tokens -= static_cast<double>(tokens);
+                return true;
+            }
+
+            double available(uint64_t now_ns)
+            {
+                auto_lock<ex_lock_nr_spin> l(_lock);
+                refill(now_ns);
+                return _tokens;
+            }
+
+        private:
+            void refill(uint64_t now_ns)
+            {
+                if (_last_ns != 0 && now_ns > _last_ns)
+                {
+                    _tokens = std::min(static_cast<double>(_burst),
+                        _tokens + static_cast<double>(now_ns - _last_ns) * static_cast<double>(_rate) / 1e9);
+                }
+                if (now_ns > _last_ns)
+                    _last_ns = now_ns;
+            }
+
+        private:
+            ex_lock_nr_spin _lock;
+            uint64_t        _rate;
+            uint64_t        _burst;
+            double          _tokens;
+            uint64_t        _last_ns;
+        };
+    }
+}
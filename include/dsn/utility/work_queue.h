@@ -65,12 +65,11 @@ namespace dsn {
             _hdr.add(dl);
 
             // allocate slot and run
-            if (_current_op_count == _max_concurrent_op)
+            if (_current_op_count >= _max_concurrent_op)
                 return nullptr;
             else
             {
-                _current_op_count++;
-                return unlink_next_workload(ctx);
+                return run_next_workload(ctx);
             }
         }
 
@@ -81,8 +80,8 @@ namespace dsn {
             scope_lk l(_lock);
             _current_op_count--;
             
-            // no further workload
-            if (_hdr.is_empty())
+            // no further workload, or the max concurrency is lowered
+            if (_hdr.is_empty() || _current_op_count >= _max_concurrent_op)
             {
                 return nullptr;
             }
@@ -90,26 +89,44 @@ namespace dsn {
             // run further workload
             else
             {
-                _current_op_count++;
-                return unlink_next_workload(ctx);
+                return run_next_workload(ctx);
             }
         }
 
     protected:
-        // lock is already hold
+        // lock is already hold; may return nullptr when the pending workload cannot
+        // run yet (e.g., it waits for the running ones), it is retried on the next
+        // add_work or on_work_completed
         virtual T* unlink_next_workload(void* ctx)
         {
             return _hdr.pop_one();
         }
 
+        // lock is already hold, including the slot of the workload being unlinked
+        int current_op_count() const { return _current_op_count; }
+
+        // takes effect on the following add_work and on_work_completed
         void reset_max_concurrent_ops(int max_c)
         {
+            scope_lk l(_lock);
             _max_concurrent_op = max_c;
         }
 
-    private:
+    protected:
         typedef utils::auto_lock<utils::ex_lock_nr_spin> scope_lk;
         utils::ex_lock_nr_spin _lock;        
+
+    private:
+        T* run_next_workload(void* ctx)
+        {
+            _current_op_count++;
+            T* wk = unlink_next_workload(ctx);
+            if (wk == nullptr)
+                _current_op_count--;
+            return wk;
+        }
+
+    private:
         int _current_op_count;
         int _max_concurrent_op;
 
@@ -36,11 +36,116 @@
 #include <gtest/gtest.h>
 #include <dsn/service_api_cpp.h>
 #include <dsn/cpp/test_utils.h>
+#include <dsn/utility/factory_store.h>
 #include <boost/lexical_cast.hpp>
+#include "disk_engine.h"
 
-void aio_testcase(uint64_t block_size, size_t concurrency, bool is_write, bool shared)
+# ifdef DSN_HAS_COROUTINE
+static coro::task<void> aio_coroutine(
+    dsn_handle_t file,
+    char* buffer,
+    uint64_t block_size,
+    bool is_write,
+    bool shared,
+    volatile bool& exit,
+    std::atomic<uint64_t>& io_count,
+    std::atomic<uint64_t>& cb_flying_count
+    )
 {
-    std::unique_ptr<char[]> buffer(new char[block_size]);
+    uint64_t next_offset = 0;
+    while (!exit)
+    {
+        auto ioc = io_count++;
+        uint64_t offset;
+        if (!shared)
+        {
+            offset = next_offset;
+            next_offset += block_size;
+        }
+        else
+        {
+            offset = ioc * block_size;
+        }
+
+        std::pair<error_code, size_t> r;
+        if (is_write)
+            r = co_await coro::file::write(file, buffer, (int)block_size, offset, LPC_AIO_TEST);
+        else
+            r = co_await coro::file::read(file, buffer, (int)block_size, offset, LPC_AIO_TEST);
+
+        if (ERR_OK != r.first)
+            break;
+    }
+    cb_flying_count--;
+}
+# endif
+
+// the file io issued in the scope goes to the given disk engine instead of the one
+// of the current node, so that the same cases run over different aio providers
+struct test_disk_scope
+{
+    disk_engine* old_disk;
+
+    test_disk_scope(disk_engine* disk) : old_disk(tls_dsn.disk)
+    {
+        if (disk != nullptr)
+            tls_dsn.disk = disk;
+    }
+    ~test_disk_scope() { tls_dsn.disk = old_disk; }
+};
+
+// a disk engine with its own provider, never deleted as the provider threads keep running
+static disk_engine* create_test_disk(const char* aio_factory_name)
+{
+    auto node = task::get_current_node2();
+    auto disk = new disk_engine(node);
+    auto provider = utils::factory_store<aio_provider>::create(aio_factory_name, PROVIDER_TYPE_MAIN, disk, nullptr);
+    dassert(provider != nullptr, "aio provider %s is not registered", aio_factory_name);
+
+    io_modifer ctx;
+    ctx.mode = IOE_PER_NODE;
+    ctx.queue = nullptr;
+    ctx.port_shift_value = 0;
+    disk->start(provider, ctx);
+    return disk;
+}
+
+// the disk engines of the aio providers available on this platform, in the order of
+// aio_testcase_providers
+static std::vector<std::pair<std::string, disk_engine*>> get_test_disks()
+{
+    static const char* aio_testcase_providers[] = {
+        "dsn::tools::native_aio_provider",
+        "dsn::tools::io_uring_aio_provider"
+    };
+    static std::vector<std::pair<std::string, disk_engine*>> disks;
+    if (!disks.empty())
+        return disks;
+
+    auto fs = utils::factory_store<aio_provider>::get_all_factories<aio_provider::factory>();
+    for (auto name : aio_testcase_providers)
+    {
+        bool registered = false;
+        for (auto& f : fs)
+            registered = registered || (f.name == name && f.type == PROVIDER_TYPE_MAIN);
+
+        if (registered)
+            disks.emplace_back(name, create_test_disk(name));
+        else
+            std::cout << "aio = " << name << " is not available, skipped" << std::endl;
+    }
+    return disks;
+}
+
+// direct io (O_DIRECT) needs aligned buffers, offsets and block sizes
+void aio_testcase(uint64_t block_size, size_t concurrency, bool is_write, bool shared, bool coroutine = false, bool direct = false,
+    const char* aio_name = nullptr, disk_engine* disk = nullptr)
+{
+    // coroutines are resumed on the worker threads, whose file io goes to the node
+    dassert(!coroutine || disk == nullptr, "coroutine cases use the aio provider of the node");
+    test_disk_scope scope(disk);
+
+    auto buffer = make_aligned_shared_array(block_size, 4096);
     std::vector<dsn_handle_t> files;
     files.resize(concurrency);
 
@@ -70,6 +175,11 @@ void aio_testcase(uint64_t block_size, size_t concurrency, bool is_write, bool s
         flag = O_RDWR;
     }
 
+# ifdef O_DIRECT
+    if (direct)
+        flag |= O_DIRECT;
+# endif
+
     if (shared)
     {
         auto file_handle = dsn_file_open("temp", flag, 0666);
@@ -114,6 +224,7 @@ void aio_testcase(uint64_t block_size, size_t concurrency, bool is_write, bool s
             }
 
             cb_flying_count++;
+            test_disk_scope scope(disk);
             if (is_write)
             {
                 file::write(files[index], buffer.get(), (int)block_size, offset,
@@ -142,6 +253,14 @@ void aio_testcase(uint64_t block_size, size_t concurrency, bool is_write, bool s
     for (int i = 0; i < concurrency; i++)
     {
         offsets[i] = 0;
+# ifdef DSN_HAS_COROUTINE
+        if (coroutine)
+        {
+            cb_flying_count++;
+            coro::spawn(aio_coroutine(files[i], buffer.get(), block_size, is_write, shared, exit, io_count, cb_flying_count));
+            continue;
+        }
+# endif
         cb(i);
     }
 
@@ -151,7 +270,11 @@ void aio_testcase(uint64_t block_size, size_t concurrency, bool is_write, bool s
     auto bytes = ioc * block_size;    
     auto toc = std::chrono::steady_clock::now();
     
-    std::cout << "is_write = " << is_write        
+    std::cout << "aio = " << (aio_name != nullptr ? aio_name
+            : dsn_config_get_value_string("core", "aio_factory_name", "", "asynchonous file system provider"))
+        << ", coroutine = " << coroutine
+        << ", direct = " << direct
+        << ", is_write = " << is_write
         << ", block_size = " << block_size
         << ", shared = " << shared
         << ", concurrency = " << concurrency
@@ -186,10 +309,32 @@ void aio_testcase(uint64_t block_size, size_t concurrency, bool is_write, bool s
 }
 
 TEST(perf_core, aio)
+{
+    for (auto& d : get_test_disks())
+        for (auto is_write : { true, false })
+            for (auto shared : { false, true })
+                for (auto blk_size_bytes : { 256, 1024, 4 * 1024 })
+                    for (auto concurrency : { 1, 2, 4})
+                        aio_testcase(blk_size_bytes, concurrency, is_write, shared, false, false, d.first.c_str(), d.second);
+}
+
+TEST(perf_core, aio_direct)
+{
+    for (auto& d : get_test_disks())
+        for (auto is_write : { true, false })
+            for (auto shared : { false, true })
+                for (auto blk_size_bytes : { 4 * 1024, 64 * 1024 })
+                    for (auto concurrency : { 1, 4, 16 })
+                        aio_testcase(blk_size_bytes, concurrency, is_write, shared, false, true, d.first.c_str(), d.second);
+}
+
+# ifdef DSN_HAS_COROUTINE
+TEST(perf_core, aio_coroutine)
 {
     for (auto is_write : { true, false })
         for (auto shared : { false, true })
             for (auto blk_size_bytes : { 256, 1024, 4 * 1024 })
                 for (auto concurrency : { 1, 2, 4})
-                    aio_testcase(blk_size_bytes, concurrency, is_write, shared);
+                    aio_testcase(blk_size_bytes, concurrency, is_write, shared, true);
 }
+# endif
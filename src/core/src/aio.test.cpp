@@ -36,7 +36,9 @@
 
 # include <dsn/service_api_cpp.h>
 # include <gtest/gtest.h>
+# include <iostream>
 # include <dsn/cpp/test_utils.h>
+# include "disk_engine.h"
 
 using namespace ::dsn;
 
@@ -207,3 +209,392 @@ TEST(core, operation_failed)
 
     EXPECT_TRUE(utils::filesystem::remove_path("tmp_test_file"));
 }
+
+static dsn_handle_t                    s_batch_file;
+static std::atomic<bool>               s_batch_added;
+static std::vector<char>               s_batch_data;
+static std::vector<dsn_file_buffer_t>  s_batch_buffers;
+static std::vector<task_ptr>           s_batch_tasks;
+
+// called when the first write completes, so that the first write issued here runs
+// alone and the others queue up behind it
+static void on_batch_write_test_enqueue(aio_task* tsk)
+{
+    if (s_batch_added.exchange(true))
+        return;
+
+    const int count = 300;
+    const int piece = 37;
+    uint64_t offset = piece * 2;
+    for (int i = 1; i < count; i++)
+    {
+        char* ptr = &s_batch_data[offset];
+        if (i % 2 == 0)
+        {
+            s_batch_tasks.push_back(::dsn::file::write(s_batch_file, ptr, piece * 2, offset, LPC_AIO_TEST, nullptr, dsn::empty_callback));
+        }
+        else
+        {
+            s_batch_buffers[i * 2].buffer = ptr;
+            s_batch_buffers[i * 2].size = piece;
+            s_batch_buffers[i * 2 + 1].buffer = ptr + piece;
+            s_batch_buffers[i * 2 + 1].size = piece;
+            s_batch_tasks.push_back(::dsn::file::write_vector(s_batch_file, &s_batch_buffers[i * 2], 2, offset, LPC_AIO_TEST, nullptr, dsn::empty_callback));
+        }
+        offset += piece * 2;
+    }
+}
+
+TEST(core, aio_batch_write)
+{
+    // if in dsn_mimic_app() and disk_io_mode == IOE_PER_QUEUE
+    if (task::get_current_disk() == nullptr) return;
+
+    // contiguous plain and vector writes are batched into one io by the disk engine
+    const int count = 300;
+    const int piece = 37;
+    s_batch_data.resize(count * piece * 2);
+    for (size_t i = 0; i < s_batch_data.size(); i++)
+        s_batch_data[i] = (char)('a' + i % 26 + i / 1000);
+    s_batch_buffers.resize(count * 2);
+    s_batch_tasks.clear();
+    s_batch_added = false;
+
+    auto fp = dsn_file_open("tmp_batch", O_RDWR | O_CREAT | O_BINARY, 0666);
+    ASSERT_TRUE(fp != nullptr);
+    s_batch_file = fp;
+    dsn_file_ctrl(fp, CTL_MAX_CON_WRITE_OP_COUNT, 1);
+
+    auto& on_enqueue = task_spec::get(LPC_AIO_TEST_BATCH)->on_aio_enqueue;
+    on_enqueue.put_back(on_batch_write_test_enqueue, "aio_batch_write");
+
+    auto first = ::dsn::file::write(fp, &s_batch_data[0], piece * 2, 0, LPC_AIO_TEST_BATCH, nullptr, dsn::empty_callback);
+    first->wait();
+    EXPECT_EQ(ERR_OK, first->error());
+
+    ASSERT_EQ((size_t)count - 1, s_batch_tasks.size());
+    for (auto& t : s_batch_tasks)
+    {
+        t->wait();
+        EXPECT_EQ(ERR_OK, t->error());
+        EXPECT_EQ((size_t)piece * 2, t->io_size());
+    }
+    on_enqueue.remove("aio_batch_write");
+    s_batch_tasks.clear();
+
+    // the queued writes are batched, with vectored writes when the provider supports them
+    auto df = (disk_file*)fp;
+    EXPECT_GT(df->batch_write_count(), 0u);
+    if (task::get_current_disk()->provider()->vectored_write_supported())
+    {
+        EXPECT_EQ(df->batch_write_count(), df->vectored_write_count());
+    }
+    else
+    {
+        EXPECT_EQ(0u, df->vectored_write_count());
+    }
+
+    std::vector<char> rdata(s_batch_data.size());
+    auto t = ::dsn::file::read(fp, &rdata[0], (int)rdata.size(), 0, LPC_AIO_TEST, nullptr, dsn::empty_callback);
+    t->wait();
+    EXPECT_EQ(rdata.size(), t->io_size());
+    EXPECT_TRUE(memcmp(&s_batch_data[0], &rdata[0], s_batch_data.size()) == 0);
+
+    EXPECT_EQ(ERR_OK, dsn_file_close(fp));
+    utils::filesystem::remove_path("tmp_batch");
+}
+
+static dsn_handle_t          s_coalesce_file;
+static std::atomic<bool>     s_coalesce_added;
+static std::vector<char>     s_coalesce_rdata;
+static std::vector<uint64_t> s_coalesce_offsets;
+static std::vector<task_ptr> s_coalesce_tasks;
+
+// called when the first read completes, so that the first read issued here runs
+// alone and the others queue up behind it
+static void on_read_coalesce_test_enqueue(aio_task* tsk)
+{
+    if (s_coalesce_added.exchange(true))
+        return;
+
+    const int len = 300;
+    for (size_t i = 0; i < s_coalesce_offsets.size(); i++)
+    {
+        s_coalesce_tasks.push_back(::dsn::file::read(s_coalesce_file, &s_coalesce_rdata[i * len], len,
+            s_coalesce_offsets[i], LPC_AIO_TEST, nullptr, dsn::empty_callback));
+    }
+}
+
+TEST(core, aio_read_coalesce)
+{
+    // if in dsn_mimic_app() and disk_io_mode == IOE_PER_QUEUE
+    if (task::get_current_disk() == nullptr) return;
+
+    const int file_size = 64 * 1024;
+    std::vector<char> data(file_size);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = (char)(i * 13 + i / 256);
+
+    auto fp = dsn_file_open("tmp_coalesce", O_RDWR | O_CREAT | O_BINARY, 0666);
+    ASSERT_TRUE(fp != nullptr);
+    auto t = ::dsn::file::write(fp, &data[0], file_size, 0, LPC_AIO_TEST, nullptr, dsn::empty_callback);
+    t->wait();
+    ASSERT_EQ((size_t)file_size, t->io_size());
+
+    // pending reads queue up behind the only running read, and the adjacent and
+    // overlapped ones are merged
+    dsn_file_ctrl(fp, CTL_MAX_CON_READ_OP_COUNT, 1);
+    dsn_file_ctrl(fp, CTL_READ_COALESCE_BYTES, 16 * 1024);
+
+    const int count = 200;
+    const int len = 300;
+    s_coalesce_file = fp;
+    s_coalesce_added = false;
+    s_coalesce_rdata.assign(count * len, 0);
+    s_coalesce_offsets.resize(count);
+    s_coalesce_tasks.clear();
+    auto& offsets = s_coalesce_offsets;
+    for (int i = 0; i < count; i++)
+    {
+        offsets[i] = (uint64_t)((i * 7919) % (file_size / 2) + (i % 3) * 100);
+        if (i == count - 2)
+            offsets[i] = file_size - len / 2; // partially beyond the end of file
+        if (i == count - 1)
+            offsets[i] = file_size + 100;     // beyond the end of file
+    }
+
+    auto& on_enqueue = task_spec::get(LPC_AIO_TEST_BATCH)->on_aio_enqueue;
+    on_enqueue.put_back(on_read_coalesce_test_enqueue, "aio_read_coalesce");
+
+    char first_data[16];
+    auto first = ::dsn::file::read(fp, first_data, sizeof(first_data), 0, LPC_AIO_TEST_BATCH, nullptr, dsn::empty_callback);
+    first->wait();
+    EXPECT_EQ(ERR_OK, first->error());
+
+    auto& tasks = s_coalesce_tasks;
+    auto& rdata = s_coalesce_rdata;
+    ASSERT_EQ((size_t)count, tasks.size());
+    for (int i = 0; i < count; i++)
+    {
+        tasks[i]->wait();
+        if (i == count - 1)
+        {
+            EXPECT_EQ(ERR_HANDLE_EOF, tasks[i]->error());
+            EXPECT_EQ(0u, tasks[i]->io_size());
+            continue;
+        }
+
+        size_t expected = std::min((size_t)len, (size_t)(file_size - offsets[i]));
+        EXPECT_EQ(ERR_OK, tasks[i]->error());
+        EXPECT_EQ(expected, tasks[i]->io_size());
+        EXPECT_TRUE(memcmp(&data[offsets[i]], &rdata[i * len], expected) == 0);
+    }
+    on_enqueue.remove("aio_read_coalesce");
+
+    auto df = (disk_file*)fp;
+    uint64_t merged = df->merged_read_count();
+    EXPECT_GT(merged, 0u);
+
+    // more concurrent reads without merging
+    dsn_file_ctrl(fp, CTL_MAX_CON_READ_OP_COUNT, 8);
+    dsn_file_ctrl(fp, CTL_READ_COALESCE_BYTES, 0);
+    tasks.clear();
+    for (int i = 0; i < count - 2; i++)
+    {
+        tasks.push_back(::dsn::file::read(fp, &rdata[i * len], len, offsets[i], LPC_AIO_TEST, nullptr, dsn::empty_callback));
+    }
+    for (int i = 0; i < count - 2; i++)
+    {
+        tasks[i]->wait();
+        EXPECT_EQ((size_t)len, tasks[i]->io_size());
+        EXPECT_TRUE(memcmp(&data[offsets[i]], &rdata[i * len], len) == 0);
+    }
+    tasks.clear();
+    EXPECT_EQ(merged, df->merged_read_count());
+
+    EXPECT_EQ(ERR_OK, dsn_file_close(fp));
+    utils::filesystem::remove_path("tmp_coalesce");
+}
+
+static dsn_handle_t          s_flush_file;
+static std::atomic<bool>     s_flush_group_added;
+static std::atomic<int>      s_flushed;
+static std::vector<task_ptr> s_flush_tasks;
+
+static void on_flush_test_callback(error_code err, size_t n)
+{
+    EXPECT_EQ(ERR_OK, err);
+    EXPECT_EQ(0u, n);
+    ++s_flushed;
+}
+
+// called when the first flush completes, which is still running until its
+// completion callbacks are enqueued
+static void on_flush_test_enqueue(aio_task* tsk)
+{
+    if (s_flush_group_added.exchange(true))
+        return;
+
+    for (int i = 0; i < 49; i++)
+    {
+        s_flush_tasks.push_back(::dsn::file::flush(s_flush_file, LPC_AIO_TEST_FLUSH, nullptr,
+            &on_flush_test_callback));
+    }
+}
+
+TEST(core, aio_flush_async)
+{
+    // if in dsn_mimic_app() and disk_io_mode == IOE_PER_QUEUE
+    if (task::get_current_disk() == nullptr) return;
+
+    auto fp = dsn_file_open("tmp_flush", O_RDWR | O_CREAT | O_BINARY, 0666);
+    ASSERT_TRUE(fp != nullptr);
+
+    const char* buffer = "hello, world";
+    int len = (int)strlen(buffer);
+    uint64_t offset = 0;
+
+    for (int i = 0; i < 50; i++)
+    {
+        auto t = ::dsn::file::write(fp, buffer, len, offset, LPC_AIO_TEST, nullptr, dsn::empty_callback);
+        offset += len;
+        t->wait();
+        EXPECT_EQ(ERR_OK, t->error());
+    }
+
+    // the 49 flushes added while the first one is running are committed by one more flush
+    s_flush_file = fp;
+    s_flush_group_added = false;
+    s_flushed = 0;
+    s_flush_tasks.clear();
+    auto& on_enqueue = task_spec::get(LPC_AIO_TEST_FLUSH)->on_aio_enqueue;
+    on_enqueue.put_back(on_flush_test_enqueue, "aio_flush_async");
+
+    auto first = ::dsn::file::flush(fp, LPC_AIO_TEST_FLUSH, nullptr, &on_flush_test_callback);
+    first->wait();
+    EXPECT_EQ(ERR_OK, first->error());
+
+    ASSERT_EQ(49u, s_flush_tasks.size());
+    for (auto& t : s_flush_tasks)
+    {
+        t->wait();
+        EXPECT_EQ(ERR_OK, t->error());
+    }
+    EXPECT_EQ(50, s_flushed.load());
+    EXPECT_EQ(2u, ((disk_file*)fp)->flush_count());
+
+    on_enqueue.remove("aio_flush_async");
+    s_flush_tasks.clear();
+
+    EXPECT_EQ(ERR_OK, dsn_file_close(fp));
+    utils::filesystem::remove_path("tmp_flush");
+}
+
+TEST(core, aio_direct)
+{
+    // if in dsn_mimic_app() and disk_io_mode == IOE_PER_QUEUE
+    if (task::get_current_disk() == nullptr) return;
+
+# ifdef O_DIRECT
+    // some file systems (e.g., tmpfs) do not support direct io
+    auto fp = dsn_file_open("tmp_direct", O_RDWR | O_CREAT | O_TRUNC | O_BINARY | O_DIRECT, 0666);
+    if (fp == nullptr)
+    {
+        std::cout << "[  SKIPPED ] core.aio_direct: direct io is not supported by the file system" << std::endl;
+        dwarn("core.aio_direct is skipped as direct io is not supported by the file system");
+        return;
+    }
+    auto df = (disk_file*)fp;
+
+    const int block = 4096;
+    std::vector<char> data(block * 8 + 300);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = (char)(i * 7 + i / block);
+
+    // the writes are issued one by one, so that each takes the expected path
+    auto write = [fp](const char* buffer, int size, uint64_t offset)
+    {
+        auto t = ::dsn::file::write(fp, buffer, size, offset, LPC_AIO_TEST, nullptr, dsn::empty_callback);
+        t->wait();
+        EXPECT_EQ(ERR_OK, t->error());
+        EXPECT_EQ((size_t)size, t->io_size());
+    };
+    auto file_size = []()
+    {
+        int64_t sz = -1;
+        utils::filesystem::file_size("tmp_direct", sz);
+        return sz;
+    };
+
+    // aligned, written directly
+    auto aligned = make_aligned_shared_array(block * 4, block);
+    memcpy(aligned.get(), &data[0], block * 4);
+    write(aligned.get(), block * 4, 0);
+    EXPECT_EQ(0u, df->direct_bounce_write_count());
+    EXPECT_EQ(0u, df->direct_rmw_write_count());
+
+    // aligned range with an unaligned buffer, copied to an aligned bounce buffer
+    std::vector<char> unaligned(block * 2 + 1);
+    memcpy(&unaligned[1], &data[block * 4], block * 2);
+    write(&unaligned[1], block * 2, block * 4);
+    EXPECT_EQ(1u, df->direct_bounce_write_count());
+    EXPECT_EQ(0u, df->direct_rmw_write_count());
+
+    // unaligned tail, whose block is padded and cut back to the file size
+    write(&data[block * 6], block * 2 + 100, block * 6);
+    EXPECT_EQ(1u, df->direct_rmw_write_count());
+    EXPECT_EQ((int64_t)block * 8 + 100, file_size());
+
+    // the following append starts in the partial block, which is read back
+    write(&data[block * 8 + 100], 200, block * 8 + 100);
+    EXPECT_EQ(2u, df->direct_rmw_write_count());
+    EXPECT_EQ((int64_t)data.size(), file_size());
+
+    // overwriting in the middle of a block keeps its other bytes and the file size
+    std::vector<char> patch(100, 'x');
+    memcpy(&data[block + 50], &patch[0], patch.size());
+    write(&patch[0], (int)patch.size(), block + 50);
+    EXPECT_EQ(3u, df->direct_rmw_write_count());
+    EXPECT_EQ((int64_t)data.size(), file_size());
+
+    // concurrent unaligned appends run one by one (or batched) without losing data
+    const int append_size = 1000;
+    const int append_count = 16;
+    size_t append_offset = data.size();
+    data.resize(append_offset + append_size * append_count);
+    for (size_t i = append_offset; i < data.size(); i++)
+        data[i] = (char)(i * 13);
+    std::list<task_ptr> tasks;
+    for (int i = 0; i < append_count; i++)
+    {
+        tasks.push_back(::dsn::file::write(fp, &data[append_offset + i * append_size], append_size,
+            append_offset + i * append_size, LPC_AIO_TEST, nullptr, dsn::empty_callback));
+    }
+    for (auto& t : tasks)
+    {
+        t->wait();
+        EXPECT_EQ(ERR_OK, t->error());
+    }
+    EXPECT_GT(df->direct_rmw_write_count(), 3u);
+    EXPECT_EQ((int64_t)data.size(), file_size());
+    EXPECT_EQ(ERR_OK, dsn_file_flush(fp));
+
+    // aligned and unaligned reads
+    std::vector<char> rdata(data.size() + 1);
+    struct { uint64_t offset; int size; } reads[] = {
+        { 0, block }, { 1, 100 }, { block - 10, 20 }, { block + 40, 120 },
+        { block * 6 - 1, block * 2 + 301 }, { append_offset - 10, append_size * append_count + 10 }
+    };
+    for (auto& r : reads)
+    {
+        auto t = ::dsn::file::read(fp, &rdata[1], r.size, r.offset, LPC_AIO_TEST, nullptr, dsn::empty_callback);
+        t->wait();
+        EXPECT_EQ(ERR_OK, t->error());
+        EXPECT_EQ((size_t)r.size, t->io_size());
+        EXPECT_TRUE(memcmp(&data[r.offset], &rdata[1], r.size) == 0);
+    }
+
+    EXPECT_EQ(ERR_OK, dsn_file_close(fp));
+    utils::filesystem::remove_path("tmp_direct");
+# endif
+}
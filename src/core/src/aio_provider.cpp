@@ -48,6 +48,12 @@ service_node* aio_provider::node() const
     return _engine->node();
 }
 
+/*static*/ aio_provider* aio_provider::get_current()
+{
+    auto disk = task::get_current_disk();
+    return disk != nullptr ? disk->provider() : nullptr;
+}
+
 void aio_provider::complete_io(aio_task* aio, error_code err, uint32_t bytes, int delay_milliseconds)
 {
     _engine->complete_io(aio, err, bytes, delay_milliseconds);
@@ -0,0 +1,134 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     Unit-test for the coroutine tasks, built when the compiler supports
+ *     coroutines (e.g., with ENABLE_CXX20_COROUTINES).
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# include <dsn/cpp/coroutine.h>
+# include <gtest/gtest.h>
+
+# ifdef DSN_HAS_COROUTINE
+
+# include <stdexcept>
+# include <thread>
+
+using namespace ::dsn;
+
+static coro::task<int> add_value(int a, int b)
+{
+    co_return a + b;
+}
+
+static coro::task<std::string> format_value(int v)
+{
+    int r = co_await add_value(v, 1);
+    co_return std::to_string(r);
+}
+
+static coro::task<void> throw_error()
+{
+    throw std::runtime_error("coroutine error");
+    co_return;
+}
+
+// resumed on another thread, like the rpc and aio awaiters
+struct thread_awaiter
+{
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(coro::stdcoro::coroutine_handle<> h)
+    {
+        std::thread([h]() { h.resume(); }).detach();
+    }
+    void await_resume() const noexcept {}
+};
+
+static coro::task<int> add_value_on_thread(int a, int b)
+{
+    co_await thread_awaiter();
+    co_return a + b;
+}
+
+TEST(core, coroutine_task)
+{
+    std::string r;
+    bool caught = false;
+    coro::spawn([&]() -> coro::task<void>
+    {
+        r = co_await format_value(41);
+        try
+        {
+            co_await throw_error();
+        }
+        catch (const std::runtime_error&)
+        {
+            caught = true;
+        }
+    }());
+
+    EXPECT_EQ("42", r);
+    EXPECT_TRUE(caught);
+}
+
+TEST(core, coroutine_task_synchronous_loop)
+{
+    // tasks finished synchronously must not nest the awaiters on the stack
+    int64_t sum = 0;
+    coro::spawn([&]() -> coro::task<void>
+    {
+        for (int i = 0; i < 1000000; i++)
+            sum += co_await add_value(i, 1);
+    }());
+
+    EXPECT_EQ(500000500000LL, sum);
+}
+
+TEST(core, coroutine_task_resumed_on_other_thread)
+{
+    std::atomic<int> sum(0);
+    std::atomic<bool> done(false);
+
+    // the captures live in the closure, which must outlive the suspended coroutine
+    auto run = [&]() -> coro::task<void>
+    {
+        for (int i = 0; i < 100; i++)
+            sum += co_await add_value_on_thread(i, 1);
+        done = true;
+    };
+    coro::spawn(run());
+
+    while (!done)
+        std::this_thread::yield();
+    EXPECT_EQ(5050, sum.load());
+}
+
+# endif // DSN_HAS_COROUTINE
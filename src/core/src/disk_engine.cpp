@@ -36,8 +36,17 @@
 # include "disk_engine.h"
 # include <dsn/tool-api/perf_counter.h>
 # include <dsn/tool-api/aio_provider.h>
+# include <dsn/tool-api/task_worker.h>
+# include <dsn/tool_api.h>
 # include <dsn/cpp/utils.h>
 # include "transient_memory.h"
+# include <thread>
+# include <fcntl.h>
+# include <cinttypes>
+# include <cstring>
+# ifndef _WIN32
+# include <unistd.h>
+# endif
 
 # ifdef __TITLE__
 # undef __TITLE__
@@ -49,6 +58,7 @@ using namespace dsn::utils;
 namespace dsn {
 
 DEFINE_TASK_CODE_AIO(LPC_AIO_BATCH_WRITE, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
+DEFINE_TASK_CODE_AIO(LPC_AIO_BATCH_READ, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
 
 //----------------- disk_file ------------------------
 aio_task* disk_write_queue::unlink_next_workload(void* plength)
@@ -56,24 +66,39 @@ aio_task* disk_write_queue::unlink_next_workload(void* plength)
     uint64_t next_offset;
     uint32_t& sz = *(uint32_t*)plength;
     sz = 0;
+    int buffer_count = 0;
+
+    // the unaligned direct write running alone is completed once it is the only op,
+    // as current_op_count() includes the slot of the workload to be unlinked
+    if (_unaligned_running)
+    {
+        if (current_op_count() > 1)
+            return nullptr;
+        _unaligned_running = false;
+    }
 
     aio_task *first = _hdr._first, *current = first, *last = first;
     while (nullptr != current)
     {
         auto io = current->aio();
+        int io_buffer_count = current->_unmerged_write_buffers.empty() ?
+            1 : (int)current->_unmerged_write_buffers.size();
         if (sz == 0)
         {
             sz = io->buffer_size;
             next_offset = io->file_offset + sz;
+            buffer_count = io_buffer_count;
         }
         else
         {
             // batch condition
             if (next_offset == io->file_offset
-                && sz + io->buffer_size <= _max_batch_bytes)
+                && sz + io->buffer_size <= _max_batch_bytes
+                && buffer_count + io_buffer_count <= _max_batch_buffers)
             {
                 sz += io->buffer_size;
                 next_offset += io->buffer_size;
+                buffer_count += io_buffer_count;
             }
 
             // no batch is possible
@@ -88,6 +113,20 @@ aio_task* disk_write_queue::unlink_next_workload(void* plength)
         current = (aio_task*)current->next;
     }
 
+    // an unaligned direct write reads and rewrites its head and tail blocks, so it
+    // waits until the running writes are completed, and runs alone afterwards, i.e.,
+    // no other write to those blocks is in flight
+    if (first && _direct_alignment > 0
+        && (((first->aio()->file_offset | (uint64_t)sz) & (_direct_alignment - 1)) != 0))
+    {
+        if (current_op_count() > 1)
+        {
+            sz = 0;
+            return nullptr;
+        }
+        _unaligned_running = true;
+    }
+
     // unlink [first, last] -> current
     if (last)
     {
@@ -100,22 +139,110 @@ aio_task* disk_write_queue::unlink_next_workload(void* plength)
     return first;
 }
 
-disk_file::disk_file(dsn_handle_t handle)
-    : _handle(handle)
+aio_task* disk_read_queue::unlink_next_workload(void* plength)
 {
+    uint32_t& sz = *(uint32_t*)plength;
+    aio_task* first = _hdr.pop_one();
+    if (nullptr == first)
+    {
+        sz = 0;
+        return nullptr;
+    }
+
+    uint64_t start = first->aio()->file_offset;
+    uint64_t end = start + first->aio()->buffer_size;
+
+    // merge the following reads which are adjacent to or overlapped with [start, end)
+    if (_max_coalesce_bytes > 0)
+    {
+        aio_task *last = first, *prev = nullptr, *current = _hdr._first;
+        while (nullptr != current)
+        {
+            auto next = (aio_task*)current->next;
+            auto io = current->aio();
+            uint64_t io_end = io->file_offset + io->buffer_size;
+            uint64_t new_start = std::min(start, io->file_offset);
+            uint64_t new_end = std::max(end, io_end);
 
+            if (io->file_offset <= end && io_end >= start
+                && new_end - new_start <= _max_coalesce_bytes)
+            {
+                // unlink current and append it to [first, last]
+                if (prev)
+                    prev->next = next;
+                else
+                    _hdr._first = next;
+                if (current == _hdr._last)
+                    _hdr._last = prev;
+
+                current->next = nullptr;
+                last->next = current;
+                last = current;
+
+                start = new_start;
+                end = new_end;
+            }
+            else
+            {
+                prev = current;
+            }
+            current = next;
+        }
+    }
+
+    sz = (uint32_t)(end - start);
+    return first;
+}
+
+disk_file::disk_file(dsn_handle_t handle, const disk_file_options& options)
+    : _handle(handle),
+    _direct_alignment(0),
+    _write_queue(options.max_batch_write_bytes, options.max_batch_write_buffers),
+    _read_queue(options.max_concurrent_reads, options.max_coalesce_read_bytes)
+{
+    _flushing = false;
+    _flush_drained = nullptr;
+    _flush_count = 0;
+    _batch_write_count = 0;
+    _vectored_write_count = 0;
+    _merged_read_count = 0;
+    _direct_bounce_write_count = 0;
+    _direct_rmw_write_count = 0;
+    _written_begin = 0;
+    _written_end = 0;
+    _written_bytes = 0;
 }
 
 void disk_file::ctrl(dsn_ctrl_code_t code, int param)
 {
-    // TODO: 
-    dassert(false, "NOT IMPLEMENTED");
+    switch (code)
+    {
+    case CTL_BATCH_WRITE:
+        dassert(param > 0, "invalid write batch size %d", param);
+        _write_queue.reset_max_batch_bytes((uint32_t)param);
+        break;
+    case CTL_MAX_CON_READ_OP_COUNT:
+        dassert(param > 0, "invalid max concurrent read op count %d", param);
+        _read_queue.reset_max_concurrent_ops(param);
+        break;
+    case CTL_MAX_CON_WRITE_OP_COUNT:
+        dassert(param > 0, "invalid max concurrent write op count %d", param);
+        _write_queue.reset_max_concurrent_ops(param);
+        break;
+    case CTL_READ_COALESCE_BYTES:
+        dassert(param >= 0, "invalid read coalesce size %d", param);
+        _read_queue.reset_max_coalesce_bytes((uint32_t)param);
+        break;
+    default:
+        dassert(false, "invalid file ctrl code %d", (int)code);
+        break;
+    }
 }
 
-aio_task* disk_file::read(aio_task* tsk)
+aio_task* disk_file::read(aio_task* tsk, void* ctx)
 {
     tsk->add_ref(); // release on completion
-    return _read_queue.add_work(tsk, nullptr);
+    return _read_queue.add_work(tsk, ctx);
 }
 
 aio_task* disk_file::write(aio_task* tsk, void* ctx)
@@ -124,16 +251,50 @@ aio_task* disk_file::write(aio_task* tsk, void* ctx)
     return _write_queue.add_work(tsk, ctx);
 }
 
-aio_task* disk_file::on_read_completed(aio_task* wk, error_code err, size_t size)
+aio_task* disk_file::on_read_completed(aio_task* wk, void* ctx, error_code err, size_t size)
 {
     dassert(wk->next == nullptr, "");
-    auto ret = _read_queue.on_work_completed(wk, nullptr);
+    auto ret = _read_queue.on_work_completed(wk, ctx);
     wk->enqueue(err, size);
     wk->release_ref(); // added in above read
 
     return ret;
 }
 
+aio_task* disk_file::on_batch_read_completed(aio_task* wk, void* ctx, error_code err, size_t size,
+    const char* buffer, uint64_t offset)
+{
+    auto ret = _read_queue.on_work_completed(wk, ctx);
+
+    while (wk)
+    {
+        aio_task* next = (aio_task*)wk->next;
+        wk->next = nullptr;
+
+        if (err == ERR_OK || err == ERR_HANDLE_EOF)
+        {
+            auto io = wk->aio();
+            size_t pos = (size_t)(io->file_offset - offset);
+            size_t this_size = size > pos ? std::min(size - pos, (size_t)io->buffer_size) : 0;
+            if (this_size > 0)
+            {
+                memcpy(io->buffer, buffer + pos, this_size);
+            }
+            wk->enqueue(this_size > 0 || io->buffer_size == 0 ? ERR_OK : ERR_HANDLE_EOF, this_size);
+        }
+        else
+        {
+            wk->enqueue(err, 0);
+        }
+
+        wk->release_ref(); // added in above read
+
+        wk = next;
+    }
+
+    return ret;
+}
+
 aio_task* disk_file::on_write_completed(aio_task* wk, void* ctx, error_code err, size_t size)
 {
     auto ret = _write_queue.on_work_completed(wk, ctx);
@@ -174,16 +335,181 @@ aio_task* disk_file::on_write_completed(aio_task* wk, void* ctx, error_code err,
     return ret;
 }
 
+aio_task* disk_file::add_flush(aio_task* tsk)
+{
+    tsk->add_ref(); // release on completion
+
+    utils::auto_lock<utils::ex_lock_nr_spin> l(_flush_lock);
+    _pending_flushes.add(tsk);
+    if (_flushing)
+        return nullptr;
+
+    _flushing = true;
+    return _pending_flushes.pop_all();
+}
+
+aio_task* disk_file::on_flush_completed(aio_task* wk, error_code err)
+{
+    _flush_count.fetch_add(1, std::memory_order_relaxed);
+
+    while (wk)
+    {
+        aio_task* next = (aio_task*)wk->next;
+        wk->next = nullptr;
+        wk->enqueue(err, 0);
+        wk->release_ref(); // added in add_flush
+        wk = next;
+    }
+
+    // the flushes added during the completed flush may not cover all their
+    // preceding writes, so they are committed by another flush
+    utils::notify_event* drained;
+    {
+        utils::auto_lock<utils::ex_lock_nr_spin> l(_flush_lock);
+        if (!_pending_flushes.is_empty())
+            return _pending_flushes.pop_all();
+
+        _flushing = false;
+        drained = _flush_drained;
+        _flush_drained = nullptr;
+    }
+
+    // the file may be closed and deleted once notified, so do not touch it afterwards
+    if (drained)
+        drained->notify();
+    return nullptr;
+}
+
+void disk_file::wait_flushes()
+{
+    utils::notify_event drained;
+    {
+        utils::auto_lock<utils::ex_lock_nr_spin> l(_flush_lock);
+        if (!_flushing)
+            return;
+
+        dassert(_flush_drained == nullptr, "the file is closed concurrently");
+        _flush_drained = &drained;
+    }
+    drained.wait();
+}
+
+bool disk_file::add_written(uint64_t offset, uint64_t size, uint64_t threshold,
+    /*out*/ uint64_t& writeback_offset, /*out*/ uint64_t& writeback_size)
+{
+    utils::auto_lock<utils::ex_lock_nr_spin> l(_flush_lock);
+    if (_written_bytes == 0)
+    {
+        _written_begin = offset;
+        _written_end = offset + size;
+    }
+    else
+    {
+        _written_begin = std::min(_written_begin, offset);
+        _written_end = std::max(_written_end, offset + size);
+    }
+
+    _written_bytes += size;
+    if (_written_bytes < threshold)
+        return false;
+
+    writeback_offset = _written_begin;
+    writeback_size = _written_end - _written_begin;
+    _written_bytes = 0;
+    return true;
+}
+
 //----------------- disk_engine ------------------------
+static inline bool is_aligned(uint64_t value, uint32_t alignment)
+{
+    return (value & (alignment - 1)) == 0;
+}
+
+static bool is_direct_io_aligned(aio_task* aio, uint32_t alignment)
+{
+    auto dio = aio->aio();
+    if (!is_aligned(dio->file_offset, alignment) || !is_aligned(dio->buffer_size, alignment))
+        return false;
+
+    if (aio->_unmerged_write_buffers.empty())
+        return is_aligned((uint64_t)(uintptr_t)dio->buffer, alignment);
+
+    for (auto& buffer : aio->_unmerged_write_buffers)
+    {
+        if (!is_aligned((uint64_t)(uintptr_t)buffer.buffer, alignment)
+            || !is_aligned((uint64_t)buffer.size, alignment))
+            return false;
+    }
+    return true;
+}
+
+// like aio_task::collapse, with the merged buffer aligned for direct io
+static void collapse_aligned(aio_task* aio, uint32_t alignment)
+{
+    auto bb = tls_trans_mem_alloc_aligned_blob((size_t)aio->aio()->buffer_size, alignment);
+    aio->copy_to((char*)bb.data());
+    aio->_merged_write_buffer_holder = bb;
+    aio->aio()->buffer = (void*)bb.data();
+    aio->_unmerged_write_buffers.clear();
+}
+
 disk_engine::disk_engine(service_node* node)
 {
     _is_running = false;    
     _provider = nullptr;
-    _node = node;        
+    _node = node;
+
+    _file_options.max_batch_write_bytes = (uint32_t)dsn_config_get_value_uint64("aio", "write_batch_max_bytes", 1024 * 1024,
+        "max bytes of the contiguous writes to the same file that are batched into one io");
+    _file_options.max_batch_write_buffers = (int)dsn_config_get_value_uint64("aio", "write_batch_max_buffers", 64,
+        "max buffers of the contiguous writes to the same file that are batched into one io, "
+        "must not exceed IOV_MAX when the aio provider does vectored writes");
+    _file_options.max_concurrent_reads = (int)dsn_config_get_value_uint64("aio", "read_max_concurrent_ops", 1,
+        "max concurrent reads of each file, see CTL_MAX_CON_READ_OP_COUNT");
+    _file_options.max_coalesce_read_bytes = (uint32_t)dsn_config_get_value_uint64("aio", "read_coalesce_max_bytes", 0,
+        "max bytes of the adjacent or overlapped pending reads of the same file that are merged into one io, "
+        "0 for no merge, see CTL_READ_COALESCE_BYTES");
+
+    _file_options.writeback_hint_bytes = dsn_config_get_value_uint64("aio", "writeback_hint_bytes", 0,
+        "hint the aio provider to start writing back the dirty pages (e.g., sync_file_range) every time "
+        "so many bytes are written to a file, 0 for never");
+
+    _flush_datasync = dsn_config_get_value_bool("aio", "flush_async_datasync", true,
+        "whether dsn_file_flush_async flushes the file data only (e.g., fdatasync) instead of "
+        "the data and all the metadata (e.g., fsync)");
+    _flush_thread_count = (int)dsn_config_get_value_uint64("aio", "flush_thread_count", 1,
+        "how many threads issue the group commits of dsn_file_flush_async, "
+        "0 for issuing them on the callers, always 0 under the emulator");
+
+    // the flush threads are not scheduled by the emulator, so the group commits are
+    // issued on the (simulated) callers to keep the runs deterministic
+    if (_flush_thread_count > 0 && ::dsn::tools::get_current_tool()->name() == "emulator")
+    {
+        dwarn("flush_thread_count is reset from %d to 0 under the emulator", _flush_thread_count);
+        _flush_thread_count = 0;
+    }
+
+    _direct_io_alignment = (uint32_t)dsn_config_get_value_uint64("aio", "direct_io_alignment", 4096,
+        "alignment of the buffers, offsets and sizes of direct io (files opened with O_DIRECT), "
+        "a power of 2 no less than the logical block size of the disks");
+    dassert(_direct_io_alignment > 0 && (_direct_io_alignment & (_direct_io_alignment - 1)) == 0,
+        "invalid direct_io_alignment %u", _direct_io_alignment);
+
+    if (_file_options.max_batch_write_buffers < 1)
+        _file_options.max_batch_write_buffers = 1;
+    if (_file_options.max_concurrent_reads < 1)
+        _file_options.max_concurrent_reads = 1;
 }
 
 disk_engine::~disk_engine()
 {
+    if (_provider != nullptr)
+        tls_trans_mem_remove_block_observer(&disk_engine::on_transient_block, _provider);
+}
+
+void disk_engine::on_transient_block(void* context, char* blk, size_t size, bool allocated)
+{
+    ((aio_provider*)context)->on_transient_block(blk, size, allocated);
 }
 
 void disk_engine::start(aio_provider* provider, io_modifer& ctx)
@@ -194,6 +520,23 @@ void disk_engine::start(aio_provider* provider, io_modifer& ctx)
     _provider = provider;
     _provider->start(ctx);
     _is_running = true;
+
+    for (int i = 0; i < _flush_thread_count; i++)
+    {
+        auto queue = ctx.queue;
+        new std::thread([this, queue, i]()
+        {
+            task::set_tls_dsn_context(node(), nullptr, queue);
+
+            char buffer[128];
+            sprintf(buffer, "%s.flush.%d", ::dsn::tools::get_service_node_name(node()), i);
+            task_worker::set_name(buffer);
+
+            flush_thread_main();
+        });
+    }
+
+    tls_trans_mem_add_block_observer(&disk_engine::on_transient_block, _provider);
 }
 
 void disk_engine::ctrl(dsn_handle_t fh, dsn_ctrl_code_t code, int param)
@@ -208,14 +551,21 @@ void disk_engine::ctrl(dsn_handle_t fh, dsn_ctrl_code_t code, int param)
 dsn_handle_t disk_engine::open(const char* file_name, int flag, int pmode)
 {            
     dsn_handle_t nh = _provider->open(file_name, flag, pmode);
-    if (nh != DSN_INVALID_FILE_HANDLE)
+    if (nh == DSN_INVALID_FILE_HANDLE)
     {
-        return new disk_file(nh);
+        return nullptr;
     }
-    else
+
+    auto df = new disk_file(nh, _file_options);
+
+# ifdef O_DIRECT
+    if (flag & O_DIRECT)
     {
-        return nullptr;
-    }   
+        df->set_direct(_direct_io_alignment);
+    }
+# endif
+
+    return df;
 }
 
 error_code disk_engine::close(dsn_handle_t fh)
@@ -223,6 +573,10 @@ error_code disk_engine::close(dsn_handle_t fh)
     if (nullptr != fh)
     {
         auto df = (disk_file*)fh;
+
+        // the running and pending group commits still reference the file
+        df->wait_flushes();
+
         auto ret = _provider->close(df->native_handle());
         delete df;
         return ret;
@@ -267,10 +621,157 @@ void disk_engine::read(aio_task* aio)
     dio->engine = this;
     dio->type = AIO_Read;
 
-    auto wk = df->read(aio);
+    uint32_t sz;
+    auto wk = df->read(aio, &sz);
     if (wk)
     {
-        return _provider->aio(wk);
+        process_read(wk, sz);
+    }
+}
+
+void disk_engine::flush_async(aio_task* aio)
+{
+    if (!_is_running)
+    {
+        aio->enqueue(ERR_SERVICE_NOT_FOUND, 0);
+        return;
+    }
+
+    if (!aio->spec().on_aio_call.execute(task::get_current_task(), aio, true))
+    {
+        aio->enqueue(ERR_FILE_OPERATION_FAILED, 0);
+        return;
+    }
+
+    auto dio = aio->aio();
+    auto df = (disk_file*)dio->file;
+    dio->file = df->native_handle();
+    dio->file_object = df;
+    dio->engine = this;
+    dio->type = AIO_Flush;
+
+    auto wk = df->add_flush(aio);
+    if (wk == nullptr)
+        return;
+
+    if (_flush_thread_count > 0)
+    {
+        {
+            utils::auto_lock<utils::ex_lock_nr> l(_flush_queue_lock);
+            _flush_queue.emplace(df, wk);
+        }
+        _flush_queue_sema.signal();
+    }
+    else
+    {
+        process_flush(df, wk);
+    }
+}
+
+void disk_engine::process_flush(disk_file* df, aio_task* wk)
+{
+    while (wk)
+    {
+        auto err = _flush_datasync ? _provider->flush_data(df->native_handle()) : _provider->flush(df->native_handle());
+        wk = df->on_flush_completed(wk, err);
+    }
+}
+
+void disk_engine::flush_thread_main()
+{
+    while (true)
+    {
+        _flush_queue_sema.wait();
+
+        std::pair<disk_file*, aio_task*> wk;
+        {
+            utils::auto_lock<utils::ex_lock_nr> l(_flush_queue_lock);
+            wk = _flush_queue.front();
+            _flush_queue.pop();
+        }
+
+        process_flush(wk.first, wk.second);
+    }
+}
+
+class batch_read_io_task : public aio_task
+{
+public:
+    batch_read_io_task(aio_task* tasks, blob& buffer)
+        : aio_task(LPC_AIO_BATCH_READ, nullptr, tasks, nullptr)
+    {
+        _buffer = buffer;
+    }
+
+    virtual void exec() override
+    {
+        aio_task* tasks = (aio_task*)_context;
+        auto df = (disk_file*)tasks->aio()->file_object;
+        uint32_t sz;
+
+        auto wk = df->on_batch_read_completed(tasks, (void*)&sz, error(), _transferred_size,
+            _buffer.data(), aio()->file_offset);
+        if (wk)
+        {
+            wk->aio()->engine->process_read(wk, sz);
+        }
+    }
+
+public:
+    blob         _buffer;
+};
+
+void disk_engine::process_read(aio_task* aio, uint32_t sz)
+{
+    auto alignment = ((disk_file*)aio->aio()->file_object)->direct_alignment();
+
+    // no batching
+    if (aio->next == nullptr && (alignment == 0 || is_direct_io_aligned(aio, alignment)))
+    {
+        return _provider->aio(aio);
+    }
+
+    // read the merged range into one buffer, which is split in batch_read_io_task::exec;
+    // unaligned direct reads go this way too with the range and buffer aligned
+    else
+    {
+        uint64_t offset = aio->aio()->file_offset;
+        for (auto current_wk = (aio_task*)aio->next; current_wk; current_wk = (aio_task*)current_wk->next)
+        {
+            offset = std::min(offset, current_wk->aio()->file_offset);
+        }
+
+        blob bb;
+        if (alignment > 0)
+        {
+            uint64_t end = offset + sz;
+            offset &= ~(uint64_t)(alignment - 1);
+            end = (end + alignment - 1) & ~(uint64_t)(alignment - 1);
+            sz = (uint32_t)(end - offset);
+            bb = tls_trans_mem_alloc_aligned_blob((size_t)sz, alignment);
+        }
+        else
+        {
+            bb = tls_trans_mem_alloc_blob((size_t)sz);
+        }
+        if (aio->next != nullptr)
+        {
+            ((disk_file*)aio->aio()->file_object)->add_merged_read();
+        }
+
+        auto new_task = new batch_read_io_task(aio, bb);
+        auto dio = new_task->aio();
+        dio->buffer = (void*)bb.data();
+        dio->buffer_size = sz;
+        dio->file_offset = offset;
+
+        dio->file = aio->aio()->file;
+        dio->file_object = aio->aio()->file_object;
+        dio->engine = aio->aio()->engine;
+        dio->type = AIO_Read;
+
+        new_task->add_ref(); // released in complete_io
+        return _provider->aio(new_task);
     }
 }
 
@@ -321,6 +822,11 @@ void disk_engine::write(aio_task* aio)
     dio->engine = this;
     dio->type = AIO_Write;    
 
+    if (df->direct_alignment() > 0)
+    {
+        prepare_direct_write(df, aio);
+    }
+
     uint32_t sz;
     auto wk = df->write(aio, &sz);
     if (wk)
@@ -329,20 +835,93 @@ void disk_engine::write(aio_task* aio)
     }
 }
 
+void disk_engine::prepare_direct_write(disk_file* df, aio_task* aio)
+{
+    auto dio = aio->aio();
+    auto alignment = df->direct_alignment();
+
+    // unaligned buffers are copied to an aligned bounce buffer, while the unaligned
+    // ranges are copied when they are widened in process_direct_rmw_write
+    if (is_aligned(dio->file_offset, alignment) && is_aligned(dio->buffer_size, alignment)
+        && !is_direct_io_aligned(aio, alignment))
+    {
+        df->add_direct_write(false);
+        collapse_aligned(aio, alignment);
+    }
+}
+
 void disk_engine::process_write(aio_task* aio, uint32_t sz)
 {
+    auto alignment = ((disk_file*)aio->aio()->file_object)->direct_alignment();
+    if (alignment > 0 && (!is_aligned(aio->aio()->file_offset, alignment) || !is_aligned(sz, alignment)))
+    {
+        return process_direct_rmw_write(aio, sz);
+    }
+
     // no batching
     if (aio->aio()->buffer_size == sz)
     {
-        aio->collapse();
+        if (!_provider->vectored_write_supported()
+            || (int)aio->_unmerged_write_buffers.size() > _file_options.max_batch_write_buffers)
+        {
+            if (alignment > 0 && !aio->_unmerged_write_buffers.empty())
+                collapse_aligned(aio, alignment);
+            else
+                aio->collapse();
+        }
         return _provider->aio(aio);
     }
 
-    // batching
+    // batching with a vectored write over the buffers of all tasks
+    else if (_provider->vectored_write_supported())
+    {
+        ((disk_file*)aio->aio()->file_object)->add_batch_write(true);
+
+        blob no_buffer;
+        auto new_task = new batch_write_io_task(aio, no_buffer);
+        auto& buffers = new_task->_unmerged_write_buffers;
+        auto current_wk = aio;
+        do
+        {
+            if (current_wk->_unmerged_write_buffers.empty())
+            {
+                dsn_file_buffer_t buffer;
+                buffer.buffer = current_wk->aio()->buffer;
+                buffer.size = (int)current_wk->aio()->buffer_size;
+                buffers.push_back(buffer);
+            }
+            else
+            {
+                buffers.insert(buffers.end(),
+                    current_wk->_unmerged_write_buffers.begin(),
+                    current_wk->_unmerged_write_buffers.end());
+            }
+            current_wk = (aio_task*)current_wk->next;
+        } while (current_wk);
+
+        auto dio = new_task->aio();
+        dio->buffer = nullptr;
+        dio->buffer_size = sz;
+        dio->file_offset = aio->aio()->file_offset;
+
+        dio->file = aio->aio()->file;
+        dio->file_object = aio->aio()->file_object;
+        dio->engine = aio->aio()->engine;
+        dio->type = AIO_Write;
+
+        new_task->add_ref(); // released in complete_io
+        return _provider->aio(new_task);
+    }
+
+    // batching by merging the buffers
     else
     {
+        ((disk_file*)aio->aio()->file_object)->add_batch_write(false);
+
         // merge the buffers
-        auto bb = tls_trans_mem_alloc_blob((size_t)sz);
+        auto bb = alignment > 0 ?
+            tls_trans_mem_alloc_aligned_blob((size_t)sz, alignment) :
+            tls_trans_mem_alloc_blob((size_t)sz);
         char* ptr = (char*)bb.data();
         auto current_wk = aio;
         do
@@ -375,6 +954,167 @@ void disk_engine::process_write(aio_task* aio, uint32_t sz)
     }
 }
 
+# ifdef O_DIRECT
+
+//
+// an unaligned write to a direct io file is widened to the aligned blocks covering it:
+// the partial head and tail blocks are read into an aligned bounce buffer, the written
+// data is copied over them, the whole range is written, and the file is cut back to
+// its size when the tail block was only partially in the file; the write queue runs it
+// alone (see disk_write_queue::unlink_next_workload), so that no other write changes
+// the blocks between the read and the write
+//
+class direct_rmw_write
+{
+public:
+    direct_rmw_write(aio_task* tasks, uint32_t sz, uint32_t alignment)
+        : _tasks(tasks), _size(sz), _alignment(alignment), _read_count(0), _next_read(0)
+    {
+        _offset = tasks->aio()->file_offset;
+        _begin = _offset & ~(uint64_t)(alignment - 1);
+        _end = (_offset + sz + alignment - 1) & ~(uint64_t)(alignment - 1);
+        _file_size = 0;
+        _file_size_known = false;
+
+        if (_offset != _begin)
+            _reads[_read_count++] = _begin;
+        if (_offset + sz != _end && (_read_count == 0 || _end - alignment != _begin))
+            _reads[_read_count++] = _end - alignment;
+
+        _buffer = tls_trans_mem_alloc_aligned_blob((size_t)(_end - _begin), alignment);
+    }
+
+    void start() { next(); }
+
+    void on_io_completed(aio_type type, error_code err, uint32_t bytes)
+    {
+        if (err != ERR_OK && !(type == AIO_Read && err == ERR_HANDLE_EOF))
+        {
+            return complete(err);
+        }
+
+        // the file ends in the block just read, whose rest is zero
+        if (type == AIO_Read)
+        {
+            uint64_t offset = _reads[_next_read - 1];
+            if (bytes < _alignment)
+            {
+                memset((char*)_buffer.data() + (offset - _begin) + bytes, 0, _alignment - bytes);
+                _file_size = std::max(_file_size, offset + bytes);
+                _file_size_known = true;
+            }
+            return next();
+        }
+
+        // cut the padding of the tail block off
+        uint64_t size = std::max(_file_size, _offset + _size);
+        if (_file_size_known && size < _end
+            && ::ftruncate((int)(uintptr_t)(_tasks->aio()->file), (off_t)size) != 0)
+        {
+            derror("truncate direct io file to %" PRIu64 " failed, err = %s", size, strerror(errno));
+            return complete(ERR_FILE_OPERATION_FAILED);
+        }
+        complete(ERR_OK);
+    }
+
+private:
+    void next()
+    {
+        if (_next_read < _read_count)
+        {
+            uint64_t offset = _reads[_next_read++];
+            return issue(LPC_AIO_BATCH_READ, AIO_Read, offset, _alignment);
+        }
+
+        char* ptr = (char*)_buffer.data() + (_offset - _begin);
+        auto current_wk = _tasks;
+        do
+        {
+            current_wk->copy_to(ptr);
+            ptr += current_wk->aio()->buffer_size;
+            current_wk = (aio_task*)current_wk->next;
+        } while (current_wk);
+
+        issue(LPC_AIO_BATCH_WRITE, AIO_Write, _begin, (uint32_t)(_end - _begin));
+    }
+
+    void issue(dsn_task_code_t code, aio_type type, uint64_t offset, uint32_t size);
+
+    void complete(error_code err)
+    {
+        auto df = (disk_file*)_tasks->aio()->file_object;
+        auto engine = _tasks->aio()->engine;
+        uint32_t sz;
+        auto wk = df->on_write_completed(_tasks, (void*)&sz, err, err == ERR_OK ? _size : 0);
+        delete this;
+
+        if (wk)
+        {
+            engine->process_write(wk, sz);
+        }
+    }
+
+private:
+    aio_task* _tasks;
+    uint32_t  _size;
+    uint32_t  _alignment;
+    uint64_t  _offset;
+    uint64_t  _begin;      // aligned range to be written
+    uint64_t  _end;
+    blob      _buffer;     // of [_begin, _end)
+    uint64_t  _reads[2];   // offsets of the head and tail blocks to be read
+    int       _read_count;
+    int       _next_read;
+    uint64_t  _file_size;  // known when a read is short
+    bool      _file_size_known;
+};
+
+class direct_rmw_io_task : public aio_task
+{
+public:
+    direct_rmw_io_task(dsn_task_code_t code, direct_rmw_write* rmw)
+        : aio_task(code, nullptr, rmw, nullptr)
+    {
+    }
+
+    virtual void exec() override
+    {
+        ((direct_rmw_write*)_context)->on_io_completed(aio()->type, error(), (uint32_t)_transferred_size);
+    }
+};
+
+void direct_rmw_write::issue(dsn_task_code_t code, aio_type type, uint64_t offset, uint32_t size)
+{
+    auto new_task = new direct_rmw_io_task(code, this);
+    auto dio = new_task->aio();
+    dio->buffer = (char*)_buffer.data() + (offset - _begin);
+    dio->buffer_size = size;
+    dio->file_offset = offset;
+
+    dio->file = _tasks->aio()->file;
+    dio->file_object = _tasks->aio()->file_object;
+    dio->engine = _tasks->aio()->engine;
+    dio->type = type;
+
+    new_task->add_ref(); // released in complete_io
+    dio->engine->_provider->aio(new_task);
+}
+
+# endif
+
+void disk_engine::process_direct_rmw_write(aio_task* aio, uint32_t sz)
+{
+# ifdef O_DIRECT
+    auto df = (disk_file*)aio->aio()->file_object;
+    df->add_direct_write(true);
+
+    auto rmw = new direct_rmw_write(aio, sz, df->direct_alignment());
+    rmw->start();
+# else
+    dassert(false, "direct io is not supported");
+# endif
+}
+
 void disk_engine::complete_io(aio_task* aio, error_code err, uint32_t bytes, int delay_milliseconds)
 {
     if (err != ERR_OK)
@@ -386,9 +1126,19 @@ void disk_engine::complete_io(aio_task* aio, error_code err, uint32_t bytes, int
             aio->id()
             );
     }
+
+    if (_file_options.writeback_hint_bytes > 0 && err == ERR_OK && aio->aio()->type == AIO_Write)
+    {
+        uint64_t offset, size;
+        auto df = (disk_file*)(aio->aio()->file_object);
+        if (df->add_written(aio->aio()->file_offset, bytes, _file_options.writeback_hint_bytes, offset, size))
+        {
+            _provider->writeback_hint(df->native_handle(), offset, size);
+        }
+    }
     
     // batching
-    if (aio->code() == LPC_AIO_BATCH_WRITE)
+    if (aio->code() == LPC_AIO_BATCH_WRITE || aio->code() == LPC_AIO_BATCH_READ)
     {
         aio->enqueue(err, (size_t)bytes);
         aio->release_ref(); // added in process_write
@@ -400,11 +1150,12 @@ void disk_engine::complete_io(aio_task* aio, error_code err, uint32_t bytes, int
         auto df = (disk_file*)(aio->aio()->file_object);
         if (aio->aio()->type == AIO_Read)
         {
-            auto wk = df->on_read_completed(aio, err, (size_t)bytes);
+            uint32_t sz;
+            auto wk = df->on_read_completed(aio, (void*)&sz, err, (size_t)bytes);
             if (wk)
             {
-                _provider->aio(wk);
-            }            
+                process_read(wk, sz);
+            }
         }
 
         // write
@@ -39,16 +39,36 @@
 # include <dsn/utility/synchronize.h>
 # include <dsn/tool-api/aio_provider.h>
 # include <dsn/utility/work_queue.h>
+# include <queue>
+# include <atomic>
 
 namespace dsn {
 
 class disk_write_queue : public work_queue<aio_task>
 {
 public:
-    disk_write_queue()
+    disk_write_queue(uint32_t max_batch_bytes, int max_batch_buffers)
         : work_queue(200)
     {
-        _max_batch_bytes = 1024 * 1024; // 1 MB
+        _max_batch_bytes = max_batch_bytes;
+        _max_batch_buffers = max_batch_buffers;
+        _direct_alignment = 0;
+        _unaligned_running = false;
+    }
+
+    using work_queue::reset_max_concurrent_ops;
+    void reset_max_batch_bytes(uint32_t max_batch_bytes)
+    {
+        scope_lk l(_lock);
+        _max_batch_bytes = max_batch_bytes;
+    }
+
+    // writes to direct io files whose ranges are not aligned run alone, see
+    // disk_engine::process_direct_rmw_write
+    void set_direct_alignment(uint32_t alignment)
+    {
+        scope_lk l(_lock);
+        _direct_alignment = alignment;
     }
 
 private:
@@ -56,25 +76,127 @@ private:
 
 private:
     uint32_t _max_batch_bytes;
+    int      _max_batch_buffers; // bounded by IOV_MAX for vectored writes
+    uint32_t _direct_alignment;  // 0 for not direct
+    bool     _unaligned_running; // an unaligned direct write is running alone
+};
+
+//
+// pending reads whose ranges are adjacent or overlapping are merged into one read
+// of at most _max_coalesce_bytes, the merged tasks are linked by aio_task::next
+//
+class disk_read_queue : public work_queue<aio_task>
+{
+public:
+    disk_read_queue(int max_concurrent_ops, uint32_t max_coalesce_bytes)
+        : work_queue(max_concurrent_ops)
+    {
+        _max_coalesce_bytes = max_coalesce_bytes;
+    }
+
+    using work_queue::reset_max_concurrent_ops;
+    void reset_max_coalesce_bytes(uint32_t max_coalesce_bytes)
+    {
+        scope_lk l(_lock);
+        _max_coalesce_bytes = max_coalesce_bytes;
+    }
+
+private:
+    virtual aio_task* unlink_next_workload(void* plength) override;
+
+private:
+    uint32_t _max_coalesce_bytes;
+};
+
+struct disk_file_options
+{
+    uint32_t max_batch_write_bytes;
+    int      max_batch_write_buffers;
+    int      max_concurrent_reads;
+    uint32_t max_coalesce_read_bytes;
+    uint64_t writeback_hint_bytes;
 };
 
 class disk_file
 {
 public:
-    disk_file(dsn_handle_t handle);
+    disk_file(dsn_handle_t handle, const disk_file_options& options);
     void ctrl(dsn_ctrl_code_t code, int param);
-    aio_task* read(aio_task* tsk);
+    aio_task* read(aio_task* tsk, void* ctx);
     aio_task* write(aio_task* tsk, void* ctx);
 
-    aio_task* on_read_completed(aio_task* wk, error_code err, size_t size);
+    aio_task* on_read_completed(aio_task* wk, void* ctx, error_code err, size_t size);
+    // split the merged read in buffer (at file offset) to the linked read tasks
+    aio_task* on_batch_read_completed(aio_task* wk, void* ctx, error_code err, size_t size,
+        const char* buffer, uint64_t offset);
     aio_task* on_write_completed(aio_task* wk, void* ctx, error_code err, size_t size);
+
+    // group commit: return the flush tasks to be committed by a new flush, or nullptr
+    // when a flush is running, whose completion picks up the pending ones
+    aio_task* add_flush(aio_task* tsk);
+    aio_task* on_flush_completed(aio_task* wk, error_code err);
+    // wait until the running and pending group commits are completed, before closing
+    void wait_flushes();
+    // how many flushes are issued to the aio provider for the group commits
+    uint64_t flush_count() const { return _flush_count.load(std::memory_order_relaxed); }
+
+    // how many ios carry more than one write (of which as vectored writes) or read
+    void add_batch_write(bool vectored)
+    {
+        _batch_write_count.fetch_add(1, std::memory_order_relaxed);
+        if (vectored)
+            _vectored_write_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    void add_merged_read() { _merged_read_count.fetch_add(1, std::memory_order_relaxed); }
+    uint64_t batch_write_count() const { return _batch_write_count.load(std::memory_order_relaxed); }
+    uint64_t vectored_write_count() const { return _vectored_write_count.load(std::memory_order_relaxed); }
+    uint64_t merged_read_count() const { return _merged_read_count.load(std::memory_order_relaxed); }
+
+    // account the written range, return true with the range to be written back once
+    // there are at least threshold bytes written since the last time
+    bool add_written(uint64_t offset, uint64_t size, uint64_t threshold,
+        /*out*/ uint64_t& writeback_offset, /*out*/ uint64_t& writeback_size);
     
     dsn_handle_t native_handle() const { return _handle; }
 
+    // direct io (O_DIRECT) needs aligned buffers, offsets and sizes, the unaligned
+    // buffers are copied to aligned ones (bounce), and the unaligned ranges are
+    // widened to the aligned blocks with their old content (read-modify-write)
+    void set_direct(uint32_t alignment)
+    {
+        _direct_alignment = alignment;
+        _write_queue.set_direct_alignment(alignment);
+    }
+    uint32_t     direct_alignment() const { return _direct_alignment; } // 0 for not direct
+    void add_direct_write(bool rmw)
+    {
+        if (rmw)
+            _direct_rmw_write_count.fetch_add(1, std::memory_order_relaxed);
+        else
+            _direct_bounce_write_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    uint64_t direct_bounce_write_count() const { return _direct_bounce_write_count.load(std::memory_order_relaxed); }
+    uint64_t direct_rmw_write_count() const { return _direct_rmw_write_count.load(std::memory_order_relaxed); }
+
 private:
     dsn_handle_t     _handle;
+    uint32_t         _direct_alignment;
     disk_write_queue _write_queue;
-    work_queue<aio_task> _read_queue;
+    disk_read_queue  _read_queue;
+
+    utils::ex_lock_nr_spin _flush_lock;
+    slist<aio_task>  _pending_flushes;
+    bool             _flushing;
+    utils::notify_event* _flush_drained; // the waiter in wait_flushes
+    std::atomic<uint64_t> _flush_count;
+    std::atomic<uint64_t> _batch_write_count;
+    std::atomic<uint64_t> _vectored_write_count;
+    std::atomic<uint64_t> _merged_read_count;
+    std::atomic<uint64_t> _direct_bounce_write_count;
+    std::atomic<uint64_t> _direct_rmw_write_count;
+    uint64_t         _written_begin;
+    uint64_t         _written_end;
+    uint64_t         _written_bytes;
 };
 
 class disk_engine
@@ -91,21 +213,40 @@ public:
     error_code      flush(dsn_handle_t fh);
     void            read(aio_task* aio);
     void            write(aio_task* aio);  
+    void            flush_async(aio_task* aio);
 
     void            ctrl(dsn_handle_t fh, dsn_ctrl_code_t code, int param);
     disk_aio*       prepare_aio_context(aio_task* tsk) { return _provider->prepare_aio_context(tsk); }
     service_node*   node() const { return _node; }
+    aio_provider*   provider() const { return _provider; }
     
 private:
     friend class aio_provider;
     friend class batch_write_io_task;
+    friend class batch_read_io_task;
+    friend class direct_rmw_write;
+    void process_read(aio_task* wk, uint32_t sz);
     void process_write(aio_task* wk, uint32_t sz);
+    void process_flush(disk_file* df, aio_task* wk);
+    void prepare_direct_write(disk_file* df, aio_task* aio);
+    void process_direct_rmw_write(aio_task* aio, uint32_t sz);
+    void flush_thread_main();
     void complete_io(aio_task* aio, error_code err, uint32_t bytes, int delay_milliseconds = 0);
+    static void on_transient_block(void* context, char* blk, size_t size, bool allocated);
 
 private:
     volatile bool   _is_running;
     aio_provider    *_provider;
     service_node    *_node;
+    disk_file_options _file_options;
+    uint32_t        _direct_io_alignment;
+
+    // group commits waiting for the flush threads
+    bool            _flush_datasync;
+    int             _flush_thread_count;
+    utils::ex_lock_nr _flush_queue_lock;
+    utils::semaphore  _flush_queue_sema;
+    std::queue<std::pair<disk_file*, aio_task*>> _flush_queue;
 };
 
 } // end namespace
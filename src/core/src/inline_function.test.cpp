@@ -0,0 +1,101 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     Unit-test for inline_function.
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# include <dsn/cpp/inline_function.h>
+# include <gtest/gtest.h>
+# include <cstring>
+# include <memory>
+# include <string>
+
+using namespace ::dsn;
+
+TEST(core, inline_function)
+{
+    // empty
+    inline_function<int(int)> f0;
+    ASSERT_FALSE((bool)f0);
+    f0 = nullptr;
+    ASSERT_FALSE((bool)f0);
+
+    // small capture is stored inline
+    int base = 10;
+    inline_function<int(int)> f1([base](int v) { return base + v; });
+    ASSERT_TRUE((bool)f1);
+    ASSERT_TRUE(f1.is_inline());
+    ASSERT_EQ(15, f1(5));
+
+    // large capture falls back to heap
+    char large[256];
+    memset(large, 1, sizeof(large));
+    inline_function<int(int)> f2([large](int v) { return large[0] + large[255] + v; });
+    ASSERT_TRUE((bool)f2);
+    ASSERT_FALSE(f2.is_inline());
+    ASSERT_EQ(5, f2(3));
+
+    // move-only capture
+    std::unique_ptr<std::string> ptr(new std::string("hello"));
+    inline_function<size_t()> f3([p = std::move(ptr)]() { return p->length(); });
+    ASSERT_TRUE(f3.is_inline());
+    ASSERT_EQ(5u, f3());
+
+    // move transfers ownership, for both inline and heap storage
+    inline_function<size_t()> f4(std::move(f3));
+    ASSERT_FALSE((bool)f3);
+    ASSERT_EQ(5u, f4());
+
+    inline_function<int(int)> f5;
+    f5 = std::move(f2);
+    ASSERT_FALSE((bool)f2);
+    ASSERT_FALSE(f5.is_inline());
+    ASSERT_EQ(6, f5(4));
+
+    // captured objects are destroyed exactly once
+    auto counter = std::make_shared<int>(0);
+    {
+        inline_function<void()> f6([counter]() { (*counter)++; });
+        ASSERT_EQ(2, counter.use_count());
+        f6();
+        inline_function<void()> f7(std::move(f6));
+        ASSERT_EQ(2, counter.use_count());
+        f7();
+    }
+    ASSERT_EQ(1, counter.use_count());
+    ASSERT_EQ(2, *counter);
+
+    // a larger inline buffer keeps the large capture inline
+    inline_function<int(int), 512> f8([large](int v) { return large[0] + v; });
+    ASSERT_TRUE(f8.is_inline());
+    ASSERT_EQ(2, f8(1));
+}
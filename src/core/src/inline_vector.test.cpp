@@ -0,0 +1,107 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     Unit-test for inline_vector.
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# include <dsn/cpp/inline_vector.h>
+# include <gtest/gtest.h>
+# include <memory>
+# include <string>
+
+using namespace ::dsn;
+
+TEST(core, inline_vector)
+{
+    inline_vector<std::string, 2> v;
+    ASSERT_TRUE(v.empty());
+    ASSERT_TRUE(v.is_inline());
+
+    // the first elements are stored inline
+    v.push_back("a");
+    v.emplace_back("b");
+    ASSERT_EQ(2u, v.size());
+    ASSERT_TRUE(v.is_inline());
+    ASSERT_EQ("a", v.front());
+    ASSERT_EQ("b", *v.rbegin());
+
+    // more elements move all to heap, including one referring to the vector itself
+    v.push_back(v[0]);
+    ASSERT_FALSE(v.is_inline());
+    ASSERT_EQ(3u, v.size());
+    ASSERT_EQ("a", v.back());
+
+    std::string all;
+    for (auto& s : v)
+        all += s;
+    ASSERT_EQ("aba", all);
+
+    // copy
+    inline_vector<std::string, 2> v2(v);
+    ASSERT_EQ(3u, v2.size());
+    ASSERT_EQ("aba", v2[0] + v2[1] + v2[2]);
+
+    // move steals the heap storage
+    inline_vector<std::string, 2> v3(std::move(v));
+    ASSERT_TRUE(v.empty());
+    ASSERT_TRUE(v.is_inline());
+    ASSERT_FALSE(v3.is_inline());
+    ASSERT_EQ(3u, v3.size());
+
+    // move of inline elements
+    inline_vector<std::string, 2> v4;
+    v4.push_back("x");
+    v = std::move(v4);
+    ASSERT_TRUE(v4.empty());
+    ASSERT_EQ(1u, v.size());
+    ASSERT_EQ("x", v[0]);
+
+    // resize and clear
+    v3.resize(1);
+    ASSERT_EQ(1u, v3.size());
+    ASSERT_EQ("a", v3[0]);
+    v3.resize(4);
+    ASSERT_EQ(4u, v3.size());
+    ASSERT_TRUE(v3[3].empty());
+    v3.clear();
+    ASSERT_TRUE(v3.empty());
+
+    // elements are destroyed
+    std::shared_ptr<int> p(new int(1));
+    {
+        inline_vector<std::shared_ptr<int>, 1> pv;
+        pv.push_back(p);
+        pv.push_back(p);
+        ASSERT_EQ(3, p.use_count());
+    }
+    ASSERT_EQ(1, p.use_count());
+}
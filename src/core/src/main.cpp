@@ -55,6 +55,8 @@
 # include "task_engine.h"
 # include "coredump.h"
 # include "transient_memory.h"
+# include "slab_pool.h"
+# include "memory_accounting.h"
 # include "library_utils.h"
 # include <fstream>
 
@@ -379,9 +381,38 @@ bool run(
         1024, // 1 MB
         "thread local transient memory buffer size (KB), default is 1024"
         );
-    ::dsn::tls_trans_mem_init(tls_trans_memory_KB * 1024);
+    auto tls_trans_memory_long_KB = (size_t)dsn_all.config->get_value<int>(
+        "core", "tls_trans_memory_long_KB",
+        64,
+        "thread local transient memory buffer size (KB) for long-lived objects, see dsn_transient_malloc_long"
+        );
+    ::dsn::tls_trans_mem_init(tls_trans_memory_KB * 1024, tls_trans_memory_long_KB * 1024);
+
+    ::dsn::tls_trans_mem_pool_options pool_opts;
+    pool_opts.max_pooled_bytes = (size_t)dsn_all.config->get_value<int>(
+        "core", "tls_trans_memory_pool_MB",
+        64,
+        "max memory (MB) of the recycled thread local transient memory blocks, 0 for no recycling"
+        ) * 1024 * 1024;
+    pool_opts.local_block_count = dsn_all.config->get_value<int>(
+        "core", "tls_trans_memory_pool_local_blocks",
+        2,
+        "max recycled transient memory blocks cached by each thread, [0, 16]"
+        );
+    pool_opts.prefault = dsn_all.config->get_value<bool>(
+        "core", "tls_trans_memory_prefault",
+        false,
+        "whether to touch all pages of the newly allocated transient memory blocks"
+        );
+    pool_opts.huge_page = dsn_all.config->get_value<bool>(
+        "core", "tls_trans_memory_huge_page",
+        false,
+        "whether to advise transparent huge pages for the newly allocated transient memory blocks (linux only)"
+        );
+    ::dsn::tls_trans_mem_pool_init(pool_opts);
     dsn_all.memory = ::dsn::utils::factory_store< ::dsn::memory_provider>::create(
         spec.tools_memory_factory_name.c_str(), ::dsn::PROVIDER_TYPE_MAIN);
+    ::dsn::dsn_malloc_init(dsn_all.memory);
 
     // prepare minimum necessary
     ::dsn::service_engine::fast_instance().init_before_toollets(spec);
@@ -405,6 +436,14 @@ bool run(
     // init runtime
     ::dsn::service_engine::fast_instance().init_after_toollets();
 
+    // init memory accounting after all task codes and perf counter providers are ready
+    ::dsn::memory_accounting::init(dsn_all.config->get_value<uint64_t>(
+        "core", "memory_accounting_sample_bytes",
+        0,
+        "sample one dsn_malloc/transient object allocation every this many bytes allocated by each thread, "
+        "to attribute memory to task codes and thread pools, 0 to disable"
+        ));
+
     dsn_all.engine_ready = true;
 
     // split app_name and app_index
@@ -480,6 +519,54 @@ bool run(
         return oss.str();
     });
     
+    ::dsn::register_command("tls-trans-mem",
+        "tls-trans-mem - query stats of the thread local transient memory blocks (recycling, live vs. pinned bytes)",
+        "tls-trans-mem",
+        [](const ::dsn::safe_vector< ::dsn::safe_string>& args)
+    {
+        ::dsn::tls_trans_mem_pool_stats stats;
+        ::dsn::tls_trans_mem_pool_get_stats(stats);
+
+        ::dsn::safe_sstream ss;
+        auto total = stats.hits + stats.misses;
+        ss << "hits = " << stats.hits
+            << ", misses = " << stats.misses
+            << ", hit rate = " << (total == 0 ? 0.0 : (double)stats.hits / (double)total)
+            << ", recycled = " << stats.recycled
+            << ", dropped = " << stats.dropped
+            << ", pooled bytes = " << stats.pooled_bytes
+            << std::endl;
+
+        const char* lanes[] = { "short", "long" };
+        for (int lane = 0; lane < ::dsn::TRANS_MEM_LANE_COUNT; lane++)
+        {
+            ::dsn::tls_trans_mem_block_stats bs;
+            ::dsn::tls_trans_mem_get_block_stats(lane, bs);
+            ss << lanes[lane] << "-lived blocks: alive = " << bs.alive_blocks
+                << " (" << bs.alive_bytes << " bytes)"
+                << ", pinned = " << bs.pinned_blocks
+                << " (" << bs.pinned_bytes << " bytes, " << bs.pinned_live_bytes << " bytes live)"
+                << std::endl;
+        }
+        return ss.str();
+    });
+
+    ::dsn::register_command("mem.accounting",
+        "mem.accounting - query the sampled live and allocated bytes by thread pool and task code",
+        "mem.accounting",
+        [](const ::dsn::safe_vector< ::dsn::safe_string>& args)
+    {
+        return ::dsn::memory_accounting::get_stats();
+    });
+
+    ::dsn::register_command("slab-pool",
+        "slab-pool - query stats of the slab pools of messages and rpc tasks",
+        "slab-pool",
+        [](const ::dsn::safe_vector< ::dsn::safe_string>& args)
+    {
+        return ::dsn::slab_pool::get_all_stats();
+    });
+
     // invoke customized init after apps are created
     dsn::tools::sys_init_after_app_created.execute();
 
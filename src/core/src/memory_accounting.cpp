@@ -0,0 +1,236 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     sampled memory accounting by task code and thread pool
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# include "memory_accounting.h"
+# include <dsn/tool-api/task.h>
+# include <dsn/tool-api/task_spec.h>
+# include <dsn/tool-api/perf_counter.h>
+# include <algorithm>
+# include <atomic>
+# include <vector>
+
+# ifdef __TITLE__
+# undef __TITLE__
+# endif
+# define __TITLE__ "memory.accounting"
+
+namespace dsn {
+
+__thread int64_t tls_mem_acct_bytes_to_sample;
+std::atomic<uint64_t> memory_accounting::s_sample_bytes(0);
+
+// tags are task code + 1, and never reach 0xdead, which is used by transient
+// objects as the magic of the untagged ones
+# define MEM_ACCT_MAX_CODE_COUNT 0xdeac
+
+struct mem_acct_stats
+{
+    std::atomic<int64_t>  live_bytes;
+    std::atomic<uint64_t> alloc_bytes;
+    perf_counter*         live_counter;
+    perf_counter*         alloc_counter;
+};
+
+// never released as memory may be freed during process exit
+static mem_acct_stats* s_code_stats = nullptr;
+static int             s_code_count = 0;
+static mem_acct_stats* s_pool_stats = nullptr;
+static int             s_pool_count = 0;
+static int*            s_code_pools = nullptr; // pool of each task code, -1 for none
+static uint64_t        s_sample_weight = 0;    // bytes a small sample stands for, fixed with the stats
+
+static void init_stats(mem_acct_stats& st, const std::string& name)
+{
+    st.live_bytes.store(0);
+    st.alloc_bytes.store(0);
+
+    auto c = perf_counter::get_counter("core", "memory", (name + ".live(bytes)").c_str(),
+        COUNTER_TYPE_NUMBER, "live bytes of the sampled memory allocations", true);
+    c->add_ref();
+    st.live_counter = c.get();
+
+    c = perf_counter::get_counter("core", "memory", (name + ".alloc(bytes/s)").c_str(),
+        COUNTER_TYPE_RATE, "bytes of the sampled memory allocations per second", true);
+    c->add_ref();
+    st.alloc_counter = c.get();
+}
+
+/*static*/ void memory_accounting::init(uint64_t sample_bytes)
+{
+    // the allocations sampled before are still unsampled when they are freed
+    if (sample_bytes == 0)
+    {
+        s_sample_bytes.store(0, std::memory_order_relaxed);
+        return;
+    }
+
+    if (s_code_stats != nullptr)
+    {
+        if (sample_bytes != s_sample_weight)
+        {
+            dwarn("memory accounting keeps sampling every %" PRIu64 " bytes instead of %" PRIu64,
+                s_sample_weight, sample_bytes);
+        }
+        s_sample_bytes.store(s_sample_weight, std::memory_order_release);
+        return;
+    }
+
+    s_code_count = std::min(dsn_task_code_max() + 1, MEM_ACCT_MAX_CODE_COUNT);
+    s_pool_count = dsn_threadpool_code_max() + 1;
+    s_code_stats = new mem_acct_stats[s_code_count];
+    s_pool_stats = new mem_acct_stats[s_pool_count];
+    s_code_pools = new int[s_code_count];
+
+    for (int i = 0; i < s_pool_count; i++)
+    {
+        init_stats(s_pool_stats[i], std::string("pool.") + dsn_threadpool_code_to_string(i));
+    }
+
+    for (int i = 0; i < s_code_count; i++)
+    {
+        init_stats(s_code_stats[i], dsn_task_code_to_string(i));
+
+        auto spec = task_spec::get(i);
+        s_code_pools[i] = (i == TASK_CODE_INVALID || spec == nullptr) ? -1 : (int)spec->pool_code;
+    }
+
+    // published to the allocating threads by the release store
+    s_sample_weight = sample_bytes;
+    s_sample_bytes.store(sample_bytes, std::memory_order_release);
+}
+
+/*static*/ uint16_t memory_accounting::sample(size_t sz)
+{
+    int code = TASK_CODE_INVALID;
+    if (tls_dsn.magic == 0xdeadbeef && tls_dsn.current_task != nullptr)
+    {
+        code = tls_dsn.current_task->spec().code;
+        if (code >= s_code_count)
+            code = TASK_CODE_INVALID;
+    }
+
+    int64_t weight = (int64_t)(sz < s_sample_weight ? s_sample_weight : sz);
+
+    auto& st = s_code_stats[code];
+    st.live_counter->set((uint64_t)(st.live_bytes.fetch_add(weight, std::memory_order_relaxed) + weight));
+    st.alloc_bytes.fetch_add((uint64_t)weight, std::memory_order_relaxed);
+    st.alloc_counter->add((uint64_t)weight);
+
+    int pool = s_code_pools[code];
+    if (pool >= 0)
+    {
+        auto& pst = s_pool_stats[pool];
+        pst.live_counter->set((uint64_t)(pst.live_bytes.fetch_add(weight, std::memory_order_relaxed) + weight));
+        pst.alloc_bytes.fetch_add((uint64_t)weight, std::memory_order_relaxed);
+        pst.alloc_counter->add((uint64_t)weight);
+    }
+
+    return (uint16_t)(code + 1);
+}
+
+/*static*/ void memory_accounting::unsample(uint16_t tag, size_t sz)
+{
+    int code = (int)tag - 1;
+    dassert(code < s_code_count, "invalid memory accounting tag %d", (int)tag);
+
+    int64_t weight = (int64_t)(sz < s_sample_weight ? s_sample_weight : sz);
+
+    auto& st = s_code_stats[code];
+    st.live_counter->set((uint64_t)(st.live_bytes.fetch_sub(weight, std::memory_order_relaxed) - weight));
+
+    int pool = s_code_pools[code];
+    if (pool >= 0)
+    {
+        auto& pst = s_pool_stats[pool];
+        pst.live_counter->set((uint64_t)(pst.live_bytes.fetch_sub(weight, std::memory_order_relaxed) - weight));
+    }
+}
+
+/*static*/ safe_string memory_accounting::get_stats()
+{
+    if (!enabled())
+        return "memory accounting is disabled, see [core] memory_accounting_sample_bytes";
+
+    // name, live bytes, allocated bytes
+    struct item
+    {
+        std::string name;
+        int64_t     live;
+        uint64_t    allocated;
+    };
+
+    auto collect = [](std::vector<item>& items, const mem_acct_stats& st, const char* name)
+    {
+        uint64_t allocated = st.alloc_bytes.load(std::memory_order_relaxed);
+        if (allocated != 0)
+            items.push_back(item{ name, st.live_bytes.load(std::memory_order_relaxed), allocated });
+    };
+
+    auto print = [](safe_sstream& ss, std::vector<item>& items)
+    {
+        std::sort(items.begin(), items.end(), [](const item& l, const item& r)
+        {
+            return l.live > r.live;
+        });
+
+        for (auto& it : items)
+        {
+            ss << "  " << it.name
+                << ": live = " << it.live
+                << ", allocated = " << it.allocated
+                << std::endl;
+        }
+    };
+
+    safe_sstream ss;
+    std::vector<item> items;
+    for (int i = 0; i < s_pool_count; i++)
+    {
+        collect(items, s_pool_stats[i], dsn_threadpool_code_to_string(i));
+    }
+    ss << "by thread pool (bytes, sampled every " << s_sample_weight << " bytes):" << std::endl;
+    print(ss, items);
+
+    items.clear();
+    for (int i = 0; i < s_code_count; i++)
+    {
+        collect(items, s_code_stats[i], i == TASK_CODE_INVALID ? "(not in task)" : dsn_task_code_to_string(i));
+    }
+    ss << "by task code:" << std::endl;
+    print(ss, items);
+    return ss.str();
+}
+
+}
@@ -0,0 +1,104 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     sampled memory accounting by task code and thread pool
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# pragma once
+
+# include <dsn/service_api_c.h>
+# include <dsn/cpp/safe_string.h>
+# include <atomic>
+
+namespace dsn {
+
+extern __thread int64_t tls_mem_acct_bytes_to_sample;
+
+//
+// memory_accounting attributes the transient objects (dsn_transient_malloc) and dsn_malloc
+// memory to the task code of the current task (TASK_CODE_INVALID when not in a task),
+// so that we can tell which rpc types and pools hold the memory:
+// - allocations smaller than sample_bytes are sampled once every sample_bytes bytes
+//   allocated by each thread, and each sample stands for sample_bytes bytes, while
+//   larger allocations are always sampled with their own sizes
+// - a sampled allocation gets a tag, which must be passed to on_free with the same size
+// - live bytes and allocation rate are reported by perf counters
+//   "core*memory*<task code>.live(bytes)" and "core*memory*<task code>.alloc(bytes/s)",
+//   and the same ones per thread pool, as well as the command "mem.accounting"
+//
+// message buffers and other blobs are not accounted as they are released with their blocks.
+//
+class memory_accounting
+{
+public:
+    // sample_bytes = 0 disables the accounting, the sample bytes cannot be changed
+    // once enabled (the later values are ignored)
+    static void init(uint64_t sample_bytes);
+    static bool enabled() { return sample_bytes() != 0; }
+    static uint64_t sample_bytes() { return s_sample_bytes.load(std::memory_order_relaxed); }
+
+    // return the tag of the allocation, 0 for not sampled
+    static uint16_t on_alloc(size_t sz)
+    {
+        // acquire the stats published by init
+        uint64_t sample_bytes = s_sample_bytes.load(std::memory_order_acquire);
+        if (sample_bytes == 0)
+            return 0;
+
+        if (sz < sample_bytes)
+        {
+            tls_mem_acct_bytes_to_sample -= (int64_t)sz;
+            if (tls_mem_acct_bytes_to_sample > 0)
+                return 0;
+            tls_mem_acct_bytes_to_sample += (int64_t)sample_bytes;
+        }
+        return sample(sz);
+    }
+
+    static void on_free(uint16_t tag, size_t sz)
+    {
+        if (tag != 0)
+            unsample(tag, sz);
+    }
+
+    // per task code and per thread pool stats, for the command line
+    static safe_string get_stats();
+
+private:
+    static uint16_t sample(size_t sz);
+    static void unsample(uint16_t tag, size_t sz);
+
+private:
+    static std::atomic<uint64_t> s_sample_bytes;
+};
+
+}
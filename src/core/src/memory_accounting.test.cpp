@@ -0,0 +1,90 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     Unit-test for memory_accounting.
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# include "memory_accounting.h"
+# include <gtest/gtest.h>
+# include <dsn/service_api_cpp.h>
+# include <dsn/cpp/test_utils.h>
+# include <dsn/tool-api/perf_counter.h>
+
+using namespace ::dsn;
+
+static void on_memory_accounting_test(void* p)
+{
+    auto objs = (void**)p;
+    objs[0] = dsn_transient_malloc(64 * 1024);
+    objs[1] = dsn_malloc(64 * 1024);
+}
+
+static int64_t memory_live_bytes(const char* name)
+{
+    auto c = perf_counter::get_counter("core", "memory", (std::string(name) + ".live(bytes)").c_str(),
+        COUNTER_TYPE_NUMBER, "", false);
+    return c.get() == nullptr ? -1 : (int64_t)c->get_integer_value();
+}
+
+TEST(core, memory_accounting)
+{
+    // restored at the end, as it may be enabled by the config
+    uint64_t sample_bytes = memory_accounting::sample_bytes();
+    memory_accounting::init(4096);
+    ASSERT_TRUE(memory_accounting::enabled());
+
+    int64_t code_live = memory_live_bytes("LPC_TEST_HASH");
+    ASSERT_LE(0, code_live);
+    ASSERT_LE(0, memory_live_bytes("pool.THREAD_POOL_DEFAULT"));
+
+    // allocations larger than the sample bytes are always sampled
+    void* objs[2];
+    auto t = dsn_task_create(LPC_TEST_HASH, on_memory_accounting_test, (void*)objs, 1);
+    dsn_task_add_ref(t);
+    dsn_task_call(t, 0);
+    dsn_task_wait(t);
+    dsn_task_release_ref(t);
+
+    EXPECT_EQ(code_live + 128 * 1024, memory_live_bytes("LPC_TEST_HASH"));
+
+    auto stats = memory_accounting::get_stats();
+    EXPECT_NE(std::string::npos, stats.find("LPC_TEST_HASH"));
+    EXPECT_NE(std::string::npos, stats.find("THREAD_POOL_DEFAULT"));
+
+    // frees on any thread are attributed to the allocating task code
+    dsn_transient_free(objs[0]);
+    dsn_free(objs[1]);
+    EXPECT_EQ(code_live, memory_live_bytes("LPC_TEST_HASH"));
+
+    memory_accounting::init(sample_bytes);
+    EXPECT_EQ(sample_bytes, memory_accounting::sample_bytes());
+}
@@ -0,0 +1,119 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     node-wide memory budget for in-flight rpc messages
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# include "message_memory_budget.h"
+# include <dsn/tool-api/network.h>
+
+# ifdef __TITLE__
+# undef __TITLE__
+# endif
+# define __TITLE__ "message.budget"
+
+namespace dsn {
+
+message_memory_budget::message_memory_budget()
+    : _usage(0), _limit(0), _delay_ms(0), _reject_priority(TASK_PRIORITY_LOW)
+{
+}
+
+message_memory_budget::~message_memory_budget()
+{
+    if (_usage_counter != nullptr)
+    {
+        perf_counter::remove_counter(_usage_counter->full_name());
+        perf_counter::remove_counter(_delayed_counter->full_name());
+        perf_counter::remove_counter(_rejected_counter->full_name());
+    }
+}
+
+void message_memory_budget::init(const char* node_name)
+{
+    _limit = dsn_config_get_value_uint64(
+        "network", "message_memory_budget_mb",
+        0, "max memory (MB) held by the in-flight messages (received or to be sent) of a node, 0 for unlimited"
+        ) * 1024 * 1024;
+
+    _delay_ms = (int)dsn_config_get_value_uint64(
+        "network", "message_memory_budget_delay_ms",
+        10, "how many milliseconds to delay recving on a session when its new request arrives with message_memory_budget_mb exceeded"
+        );
+
+    _reject_priority = enum_from_string(
+        dsn_config_get_value_string(
+            "network", "message_memory_budget_reject_priority",
+            "TASK_PRIORITY_LOW",
+            "requests with priority no higher than this are rejected when message_memory_budget_mb is exceeded"
+            ), TASK_PRIORITY_INVALID);
+    dassert(_reject_priority != TASK_PRIORITY_INVALID, "invalid [network] message_memory_budget_reject_priority");
+
+    _usage_counter = perf_counter::get_counter(node_name, "engine", "message.memory(bytes)",
+        COUNTER_TYPE_NUMBER, "memory held by the in-flight messages", true);
+    _usage_counter->set(usage());
+    _delayed_counter = perf_counter::get_counter(node_name, "engine", "message.memory.delayed",
+        COUNTER_TYPE_NUMBER, "requests whose sessions are delayed due to message_memory_budget_mb", true);
+    _rejected_counter = perf_counter::get_counter(node_name, "engine", "message.memory.rejected",
+        COUNTER_TYPE_NUMBER, "requests rejected due to message_memory_budget_mb", true);
+}
+
+bool message_memory_budget::on_exceeded(message_ex* request, dsn_task_priority_t priority)
+{
+    if (priority <= _reject_priority)
+    {
+        dinfo("message memory budget exceeded (%" PRId64 " > %" PRIu64 "), reject message from %s with trace_id = %016" PRIx64,
+            usage(),
+            _limit,
+            request->header->from_address.to_string(),
+            request->header->trace_id
+            );
+        _rejected_counter->increment();
+        return false;
+    }
+
+    if (request->io_session != nullptr && _delay_ms > 0)
+    {
+        request->io_session->delay_recv(_delay_ms);
+        _delayed_counter->increment();
+
+        dwarn("message memory budget exceeded (%" PRId64 " > %" PRIu64 "), delay traffic from %s for %d milliseconds",
+            usage(),
+            _limit,
+            request->header->from_address.to_string(),
+            _delay_ms
+            );
+    }
+    return true;
+}
+
+}
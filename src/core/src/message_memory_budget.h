@@ -0,0 +1,109 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     node-wide memory budget for in-flight rpc messages
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# pragma once
+
+# include <dsn/tool-api/rpc_message.h>
+# include <dsn/tool-api/perf_counter.h>
+# include <dsn/tool-api/task_spec.h>
+# include <atomic>
+
+namespace dsn {
+
+//
+// message_memory_budget accounts the bytes (header + body) of the messages
+// received by or queued for sending on the sessions of a node, from when they
+// are received or queued until they are destroyed, which covers the time they
+// stay in the task queues and send queues;
+// when the usage exceeds [network] message_memory_budget_mb, reading from the
+// sessions of the new requests is delayed, and requests with priority no higher than
+// [network] message_memory_budget_reject_priority are rejected with ERR_BUSY
+//
+class message_memory_budget
+{
+public:
+    message_memory_budget();
+    ~message_memory_budget();
+
+    void init(const char* node_name);
+
+    // charge the message to this budget if it is not charged yet
+    void charge(message_ex* msg)
+    {
+        if (msg->budget != nullptr)
+            return;
+
+        msg->budget = this;
+        msg->budget_bytes = static_cast<uint32_t>(sizeof(message_header) + msg->header->body_length);
+        _usage.fetch_add(msg->budget_bytes, std::memory_order_relaxed);
+        if (_usage_counter != nullptr)
+            _usage_counter->add(msg->budget_bytes);
+    }
+
+    // called when the message is destroyed
+    static void release(message_ex* msg)
+    {
+        auto b = msg->budget;
+        if (b == nullptr)
+            return;
+
+        b->_usage.fetch_sub(msg->budget_bytes, std::memory_order_relaxed);
+        if (b->_usage_counter != nullptr)
+            b->_usage_counter->add((uint64_t)(-(int64_t)msg->budget_bytes));
+        msg->budget = nullptr;
+    }
+
+    int64_t usage() const { return _usage.load(std::memory_order_relaxed); }
+    uint64_t limit() const { return _limit; }
+    bool exceeded() const { return _limit != 0 && usage() > (int64_t)_limit; }
+
+    //
+    // called for a received request when exceeded(),
+    // return false when the request should be rejected
+    //
+    bool on_exceeded(message_ex* request, dsn_task_priority_t priority);
+
+private:
+    std::atomic<int64_t> _usage;
+    uint64_t             _limit;
+    int                  _delay_ms;
+    dsn_task_priority_t  _reject_priority;
+
+    perf_counter_ptr     _usage_counter;
+    perf_counter_ptr     _delayed_counter;
+    perf_counter_ptr     _rejected_counter;
+};
+
+}
@@ -290,6 +290,7 @@ namespace dsn
         msg->add_ref(); // released in on_send_completed
 
         msg->io_session = this;
+        _net.engine()->msg_budget()->charge(msg);
 
         dassert(_parser, "parser should not be null when send");
         _parser->prepare_on_send(msg);
@@ -447,6 +448,7 @@ namespace dsn
             msg->header->from_address = _remote_addr;
         msg->to_address = _net.address();
         msg->io_session = this;
+        _net.engine()->msg_budget()->charge(msg);
 
         if (msg->header->context.u.is_request)
         {
@@ -0,0 +1,104 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     Scaling benchmark of parallel_for and parallel_reduce.
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# include <dsn/service_api_cpp.h>
+# include <dsn/cpp/parallel.h>
+# include <gtest/gtest.h>
+# include <chrono>
+# include <cmath>
+# include <iostream>
+# include <vector>
+
+// worker_count = 8
+DEFINE_THREAD_POOL_CODE(THREAD_POOL_TEST_PARALLEL)
+DEFINE_TASK_CODE(LPC_TEST_PARALLEL, TASK_PRIORITY_COMMON, THREAD_POOL_TEST_PARALLEL)
+
+static const int parallel_test_max_workers = 8;
+
+// cpu-bound work without memory traffic
+static double spin(int i)
+{
+    double v = i;
+    for (int k = 0; k < 200; k++)
+        v = std::sqrt(v + k);
+    return v;
+}
+
+static void parallel_testcase(int parallelism, int count, double base_us)
+{
+    std::vector<double> out(count);
+
+    auto start = std::chrono::steady_clock::now();
+    ::dsn::parallel_for(LPC_TEST_PARALLEL, 0, count, [&](int i) { out[i] = spin(i); }, 0, parallelism);
+    auto for_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    double sum = ::dsn::parallel_reduce(LPC_TEST_PARALLEL, 0, count, 0.0,
+        [](int b, int e)
+        {
+            double s = 0;
+            for (int i = b; i < e; i++)
+                s += spin(i);
+            return s;
+        },
+        [](double l, double r) { return l + r; },
+        0, parallelism);
+    auto reduce_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "parallelism = " << parallelism
+        << ", parallel_for = " << for_us << " us"
+        << ", speedup = " << (base_us > 0 ? base_us / (double)for_us : 1.0)
+        << ", parallel_reduce = " << reduce_us << " us"
+        << ", sum = " << sum
+        << std::endl;
+}
+
+TEST(perf_core, parallel_for)
+{
+    const int count = 2000000;
+    std::vector<double> out(count);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; i++)
+        out[i] = spin(i);
+    double base_us = (double)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "sequential = " << base_us << " us" << std::endl;
+
+    int max_parallelism = std::min((int)std::thread::hardware_concurrency(), parallel_test_max_workers + 1);
+    for (int p = 1; p <= max_parallelism; p++)
+    {
+        parallel_testcase(p, count, base_us);
+    }
+}
@@ -0,0 +1,137 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     Unit-test for parallel_for, parallel_reduce and fork_join_group.
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# include <dsn/service_api_cpp.h>
+# include <dsn/cpp/parallel.h>
+# include <dsn/cpp/test_utils.h>
+# include <gtest/gtest.h>
+# include <atomic>
+# include <vector>
+
+using namespace ::dsn;
+
+TEST(core, parallel_for)
+{
+    std::vector<int> values(10007, 0);
+    parallel_for(LPC_TEST_HASH, 0, (int)values.size(), [&](int i) { values[i] += i; });
+    for (int i = 0; i < (int)values.size(); i++)
+        ASSERT_EQ(i, values[i]);
+
+    // more parallelism than workers, and grain size larger than the range
+    std::atomic<int> count(0);
+    parallel_for(LPC_TEST_HASH, 0, 100, [&](int) { ++count; }, 0, 16);
+    ASSERT_EQ(100, count.load());
+    parallel_for(LPC_TEST_HASH, 0, 100, [&](int) { ++count; }, 1000, 4);
+    ASSERT_EQ(200, count.load());
+
+    // empty range
+    parallel_for(LPC_TEST_HASH, 5, 5, [&](int) { ++count; });
+    ASSERT_EQ(200, count.load());
+
+    // nested calls from the workers do not deadlock, as the callers help
+    std::atomic<int> nested(0);
+    parallel_for(LPC_TEST_HASH, 0, 8, [&](int)
+    {
+        parallel_for(LPC_TEST_HASH, 0, 8, [&](int) { ++nested; }, 1, 8);
+    }, 1, 8);
+    ASSERT_EQ(64, nested.load());
+}
+
+TEST(core, parallel_reduce)
+{
+    int64_t sum = parallel_reduce(LPC_TEST_HASH, (int64_t)1, (int64_t)100001, (int64_t)0,
+        [](int64_t b, int64_t e)
+        {
+            int64_t s = 0;
+            for (auto i = b; i < e; i++)
+                s += i;
+            return s;
+        },
+        [](int64_t l, int64_t r) { return l + r; }
+        );
+    ASSERT_EQ((int64_t)5000050000, sum);
+
+    // partials are combined in chunk order
+    std::string s = parallel_reduce(LPC_TEST_HASH, 0, 10, std::string(),
+        [](int b, int e)
+        {
+            std::string r;
+            for (int i = b; i < e; i++)
+                r.push_back((char)('0' + i));
+            return r;
+        },
+        [](std::string l, std::string r) { return l + r; },
+        3
+        );
+    ASSERT_EQ("0123456789", s);
+}
+
+TEST(core, fork_join_group)
+{
+    std::atomic<int> count(0);
+    {
+        fork_join_group g(LPC_TEST_HASH);
+        for (int i = 0; i < 100; i++)
+            g.fork([&count, i]() { count += i; });
+        g.join();
+        ASSERT_EQ(4950, count.load());
+
+        // reuse after join
+        for (int i = 0; i < 10; i++)
+            g.fork([&count]() { count++; });
+        g.join();
+        ASSERT_EQ(4960, count.load());
+
+        // left for the destructor to join
+        g.fork([&count]() { count++; });
+    }
+    ASSERT_EQ(4961, count.load());
+
+    // nested groups on the workers
+    std::atomic<int> nested(0);
+    fork_join_group outer(LPC_TEST_HASH);
+    for (int i = 0; i < 4; i++)
+    {
+        outer.fork([&nested]()
+        {
+            fork_join_group inner(LPC_TEST_HASH);
+            for (int j = 0; j < 4; j++)
+                inner.fork([&nested]() { nested++; });
+            inner.join();
+        });
+    }
+    outer.join();
+    ASSERT_EQ(16, nested.load());
+}
@@ -0,0 +1,180 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     Unit-test for request_arena.
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# include <dsn/cpp/request_arena.h>
+# include <dsn/cpp/test_utils.h>
+# include <gtest/gtest.h>
+
+using namespace ::dsn;
+
+TEST(core, request_arena_allocate)
+{
+    request_arena arena(256, 1024);
+    EXPECT_EQ(0u, arena.chunk_count());
+
+    char* p1 = (char*)arena.allocate(1, 1);
+    uint64_t* p2 = (uint64_t*)arena.allocate(sizeof(uint64_t), alignof(uint64_t));
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(p2) % alignof(uint64_t));
+    EXPECT_LT(p1, (char*)p2);
+    EXPECT_EQ(1u, arena.chunk_count());
+    EXPECT_EQ(1 + sizeof(uint64_t), arena.allocated_bytes());
+
+    // larger than a chunk
+    char* p3 = (char*)arena.allocate(4096);
+    memset(p3, 0, 4096);
+    EXPECT_EQ(2u, arena.chunk_count());
+
+    // the largest chunk is kept and reused
+    arena.reset();
+    EXPECT_EQ(1u, arena.chunk_count());
+    EXPECT_EQ(0u, arena.allocated_bytes());
+    EXPECT_EQ(p3, (char*)arena.allocate(1, 1));
+}
+
+TEST(core, request_arena_blob)
+{
+    request_arena arena(256, 1024);
+
+    // empty blobs need no chunk, even on a fresh arena
+    blob b0 = arena.copy_blob("", 0);
+    EXPECT_EQ(0u, b0.length());
+    EXPECT_EQ(0u, arena.chunk_count());
+
+    blob b1 = arena.copy_blob("hello", 5);
+    blob b2 = arena.copy_blob("world", 5);
+    EXPECT_EQ(b1.buffer_ptr(), b2.buffer_ptr());
+    EXPECT_EQ(b1.data() + 5, b2.data());
+    EXPECT_EQ(1u, arena.chunk_count());
+
+    // blobs keep their chunk alive after reset, which is not reused
+    arena.reset();
+    EXPECT_EQ(0u, arena.chunk_count());
+    blob b3 = arena.copy_blob("12345", 5);
+    EXPECT_NE(b1.buffer_ptr(), b3.buffer_ptr());
+    EXPECT_EQ(std::string("hello"), std::string(b1.data(), b1.length()));
+    EXPECT_EQ(std::string("world"), std::string(b2.data(), b2.length()));
+
+    b3 = blob();
+    arena.reset();
+    EXPECT_EQ(1u, arena.chunk_count());
+
+    // every chunk is still referenced after reset
+    b3 = arena.copy_blob("12345", 5);
+    arena.reset();
+    EXPECT_EQ(0u, arena.chunk_count());
+    b0 = arena.copy_blob("", 0);
+    EXPECT_EQ(0u, b0.length());
+    EXPECT_EQ(0u, arena.chunk_count());
+}
+
+TEST(core, request_arena_detach_blob)
+{
+    request_arena arena(256, 1024);
+
+    // the detached copy does not pin the chunk, which is kept for the next request
+    blob b1 = arena.copy_blob("hello", 5);
+    blob kept = detach_request_blob(b1);
+    EXPECT_NE(b1.buffer_ptr(), kept.buffer_ptr());
+    b1 = blob();
+    arena.reset();
+    EXPECT_EQ(1u, arena.chunk_count());
+    EXPECT_EQ(std::string("hello"), std::string(kept.data(), kept.length()));
+
+    blob empty = detach_request_blob(blob());
+    EXPECT_EQ(0u, empty.length());
+    EXPECT_FALSE(empty.has_holder());
+}
+
+TEST(core, request_arena_allocator)
+{
+    request_arena arena(256, 1024);
+    {
+        arena_vector<int> v{ arena_allocator<int>(&arena) };
+        for (int i = 0; i < 100; i++)
+            v.push_back(i);
+        EXPECT_EQ(99, v.back());
+
+        arena_string s{ arena_allocator<char>(&arena) };
+        s.assign(100, 'x');
+        EXPECT_EQ(100u, s.size());
+
+        arena_map<int, int> m{ arena_allocator<std::pair<const int, int> >(&arena) };
+        for (int i = 0; i < 10; i++)
+            m[i] = i * 2;
+        EXPECT_EQ(18, m[9]);
+        EXPECT_GT(arena.allocated_bytes(), 100 * sizeof(int) + 100);
+    }
+    arena.reset();
+
+    // no current arena out of request handlers, which falls back to the heap
+    EXPECT_EQ(nullptr, request_arena::current());
+    arena_vector<int> v;
+    EXPECT_EQ(nullptr, v.get_allocator().arena());
+    v.push_back(1);
+    EXPECT_EQ(1u, v.size());
+}
+
+TEST(core, request_arena_rpc)
+{
+    ::dsn::rpc_address server("localhost", 20101);
+    std::string content(100, 'a');
+    blob req(content.data(), 0, (unsigned int)content.size());
+
+    auto result = ::dsn::rpc::call_wait<std::string>(
+        server,
+        RPC_TEST_ARENA,
+        req,
+        std::chrono::milliseconds(0),
+        1
+        );
+    EXPECT_EQ(ERR_OK, result.first);
+    EXPECT_EQ(content, result.second);
+}
+
+TEST(core, request_arena_rpc_empty_blob)
+{
+    ::dsn::rpc_address server("localhost", 20101);
+    blob req;
+
+    auto result = ::dsn::rpc::call_wait<std::string>(
+        server,
+        RPC_TEST_ARENA,
+        req,
+        std::chrono::milliseconds(0),
+        1
+        );
+    EXPECT_EQ(ERR_OK, result.first);
+    EXPECT_EQ(std::string(), result.second);
+}
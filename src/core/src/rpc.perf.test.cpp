@@ -35,7 +35,13 @@
 #include <gtest/gtest.h>
 #include <dsn/cpp/test_utils.h>
 #include <dsn/service_api_cpp.h>
+#include <dsn/utility/synchronize.h>
 #include <boost/lexical_cast.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include "slab_pool.h"
+#include "transient_memory.h"
 
 
 void rpc_testcase(uint64_t block_size, size_t concurrency)
@@ -116,6 +122,212 @@ TEST(perf_core, rpc)
             rpc_testcase(blk_size_bytes, concurrency);
 }
 
+# ifdef DSN_COUNT_HEAP_ALLOCATIONS
+
+//
+// allocator calls per rpc round trip, counted for the whole process (client and server
+// are in this process), as
+// - operator new (e.g., vectors, callbacks, decoded std::string payloads), counted by
+//   replacing the global operator new; as the tests are built into the core library,
+//   this is only enabled by ENABLE_HEAP_ALLOCATION_COUNT
+// - dsn_transient_malloc and dsn_malloc (e.g., messages and rpc tasks when the slab
+//   pools are disabled, see [core] slab_pool_enabled)
+//
+// the before/after numbers of the slab pools are got from two runs of the same build,
+// with [core] slab_pool_enabled = true and false; note the payload is a std::string, so
+// decoding the request and the response allocates when it is longer than the small
+// string buffer, which is not saved by the pools
+//
+static std::atomic<uint64_t> s_heap_allocations(0);
+
+void* operator new(size_t size)
+{
+    s_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = ::malloc(size == 0 ? 1 : size);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return ::operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    ::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    ::free(p);
+}
+
+struct allocation_counts
+{
+    uint64_t heap;
+    uint64_t transient;
+    uint64_t dsn_malloc;
+
+    static allocation_counts now()
+    {
+        allocation_counts c;
+        c.heap = s_heap_allocations.load(std::memory_order_relaxed);
+        c.transient = trans_malloc_call_count();
+        c.dsn_malloc = dsn_malloc_call_count();
+        return c;
+    }
+};
+
+// allocator calls per rpc round trip, cold and after the slab pools, thread caches
+// and transient memory blocks are warmed up by the first round of calls
+void rpc_heap_allocation_testcase(uint64_t block_size, int count)
+{
+    std::string req;
+    req.resize(block_size, 'x');
+    rpc_address server("localhost", 20101);
+
+    int remaining = 0;
+    int completed = 0;
+    utils::notify_event done;
+    std::function<void()> next;
+    next = [&]()
+    {
+        rpc::call(
+            server,
+            RPC_TEST_HASH,
+            req,
+            nullptr,
+            [&](error_code err, std::string&& result)
+            {
+                if (ERR_OK == err)
+                    completed++;
+                if (ERR_OK == err && --remaining > 0)
+                    next();
+                else
+                    done.notify();
+            }
+        );
+    };
+
+    allocation_counts allocations[2];
+    for (int round = 0; round < 2; round++)
+    {
+        remaining = count;
+        completed = 0;
+        auto before = allocation_counts::now();
+        next();
+        done.wait();
+        auto after = allocation_counts::now();
+        allocations[round].heap = after.heap - before.heap;
+        allocations[round].transient = after.transient - before.transient;
+        allocations[round].dsn_malloc = after.dsn_malloc - before.dsn_malloc;
+    }
+
+    double n = (double)std::max(completed, 1);
+    std::cout
+        << "slab_pool_enabled = " << slab_pool::enabled()
+        << ", block_size = " << block_size
+        << ", rpc count = " << completed
+        << ", per rpc: operator new = " << (double)allocations[1].heap / n
+        << ", dsn_transient_malloc = " << (double)allocations[1].transient / n
+        << ", dsn_malloc = " << (double)allocations[1].dsn_malloc / n
+        << " (cold: " << (double)allocations[0].heap / (double)count
+        << ", " << (double)allocations[0].transient / (double)count
+        << ", " << (double)allocations[0].dsn_malloc / (double)count << ")"
+        << std::endl;
+}
+
+TEST(perf_core, rpc_heap_allocations)
+{
+    // 1 byte payloads fit in the small string buffer, so they show the allocations
+    // of the rpc path itself
+    for (auto blk_size_bytes : { 1, 128, 4 * 1024 })
+        rpc_heap_allocation_testcase(blk_size_bytes, 10000);
+}
+
+# endif // DSN_COUNT_HEAP_ALLOCATIONS
+
+
+# ifdef DSN_HAS_COROUTINE
+
+static coro::task<void> rpc_coroutine(
+    rpc_address server,
+    const std::string& req,
+    volatile bool& exit,
+    std::atomic<uint64_t>& io_count,
+    std::atomic<uint64_t>& cb_flying_count
+    )
+{
+    while (!exit)
+    {
+        io_count++;
+        auto resp = co_await coro::rpc::call<std::string>(server, RPC_TEST_HASH, req);
+        if (ERR_OK != resp.first)
+            break;
+    }
+    cb_flying_count--;
+}
+
+void rpc_coroutine_testcase(uint64_t block_size, size_t concurrency)
+{
+    std::atomic<uint64_t> io_count(0);
+    std::atomic<uint64_t> cb_flying_count(0);
+    volatile bool exit = false;
+    std::string req;
+    req.resize(block_size, 'x');
+    rpc_address server("localhost", 20101);
+
+    std::string test_server = dsn_config_get_value_string("apps.client", "test_server", "",
+        "rpc test server address, i.e., host:port"
+        );
+    if (test_server.length() > 0)
+    {
+        url_host_address addr(test_server.c_str());
+        server.assign_ipv4(addr.ip(), addr.port());
+    }
+
+    // start
+    auto tic = std::chrono::steady_clock::now();
+    for (int i = 0; i < concurrency; i++)
+    {
+        cb_flying_count++;
+        coro::spawn(rpc_coroutine(server, req, exit, io_count, cb_flying_count));
+    }
+
+    // run for seconds
+    std::this_thread::sleep_for(std::chrono::seconds(10));
+    auto ioc = io_count.load();
+    auto bytes = ioc * block_size;
+    auto toc = std::chrono::steady_clock::now();
+
+    std::cout
+        << "coroutine"
+        << ", block_size = " << block_size
+        << ", concurrency = " << concurrency
+        << ", iops = " << (double)ioc / (double)std::chrono::duration_cast<std::chrono::microseconds>(toc - tic).count() * 1000000.0 << " #/s"
+        << ", throughput = " << (double)bytes / std::chrono::duration_cast<std::chrono::microseconds>(toc - tic).count() << " mB/s"
+        << ", avg_latency = " << (double)std::chrono::duration_cast<std::chrono::microseconds>(toc - tic).count() / (double)(ioc / concurrency) << " us"
+        << std::endl;
+
+    // safe exit
+    exit = true;
+
+    while (cb_flying_count.load() > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+TEST(perf_core, rpc_coroutine)
+{
+    for (auto blk_size_bytes : { 1, 128, 256, 4 * 1024 })
+        for (auto concurrency : { 1, 2, 4,10,50,100,200 })
+            rpc_coroutine_testcase(blk_size_bytes, concurrency);
+}
+
+# endif
 
 void lpc_testcase(size_t concurrency)
 {
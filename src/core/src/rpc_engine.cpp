@@ -63,7 +63,7 @@ namespace dsn {
     
     DEFINE_TASK_CODE(LPC_RPC_TIMEOUT, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
 
-    class rpc_timeout_task : public task, public transient_object
+    class rpc_timeout_task : public task, public long_transient_object
     {
     public:
         rpc_timeout_task(rpc_client_matcher* matcher, uint64_t id, service_node* node) 
@@ -579,6 +579,9 @@ namespace dsn {
             }
         }
 
+        ss << indent2 << "RPC.MessageMemory: usage = " << _msg_budget.usage()
+            << " bytes, budget = " << _msg_budget.limit() << " bytes" << std::endl;
+
         ss << indent2 << std::endl;
     }
         
@@ -627,6 +630,8 @@ namespace dsn {
         {
             return ERR_SERVICE_ALREADY_RUNNING;
         }
+
+        _msg_budget.init(_node->name());
     
         // local cache for shared networks with same provider and message format and port
         std::map<std::string, network*> named_nets; // factory##fmt##port -> net
@@ -780,6 +785,19 @@ namespace dsn {
 
         if (code != ::dsn::TASK_CODE_INVALID)
         {
+            if (_msg_budget.exceeded()
+                && !_msg_budget.on_exceeded(msg, task_spec::get(code)->priority))
+            {
+                auto resp = msg->create_response();
+                reply(resp, ERR_BUSY);
+
+                // because (1) initially, the ref count is zero
+                //         (2) no task is created to hold it
+                msg->add_ref();
+                msg->release_ref();
+                return;
+            }
+
             rpc_request_task* tsk = nullptr;
 
             // handle replication
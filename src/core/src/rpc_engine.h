@@ -40,6 +40,7 @@
 # include <dsn/utility/synchronize.h>
 # include <dsn/tool-api/global_config.h>
 # include <dsn/utility/configuration.h>
+# include "message_memory_budget.h"
 
 namespace dsn {
 
@@ -162,6 +163,7 @@ public:
     service_node* node() const { return _node; }
     ::dsn::rpc_address primary_address() const { return _local_primary_address; }
     rpc_client_matcher* matcher() { return &_rpc_matcher; }
+    message_memory_budget* msg_budget() { return &_msg_budget; }
     uri_resolver_manager* uri_resolver_mgr() { return _uri_resolver_mgr.get(); }
     void get_runtime_info(const safe_string& indent, const safe_vector<safe_string>& args, /*out*/ safe_sstream& ss);
 
@@ -193,6 +195,7 @@ private:
     ::dsn::rpc_address                               _local_primary_address;
     rpc_client_matcher                               _rpc_matcher;
     rpc_server_dispatcher                            _rpc_dispatcher;   
+    message_memory_budget                            _msg_budget;
 
     std::unique_ptr<uri_resolver_manager>            _uri_resolver_mgr;
     
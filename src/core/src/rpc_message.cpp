@@ -41,6 +41,8 @@
 
 # include "task_engine.h"
 # include "transient_memory.h"
+# include "message_memory_budget.h"
+# include "slab_pool.h"
 
 using namespace dsn::utils;
 
@@ -99,6 +101,21 @@ DSN_API void dsn_msg_write_commit(dsn_message_t msg, size_t size)
     ((::dsn::message_ex*)msg)->write_commit(size);
 }
 
+DSN_API void dsn_msg_write_append(dsn_message_t msg, const void* ptr, size_t size, void (*release)(void*), void* release_context)
+{
+    ::dsn::blob bb;
+    if (release)
+    {
+        std::shared_ptr<char> holder((char*)ptr, [release, release_context](char*) { release(release_context); });
+        bb.assign(std::move(holder), 0, (unsigned int)size);
+    }
+    else
+    {
+        bb.assign((const char*)ptr, 0, (unsigned int)size);
+    }
+    ((::dsn::message_ex*)msg)->write_append(bb);
+}
+
 DSN_API bool dsn_msg_read_next(dsn_message_t msg, void** ptr, size_t* size)
 {
     return ((::dsn::message_ex*)msg)->read_next(ptr, size);
@@ -213,14 +230,40 @@ namespace dsn {
 std::atomic<uint64_t> message_ex::_id(0);
 uint32_t message_ex::s_local_hash = 0;
 
+// never released as messages may be freed during process exit
+static slab_pool* message_slab_pool()
+{
+    static slab_pool* pool = new slab_pool("message_ex", sizeof(message_ex));
+    return pool;
+}
+
+void* message_ex::operator new(size_t size)
+{
+    if (size == sizeof(message_ex) && slab_pool::enabled())
+        return message_slab_pool()->allocate();
+    else
+        return dsn_transient_malloc((uint32_t)size);
+}
+
+void message_ex::operator delete(void* p, size_t size)
+{
+    if (size == sizeof(message_ex) && slab_pool::enabled())
+        message_slab_pool()->deallocate(p);
+    else
+        dsn_transient_free(p);
+}
+
 message_ex::message_ex()
     : header(nullptr), local_rpc_code(::dsn::TASK_CODE_INVALID), hdr_format(NET_HDR_INVALID), send_retry_count(0),
+      budget(nullptr), budget_bytes(0),
       _rw_index(-1), _rw_offset(0), _rw_committed(true), _is_read(false)
 {
 }
 
 message_ex::~message_ex()
 {
+    message_memory_budget::release(this);
+
     if (!_is_read)
     {
         dassert(_rw_committed, "message write is not committed");
@@ -549,7 +592,7 @@ void message_ex::write_append(const blob& data)
     if (size > 0)
     {
         this->_rw_index++;
-        this->_rw_offset += size;
+        this->_rw_offset = size;
         this->buffers.push_back(data);
         this->header->body_length += size;
     }
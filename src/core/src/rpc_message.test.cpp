@@ -34,8 +34,10 @@
  */
 
 # include <dsn/tool-api/rpc_message.h>
+# include <dsn/cpp/rpc_stream.h>
 # include <gtest/gtest.h>
 # include "transient_memory.h"
+# include "message_memory_budget.h"
 
 using namespace ::dsn;
 
@@ -138,6 +140,7 @@ TEST(core, message_ex)
         memcpy(ptr, data, data_size);
         request->write_commit(data_size);
         ASSERT_EQ(2u, request->buffers.size());
+        ASSERT_TRUE(request->buffers.is_inline());
         ASSERT_EQ(ptr, request->rw_ptr(data_size));
         ASSERT_EQ((void*)((char*)ptr + 10), request->rw_ptr(data_size + 10));
         ASSERT_EQ(nullptr, request->rw_ptr(data_size + data_size));
@@ -244,3 +247,130 @@ TEST(core, message_ex)
     }
 }
 
+TEST(core, rpc_read_stream_zero_copy)
+{
+    message_ex* request = message_ex::create_request(RPC_CODE_FOR_TEST, 100, 1);
+
+    // a blob field of 8 KB, written as length + data (see binary_reader::read(blob&))
+    int length = 8 * 1024;
+    void* ptr;
+    size_t sz;
+    request->write_next(&ptr, &sz, sizeof(length) + length);
+    memcpy(ptr, &length, sizeof(length));
+    memset((char*)ptr + sizeof(length), 'x', length);
+    request->write_commit(sizeof(length) + length);
+
+    ASSERT_EQ(1u, request->buffers.size());
+    message_ex* receive = message_ex::create_receive_message(request->buffers[0]);
+    receive->add_ref();
+    ASSERT_TRUE(receive->read_next(&ptr, &sz));
+    const char* body = (const char*)ptr;
+    receive->read_commit(0);
+
+    blob bb;
+    {
+        rpc_read_stream reader((dsn_message_t)receive);
+        reader.read(bb);
+    }
+
+    // the blob references the message buffer, which keeps the message alive
+    ASSERT_EQ((unsigned int)length, bb.length());
+    ASSERT_EQ(body + sizeof(length), bb.data());
+    ASSERT_EQ('x', bb.data()[length - 1]);
+    ASSERT_EQ(2, receive->get_count());
+
+    bb = blob();
+    ASSERT_EQ(1, receive->get_count());
+
+    receive->release_ref();
+    request->add_ref();
+    request->release_ref();
+}
+
+TEST(core, rpc_write_stream_append_by_ref)
+{
+    message_ex* request = message_ex::create_request(RPC_CODE_FOR_TEST, 100, 1);
+
+    int length = 8 * 1024;
+    std::shared_ptr<char> large(::dsn::make_shared_array<char>(length));
+    memset(large.get(), 'x', length);
+    blob large_bb(large, 0, length);
+
+    const char small_data[] = "small";
+    blob small_bb(small_data, 0, sizeof(small_data)); // no holder, always copied
+
+    {
+        rpc_write_stream writer((dsn_message_t)request);
+        writer.write(small_bb);
+        writer.write(large_bb);
+        writer.write(std::string("tail"));
+        ASSERT_EQ((int)(3 * sizeof(int) + sizeof(small_data) + length + 4), writer.total_size());
+    }
+
+    // the large blob is a message buffer by itself, which references the blob memory
+    ASSERT_EQ((unsigned int)(3 * sizeof(int) + sizeof(small_data) + length + 4), request->header->body_length);
+    int refs = 0;
+    for (auto& bb : request->buffers)
+    {
+        if (bb.data() == large.get())
+        {
+            ASSERT_EQ((unsigned int)length, bb.length());
+            refs++;
+        }
+    }
+    ASSERT_EQ(1, refs);
+    ASSERT_EQ(3, large.use_count());
+
+    // the content is read back the same as the copied way
+    message_ex* receive = request->copy(true, true);
+    receive->add_ref();
+    {
+        rpc_read_stream reader((dsn_message_t)receive);
+        blob bb;
+        std::string tail;
+        reader.read(bb);
+        ASSERT_EQ(0, memcmp(small_data, bb.data(), sizeof(small_data)));
+        reader.read(bb);
+        ASSERT_EQ((unsigned int)length, bb.length());
+        ASSERT_EQ('x', bb.data()[0]);
+        ASSERT_EQ('x', bb.data()[length - 1]);
+        reader.read(tail);
+        ASSERT_EQ(std::string("tail"), tail);
+    }
+    receive->release_ref();
+
+    request->add_ref();
+    request->release_ref();
+    ASSERT_EQ(2, large.use_count());
+}
+
+TEST(core, message_memory_budget)
+{
+    message_memory_budget budget;
+    ASSERT_EQ(0, budget.usage());
+    ASSERT_FALSE(budget.exceeded()); // unlimited before init
+
+    message_ex* request = message_ex::create_request(RPC_CODE_FOR_TEST, 0, 0);
+    const char data[] = "budget";
+    request->write_append(blob(data, 0, sizeof(data)));
+    request->add_ref();
+
+    budget.charge(request);
+    int64_t bytes = (int64_t)(sizeof(message_header) + sizeof(data));
+    ASSERT_EQ(bytes, budget.usage());
+
+    // charged only once
+    budget.charge(request);
+    ASSERT_EQ(bytes, budget.usage());
+
+    message_ex* response = request->create_response();
+    response->add_ref();
+    budget.charge(response);
+    ASSERT_EQ(bytes + (int64_t)sizeof(message_header), budget.usage());
+
+    // released when the messages are destroyed
+    request->release_ref();
+    ASSERT_EQ((int64_t)sizeof(message_header), budget.usage());
+    response->release_ref();
+    ASSERT_EQ(0, budget.usage());
+}
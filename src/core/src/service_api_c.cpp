@@ -653,6 +653,11 @@ DSN_API void dsn_rpc_forward(dsn_message_t request, dsn_address_t addr)
     ::dsn::task::get_current_rpc()->forward((::dsn::message_ex*)(request), ::dsn::rpc_address(addr));
 }
 
+DSN_API void* dsn_rpc_get_request_arena()
+{
+    return ::dsn::rpc_request_task::get_current_arena();
+}
+
 DSN_API dsn_message_t dsn_rpc_get_response(dsn_task_t rpc_call)
 {
     ::dsn::rpc_response_task* task = (::dsn::rpc_response_task*)rpc_call;
@@ -697,6 +702,24 @@ DSN_API dsn_error_t dsn_file_flush(dsn_handle_t file)
     return ::dsn::task::get_current_disk()->flush(file);
 }
 
+DSN_API void dsn_file_flush_async(dsn_handle_t file, dsn_task_t cb)
+{
+    ::dsn::aio_task* callback((::dsn::aio_task*)cb);
+    callback->aio()->buffer = nullptr;
+    callback->aio()->buffer_size = 0;
+    callback->aio()->engine = nullptr;
+    callback->aio()->file = file;
+    callback->aio()->file_offset = 0;
+    callback->aio()->type = ::dsn::AIO_Flush;
+
+    ::dsn::task::get_current_disk()->flush_async(callback);
+}
+
+DSN_API void dsn_file_ctrl(dsn_handle_t file, dsn_ctrl_code_t code, int param)
+{
+    ::dsn::task::get_current_disk()->ctrl(file, code, param);
+}
+
 // native HANDLE: HANDLE for windows, int for non-windows
 DSN_API void* dsn_file_native_handle(dsn_handle_t file)
 {
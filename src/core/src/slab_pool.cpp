@@ -0,0 +1,254 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     per-thread slab pools for the hot framework objects
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# include "slab_pool.h"
+# include <cstdlib>
+
+# ifdef __TITLE__
+# undef __TITLE__
+# endif
+# define __TITLE__ "slab.pool"
+
+namespace dsn {
+
+# define MAX_SLAB_POOL_COUNT 8
+# define SLAB_ALLOCATION_COUNTER_BATCH 1024
+
+struct slab_thread_cache
+{
+    void*    head;
+    int      count;
+    uint32_t pending_allocations; // not yet added to the pool stats
+};
+
+static slab_pool*       s_slab_pools[MAX_SLAB_POOL_COUNT];
+static std::atomic<int> s_slab_pool_count(0);
+
+static __thread slab_thread_cache tls_slab_caches[MAX_SLAB_POOL_COUNT];
+static __thread bool              tls_slab_caches_exited;
+
+struct tls_slab_cache_flusher
+{
+    bool touched;
+
+    ~tls_slab_cache_flusher()
+    {
+        slab_pool::flush_thread_caches();
+        tls_slab_caches_exited = true;
+    }
+};
+
+static thread_local tls_slab_cache_flusher tls_slab_cache_flusher_obj;
+
+slab_pool::slab_pool(const char* name, size_t object_size, int objects_per_slab)
+    : _name(name), _objects_per_slab(objects_per_slab), _global_head(nullptr), _global_count(0),
+    _allocations(0), _global_gets(0), _global_puts(0), _slabs(0)
+{
+    const size_t align = 16;
+    _object_size = (object_size + align - 1) / align * align;
+    _batch_count = objects_per_slab / 2 > 0 ? objects_per_slab / 2 : 1;
+
+    _index = s_slab_pool_count.fetch_add(1);
+    dassert(_index < MAX_SLAB_POOL_COUNT, "too many slab pools, max = %d", MAX_SLAB_POOL_COUNT);
+    s_slab_pools[_index] = this;
+}
+
+void slab_pool::put_global(free_object* head, free_object* tail, int count)
+{
+    utils::auto_lock<utils::ex_lock_nr_spin> l(_lock);
+    tail->next = _global_head;
+    _global_head = head;
+    _global_count += count;
+    _global_puts.fetch_add(1, std::memory_order_relaxed);
+}
+
+void slab_pool::refill(int idx)
+{
+    auto& c = tls_slab_caches[idx];
+    if (!tls_slab_caches_exited)
+        tls_slab_cache_flusher_obj.touched = true;
+
+    {
+        utils::auto_lock<utils::ex_lock_nr_spin> l(_lock);
+        if (_global_head != nullptr)
+        {
+            free_object* head = _global_head;
+            free_object* tail = head;
+            int count = 1;
+            while (count < _batch_count && tail->next != nullptr)
+            {
+                tail = tail->next;
+                count++;
+            }
+
+            _global_head = tail->next;
+            _global_count -= count;
+            tail->next = (free_object*)c.head;
+            c.head = head;
+            c.count += count;
+            _global_gets.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    char* slab = (char*)::malloc(_object_size * _objects_per_slab);
+    dassert(slab != nullptr, "cannot allocate slab for %s", _name);
+    for (int i = _objects_per_slab - 1; i >= 0; i--)
+    {
+        auto o = (free_object*)(slab + _object_size * i);
+        o->next = (free_object*)c.head;
+        c.head = o;
+    }
+    c.count += _objects_per_slab;
+    _slabs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void* slab_pool::allocate()
+{
+    auto& c = tls_slab_caches[_index];
+    if (c.head == nullptr)
+        refill(_index);
+
+    auto o = (free_object*)c.head;
+    c.head = o->next;
+    c.count--;
+
+    if (++c.pending_allocations == SLAB_ALLOCATION_COUNTER_BATCH)
+    {
+        _allocations.fetch_add(c.pending_allocations, std::memory_order_relaxed);
+        c.pending_allocations = 0;
+    }
+    return o;
+}
+
+void slab_pool::deallocate(void* p)
+{
+    auto o = (free_object*)p;
+    if (tls_slab_caches_exited)
+    {
+        put_global(o, o, 1);
+        return;
+    }
+
+    // threads that only free objects (e.g., completion threads releasing responses
+    // allocated elsewhere) also need their caches flushed at exit
+    auto& c = tls_slab_caches[_index];
+    if (c.count == 0)
+        tls_slab_cache_flusher_obj.touched = true;
+
+    o->next = (free_object*)c.head;
+    c.head = o;
+    c.count++;
+
+    // keep at most 2 batches in the cache
+    if (c.count >= 2 * _batch_count)
+    {
+        free_object* head = (free_object*)c.head;
+        free_object* tail = head;
+        for (int i = 1; i < _batch_count; i++)
+            tail = tail->next;
+
+        c.head = tail->next;
+        c.count -= _batch_count;
+        put_global(head, tail, _batch_count);
+    }
+}
+
+void slab_pool::get_stats(/*out*/ stats& st) const
+{
+    st.allocations = _allocations.load(std::memory_order_relaxed);
+    st.global_gets = _global_gets.load(std::memory_order_relaxed);
+    st.global_puts = _global_puts.load(std::memory_order_relaxed);
+    st.slabs = _slabs.load(std::memory_order_relaxed);
+    st.object_size = _object_size;
+    st.objects_per_slab = _objects_per_slab;
+}
+
+/*static*/ void slab_pool::flush_thread_caches()
+{
+    int n = s_slab_pool_count.load();
+    for (int i = 0; i < n; i++)
+    {
+        auto pool = s_slab_pools[i];
+        auto& c = tls_slab_caches[i];
+
+        if (c.pending_allocations > 0)
+        {
+            pool->_allocations.fetch_add(c.pending_allocations, std::memory_order_relaxed);
+            c.pending_allocations = 0;
+        }
+
+        if (c.head == nullptr)
+            continue;
+
+        free_object* head = (free_object*)c.head;
+        free_object* tail = head;
+        while (tail->next != nullptr)
+            tail = tail->next;
+
+        pool->put_global(head, tail, c.count);
+        c.head = nullptr;
+        c.count = 0;
+    }
+}
+
+/*static*/ bool slab_pool::enabled()
+{
+    static bool s_enabled = dsn_config_get_value_bool("core", "slab_pool_enabled", true,
+        "whether messages and rpc tasks are allocated from the slab pools, false for allocating them as transient objects");
+    return s_enabled;
+}
+
+/*static*/ safe_string slab_pool::get_all_stats()
+{
+    safe_sstream ss;
+    int n = s_slab_pool_count.load();
+    for (int i = 0; i < n; i++)
+    {
+        stats st;
+        s_slab_pools[i]->get_stats(st);
+        ss << s_slab_pools[i]->name()
+            << ": object size = " << st.object_size
+            << ", allocations = " << st.allocations
+            << ", slabs = " << st.slabs
+            << " (" << st.slabs * st.objects_per_slab * st.object_size << " bytes)"
+            << ", global gets = " << st.global_gets
+            << ", global puts = " << st.global_puts
+            << std::endl;
+    }
+    return ss.str();
+}
+
+}
@@ -0,0 +1,114 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     per-thread slab pools for the hot framework objects
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# pragma once
+
+# include <dsn/service_api_c.h>
+# include <dsn/utility/synchronize.h>
+# include <dsn/cpp/safe_string.h>
+# include <atomic>
+
+namespace dsn {
+
+//
+// slab_pool serves fixed-size objects (e.g., message_ex, rpc tasks):
+// - each thread allocates from and frees to its own cache without locking, so objects
+//   freed by another thread (e.g., a message received by an io thread and released by
+//   a worker) are returned to the cache of the freeing thread
+// - caches exchange batches of objects with a global free list when they are
+//   empty or too large
+// - memory is carved from slabs of objects_per_slab objects, which are never released,
+//   so the pool keeps its peak size
+//
+class slab_pool
+{
+public:
+    struct stats
+    {
+        uint64_t allocations;   // total object allocations
+        uint64_t global_gets;   // batches got from the global free list
+        uint64_t global_puts;   // batches returned to the global free list
+        uint64_t slabs;         // slabs allocated from the heap
+        uint64_t object_size;
+        uint64_t objects_per_slab;
+    };
+
+    slab_pool(const char* name, size_t object_size, int objects_per_slab = 128);
+
+    void* allocate();
+    void  deallocate(void* p);
+
+    size_t object_size() const { return _object_size; }
+    const char* name() const { return _name; }
+    void   get_stats(/*out*/ stats& st) const;
+
+    // stats of all pools, e.g., for the command line
+    static safe_string get_all_stats();
+
+    // return the cached objects of the exiting thread to the global lists
+    static void flush_thread_caches();
+
+    // whether messages and rpc tasks are allocated from the pools, otherwise they are
+    // transient objects as before (e.g., for comparing the allocations), fixed at the
+    // first call as the objects are freed to where they are allocated from
+    static bool enabled();
+
+private:
+    struct free_object
+    {
+        free_object* next;
+    };
+
+    void refill(int idx);
+    void put_global(free_object* head, free_object* tail, int count);
+
+private:
+    const char*            _name;
+    size_t                 _object_size;
+    int                    _objects_per_slab;
+    int                    _index;       // index into the per-thread caches
+    int                    _batch_count; // objects moved between a cache and the global list
+
+    utils::ex_lock_nr_spin _lock;
+    free_object*           _global_head; // protected by _lock
+    int                    _global_count;
+
+    std::atomic<uint64_t>  _allocations;
+    std::atomic<uint64_t>  _global_gets;
+    std::atomic<uint64_t>  _global_puts;
+    std::atomic<uint64_t>  _slabs;
+};
+
+}
@@ -0,0 +1,139 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     Unit-test for slab_pool.
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# include "slab_pool.h"
+# include <gtest/gtest.h>
+# include <cstring>
+# include <set>
+# include <thread>
+# include <vector>
+
+using namespace ::dsn;
+
+TEST(core, slab_pool)
+{
+    static slab_pool* pool = new slab_pool("slab.pool.test", 40, 16);
+    ASSERT_EQ(48u, pool->object_size());
+
+    slab_pool::stats st0;
+    pool->get_stats(st0);
+
+    // objects are distinct and usable
+    std::vector<void*> objs;
+    std::set<void*> distinct;
+    for (int i = 0; i < 40; i++)
+    {
+        void* p = pool->allocate();
+        memset(p, i, 40);
+        objs.push_back(p);
+        distinct.insert(p);
+    }
+    ASSERT_EQ(objs.size(), distinct.size());
+
+    slab_pool::stats st1;
+    pool->get_stats(st1);
+    ASSERT_EQ(st0.slabs + 3, st1.slabs);
+
+    // freed objects are reused by the same thread
+    void* last = objs.back();
+    objs.pop_back();
+    pool->deallocate(last);
+    ASSERT_EQ(last, pool->allocate());
+    objs.push_back(last);
+
+    // objects allocated here and freed by another thread are recycled there
+    std::thread t([&objs]()
+    {
+        for (auto p : objs)
+            pool->deallocate(p);
+
+        slab_pool::stats st;
+        pool->get_stats(st);
+        auto slabs = st.slabs;
+        for (int i = 0; i < 40; i++)
+            objs[i] = pool->allocate();
+        pool->get_stats(st);
+        EXPECT_EQ(slabs, st.slabs);
+
+        for (auto p : objs)
+            pool->deallocate(p);
+    });
+    t.join();
+
+    // the exited thread returned its cache to the global list
+    slab_pool::stats st2;
+    pool->get_stats(st2);
+    ASSERT_LT(st1.global_puts, st2.global_puts);
+
+    objs.clear();
+    for (int i = 0; i < 40; i++)
+        objs.push_back(pool->allocate());
+    slab_pool::stats st3;
+    pool->get_stats(st3);
+    ASSERT_EQ(st2.slabs, st3.slabs);
+    ASSERT_LT(st2.global_gets, st3.global_gets);
+
+    for (auto p : objs)
+        pool->deallocate(p);
+    slab_pool::flush_thread_caches();
+
+    auto all = slab_pool::get_all_stats();
+    ASSERT_NE(std::string::npos, all.find("slab.pool.test"));
+}
+
+TEST(core, slab_pool_free_only_thread)
+{
+    static slab_pool* pool = new slab_pool("slab.pool.test.free", 40, 16);
+
+    std::vector<void*> objs;
+    for (int i = 0; i < 5; i++)
+        objs.push_back(pool->allocate());
+
+    slab_pool::stats st0;
+    pool->get_stats(st0);
+
+    // fewer than a batch are freed, so they stay in the thread cache until
+    // the thread exits, even though the thread never allocates
+    std::thread t([&objs]()
+    {
+        for (auto p : objs)
+            pool->deallocate(p);
+    });
+    t.join();
+
+    slab_pool::stats st1;
+    pool->get_stats(st1);
+    ASSERT_EQ(st0.global_puts + 1, st1.global_puts);
+}
@@ -38,6 +38,7 @@
 # include <dsn/tool-api/task.h>
 # include <dsn/tool-api/env_provider.h>
 # include <dsn/cpp/utils.h>
+# include <dsn/cpp/request_arena.h>
 # include <dsn/utility/synchronize.h>
 # include <dsn/tool-api/node_scoper.h>
 
@@ -46,6 +47,7 @@
 # include "service_engine.h"
 # include "disk_engine.h"
 # include "rpc_engine.h"
+# include "slab_pool.h"
 
 
 # ifdef __TITLE__
@@ -548,6 +550,29 @@ void timer_task::exec()
     }
 }
 
+// never released as tasks may be freed during process exit
+static slab_pool* rpc_request_task_slab_pool()
+{
+    static slab_pool* pool = new slab_pool("rpc_request_task", sizeof(rpc_request_task));
+    return pool;
+}
+
+void* rpc_request_task::operator new(size_t size)
+{
+    if (size == sizeof(rpc_request_task) && slab_pool::enabled())
+        return rpc_request_task_slab_pool()->allocate();
+    else
+        return dsn_transient_malloc((uint32_t)size);
+}
+
+void rpc_request_task::operator delete(void* p, size_t size)
+{
+    if (size == sizeof(rpc_request_task) && slab_pool::enabled())
+        rpc_request_task_slab_pool()->deallocate(p);
+    else
+        dsn_transient_free(p);
+}
+
 rpc_request_task::rpc_request_task(message_ex* request, rpc_handler_info* h, service_node* node)
     : task(dsn_task_code_t(h->code),  // it is possible that request->local_rpc_code != h->code when it is handled in frameworks
         nullptr, 
@@ -573,11 +598,69 @@ rpc_request_task::~rpc_request_task()
 
 void rpc_request_task::enqueue()
 {
-    if (spec().rpc_request_dropped_before_execution_when_timeout)
+    // used by timeout dropping and admission controllers
+    _enqueue_ts_ns = dsn_now_ns();
+    task::enqueue(node()->computation()->get_pool(spec().pool_code));
+}
+
+static __thread request_arena* tls_current_request_arena;
+
+// one arena per thread, reused by all requests of the thread
+static request_arena* get_thread_request_arena()
+{
+    static thread_local request_arena arena;
+    return &arena;
+}
+
+/*static*/ request_arena* rpc_request_task::get_current_arena()
+{
+    return tls_current_request_arena;
+}
+
+void rpc_request_task::exec_with_arena()
+{
+    // requests handled inside another request (e.g., inlined local calls) share
+    // the arena of the outer one, which resets it
+    if (tls_current_request_arena != nullptr)
     {
-        _enqueue_ts_ns = dsn_now_ns();
+        _handler->run(_request);
+        return;
     }
-    task::enqueue(node()->computation()->get_pool(spec().pool_code));
+
+    struct arena_scope
+    {
+        request_arena* arena;
+        arena_scope() : arena(get_thread_request_arena()) { tls_current_request_arena = arena; }
+        ~arena_scope()
+        {
+            tls_current_request_arena = nullptr;
+            arena->reset();
+        }
+    } scope;
+
+    _handler->run(_request);
+}
+
+static slab_pool* rpc_response_task_slab_pool()
+{
+    static slab_pool* pool = new slab_pool("rpc_response_task", sizeof(rpc_response_task));
+    return pool;
+}
+
+void* rpc_response_task::operator new(size_t size)
+{
+    if (size == sizeof(rpc_response_task) && slab_pool::enabled())
+        return rpc_response_task_slab_pool()->allocate();
+    else
+        return dsn_transient_malloc((uint32_t)size);
+}
+
+void rpc_response_task::operator delete(void* p, size_t size)
+{
+    if (size == sizeof(rpc_response_task) && slab_pool::enabled())
+        rpc_response_task_slab_pool()->deallocate(p);
+    else
+        dsn_transient_free(p);
 }
 
 rpc_response_task::rpc_response_task(
@@ -36,6 +36,9 @@
 # include "task_engine.h"
 # include <dsn/tool-api/perf_counter.h>
 # include <dsn/utility/factory_store.h>
+# include <map>
+# include <limits>
+# include <algorithm>
 
 # ifdef __TITLE__
 # undef __TITLE__
@@ -48,10 +51,21 @@ namespace dsn {
 
 
 task_worker_pool::task_worker_pool(const threadpool_spec& opts, task_engine* owner)
-    : _spec(opts), _owner(owner), _node(owner->node())
+    : _spec(opts), _owner(owner), _node(owner->node()),
+    _active_worker_count(opts.elastic ? opts.elastic_min_worker_count : opts.worker_count),
+    _queue_delay_estimate_ms(0)
 {
     _is_running = false;
     _per_node_timer_svc = nullptr;
+    _elastic_monitor = nullptr;
+    _elastic_stopped = false;
+    _elastic_grow_streak = 0;
+    _elastic_park_streak = 0;
+}
+
+task_worker_pool::~task_worker_pool()
+{
+    stop_elastic_monitor();
 }
 
 void task_worker_pool::create()
@@ -108,6 +122,15 @@ void task_worker_pool::create()
 
         _workers.push_back(worker);
     }
+
+    if (_spec.elastic)
+    {
+        _active_worker_counter = perf_counter::get_counter(_node->name(), "engine",
+            (_spec.name + ".worker.active").c_str(), COUNTER_TYPE_NUMBER, "active worker count of the elastic thread pool", true);
+        _queue_delay_counter = perf_counter::get_counter(_node->name(), "engine",
+            (_spec.name + ".queue.delay.estimate(ms)").c_str(), COUNTER_TYPE_NUMBER, "estimated queueing delay (ms) of the elastic thread pool", true);
+        _active_worker_counter->set(active_worker_count());
+    }
 }
 
 void task_worker_pool::start()
@@ -141,6 +164,134 @@ void task_worker_pool::start()
     }
 
     _is_running = true;
+
+    if (_spec.elastic)
+    {
+        ddebug("[%s] thread pool [%s] is elastic, active worker count = [%d, %d], queueing delay target = %d ms",
+            _node->name(), _spec.name.c_str(),
+            _spec.elastic_min_worker_count,
+            _spec.worker_count,
+            _spec.elastic_queue_delay_target_ms);
+
+        _elastic_monitor = new std::thread(std::bind(&task_worker_pool::elastic_monitor, this));
+    }
+}
+
+void task_worker_pool::park(task_worker* worker)
+{
+    std::unique_lock<std::mutex> l(_park_lock);
+    _park_cond.wait(l, [=]() { return worker->index() < active_worker_count(); });
+}
+
+void task_worker_pool::resize(int active_worker_count)
+{
+    {
+        std::lock_guard<std::mutex> l(_park_lock);
+        _active_worker_count.store(active_worker_count, std::memory_order_relaxed);
+    }
+    _park_cond.notify_all();
+    _active_worker_counter->set(active_worker_count);
+
+    ddebug("[%s] thread pool [%s] resized to %d active workers, estimated queueing delay = %" PRIu64 " ms",
+        _node->name(), _spec.name.c_str(),
+        active_worker_count,
+        queue_delay_estimate_ms());
+}
+
+void task_worker_pool::stop_elastic_monitor()
+{
+    if (_elastic_monitor == nullptr)
+        return;
+
+    {
+        std::lock_guard<std::mutex> l(_elastic_lock);
+        _elastic_stopped = true;
+    }
+    _elastic_cond.notify_all();
+
+    _elastic_monitor->join();
+    delete _elastic_monitor;
+    _elastic_monitor = nullptr;
+}
+
+//
+// the queueing delay is estimated with Little's law (queue length / throughput), which
+// is the mean of what the profiler reports as TASK_QUEUEING_TIME_NS, but does not
+// require the profiler to be enabled;
+// hysteresis: one worker is activated after elastic_grow_check_count consecutive checks
+// above the target, and one is parked after elastic_park_check_count consecutive
+// checks below 1/4 of the target, and the streaks restart after each resize
+//
+void task_worker_pool::elastic_monitor()
+{
+    char name[64];
+    sprintf(name, "%s.elastic", _spec.name.c_str());
+    task_worker::set_name(name);
+
+    uint32_t last_processed = 0;
+    for (auto& wk : _workers)
+        last_processed += static_cast<uint32_t>(wk->processed_task_count());
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> l(_elastic_lock);
+            if (_elastic_cond.wait_for(l, std::chrono::milliseconds(_spec.elastic_check_interval_ms),
+                [this]() { return _elastic_stopped; }))
+                return;
+        }
+
+        uint64_t queued = 0;
+        for (auto& q : _queues)
+            queued += static_cast<uint64_t>(std::max(q->count(), 0));
+
+        uint32_t processed = 0;
+        for (auto& wk : _workers)
+            processed += static_cast<uint32_t>(wk->processed_task_count());
+
+        elastic_check(queued, processed - last_processed);
+        last_processed = processed;
+    }
+}
+
+void task_worker_pool::elastic_check(uint64_t queued, uint32_t processed)
+{
+    const uint64_t interval_ms = static_cast<uint64_t>(_spec.elastic_check_interval_ms);
+    const uint64_t target_ms = static_cast<uint64_t>(_spec.elastic_queue_delay_target_ms);
+
+    uint64_t delay_ms;
+    if (processed > 0)
+        delay_ms = queued * interval_ms / processed;
+    else
+        delay_ms = (queued > 0 ? std::numeric_limits<uint64_t>::max() : 0);
+
+    _queue_delay_estimate_ms.store(delay_ms, std::memory_order_relaxed);
+    _queue_delay_counter->set(std::min(delay_ms, static_cast<uint64_t>(3600 * 1000)));
+
+    int active = active_worker_count();
+    if (delay_ms > target_ms)
+    {
+        _elastic_park_streak = 0;
+        if (++_elastic_grow_streak >= _spec.elastic_grow_check_count && active < _spec.worker_count)
+        {
+            _elastic_grow_streak = 0;
+            resize(active + 1);
+        }
+    }
+    else if (delay_ms * 4 < target_ms)
+    {
+        _elastic_grow_streak = 0;
+        if (++_elastic_park_streak >= _spec.elastic_park_check_count && active > _spec.elastic_min_worker_count)
+        {
+            _elastic_park_streak = 0;
+            resize(active - 1);
+        }
+    }
+    else
+    {
+        _elastic_grow_streak = 0;
+        _elastic_park_streak = 0;
+    }
 }
 
 void task_worker_pool::add_timer(task* t)
@@ -203,11 +354,35 @@ bool task_worker_pool::shared_same_worker_with_current_task(task* tsk) const
     }
 }
 
+// print as cpuset list, e.g., 0-15,64-79
+static void print_cpu_list(const std::vector<int>& cpus, /*out*/ safe_sstream& ss)
+{
+    for (size_t i = 0; i < cpus.size(); )
+    {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1)
+            j++;
+
+        if (i > 0)
+            ss << ",";
+        ss << cpus[i];
+        if (j > i)
+            ss << "-" << cpus[j];
+        i = j + 1;
+    }
+}
+
 void task_worker_pool::get_runtime_info(const safe_string& indent, 
     const safe_vector<safe_string>& args, /*out*/ safe_sstream& ss)
 {
     auto indent2 = indent + "\t";
     ss << indent << "contains " << _workers.size() << " threads with " << _queues.size() << " queues" << std::endl;
+    if (_spec.elastic)
+    {
+        ss << indent2 << "elastic: " << active_worker_count() << " active workers in ["
+            << _spec.elastic_min_worker_count << ", " << _spec.worker_count
+            << "], estimated queueing delay = " << queue_delay_estimate_ms() << " ms" << std::endl;
+    }
     
     for (auto& q : _queues)
     {
@@ -217,13 +392,30 @@ void task_worker_pool::get_runtime_info(const safe_string& indent,
         }
     }
 
+    std::map<int, int> node_workers;
     for (auto& wk : _workers)
     {
         if (wk)
         {
-            ss << indent2 << wk->index() << " (TID = " << wk->native_tid() << ") attached with queue " << wk->queue()->get_name() << std::endl;
+            ss << indent2 << wk->index() << " (TID = " << wk->native_tid() << ") attached with queue " << wk->queue()->get_name();
+            if (wk->affinity_cpus().size() > 0)
+            {
+                ss << ", cpus = ";
+                print_cpu_list(wk->affinity_cpus(), ss);
+                ss << ", numa node = " << wk->numa_node();
+            }
+            ss << std::endl;
+            node_workers[wk->numa_node()]++;
         }
     }
+
+    for (auto& kv : node_workers)
+    {
+        if (kv.first >= 0)
+            ss << indent2 << "numa node " << kv.first << " has " << kv.second << " workers" << std::endl;
+        else
+            ss << indent2 << kv.second << " workers are not bound to a numa node" << std::endl;
+    }
 }
 void task_worker_pool::get_queue_info(/*out*/ safe_sstream& ss)
 {
@@ -237,7 +429,10 @@ void task_worker_pool::get_queue_info(/*out*/ safe_sstream& ss)
                 first_flag = 1;
             else
                 ss << ",";
-            ss <<"\t\t{\"name\":\""<< q->get_name() << "\",\n\t\t\"num\":" << q->count() << "}\n";
+            ss <<"\t\t{\"name\":\""<< q->get_name() << "\",\n\t\t\"num\":" << q->count();
+            if (_spec.elastic)
+                ss << ",\n\t\t\"active_workers\":" << active_worker_count();
+            ss << "}\n";
         }
     }
     ss << "]\n";
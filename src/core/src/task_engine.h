@@ -41,6 +41,10 @@
 # include <dsn/tool-api/perf_counter.h>
 # include <dsn/tool-api/task_worker.h>
 # include <dsn/tool-api/timer_service.h>
+# include <atomic>
+# include <condition_variable>
+# include <mutex>
+# include <thread>
 
 namespace dsn {
 
@@ -56,6 +60,7 @@ class task_worker_pool
 {
 public:
     task_worker_pool(const threadpool_spec& opts, task_engine* owner);
+    ~task_worker_pool();
 
     // service management
     void create();    
@@ -75,10 +80,29 @@ public:
     service_node* node() const { return _node; }
     void get_runtime_info(const safe_string& indent, const safe_vector<safe_string>& args, /*out*/ safe_sstream& ss);
     void get_queue_info(/*out*/ safe_sstream& ss);
+    int active_worker_count() const { return _active_worker_count.load(std::memory_order_relaxed); }
     std::vector<task_queue*>& queues() { return _queues; }
     std::vector<task_worker*>& workers() { return _workers; }
     std::vector<admission_controller*>& controllers() { return _controllers; }
 
+    // elastic pools: workers beyond the active worker count park here until activated
+    void park_if_inactive(task_worker* worker)
+    {
+        if (_spec.elastic && worker->index() >= active_worker_count())
+            park(worker);
+    }
+
+    // one check of the elastic monitor with the queue length and the count of tasks
+    // processed since the last check, which may activate or park one worker
+    void elastic_check(uint64_t queued, uint32_t processed);
+    uint64_t queue_delay_estimate_ms() const { return _queue_delay_estimate_ms.load(std::memory_order_relaxed); }
+
+private:
+    void park(task_worker* worker);
+    void elastic_monitor();
+    void stop_elastic_monitor();
+    void resize(int active_worker_count);
+
 private:
     threadpool_spec                    _spec;
     task_engine*                       _owner;
@@ -93,6 +117,20 @@ private:
     std::vector<timer_service*>        _per_queue_timer_svcs;
 
     bool                              _is_running;
+
+    // elastic pools
+    std::atomic<int>                   _active_worker_count;
+    std::mutex                         _park_lock;
+    std::condition_variable            _park_cond;
+    std::thread*                       _elastic_monitor;
+    std::mutex                         _elastic_lock;
+    std::condition_variable            _elastic_cond;
+    bool                               _elastic_stopped;
+    int                                _elastic_grow_streak;
+    int                                _elastic_park_streak;
+    perf_counter_ptr                   _active_worker_counter;
+    perf_counter_ptr                   _queue_delay_counter;
+    std::atomic<uint64_t>              _queue_delay_estimate_ms;
 };
 
 class task_engine
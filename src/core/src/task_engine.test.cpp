@@ -143,6 +143,93 @@ TEST(core, task_engine)
     ASSERT_EQ(nullptr, controllers2[1]);
 }
 
+TEST(core, task_worker_affinity_cpus)
+{
+    std::vector<int> cpus;
+    ASSERT_TRUE(task_worker::parse_affinity_cpus("0-3, 8,66-67", cpus));
+    ASSERT_EQ(std::vector<int>({ 0, 1, 2, 3, 8, 66, 67 }), cpus);
+
+    ASSERT_TRUE(task_worker::parse_affinity_cpus("5,1-2,2", cpus));
+    ASSERT_EQ(std::vector<int>({ 1, 2, 5 }), cpus);
+
+    ASSERT_FALSE(task_worker::parse_affinity_cpus("", cpus));
+    ASSERT_FALSE(task_worker::parse_affinity_cpus("3-1", cpus));
+    ASSERT_FALSE(task_worker::parse_affinity_cpus("1-", cpus));
+    ASSERT_FALSE(task_worker::parse_affinity_cpus("a", cpus));
+
+    // out of the cpu set, rejected without enumerating the range
+    ASSERT_FALSE(task_worker::parse_affinity_cpus("100000", cpus));
+    ASSERT_FALSE(task_worker::parse_affinity_cpus("0-2000000000", cpus));
+
+    // not pinned on an invalid list
+    ASSERT_EQ(-1, task_worker::pin_current_thread("3-1", false));
+}
+
+TEST(core, task_worker_pool_elastic)
+{
+    service_node* node = task::get_current_node2();
+    ASSERT_NE(nullptr, node);
+
+    // the workers are created but not started, and the checks are driven by the test
+    threadpool_spec spec(node->computation()->get_pool(THREAD_POOL_DEFAULT)->spec());
+    spec.name = "THREAD_POOL_ELASTIC_TEST";
+    spec.worker_count = 3;
+    spec.elastic = true;
+    spec.elastic_min_worker_count = 1;
+    spec.elastic_queue_delay_target_ms = 10;
+    spec.elastic_check_interval_ms = 100;
+    spec.elastic_grow_check_count = 2;
+    spec.elastic_park_check_count = 3;
+
+    task_worker_pool pool(spec, node->computation());
+    pool.create();
+    ASSERT_EQ(3u, pool.workers().size());
+    EXPECT_EQ(1, pool.active_worker_count());
+
+    // 100 queued and 10 processed in 100 ms: 1000 ms delay, above the target
+    pool.elastic_check(100, 10);
+    EXPECT_EQ(1000u, pool.queue_delay_estimate_ms());
+    EXPECT_EQ(1, pool.active_worker_count());
+    pool.elastic_check(100, 10);
+    EXPECT_EQ(2, pool.active_worker_count());
+    pool.elastic_check(100, 10);
+    pool.elastic_check(100, 10);
+    EXPECT_EQ(3, pool.active_worker_count());
+
+    // never beyond worker_count
+    pool.elastic_check(100, 10);
+    pool.elastic_check(100, 10);
+    EXPECT_EQ(3, pool.active_worker_count());
+
+    // between 1/4 of the target and the target, which restarts the streaks
+    pool.elastic_check(0, 100);
+    pool.elastic_check(0, 100);
+    pool.elastic_check(5, 100);
+    EXPECT_EQ(5u, pool.queue_delay_estimate_ms());
+    EXPECT_EQ(3, pool.active_worker_count());
+
+    // below 1/4 of the target
+    pool.elastic_check(0, 100);
+    pool.elastic_check(0, 100);
+    EXPECT_EQ(3, pool.active_worker_count());
+    pool.elastic_check(0, 100);
+    EXPECT_EQ(2, pool.active_worker_count());
+    for (int i = 0; i < 6; i++)
+        pool.elastic_check(0, 0);
+    EXPECT_EQ(0u, pool.queue_delay_estimate_ms());
+    EXPECT_EQ(1, pool.active_worker_count());
+
+    // never below elastic_min_worker_count
+    for (int i = 0; i < 3; i++)
+        pool.elastic_check(0, 0);
+    EXPECT_EQ(1, pool.active_worker_count());
+
+    // queued tasks without progress
+    pool.elastic_check(1, 0);
+    pool.elastic_check(1, 0);
+    EXPECT_EQ(2, pool.active_worker_count());
+}
+
 /*
 TEST(core, task_engine)
 {
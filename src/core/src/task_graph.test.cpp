@@ -0,0 +1,113 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     Unit-test for task_graph.
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# include <dsn/service_api_cpp.h>
+# include <dsn/cpp/task_graph.h>
+# include <dsn/cpp/test_utils.h>
+# include <gtest/gtest.h>
+# include <atomic>
+# include <thread>
+
+using namespace ::dsn;
+
+TEST(core, task_graph)
+{
+    task_graph_profile profile;
+    profile.init("test.graph");
+
+    // diamond: a -> (b, c) -> d, with c the slow branch
+    std::atomic<int> order(0);
+    int a_order = -1, b_order = -1, c_order = -1, d_order = -1;
+
+    task_graph_ptr g(new task_graph("test.graph", &profile));
+    auto a = g->add_lpc("a", LPC_TEST_HASH, [&]() { a_order = order++; });
+    auto b = g->add_lpc("b", LPC_TEST_HASH, [&]() { b_order = order++; });
+    auto c = g->add_async("c", [&](const task_graph::completion& done)
+    {
+        tasking::enqueue(LPC_TEST_HASH, nullptr, [&, done]()
+        {
+            c_order = order++;
+            done(ERR_OK);
+        }, 0, std::chrono::milliseconds(50));
+    });
+    auto d = g->add_lpc("d", LPC_TEST_HASH, [&]() { d_order = order++; });
+    g->add_dependency(b, a);
+    g->add_dependency(c, a);
+    g->add_dependency(d, b);
+    g->add_dependency(d, c);
+
+    error_code result = ERR_UNKNOWN;
+    g->run([&result](error_code err) { result = err; });
+    g->wait();
+
+    ASSERT_EQ(ERR_OK, result);
+    ASSERT_EQ(ERR_OK, g->error());
+    ASSERT_EQ(0, a_order);
+    ASSERT_EQ(1, b_order);
+    ASSERT_EQ(2, c_order);
+    ASSERT_EQ(3, d_order);
+
+    ASSERT_EQ(3u, g->critical_path().size());
+    ASSERT_EQ(a, g->critical_path()[0]);
+    ASSERT_EQ(c, g->critical_path()[1]);
+    ASSERT_EQ(d, g->critical_path()[2]);
+    ASSERT_GE(g->critical_path_ns(), 50u * 1000000u);
+    ASSERT_GE(g->latency_ns(), g->critical_path_ns());
+}
+
+TEST(core, task_graph_failure)
+{
+    // a fails, so b (depends on a) and c (depends on b) are skipped, while e still runs
+    std::atomic<int> executed(0);
+    task_graph_ptr g(new task_graph("test.graph.failure"));
+    auto a = g->add_async("a", [](const task_graph::completion& done) { done(ERR_TIMEOUT); });
+    auto b = g->add_lpc("b", LPC_TEST_HASH, [&]() { executed++; });
+    auto c = g->add_lpc("c", LPC_TEST_HASH, [&]() { executed++; });
+    g->add_lpc("e", LPC_TEST_HASH, [&]() { executed += 10; });
+    g->add_dependency(b, a);
+    g->add_dependency(c, b);
+
+    g->run();
+    g->wait();
+    ASSERT_EQ(ERR_TIMEOUT, g->error());
+    ASSERT_EQ(10, executed.load());
+
+    // empty graph
+    task_graph_ptr g2(new task_graph("test.graph.empty"));
+    bool called = false;
+    g2->run([&called](error_code err) { called = (err == ERR_OK); });
+    g2->wait();
+    ASSERT_TRUE(called);
+}
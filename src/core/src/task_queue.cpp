@@ -57,13 +57,27 @@ task_queue::task_queue(task_worker_pool* pool, int index, task_queue* inner_prov
     _owner_worker = nullptr;
     _worker_count = _pool->spec().partitioned ? 1 : _pool->spec().worker_count;
     _queue_length_counter = perf_counter::get_counter(_pool->node()->name(), "engine", (_name + ".queue.length").c_str(), COUNTER_TYPE_NUMBER, "task queue length", true);
+    _rate_limit_rejected_counter = perf_counter::get_counter(_pool->node()->name(), "engine", (_name + ".rate_limit.rejected").c_str(), COUNTER_TYPE_NUMBER, "rpc requests rejected by rpc_request_rate_limit", true);
     _virtual_queue_length = 0;
     _spec = (threadpool_spec*)&pool->spec();
 }
 
+service_node* task_queue::node() const
+{
+    return _pool->node();
+}
+
 task_queue::~task_queue()
 {
     perf_counter::remove_counter(_queue_length_counter->full_name());
+    perf_counter::remove_counter(_rate_limit_rejected_counter->full_name());
+}
+
+/*static*/ void task_queue::reply_busy(task* request_task)
+{
+    auto rtask = static_cast<rpc_request_task*>(request_task);
+    auto resp = rtask->get_request()->create_response();
+    task::get_current_rpc()->reply(resp, ERR_BUSY);
 }
 
 void task_queue::enqueue_internal(task* task)
@@ -119,6 +133,37 @@ void task_queue::enqueue_internal(task* task)
         }
     }
 
+    if (!sp.rpc_request_rate_limiter.unlimited() && !sp.rpc_request_rate_limiter.try_consume(dsn_now_ns()))
+    {
+        auto rtask = static_cast<rpc_request_task*>(task);
+        reply_busy(task);
+
+        dinfo("%s exceeds rpc_request_rate_limit (%" PRIu64 "/s), reject message from %s with trace_id = %016" PRIx64,
+            sp.name.c_str(),
+            sp.rpc_request_rate_limit,
+            rtask->get_request()->header->from_address.to_string(),
+            rtask->get_request()->header->trace_id
+            );
+
+        _rate_limit_rejected_counter->increment();
+        task->release_ref(); // added in task::enqueue(pool)
+        return;
+    }
+
+    if (_controller != nullptr && sp.type == TASK_TYPE_RPC_REQUEST && !_controller->is_task_accepted(task))
+    {
+        auto rtask = static_cast<rpc_request_task*>(task);
+        reply_busy(task);
+
+        dinfo("rejected by admission controller, reject message from %s with trace_id = %016" PRIx64,
+            rtask->get_request()->header->from_address.to_string(),
+            rtask->get_request()->header->trace_id
+            );
+
+        task->release_ref(); // added in task::enqueue(pool)
+        return;
+    }
+
     tls_dsn.last_worker_queue_size = increase_count();
     enqueue(task);
 }
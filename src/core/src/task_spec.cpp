@@ -37,6 +37,7 @@
 # include <dsn/utility/singleton.h>
 # include <dsn/tool-api/perf_counter.h>
 # include <dsn/tool-api/command.h>
+# include <dsn/tool-api/task_worker.h>
 # include <sstream>
 # include <vector>
 # include <thread>
@@ -114,6 +115,7 @@ task_spec::task_spec(int code, const char* name, dsn_task_type_t type, dsn_task_
     rpc_call_header_format(NET_HDR_DSN),
     rpc_call_channel(RPC_CHANNEL_TCP),
     rpc_message_crc_required(false),
+    rpc_request_arena_enabled(false),
     on_task_create((std::string(name) + std::string(".create")).c_str()),
     on_task_enqueue((std::string(name) + std::string(".enqueue")).c_str()),
     on_task_begin((std::string(name) + std::string(".begin")).c_str()), 
@@ -185,6 +187,18 @@ bool task_spec::init()
             spec->rpc_request_delayer.initialize(mss);
         }
 
+        if (spec->rpc_request_rate_limit > 0)
+        {
+            if (spec->type != TASK_TYPE_RPC_REQUEST)
+            {
+                derror("%s: only rpc request type can have non-zero rpc_request_rate_limit",
+                    spec->name.c_str()
+                    );
+                return false;
+            }
+            spec->rpc_request_rate_limiter.reset(spec->rpc_request_rate_limit, spec->rpc_request_rate_burst);
+        }
+
         if (spec->rpc_request_throttling_mode != TM_NONE)
         {
             if (spec->type != TASK_TYPE_RPC_REQUEST)
@@ -276,9 +290,47 @@ bool threadpool_spec::init(/*out*/ safe_vector<threadpool_spec>& specs)
         if ("" == spec.name) 
             spec.name = dsn_threadpool_code_to_string(code);
 
-        if (false == spec.worker_share_core && 0 == spec.worker_affinity_mask)
+        if (spec.worker_affinity_cpus.length() > 0)
+        {
+            std::vector<int> cpus;
+            if (!task_worker::parse_affinity_cpus(spec.worker_affinity_cpus.c_str(), cpus))
+            {
+                derror("invalid worker_affinity_cpus '%s' for thread pool %s",
+                    spec.worker_affinity_cpus.c_str(), spec.name.c_str());
+                return false;
+            }
+            spec.worker_affinity_cpu_list.assign(cpus.begin(), cpus.end());
+        }
+        else if (false == spec.worker_share_core && 0 == spec.worker_affinity_mask)
+        {
+            // leave it as 0 when #core >= 64, so that the workers pick cores from all cpus
+            unsigned int nr_cpu = std::thread::hardware_concurrency();
+            if (nr_cpu < 64)
+                spec.worker_affinity_mask = ((uint64_t)1 << nr_cpu) - 1;
+        }
+
+        if (spec.elastic)
         {
-            spec.worker_affinity_mask = (1 << std::thread::hardware_concurrency()) - 1;
+            if (spec.partitioned)
+            {
+                derror("elastic thread pool %s cannot be partitioned", spec.name.c_str());
+                return false;
+            }
+
+            if (spec.elastic_min_worker_count < 1 || spec.elastic_min_worker_count > spec.worker_count)
+            {
+                derror("elastic_min_worker_count (%d) of thread pool %s must be in [1, worker_count(%d)]",
+                    spec.elastic_min_worker_count, spec.name.c_str(), spec.worker_count);
+                return false;
+            }
+
+            if (spec.elastic_check_interval_ms <= 0 || spec.elastic_grow_check_count <= 0
+                || spec.elastic_park_check_count <= 0)
+            {
+                derror("elastic_check_interval_ms, elastic_grow_check_count and elastic_park_check_count of thread pool %s must be positive",
+                    spec.name.c_str());
+                return false;
+            }
         }
 
         specs.push_back(spec);
@@ -35,7 +35,11 @@
 
 # include <dsn/tool-api/task_worker.h>
 # include "task_engine.h"
+# include <dsn/cpp/utils.h>
 # include <sstream>
+# include <fstream>
+# include <algorithm>
+# include <limits>
 # include <errno.h>
 
 # ifdef _WIN32
@@ -51,6 +55,14 @@
 # include <mach/thread_policy.h>
 # endif
 
+# ifdef __linux__
+# include <unistd.h>
+# include <sys/syscall.h>
+# ifndef MPOL_PREFERRED
+# define MPOL_PREFERRED 1
+# endif
+# endif
+
 # endif
 
 
@@ -78,6 +90,7 @@ task_worker::task_worker(task_worker_pool* pool, task_queue* q, int index, task_
 
     _thread = nullptr;
     _processed_task_count = 0;
+    _numa_node = -1;
 }
 
 task_worker::~task_worker()
@@ -283,6 +296,219 @@ void task_worker::set_affinity(uint64_t affinity)
     }
 }
 
+void task_worker::set_affinity(const std::vector<int>& cpus)
+{
+    dassert(cpus.size() > 0, "affinity cpu list cannot be empty.");
+
+# if defined(__linux__) || defined(__FreeBSD__)
+    # ifdef __FreeBSD__
+        # ifndef cpu_set_t
+            # define cpu_set_t cpuset_t
+        # endif
+    # endif
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (auto cpu : cpus)
+    {
+        if (cpu >= 0 && cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &cpuset);
+        else
+            dwarn("cpu %d is ignored as it is out of range [0, %d)", cpu, CPU_SETSIZE);
+    }
+
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+    if (err != 0)
+    {
+        dwarn("Fail to set thread affinity. err = %d", err);
+    }
+# else
+    uint64_t mask = 0;
+    for (auto cpu : cpus)
+    {
+        if (cpu < 64)
+            mask |= ((uint64_t)1 << cpu);
+        else
+            dwarn("cpu %d is ignored as only the first 64 cores are supported on this platform", cpu);
+    }
+    if (mask != 0)
+        set_affinity(mask);
+# endif
+}
+
+// cpus that can be given in an affinity list
+# if defined(__linux__) || defined(__FreeBSD__)
+static const int max_affinity_cpu_count = CPU_SETSIZE;
+# else
+static const int max_affinity_cpu_count = 64;
+# endif
+
+// e.g., 0-3,8,10-11
+// ids are in [0, max_id)
+static bool parse_id_list(const char* list, int max_id, /*out*/ std::vector<int>& ids)
+{
+    std::vector<std::string> ranges;
+    ::dsn::utils::split_args(list, ranges, ',');
+    if (ranges.size() == 0)
+        return false;
+
+    for (auto& r : ranges)
+    {
+        int first, last;
+        char tail;
+        if (sscanf(r.c_str(), "%d-%d%c", &first, &last, &tail) == 2)
+        {
+            if (first < 0 || last < first)
+                return false;
+        }
+        else if (sscanf(r.c_str(), "%d%c", &first, &tail) == 1 && first >= 0)
+        {
+            last = first;
+        }
+        else
+            return false;
+
+        if (last >= max_id)
+        {
+            derror("id %d in '%s' is out of range [0, %d)", last, list, max_id);
+            return false;
+        }
+
+        for (int i = first; i <= last; i++)
+            ids.push_back(i);
+    }
+
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return true;
+}
+
+static bool read_sys_id_list(const char* path, /*out*/ std::vector<int>& ids)
+{
+    std::ifstream f(path);
+    std::string line;
+    if (!f || !std::getline(f, line))
+        return false;
+    return parse_id_list(line.c_str(), std::numeric_limits<int>::max(), ids);
+}
+
+// numa node id of each cpu, -1 for unknown
+static const std::vector<int>& cpu_numa_nodes()
+{
+    static std::vector<int> s_nodes = []()
+    {
+        std::vector<int> cpu_nodes;
+# ifdef __linux__
+        std::vector<int> nodes;
+        read_sys_id_list("/sys/devices/system/node/possible", nodes);
+        for (auto node : nodes)
+        {
+            char path[128];
+            std::vector<int> cpus;
+            sprintf(path, "/sys/devices/system/node/node%d/cpulist", node);
+            if (!read_sys_id_list(path, cpus))
+                continue;
+
+            for (auto cpu : cpus)
+            {
+                if (cpu >= (int)cpu_nodes.size())
+                    cpu_nodes.resize(cpu + 1, -1);
+                cpu_nodes[cpu] = node;
+            }
+        }
+# endif
+        return cpu_nodes;
+    }();
+    return s_nodes;
+}
+
+bool task_worker::parse_affinity_cpus(const char* spec, /*out*/ std::vector<int>& cpus)
+{
+    cpus.clear();
+
+    std::string buffer(spec);
+    std::string s = ::dsn::utils::trim_string(&buffer[0]);
+    if (s.compare(0, 5, "node:") != 0)
+        return parse_id_list(s.c_str(), max_affinity_cpu_count, cpus);
+
+    std::vector<int> nodes;
+    if (!parse_id_list(s.c_str() + 5, max_affinity_cpu_count, nodes))
+        return false;
+
+    auto& cpu_nodes = cpu_numa_nodes();
+    for (int cpu = 0; cpu < (int)cpu_nodes.size() && cpu < max_affinity_cpu_count; cpu++)
+    {
+        if (std::find(nodes.begin(), nodes.end(), cpu_nodes[cpu]) != nodes.end())
+            cpus.push_back(cpu);
+    }
+
+    if (cpus.size() == 0)
+    {
+        derror("no cpu is found on numa node(s) '%s'", s.c_str() + 5);
+        return false;
+    }
+    return true;
+}
+
+int task_worker::numa_node_of_cpus(const std::vector<int>& cpus)
+{
+    auto& cpu_nodes = cpu_numa_nodes();
+    int node = -1;
+    for (auto cpu : cpus)
+    {
+        if (cpu >= (int)cpu_nodes.size() || cpu_nodes[cpu] == -1)
+            return -1;
+        if (node == -1)
+            node = cpu_nodes[cpu];
+        else if (node != cpu_nodes[cpu])
+            return -1;
+    }
+    return node;
+}
+
+void task_worker::bind_memory_to_numa_node(int node)
+{
+    dassert(node >= 0, "invalid numa node %d", node);
+
+# ifdef __linux__
+    // issue the syscall directly to avoid the dependency on libnuma
+    unsigned long mask[16];
+    const unsigned long bits = sizeof(mask) * 8;
+    if ((unsigned long)node >= bits - 1)
+    {
+        dwarn("numa node %d is too large for memory binding", node);
+        return;
+    }
+
+    memset(mask, 0, sizeof(mask));
+    mask[node / (sizeof(unsigned long) * 8)] |= (1UL << (node % (sizeof(unsigned long) * 8)));
+    if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask, bits) != 0)
+    {
+        dwarn("Fail to bind memory to numa node %d. errno = %d", node, errno);
+    }
+# endif
+}
+
+int task_worker::pin_current_thread(const char* affinity_cpus, bool numa_memory_binding)
+{
+    if (affinity_cpus == nullptr || affinity_cpus[0] == '\0')
+        return -1;
+
+    std::vector<int> cpus;
+    if (!parse_affinity_cpus(affinity_cpus, cpus))
+    {
+        derror("invalid affinity cpus '%s', the thread is not pinned", affinity_cpus);
+        return -1;
+    }
+    set_affinity(cpus);
+
+    int node = numa_node_of_cpus(cpus);
+    if (node >= 0 && numa_memory_binding)
+    {
+        bind_memory_to_numa_node(node);
+    }
+    return node;
+}
+
 void task_worker::run_internal()
 {
     while (_thread == nullptr)
@@ -296,35 +522,45 @@ void task_worker::run_internal()
     set_name(name().c_str());
     set_priority(pool_spec().worker_priority);
     
-    if (true == pool_spec().worker_share_core)
+    // worker_affinity_cpus is parsed and validated when the pool spec is loaded
+    std::vector<int> cpus(pool_spec().worker_affinity_cpu_list.begin(), pool_spec().worker_affinity_cpu_list.end());
+    if (cpus.size() == 0 && pool_spec().worker_affinity_mask > 0)
     {
-        if (pool_spec().worker_affinity_mask > 0) 
+        for (int i = 0; i < 64; i++)
         {
-            set_affinity(pool_spec().worker_affinity_mask);
+            if ((pool_spec().worker_affinity_mask & ((uint64_t)1 << i)) != 0)
+                cpus.push_back(i);
         }
     }
-    else
+
+    if (false == pool_spec().worker_share_core)
     {
-        uint64_t current_mask = pool_spec().worker_affinity_mask;
-        if (0 == current_mask)
+        if (cpus.size() == 0)
         {
-            derror("mask for %s is set to 0x0, mostly due to that #core > 64, set to 64 now",
-                pool_spec().name.c_str()
-                );
-
-            current_mask = ~((uint64_t)0);
+            // no mask is given (e.g., #core >= 64), use all cores
+            int nr_cpu = static_cast<int>(std::thread::hardware_concurrency());
+            for (int i = 0; i < nr_cpu; i++)
+                cpus.push_back(i);
         }
-        for (int i = 0; i < _index; ++i)
-        {            
-            current_mask &= (current_mask - 1);
-            if (0 == current_mask)
-            {
-                current_mask = pool_spec().worker_affinity_mask;
-            }
-        }
-        current_mask -= (current_mask & (current_mask - 1));
 
-        set_affinity(current_mask);
+        // one dedicated core per worker, round-robin when #worker > #core
+        int cpu = cpus[_index % cpus.size()];
+        cpus.clear();
+        cpus.push_back(cpu);
+    }
+
+    if (cpus.size() > 0)
+    {
+        set_affinity(cpus);
+        _affinity_cpus = cpus;
+        _numa_node = numa_node_of_cpus(cpus);
+
+        // the transient memory blocks are allocated lazily by this thread, so they
+        // land on the preferred node after this
+        if (_numa_node >= 0 && pool_spec().worker_numa_memory_binding)
+        {
+            bind_memory_to_numa_node(_numa_node);
+        }
     }
 
     _started.notify();
@@ -337,11 +573,14 @@ void task_worker::run_internal()
 void task_worker::loop()
 {
     task_queue* q = queue();
+    admission_controller* controller = q->controller();
     int best_batch_size = pool_spec().dequeue_batch_size;
 
     //try {
         while (_is_running)
         {
+            pool()->park_if_inactive(this);
+
             int batch_size = best_batch_size;
             task* task = q->dequeue(batch_size), *next;
 
@@ -354,7 +593,18 @@ void task_worker::loop()
             {                
                 next = task->next;
                 task->next = nullptr;
-                task->exec_internal();                
+                if (controller == nullptr)
+                {
+                    task->exec_internal();
+                }
+                else
+                {
+                    task->add_ref(); // exec_internal releases the ref from enqueue
+                    controller->on_task_begin(task);
+                    task->exec_internal();
+                    controller->on_task_end(task);
+                    task->release_ref();
+                }
                 task = next;
 # ifndef NDEBUG
                 count++;
@@ -369,7 +619,9 @@ void task_worker::loop()
                 );
 # endif
 
-            _processed_task_count += batch_size;
+            // single writer
+            _processed_task_count.store(_processed_task_count.load(std::memory_order_relaxed) + batch_size,
+                std::memory_order_relaxed);
         }
     /*}
     catch (std::exception& ex)
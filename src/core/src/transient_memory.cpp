@@ -26,7 +26,7 @@
 
 /*
  * Description:
- *     What is this file about?
+ *     thread local transient memory with recycled blocks
  *
  * Revision history:
  *     xxxx-xx-xx, author, first version
@@ -34,66 +34,457 @@
  */
 
 # include "transient_memory.h"
+# include "memory_accounting.h"
+# include <dsn/tool-api/memory_provider.h>
+# include <dsn/utility/synchronize.h>
+# include <atomic>
+# include <vector>
+# include <cstdlib>
+# ifdef __linux__
+# include <sys/mman.h>
+# endif
 
 namespace dsn 
 {
     __thread tls_transient_memory_t tls_trans_memory;
+    static __thread tls_transient_memory_t tls_trans_memory_long;
 
     static size_t tls_trans_mem_default_block_bytes = 1024 * 1024; // 1 MB
+    static size_t tls_trans_mem_long_block_bytes = 64 * 1024; // 64 KB
 
-    void tls_trans_mem_init(size_t default_per_block_bytes)
+    //
+    // each block is prefixed with a header, and the memory pointed by the block
+    // shared_ptr starts right after the header
+    //
+    struct trans_block_header
     {
-        tls_trans_mem_default_block_bytes = default_per_block_bytes;
+        // bytes of the live objects allocated by tls_trans_malloc, with TRANS_BLOCK_RETIRED set
+        // when the block is no longer used for allocation by its thread
+        std::atomic<uint64_t> live_bytes;
+        uint64_t              size;
+        int                   lane;
+    };
+
+    # define TRANS_BLOCK_HEADER_BYTES 64
+    # define TRANS_BLOCK_RETIRED (1ULL << 63)
+    static_assert(sizeof(trans_block_header) <= TRANS_BLOCK_HEADER_BYTES, "block header is too large");
+
+    static inline trans_block_header* get_block_header(char* blk)
+    {
+        return (trans_block_header*)(blk - TRANS_BLOCK_HEADER_BYTES);
     }
 
-    void tls_trans_mem_alloc(size_t min_size)
+    struct trans_lane_stats
+    {
+        std::atomic<int64_t> alive_blocks;
+        std::atomic<int64_t> alive_bytes;
+        std::atomic<int64_t> pinned_blocks;
+        std::atomic<int64_t> pinned_bytes;
+        std::atomic<int64_t> pinned_live_bytes;
+
+        trans_lane_stats() : alive_blocks(0), alive_bytes(0), pinned_blocks(0), pinned_bytes(0), pinned_live_bytes(0) {}
+    };
+
+    //
+    // recycling pool for the transient memory blocks
+    //
+    # define MAX_LOCAL_POOLED_BLOCK_COUNT 16
+
+    struct trans_block_pool
+    {
+        tls_trans_mem_pool_options opts;
+        utils::ex_lock_nr          lock;
+        std::vector<char*>         blocks; // global free list, protected by lock
+        std::atomic<int64_t>       pooled_bytes;
+        std::atomic<uint64_t>      hits;
+        std::atomic<uint64_t>      misses;
+        std::atomic<uint64_t>      recycled;
+        std::atomic<uint64_t>      dropped;
+        trans_lane_stats           lanes[TRANS_MEM_LANE_COUNT];
+
+        trans_block_pool() : pooled_bytes(0), hits(0), misses(0), recycled(0), dropped(0)
+        {
+            opts.max_pooled_bytes = 64 * 1024 * 1024;
+            opts.local_block_count = 2;
+            opts.prefault = false;
+            opts.huge_page = false;
+        }
+    };
+
+    // never deleted, as blocks may be released by other threads during exit
+    static trans_block_pool* s_block_pool = new trans_block_pool();
+
+    // per-thread cache of free blocks with the size of tls_free_block_bytes
+    static __thread char*  tls_free_blocks[MAX_LOCAL_POOLED_BLOCK_COUNT];
+    static __thread int    tls_free_block_count;
+    static __thread size_t tls_free_block_bytes;
+    static __thread bool   tls_block_pool_exited;
+
+    struct trans_block_observer_entry
+    {
+        trans_mem_block_observer observer;
+        void*                    context;
+    };
+
+    // the blocks are allocated from and returned to the heap rarely, so the observers
+    // are notified under the read lock, which keeps them alive while being notified
+    struct trans_block_observers
+    {
+        utils::rw_lock_nr                       lock;
+        std::vector<trans_block_observer_entry> entries;
+        std::atomic<int>                        count;
+
+        trans_block_observers() : count(0) {}
+    };
+
+    // never deleted, as blocks may be released by other threads during exit
+    static trans_block_observers* s_block_observers = new trans_block_observers();
+
+    void tls_trans_mem_add_block_observer(trans_mem_block_observer observer, void* context)
+    {
+        utils::auto_write_lock l(s_block_observers->lock);
+        s_block_observers->entries.push_back(trans_block_observer_entry{ observer, context });
+        s_block_observers->count.store((int)s_block_observers->entries.size(), std::memory_order_relaxed);
+    }
+
+    void tls_trans_mem_remove_block_observer(trans_mem_block_observer observer, void* context)
+    {
+        utils::auto_write_lock l(s_block_observers->lock);
+        auto& entries = s_block_observers->entries;
+        for (auto it = entries.begin(); it != entries.end(); ++it)
+        {
+            if (it->observer == observer && it->context == context)
+            {
+                entries.erase(it);
+                break;
+            }
+        }
+        s_block_observers->count.store((int)entries.size(), std::memory_order_relaxed);
+    }
+
+    static void notify_block_observers(char* blk, size_t sz, bool allocated)
+    {
+        if (s_block_observers->count.load(std::memory_order_relaxed) == 0)
+            return;
+
+        utils::auto_read_lock l(s_block_observers->lock);
+        for (auto& e : s_block_observers->entries)
+        {
+            e.observer(e.context, blk, sz, allocated);
+        }
+    }
+
+    static void free_block(char* blk)
+    {
+        auto hdr = get_block_header(blk);
+        if (hdr->lane == TRANS_MEM_LANE_SHORT)
+            notify_block_observers(blk, hdr->size, false);
+
+        ::free(blk - TRANS_BLOCK_HEADER_BYTES);
+    }
+
+    // move the blocks cached by the exiting thread to the global list
+    struct tls_block_pool_flusher
+    {
+        bool touched;
+
+        ~tls_block_pool_flusher()
+        {
+            tls_block_pool_exited = true;
+            if (tls_free_block_count == 0)
+                return;
+
+            utils::auto_lock<utils::ex_lock_nr> l(s_block_pool->lock);
+            for (int i = 0; i < tls_free_block_count; i++)
+            {
+                if (tls_free_block_bytes == tls_trans_mem_default_block_bytes)
+                    s_block_pool->blocks.push_back(tls_free_blocks[i]);
+                else
+                {
+                    s_block_pool->pooled_bytes -= tls_free_block_bytes;
+                    free_block(tls_free_blocks[i]);
+                }
+            }
+            tls_free_block_count = 0;
+        }
+    };
+
+    static thread_local tls_block_pool_flusher tls_block_pool_flusher_obj;
+
+    static char* new_block(size_t sz)
+    {
+        auto& opts = s_block_pool->opts;
+        char* blk = nullptr;
+        sz += TRANS_BLOCK_HEADER_BYTES;
+
+# ifdef __linux__
+        if (opts.huge_page)
+        {
+            const size_t huge_page_bytes = 2 * 1024 * 1024;
+            void* ptr;
+            if (0 == posix_memalign(&ptr, huge_page_bytes, sz))
+            {
+                blk = (char*)ptr;
+                madvise(blk, sz, MADV_HUGEPAGE);
+            }
+        }
+# endif
+
+        if (blk == nullptr)
+            blk = (char*)::malloc(sz);
+        dassert(blk != nullptr, "cannot allocate transient memory block with size %" PRIu64, (uint64_t)sz);
+
+        if (opts.prefault)
+        {
+            for (size_t i = 0; i < sz; i += 4096)
+                blk[i] = 0;
+        }
+        return blk + TRANS_BLOCK_HEADER_BYTES;
+    }
+
+    static void release_block(char* blk, size_t sz)
+    {
+        auto pool = s_block_pool;
+        auto hdr = get_block_header(blk);
+        auto& ls = pool->lanes[hdr->lane];
+        ls.alive_blocks--;
+        ls.alive_bytes -= sz;
+        if (hdr->live_bytes.load(std::memory_order_acquire) & TRANS_BLOCK_RETIRED)
+        {
+            ls.pinned_blocks--;
+            ls.pinned_bytes -= sz;
+        }
+
+        if (hdr->lane != TRANS_MEM_LANE_SHORT
+            || sz != tls_trans_mem_default_block_bytes
+            || pool->opts.max_pooled_bytes == 0)
+        {
+            free_block(blk);
+            return;
+        }
+
+        if (pool->pooled_bytes.fetch_add(sz, std::memory_order_relaxed) + sz > pool->opts.max_pooled_bytes)
+        {
+            pool->pooled_bytes.fetch_sub(sz, std::memory_order_relaxed);
+            pool->dropped.fetch_add(1, std::memory_order_relaxed);
+            free_block(blk);
+            return;
+        }
+
+        pool->recycled.fetch_add(1, std::memory_order_relaxed);
+        if (!tls_block_pool_exited
+            && tls_free_block_count < pool->opts.local_block_count
+            && (tls_free_block_count == 0 || tls_free_block_bytes == sz))
+        {
+            tls_block_pool_flusher_obj.touched = true;
+            tls_free_block_bytes = sz;
+            tls_free_blocks[tls_free_block_count++] = blk;
+        }
+        else
+        {
+            utils::auto_lock<utils::ex_lock_nr> l(pool->lock);
+            pool->blocks.push_back(blk);
+        }
+    }
+
+    static std::shared_ptr<char> acquire_block(size_t sz, int lane)
+    {
+        auto pool = s_block_pool;
+        char* blk = nullptr;
+
+        if (lane == TRANS_MEM_LANE_SHORT
+            && sz == tls_trans_mem_default_block_bytes
+            && pool->opts.max_pooled_bytes > 0)
+        {
+            // drop the local blocks of an obsolete size
+            if (tls_free_block_count > 0 && tls_free_block_bytes != sz)
+            {
+                for (int i = 0; i < tls_free_block_count; i++)
+                    free_block(tls_free_blocks[i]);
+                pool->pooled_bytes -= tls_free_block_bytes * tls_free_block_count;
+                tls_free_block_count = 0;
+            }
+
+            if (tls_free_block_count > 0)
+            {
+                blk = tls_free_blocks[--tls_free_block_count];
+            }
+            else
+            {
+                utils::auto_lock<utils::ex_lock_nr> l(pool->lock);
+                if (!pool->blocks.empty())
+                {
+                    blk = pool->blocks.back();
+                    pool->blocks.pop_back();
+                }
+            }
+
+            if (blk != nullptr)
+            {
+                pool->pooled_bytes.fetch_sub(sz, std::memory_order_relaxed);
+                pool->hits.fetch_add(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                pool->misses.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        bool is_new = (blk == nullptr);
+        if (is_new)
+            blk = new_block(sz);
+
+        auto hdr = get_block_header(blk);
+        new (hdr) trans_block_header();
+        hdr->live_bytes.store(0, std::memory_order_relaxed);
+        hdr->size = sz;
+        hdr->lane = lane;
+
+        if (is_new && lane == TRANS_MEM_LANE_SHORT)
+            notify_block_observers(blk, sz, true);
+
+        auto& ls = pool->lanes[lane];
+        ls.alive_blocks++;
+        ls.alive_bytes += sz;
+
+        return std::shared_ptr<char>(blk, [sz](char* p) { release_block(p, sz); });
+    }
+
+    // the block is no longer used for allocation, and the memory is pinned until
+    // all objects and blobs referencing it are released
+    static void retire_block(char* blk)
+    {
+        auto hdr = get_block_header(blk);
+        uint64_t live = hdr->live_bytes.fetch_or(TRANS_BLOCK_RETIRED, std::memory_order_acq_rel);
+        dbg_dassert((live & TRANS_BLOCK_RETIRED) == 0, "block is already retired");
+
+        auto& ls = s_block_pool->lanes[hdr->lane];
+        ls.pinned_blocks++;
+        ls.pinned_bytes += hdr->size;
+        ls.pinned_live_bytes += live;
+    }
+
+    static void clear_global_blocks()
+    {
+        std::vector<char*> blocks;
+        {
+            utils::auto_lock<utils::ex_lock_nr> l(s_block_pool->lock);
+            blocks.swap(s_block_pool->blocks);
+        }
+
+        // the global blocks are always of the default size
+        s_block_pool->pooled_bytes -= (int64_t)(blocks.size() * tls_trans_mem_default_block_bytes);
+        for (auto blk : blocks)
+            free_block(blk);
+    }
+
+    void tls_trans_mem_pool_init(const tls_trans_mem_pool_options& opts)
+    {
+        dassert(opts.local_block_count >= 0 && opts.local_block_count <= MAX_LOCAL_POOLED_BLOCK_COUNT,
+            "local_block_count must be in [0, %d]", MAX_LOCAL_POOLED_BLOCK_COUNT);
+
+        clear_global_blocks();
+        s_block_pool->opts = opts;
+    }
+
+    void tls_trans_mem_pool_get_stats(/*out*/ tls_trans_mem_pool_stats& stats)
+    {
+        stats.hits = s_block_pool->hits.load(std::memory_order_relaxed);
+        stats.misses = s_block_pool->misses.load(std::memory_order_relaxed);
+        stats.recycled = s_block_pool->recycled.load(std::memory_order_relaxed);
+        stats.dropped = s_block_pool->dropped.load(std::memory_order_relaxed);
+        stats.pooled_bytes = (uint64_t)s_block_pool->pooled_bytes.load(std::memory_order_relaxed);
+    }
+
+    void tls_trans_mem_get_block_stats(int lane, /*out*/ tls_trans_mem_block_stats& stats)
+    {
+        dassert(lane >= 0 && lane < TRANS_MEM_LANE_COUNT, "invalid lane %d", lane);
+        auto& ls = s_block_pool->lanes[lane];
+        stats.alive_blocks = (uint64_t)ls.alive_blocks.load(std::memory_order_relaxed);
+        stats.alive_bytes = (uint64_t)ls.alive_bytes.load(std::memory_order_relaxed);
+        stats.pinned_blocks = (uint64_t)ls.pinned_blocks.load(std::memory_order_relaxed);
+        stats.pinned_bytes = (uint64_t)ls.pinned_bytes.load(std::memory_order_relaxed);
+        stats.pinned_live_bytes = (uint64_t)ls.pinned_live_bytes.load(std::memory_order_relaxed);
+    }
+
+    void tls_trans_mem_init(size_t default_per_block_bytes, size_t long_per_block_bytes)
+    {
+        if (default_per_block_bytes != tls_trans_mem_default_block_bytes)
+        {
+            clear_global_blocks();
+            tls_trans_mem_default_block_bytes = default_per_block_bytes;
+        }
+        tls_trans_mem_long_block_bytes = long_per_block_bytes;
+    }
+
+    static void trans_mem_alloc(tls_transient_memory_t& mem, int lane, size_t min_size)
     {
         // release last buffer if necessary
-        if (tls_trans_memory.magic == 0xdeadbeef)
+        if (mem.magic == 0xdeadbeef)
         {
-            tls_trans_memory.block->reset();
+            if (*mem.block)
+            {
+                retire_block(mem.block->get());
+                mem.block->reset();
+            }
         }
         else
         {
-            tls_trans_memory.magic = 0xdeadbeef;
-            tls_trans_memory.block = new(tls_trans_memory.block_ptr_buffer) std::shared_ptr<char>();
-            tls_trans_memory.committed = true;
+            mem.magic = 0xdeadbeef;
+            mem.block = new(mem.block_ptr_buffer) std::shared_ptr<char>();
+            mem.committed = true;
         }
 
-        tls_trans_memory.remain_bytes = (min_size > tls_trans_mem_default_block_bytes ? 
-                min_size : tls_trans_mem_default_block_bytes);
-        *tls_trans_memory.block = ::dsn::make_shared_array<char>(tls_trans_memory.remain_bytes);
-        tls_trans_memory.next = tls_trans_memory.block->get();
+        size_t block_bytes = (lane == TRANS_MEM_LANE_SHORT ?
+            tls_trans_mem_default_block_bytes : tls_trans_mem_long_block_bytes);
+        mem.remain_bytes = (min_size > block_bytes ? min_size : block_bytes);
+        *mem.block = acquire_block(mem.remain_bytes, lane);
+        mem.next = mem.block->get();
     }
 
-    void tls_trans_mem_next(void** ptr, size_t* sz, size_t min_size)
+    static void trans_mem_next(tls_transient_memory_t& mem, int lane, void** ptr, size_t* sz, size_t min_size)
     {
-        if (tls_trans_memory.magic != 0xdeadbeef)
-            tls_trans_mem_alloc(min_size);
+        if (mem.magic != 0xdeadbeef)
+            trans_mem_alloc(mem, lane, min_size);
         else
         {
-            dassert(tls_trans_memory.committed == true,
+            dassert(mem.committed == true,
                 "tls_trans_mem_next and tls_trans_mem_commit must be called in pair");
 
-            if (min_size > tls_trans_memory.remain_bytes)
-                tls_trans_mem_alloc(min_size);
+            if (min_size > mem.remain_bytes)
+                trans_mem_alloc(mem, lane, min_size);
         }
 
-        *ptr = static_cast<void*>(tls_trans_memory.next);
-        *sz = tls_trans_memory.remain_bytes;
-        tls_trans_memory.committed = false;
+        *ptr = static_cast<void*>(mem.next);
+        *sz = mem.remain_bytes;
+        mem.committed = false;
     }
 
-    void tls_trans_mem_commit(size_t use_size)
+    static void trans_mem_commit(tls_transient_memory_t& mem, size_t use_size)
     {
-        dbg_dassert(tls_trans_memory.magic == 0xdeadbeef
-            && !tls_trans_memory.committed
-            && use_size <= tls_trans_memory.remain_bytes,
+        dbg_dassert(mem.magic == 0xdeadbeef
+            && !mem.committed
+            && use_size <= mem.remain_bytes,
             "invalid use or parameter of tls_trans_mem_commit");
 
-        tls_trans_memory.next += use_size;
-        tls_trans_memory.remain_bytes -= use_size;
-        tls_trans_memory.committed = true;
+        mem.next += use_size;
+        mem.remain_bytes -= use_size;
+        mem.committed = true;
+    }
+
+    void tls_trans_mem_alloc(size_t min_size)
+    {
+        trans_mem_alloc(tls_trans_memory, TRANS_MEM_LANE_SHORT, min_size);
+    }
+
+    void tls_trans_mem_next(void** ptr, size_t* sz, size_t min_size)
+    {
+        trans_mem_next(tls_trans_memory, TRANS_MEM_LANE_SHORT, ptr, sz, min_size);
+    }
+
+    void tls_trans_mem_commit(size_t use_size)
+    {
+        trans_mem_commit(tls_trans_memory, use_size);
     }
 
     blob tls_trans_mem_alloc_blob(size_t sz)
@@ -112,50 +503,196 @@ namespace dsn
         return buffer;
     }
 
-    void* tls_trans_malloc(size_t sz)
+    blob tls_trans_mem_alloc_aligned_blob(size_t sz, size_t alignment)
     {
-        sz += sizeof(std::shared_ptr<char>) + sizeof(uint32_t);
+        dassert(alignment > 0 && (alignment & (alignment - 1)) == 0, "invalid alignment %u", (uint32_t)alignment);
+
         void* ptr;
         size_t sz2;
-        tls_trans_mem_next(&ptr, &sz2, sz);
+        tls_trans_mem_next(&ptr, &sz2, sz + alignment - 1);
+
+        char* aligned_ptr = (char*)(((uintptr_t)ptr + alignment - 1) & ~(uintptr_t)(alignment - 1));
+        ::dsn::blob buffer(
+            (*::dsn::tls_trans_memory.block),
+            (int)(aligned_ptr - ::dsn::tls_trans_memory.block->get()),
+            (int)sz
+            );
+
+        tls_trans_mem_commit((size_t)(aligned_ptr - (char*)ptr) + sz);
+        return buffer;
+    }
+
+    //
+    // object layout: shared_ptr to the block, magic, size (including this prefix), object;
+    // the magic is 0xdeadbeef, or (memory accounting tag << 16 | 0xbeef) for sampled objects
+    //
+    # define TRANS_OBJECT_PREFIX_BYTES (sizeof(std::shared_ptr<char>) + sizeof(uint32_t) * 2)
+    # define TRANS_OBJECT_MAGIC 0xdeadbeef
+
+    static void* trans_malloc(tls_transient_memory_t& mem, int lane, size_t sz)
+    {
+        sz += TRANS_OBJECT_PREFIX_BYTES;
+        void* ptr;
+        size_t sz2;
+        trans_mem_next(mem, lane, &ptr, &sz2, sz);
 
         // add ref
-        new (ptr) std::shared_ptr<char>(*::dsn::tls_trans_memory.block);
+        new (ptr) std::shared_ptr<char>(*mem.block);
 
-        // add magic
-        *(uint32_t*)((char*)(ptr)+sizeof(std::shared_ptr<char>)) = 0xdeadbeef;
+        // add magic and size
+        uint16_t tag = memory_accounting::on_alloc(sz - TRANS_OBJECT_PREFIX_BYTES);
+        *(uint32_t*)((char*)(ptr)+sizeof(std::shared_ptr<char>)) =
+            tag == 0 ? TRANS_OBJECT_MAGIC : (((uint32_t)tag << 16) | (TRANS_OBJECT_MAGIC & 0xffff));
+        *(uint32_t*)((char*)(ptr)+sizeof(std::shared_ptr<char>) + sizeof(uint32_t)) = (uint32_t)sz;
+        get_block_header(mem.block->get())->live_bytes.fetch_add(sz, std::memory_order_relaxed);
 
-        tls_trans_mem_commit(sz);
+        trans_mem_commit(mem, sz);
+
+        return (void*)((char*)(ptr) + TRANS_OBJECT_PREFIX_BYTES);
+    }
 
-        return (void*)((char*)(ptr)+sizeof(std::shared_ptr<char>) + sizeof(uint32_t));
+    void* tls_trans_malloc(size_t sz)
+    {
+        return trans_malloc(tls_trans_memory, TRANS_MEM_LANE_SHORT, sz);
+    }
+
+    void* tls_trans_malloc_long(size_t sz)
+    {
+        return trans_malloc(tls_trans_memory_long, TRANS_MEM_LANE_LONG, sz);
     }
 
     void tls_trans_free(void* ptr)
     {
-        ptr = (void*)((char*)ptr - sizeof(uint32_t));
-        dassert(*(uint32_t*)(ptr) == 0xdeadbeef, "invalid transient memory block");
+        ptr = (void*)((char*)ptr - TRANS_OBJECT_PREFIX_BYTES);
+        uint32_t magic = *(uint32_t*)((char*)(ptr)+sizeof(std::shared_ptr<char>));
+        dassert((magic & 0xffff) == (TRANS_OBJECT_MAGIC & 0xffff),
+            "invalid transient memory block");
+        uint32_t sz = *(uint32_t*)((char*)(ptr)+sizeof(std::shared_ptr<char>) + sizeof(uint32_t));
+        if (magic != TRANS_OBJECT_MAGIC)
+            memory_accounting::on_free((uint16_t)(magic >> 16), sz - TRANS_OBJECT_PREFIX_BYTES);
+
+        auto block = (std::shared_ptr<char>*)(ptr);
+        auto hdr = get_block_header(block->get());
+        uint64_t live = hdr->live_bytes.fetch_sub(sz, std::memory_order_acq_rel);
+        if (live & TRANS_BLOCK_RETIRED)
+            s_block_pool->lanes[hdr->lane].pinned_live_bytes -= sz;
 
-        ptr = (void*)((char*)ptr - sizeof(std::shared_ptr<char>));
-        ((std::shared_ptr<char>*)(ptr))->~shared_ptr<char>();
+        block->~shared_ptr<char>();
     }
 }
 
+# ifdef DSN_COUNT_HEAP_ALLOCATIONS
+namespace dsn
+{
+    static std::atomic<uint64_t> s_trans_malloc_calls(0);
+    static std::atomic<uint64_t> s_dsn_malloc_calls(0);
+
+    uint64_t trans_malloc_call_count() { return s_trans_malloc_calls.load(std::memory_order_relaxed); }
+    uint64_t dsn_malloc_call_count() { return s_dsn_malloc_calls.load(std::memory_order_relaxed); }
+}
+# define COUNT_HEAP_ALLOCATION(counter) ::dsn::counter.fetch_add(1, std::memory_order_relaxed)
+# else
+# define COUNT_HEAP_ALLOCATION(counter)
+# endif
+
 DSN_API void* dsn_transient_malloc(uint32_t size)
 {
+    COUNT_HEAP_ALLOCATION(s_trans_malloc_calls);
     return ::dsn::tls_trans_malloc((size_t)size);
 }
 
+DSN_API void* dsn_transient_malloc_long(uint32_t size)
+{
+    COUNT_HEAP_ALLOCATION(s_trans_malloc_calls);
+    return ::dsn::tls_trans_malloc_long((size_t)size);
+}
+
 DSN_API void dsn_transient_free(void* ptr)
 {
     return ::dsn::tls_trans_free(ptr);
 }
 
+namespace dsn
+{
+    // prefix of the memory allocated by dsn_malloc, 16 bytes to keep the alignment
+    struct dsn_malloc_header
+    {
+        memory_provider* provider; // nullptr for malloc
+        uint32_t         size;
+        uint16_t         tag;      // see memory_accounting
+        uint16_t         reserved;
+    };
+
+    static std::atomic<memory_provider*> s_dsn_malloc_provider(nullptr);
+
+    void dsn_malloc_init(memory_provider* provider)
+    {
+        s_dsn_malloc_provider.store(provider, std::memory_order_release);
+    }
+}
+
 DSN_API void* dsn_malloc(uint32_t size)
 {
-    return malloc((size_t)size);
+    COUNT_HEAP_ALLOCATION(s_dsn_malloc_calls);
+    auto provider = ::dsn::s_dsn_malloc_provider.load(std::memory_order_acquire);
+    size_t sz = (size_t)size + sizeof(::dsn::dsn_malloc_header);
+    auto hdr = (::dsn::dsn_malloc_header*)(provider != nullptr ? provider->allocate(sz) : malloc(sz));
+    hdr->provider = provider;
+    hdr->size = size;
+    hdr->tag = ::dsn::memory_accounting::on_alloc((size_t)size);
+    return hdr + 1;
+}
+
+namespace dsn
+{
+    // prefix right before the memory returned by dsn_aligned_malloc
+    struct dsn_aligned_malloc_header
+    {
+        void*    raw;  // got from malloc
+        uint32_t size;
+        uint16_t tag;  // see memory_accounting
+    };
+}
+
+DSN_API void* dsn_aligned_malloc(uint32_t size, uint32_t alignment)
+{
+    dassert(alignment > 0 && (alignment & (alignment - 1)) == 0, "invalid alignment %u", alignment);
+    if (alignment < (uint32_t)sizeof(void*))
+        alignment = (uint32_t)sizeof(void*); // keep the header aligned
+
+    char* raw = (char*)malloc((size_t)size + alignment + sizeof(::dsn::dsn_aligned_malloc_header));
+    if (raw == nullptr)
+        return nullptr;
+
+    uintptr_t p = (uintptr_t)(raw + sizeof(::dsn::dsn_aligned_malloc_header));
+    p = (p + alignment - 1) & ~(uintptr_t)(alignment - 1);
+
+    auto hdr = (::dsn::dsn_aligned_malloc_header*)p - 1;
+    hdr->raw = raw;
+    hdr->size = size;
+    hdr->tag = ::dsn::memory_accounting::on_alloc((size_t)size);
+    return (void*)p;
+}
+
+DSN_API void dsn_aligned_free(void* ptr)
+{
+    if (ptr == nullptr)
+        return;
+
+    auto hdr = (::dsn::dsn_aligned_malloc_header*)ptr - 1;
+    ::dsn::memory_accounting::on_free(hdr->tag, (size_t)hdr->size);
+    free(hdr->raw);
 }
 
 DSN_API void dsn_free(void* ptr)
 {
-    return free(ptr);
+    if (ptr == nullptr)
+        return;
+
+    auto hdr = (::dsn::dsn_malloc_header*)ptr - 1;
+    ::dsn::memory_accounting::on_free(hdr->tag, (size_t)hdr->size);
+    if (hdr->provider != nullptr)
+        hdr->provider->deallocate(hdr);
+    else
+        free(hdr);
 }
@@ -52,14 +52,92 @@ namespace dsn
     } tls_transient_memory_t;
 
     extern __thread tls_transient_memory_t tls_trans_memory;
-    extern void tls_trans_mem_init(size_t default_per_block_bytes);
+    extern void tls_trans_mem_init(size_t default_per_block_bytes, size_t long_per_block_bytes = 64 * 1024);
+
+    //
+    // blocks of the default size are recycled when their last references are dropped,
+    // first into a small cache of the releasing thread, then into a global free list,
+    // until the pooled blocks reach max_pooled_bytes
+    //
+    typedef struct tls_trans_mem_pool_options
+    {
+        size_t   max_pooled_bytes;  // 0 for no recycling
+        int      local_block_count; // max cached blocks per thread
+        bool     prefault;          // touch all pages of new blocks
+        bool     huge_page;         // advise transparent huge pages for new blocks (linux only)
+    } tls_trans_mem_pool_options;
+
+    typedef struct tls_trans_mem_pool_stats
+    {
+        uint64_t hits;         // blocks got from the pool
+        uint64_t misses;       // blocks newly allocated
+        uint64_t recycled;     // blocks returned to the pool
+        uint64_t dropped;      // blocks freed as the pool is full
+        uint64_t pooled_bytes; // bytes of the blocks in the pool
+    } tls_trans_mem_pool_stats;
+
+    extern void tls_trans_mem_pool_init(const tls_trans_mem_pool_options& opts);
+    extern void tls_trans_mem_pool_get_stats(/*out*/ tls_trans_mem_pool_stats& stats);
     extern void tls_trans_mem_alloc(size_t min_size);
 
     extern void tls_trans_mem_next(void** ptr, size_t* sz, size_t min_size);
     extern void tls_trans_mem_commit(size_t use_size);
 
     extern blob tls_trans_mem_alloc_blob(size_t sz);
+    extern blob tls_trans_mem_alloc_aligned_blob(size_t sz, size_t alignment); // alignment is a power of 2
 
     extern void* tls_trans_malloc(size_t sz);
+    extern void* tls_trans_malloc_long(size_t sz); // see dsn_transient_malloc_long
     extern void tls_trans_free(void* ptr);
+
+    //
+    // objects are allocated from per-thread blocks of their lanes, so that long-lived
+    // objects (e.g., rpc_response_task waiting for replies) never pin the large blocks
+    // of the short-lived ones (lane short is also used by message buffers);
+    // a block is retired when its thread switches to a new block, and is then pinned
+    // until all objects and blobs referencing it are released
+    //
+    enum trans_mem_lane
+    {
+        TRANS_MEM_LANE_SHORT = 0,
+        TRANS_MEM_LANE_LONG,
+        TRANS_MEM_LANE_COUNT
+    };
+
+    typedef struct tls_trans_mem_block_stats
+    {
+        uint64_t alive_blocks;      // blocks in use or pinned
+        uint64_t alive_bytes;
+        uint64_t pinned_blocks;     // retired blocks still referenced
+        uint64_t pinned_bytes;
+        uint64_t pinned_live_bytes; // bytes of the live objects in the pinned blocks, excluding blobs
+    } tls_trans_mem_block_stats;
+
+    extern void tls_trans_mem_get_block_stats(int lane, /*out*/ tls_trans_mem_block_stats& stats);
+
+    //
+    // observers are notified when the blocks of lane short (which hold message and
+    // batched write buffers) are allocated from and before they are returned to the
+    // heap, but not when they are recycled in the pool, e.g., for registering them to
+    // the kernel as fixed io buffers (see aio_provider::on_transient_block)
+    //
+    typedef void (*trans_mem_block_observer)(void* context, char* blk, size_t size, bool allocated);
+    extern void tls_trans_mem_add_block_observer(trans_mem_block_observer observer, void* context);
+    // the observer is not called any more once this returns
+    extern void tls_trans_mem_remove_block_observer(trans_mem_block_observer observer, void* context);
+
+    //
+    // route dsn_malloc/dsn_free to the tool memory provider (e.g., arena_memory_provider);
+    // memory allocated earlier by malloc is still freed correctly as each allocation
+    // records its provider
+    //
+    class memory_provider;
+    extern void dsn_malloc_init(memory_provider* provider);
+
+# ifdef DSN_COUNT_HEAP_ALLOCATIONS
+    // calls of dsn_transient_malloc(_long) and dsn_malloc, counted in measurement
+    // builds only (see perf_core.rpc_heap_allocations)
+    extern uint64_t trans_malloc_call_count();
+    extern uint64_t dsn_malloc_call_count();
+# endif
 }
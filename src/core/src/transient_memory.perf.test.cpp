@@ -0,0 +1,126 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     Benchmark of thread local transient memory with and without block recycling.
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# include "transient_memory.h"
+# include <gtest/gtest.h>
+# include <chrono>
+# include <iostream>
+# include <thread>
+# include <vector>
+# include <memory>
+# include <mutex>
+
+using namespace ::dsn;
+
+//
+// each thread repeatedly allocates a batch of blobs which spans several blocks,
+// and hands the batch to the next thread for releasing, as messages received by
+// io threads are released by worker threads
+//
+static void transient_memory_testcase(const tls_trans_mem_pool_options& opts, int thread_count)
+{
+    const int rounds = 200;
+    const int batch = 256;
+    const size_t blob_bytes = 16 * 1024;
+
+    tls_trans_mem_pool_init(opts);
+    tls_trans_mem_pool_stats s0, s1;
+    tls_trans_mem_pool_get_stats(s0);
+
+    std::vector<std::vector<blob>> handoff(thread_count);
+    std::vector<std::mutex> handoff_locks(thread_count);
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < thread_count; t++)
+    {
+        threads.emplace_back([&, t]()
+        {
+            for (int r = 0; r < rounds; r++)
+            {
+                std::vector<blob> blobs;
+                blobs.reserve(batch);
+                for (int i = 0; i < batch; i++)
+                {
+                    blobs.push_back(tls_trans_mem_alloc_blob(blob_bytes));
+                    blobs.back().buffer().get()[0] = (char)i;
+                }
+
+                // release the batch left by the previous thread
+                int idx = (t + r) % thread_count;
+                std::vector<blob> released;
+                {
+                    std::lock_guard<std::mutex> l(handoff_locks[idx]);
+                    released.swap(handoff[idx]);
+                    handoff[idx].swap(blobs);
+                }
+            }
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+    handoff.clear();
+
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    tls_trans_mem_pool_get_stats(s1);
+    uint64_t hits = s1.hits - s0.hits, misses = s1.misses - s0.misses;
+
+    std::cout << "thread_count = " << thread_count
+        << ", pool = " << (opts.max_pooled_bytes >> 20) << " MB"
+        << ", " << (double)thread_count * rounds * batch / (double)us << " M allocs/s"
+        << ", hit rate = " << (hits + misses == 0 ? 0.0 : (double)hits / (double)(hits + misses))
+        << ", dropped = " << s1.dropped - s0.dropped
+        << std::endl;
+}
+
+TEST(perf_core, transient_memory)
+{
+    tls_trans_mem_pool_options no_pool;
+    no_pool.max_pooled_bytes = 0;
+    no_pool.local_block_count = 0;
+    no_pool.prefault = false;
+    no_pool.huge_page = false;
+
+    tls_trans_mem_pool_options pool = no_pool;
+    pool.max_pooled_bytes = 64 * 1024 * 1024;
+    pool.local_block_count = 2;
+
+    for (int thread_count : { 1, 2, 4, 8 })
+    {
+        transient_memory_testcase(no_pool, thread_count);
+        transient_memory_testcase(pool, thread_count);
+    }
+
+    tls_trans_mem_pool_init(pool); // restore
+}
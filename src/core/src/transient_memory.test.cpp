@@ -35,6 +35,9 @@
 
 # include "transient_memory.h"
 # include <gtest/gtest.h>
+# include <thread>
+# include <vector>
+# include <memory>
 
 using namespace ::dsn;
 
@@ -107,3 +110,173 @@ TEST(core, transient_memory)
     tls_trans_mem_init(1024 * 1024); // restore
 }
 
+TEST(core, transient_memory_pool)
+{
+    tls_trans_mem_init(4096);
+    tls_trans_mem_pool_options opts;
+    opts.max_pooled_bytes = 2 * 4096;
+    opts.local_block_count = 1;
+    opts.prefault = true;
+    opts.huge_page = false;
+    tls_trans_mem_pool_init(opts);
+    tls_trans_mem_alloc(100); // drop the block of the previous size
+
+    tls_trans_mem_pool_stats s0, s1;
+
+    // recycled in the local cache of this thread
+    tls_trans_mem_pool_get_stats(s0);
+    char* blk = tls_trans_memory.block->get();
+    tls_trans_mem_alloc(100);
+    ASSERT_EQ((void*)blk, (void*)tls_trans_memory.block->get());
+    tls_trans_mem_pool_get_stats(s1);
+    ASSERT_EQ(s0.hits + 1, s1.hits);
+    ASSERT_EQ(s0.misses, s1.misses);
+    ASSERT_EQ(s0.recycled + 1, s1.recycled);
+
+    // a block referenced by a blob is recycled when the blob is released on another thread,
+    // and goes to the global list when the thread exits
+    std::unique_ptr<blob> b(new blob(tls_trans_mem_alloc_blob(100)));
+    tls_trans_mem_alloc(100);
+    tls_trans_mem_pool_get_stats(s0);
+    ASSERT_EQ(s1.misses + 1, s0.misses);
+
+    std::thread t([&b]() { b.reset(); });
+    t.join();
+    tls_trans_mem_pool_get_stats(s1);
+    ASSERT_EQ(s0.recycled + 1, s1.recycled);
+    ASSERT_EQ(s0.pooled_bytes + 4096, s1.pooled_bytes);
+
+    // the local cache is empty, so it is got from the global list
+    b.reset(new blob(tls_trans_mem_alloc_blob(100)));
+    tls_trans_mem_alloc(100);
+    ASSERT_EQ((void*)blk, (void*)tls_trans_memory.block->get());
+    tls_trans_mem_pool_get_stats(s0);
+    ASSERT_EQ(s1.hits + 1, s0.hits);
+    b.reset(); // to the local cache
+
+    // at most 2 blocks are pooled, the others are freed
+    std::vector<std::unique_ptr<blob>> blobs;
+    for (int i = 0; i < 3; i++)
+    {
+        blobs.emplace_back(new blob(tls_trans_mem_alloc_blob(100)));
+        tls_trans_mem_alloc(100);
+    }
+    tls_trans_mem_pool_get_stats(s0);
+    blobs.clear();
+    tls_trans_mem_pool_get_stats(s1);
+    ASSERT_EQ(0u, s0.pooled_bytes);
+    ASSERT_EQ(2u * 4096u, s1.pooled_bytes);
+    ASSERT_EQ(s0.dropped + 1, s1.dropped);
+
+    // restore
+    tls_trans_mem_init(1024 * 1024);
+    opts.max_pooled_bytes = 64 * 1024 * 1024;
+    opts.local_block_count = 2;
+    opts.prefault = false;
+    tls_trans_mem_pool_init(opts);
+}
+
+TEST(core, transient_memory_lanes)
+{
+    tls_trans_mem_init(4096, 1024);
+    tls_trans_mem_alloc(100); // drop the block of the previous size
+
+    tls_trans_mem_block_stats short0, short1, long0, long1;
+    tls_trans_mem_get_block_stats(TRANS_MEM_LANE_SHORT, short0);
+    tls_trans_mem_get_block_stats(TRANS_MEM_LANE_LONG, long0);
+
+    // long-lived objects are allocated from their own blocks
+    void* s = tls_trans_malloc(100);
+    void* l = tls_trans_malloc_long(100);
+    ASSERT_TRUE((char*)l < tls_trans_memory.block->get()
+        || (char*)l >= tls_trans_memory.block->get() + 4096);
+
+    // the short-lived block is pinned by the object after it is retired
+    const uint64_t obj_bytes = 100 + sizeof(std::shared_ptr<char>) + 2 * sizeof(uint32_t);
+    tls_trans_mem_alloc(100);
+    tls_trans_mem_get_block_stats(TRANS_MEM_LANE_SHORT, short1);
+    ASSERT_EQ(short0.pinned_blocks + 1, short1.pinned_blocks);
+    ASSERT_EQ(short0.pinned_bytes + 4096, short1.pinned_bytes);
+    ASSERT_EQ(short0.pinned_live_bytes + obj_bytes, short1.pinned_live_bytes);
+
+    // and released with it
+    tls_trans_free(s);
+    tls_trans_mem_get_block_stats(TRANS_MEM_LANE_SHORT, short1);
+    ASSERT_EQ(short0.pinned_blocks, short1.pinned_blocks);
+    ASSERT_EQ(short0.pinned_bytes, short1.pinned_bytes);
+    ASSERT_EQ(short0.pinned_live_bytes, short1.pinned_live_bytes);
+
+    // the long-lived object only keeps its small block alive
+    tls_trans_mem_get_block_stats(TRANS_MEM_LANE_LONG, long1);
+    ASSERT_GE(long1.alive_bytes, long0.alive_bytes);
+    ASSERT_LE(long1.alive_bytes, long0.alive_bytes + 1024);
+    tls_trans_free(l);
+
+    tls_trans_mem_init(1024 * 1024); // restore
+}
+
+static void on_test_block(void* context, char* blk, size_t size, bool allocated)
+{
+    if (allocated)
+        ++*(int*)context;
+}
+
+TEST(core, transient_memory_block_observers)
+{
+    // more observers than any fixed table would hold
+    std::vector<int> counts(40, 0);
+    const size_t block_bytes = 4 * 1024 * 1024; // larger than the pooled blocks, so always new
+    for (auto& c : counts)
+        tls_trans_mem_add_block_observer(&on_test_block, &c);
+
+    tls_trans_mem_alloc(block_bytes);
+    for (auto& c : counts)
+        ASSERT_EQ(1, c);
+
+    // removed observers are not notified any more
+    for (size_t i = 0; i < counts.size(); i += 2)
+        tls_trans_mem_remove_block_observer(&on_test_block, &counts[i]);
+
+    tls_trans_mem_alloc(block_bytes);
+    for (size_t i = 0; i < counts.size(); i++)
+        ASSERT_EQ(i % 2 == 0 ? 1 : 2, counts[i]);
+
+    for (size_t i = 1; i < counts.size(); i += 2)
+        tls_trans_mem_remove_block_observer(&on_test_block, &counts[i]);
+
+    tls_trans_mem_alloc(block_bytes);
+    for (size_t i = 0; i < counts.size(); i++)
+        ASSERT_EQ(i % 2 == 0 ? 1 : 2, counts[i]);
+
+    tls_trans_mem_alloc(100);
+}
+
+TEST(core, transient_memory_aligned)
+{
+    // aligned blobs from the transient blocks
+    for (size_t alignment : { (size_t)512, (size_t)4096 })
+    {
+        for (size_t sz : { (size_t)1, (size_t)100, (size_t)4096, (size_t)3 * 4096 })
+        {
+            tls_trans_mem_alloc_blob(7); // misalign the next allocation
+            auto bb = tls_trans_mem_alloc_aligned_blob(sz, alignment);
+            ASSERT_EQ(0u, (uintptr_t)bb.data() % alignment);
+            ASSERT_EQ(sz, (size_t)bb.length());
+            memset((void*)bb.data(), 1, sz);
+        }
+    }
+
+    // aligned heap memory
+    for (uint32_t alignment : { 1u, 16u, 512u, 4096u })
+    {
+        void* p = dsn_aligned_malloc(1000, alignment);
+        ASSERT_TRUE(p != nullptr);
+        ASSERT_EQ(0u, (uintptr_t)p % alignment);
+        memset(p, 1, 1000);
+        dsn_aligned_free(p);
+    }
+    dsn_aligned_free(nullptr);
+
+    auto buffer = make_aligned_shared_array(8192, 4096);
+    ASSERT_EQ(0u, (uintptr_t)buffer.get() % 4096);
+}
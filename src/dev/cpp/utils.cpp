@@ -35,6 +35,7 @@
 
 # include <dsn/cpp/utils.h>
 # include <dsn/cpp/blob.h>
+# include <dsn/cpp/request_arena.h>
 # include <dsn/cpp/address.h>
 # include <dsn/cpp/auto_codes.h>
 # include <dsn/utility/singleton.h>
@@ -326,12 +327,10 @@ namespace  dsn
         {
             blob = _blob.range(static_cast<int>(_ptr - _blob.data()), len);
 
-            // optimization: zero-copy
+            // optimization: zero-copy, or copied into the request arena when there is one
             if (!blob.buffer_ptr())
             {
-                std::shared_ptr<char> buffer(::dsn::make_shared_array<char>(len));
-                memcpy(buffer.get(), blob.data(), blob.length());
-                blob = ::dsn::blob(buffer, 0, blob.length());
+                blob = copy_to_request_blob(blob.data(), blob.length());
             }
             
             _ptr += len;
@@ -408,7 +407,6 @@ namespace  dsn
     binary_writer::binary_writer(int reserveBufferSize)
     {
         _total_size = 0;
-        _buffers.reserve(1);
         _reserved_size_per_buffer = (reserveBufferSize == 0) ? _reserved_size_per_buffer_static : reserveBufferSize;
         _current_buffer = nullptr;
         _current_offset = 0;
@@ -418,7 +416,6 @@ namespace  dsn
     binary_writer::binary_writer(blob& buffer)
     {
         _total_size = 0;
-        _buffers.reserve(1);
         _reserved_size_per_buffer = _reserved_size_per_buffer_static;
 
         _buffers.push_back(buffer);
@@ -464,6 +461,16 @@ namespace  dsn
         }
     }
     
+    void binary_writer::seal_buffer(int appended_size)
+    {
+        commit();
+
+        _current_buffer = nullptr;
+        _current_offset = 0;
+        _current_buffer_length = 0;
+        _total_size += appended_size;
+    }
+
     blob binary_writer::get_buffer()
     {
         commit();
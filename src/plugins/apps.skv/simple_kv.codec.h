@@ -0,0 +1,113 @@
+/**
+ * Autogenerated by compile_thrift.py
+ *
+ * DO NOT EDIT UNLESS YOU ARE SURE THAT YOU KNOW WHAT YOU ARE DOING
+ *  @generated
+ */
+# pragma once
+# include "simple_kv_types.h"
+# include <dsn/cpp/serialization_helper/thrift_binary_codec.h>
+
+namespace dsn {
+
+    template<>
+    struct thrift_binary_codec< ::dsn::replication::application::kv_pair>
+    {
+        static const bool enabled = true;
+
+        static void write(binary_writer& w, const ::dsn::replication::application::kv_pair& v)
+        {
+            thrift_binary::write_field(w, 1, v.key);
+            thrift_binary::write_field(w, 2, v.value);
+            thrift_binary::write_field_stop(w);
+        }
+
+        static void read(binary_reader& r, /*out*/ ::dsn::replication::application::kv_pair& v)
+        {
+            ::apache::thrift::protocol::TType type;
+            int16_t id;
+            while (thrift_binary::read_field_begin(r, type, id))
+            {
+                switch (id)
+                {
+                case 1:
+                    if (thrift_binary::read_field(r, type, v.key))
+                        v.__isset.key = true;
+                    break;
+                case 2:
+                    if (thrift_binary::read_field(r, type, v.value))
+                        v.__isset.value = true;
+                    break;
+                default:
+                    thrift_binary::skip(r, type);
+                    break;
+                }
+            }
+        }
+    };
+}
+
+namespace dsn { namespace replication { namespace application {
+
+    typedef struct _kv_pair_view__isset {
+        _kv_pair_view__isset() : key(false), value(false) {}
+        bool key;
+        bool value;
+    } _kv_pair_view__isset;
+
+    struct kv_pair_view
+    {
+        explicit kv_pair_view(::dsn::request_arena* /*arena*/ = ::dsn::request_arena::current())
+        {
+        }
+
+        ::dsn::string_view key_view() const { return ::dsn::string_view(key); }
+        ::dsn::string_view value_view() const { return ::dsn::string_view(value); }
+
+        ::dsn::blob key;
+        ::dsn::blob value;
+
+        _kv_pair_view__isset __isset;
+    };
+} } }
+
+namespace dsn {
+
+    template<>
+    struct thrift_binary_codec< ::dsn::replication::application::kv_pair_view>
+    {
+        static const bool enabled = true;
+
+        static void read(binary_reader& r, /*out*/ ::dsn::replication::application::kv_pair_view& v)
+        {
+            ::apache::thrift::protocol::TType type;
+            int16_t id;
+            while (thrift_binary::read_field_begin(r, type, id))
+            {
+                switch (id)
+                {
+                case 1:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_STRING, v.key))
+                        v.__isset.key = true;
+                    break;
+                case 2:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_STRING, v.value))
+                        v.__isset.value = true;
+                    break;
+                default:
+                    thrift_binary::skip(r, type);
+                    break;
+                }
+            }
+        }
+    };
+}
+
+namespace dsn { namespace replication { namespace application {
+
+    inline void unmarshall(::dsn::binary_reader& reader, kv_pair_view& value, dsn_msg_serialize_format fmt)
+    {
+        dassert(fmt == DSF_THRIFT_BINARY, "kv_pair_view can only be decoded from DSF_THRIFT_BINARY");
+        ::dsn::thrift_binary::unmarshall(reader, value);
+    }
+} } }
@@ -61,15 +61,15 @@ protected:
         std::string resp;
         reply(resp);
     }
-    // RPC_SIMPLE_KV_SIMPLE_KV_WRITE 
-    virtual void on_write(const kv_pair& pr, ::dsn::rpc_replier<int32_t>& reply)
+    // RPC_SIMPLE_KV_SIMPLE_KV_WRITE, decoded as a view, see kv_pair_view
+    virtual void on_write(const kv_pair_view& pr, ::dsn::rpc_replier<int32_t>& reply)
     {
         std::cout << "... exec RPC_SIMPLE_KV_SIMPLE_KV_WRITE ... (not implemented) " << std::endl;
         int32_t resp;
         reply(resp);
     }
-    // RPC_SIMPLE_KV_SIMPLE_KV_APPEND 
-    virtual void on_append(const kv_pair& pr, ::dsn::rpc_replier<int32_t>& reply)
+    // RPC_SIMPLE_KV_SIMPLE_KV_APPEND, decoded as a view, see kv_pair_view
+    virtual void on_append(const kv_pair_view& pr, ::dsn::rpc_replier<int32_t>& reply)
     {
         std::cout << "... exec RPC_SIMPLE_KV_SIMPLE_KV_APPEND ... (not implemented) " << std::endl;
         int32_t resp;
@@ -74,30 +74,31 @@ namespace dsn {
             }
 
             // RPC_SIMPLE_KV_WRITE
-            void simple_kv_service_impl::on_write(const kv_pair& pr, ::dsn::rpc_replier<int32_t>& reply)
+            // the key and value reference the request, which are copied into the store
+            void simple_kv_service_impl::on_write(const kv_pair_view& pr, ::dsn::rpc_replier<int32_t>& reply)
             {
+                ::dsn::string_view key = pr.key_view();
+                ::dsn::string_view value = pr.value_view();
                 {
                     zauto_lock l(_lock);
-                    _store[pr.key] = pr.value;
+                    _store[key.to_string()].assign(value.data(), value.size());
                 }                
 
-                dinfo("write %s", pr.key.c_str());
+                dinfo("write %.*s", static_cast<int>(key.size()), key.data());
                 reply(0);
             }
 
             // RPC_SIMPLE_KV_APPEND
-            void simple_kv_service_impl::on_append(const kv_pair& pr, ::dsn::rpc_replier<int32_t>& reply)
+            void simple_kv_service_impl::on_append(const kv_pair_view& pr, ::dsn::rpc_replier<int32_t>& reply)
             {
+                ::dsn::string_view key = pr.key_view();
+                ::dsn::string_view value = pr.value_view();
                 {
                     zauto_lock l(_lock);
-                    auto it = _store.find(pr.key);
-                    if (it != _store.end())
-                        it->second.append(pr.value);
-                    else
-                        _store[pr.key] = pr.value;
+                    _store[key.to_string()].append(value.data(), value.size());
                 }
 
-                dinfo("append %s", pr.key.c_str());
+                dinfo("append %.*s", static_cast<int>(key.size()), key.data());
                 reply(0);
             }
             
@@ -4,6 +4,7 @@
 
 
 #include "simple_kv_types.h"
+#include "simple_kv.codec.h"
 
 
 namespace dsn { namespace replication { namespace application { 
@@ -0,0 +1,183 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     Load test for the admission controllers under 2x overload.
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+#include "gradient_admission_controller.h"
+#include "codel_admission_controller.h"
+#include <gtest/gtest.h>
+#include <deque>
+#include <functional>
+#include <iostream>
+
+using namespace dsn;
+using namespace dsn::tools;
+
+//
+// a single worker serves 1000 requests/s (1 ms each), while the clients send 2000
+// requests/s with a 500 ms timeout for 10 seconds; goodput is the count of the requests
+// completed within their timeouts per second, simulated with virtual time
+//
+struct overload_scenario
+{
+    const uint64_t service_ns = 1000000;
+    const uint64_t arrival_interval_ns = 500000;
+    const uint64_t timeout_ns = 500000000;
+    const uint64_t duration_ns = 10000000000ULL;
+
+    std::function<bool(int queue_length)>              accept;
+    std::function<void(uint64_t sojourn, uint64_t now)> on_begin;
+    std::function<void(uint64_t latency, uint64_t now)> on_end;
+
+    uint64_t accepted = 0;
+    uint64_t rejected = 0;
+    uint64_t good = 0;
+
+    double run()
+    {
+        std::deque<uint64_t> queue; // arrival time of the queued requests
+        bool busy = false;
+        uint64_t running_arrival = 0, running_end = 0, worker_free = 0;
+
+        auto advance = [&](uint64_t now)
+        {
+            while (true)
+            {
+                if (busy && running_end <= now)
+                {
+                    busy = false;
+                    worker_free = running_end;
+                    if (running_end - running_arrival <= timeout_ns)
+                        good++;
+                    if (on_end)
+                        on_end(running_end - running_arrival, running_end);
+                }
+                else if (!busy && !queue.empty())
+                {
+                    running_arrival = queue.front();
+                    queue.pop_front();
+                    uint64_t start = std::max(worker_free, running_arrival);
+                    if (on_begin)
+                        on_begin(start - running_arrival, start);
+                    running_end = start + service_ns;
+                    busy = true;
+                }
+                else
+                    break;
+            }
+        };
+
+        for (uint64_t now = arrival_interval_ns; now <= duration_ns; now += arrival_interval_ns)
+        {
+            advance(now);
+            if (!accept || accept(static_cast<int>(queue.size())))
+            {
+                accepted++;
+                queue.push_back(now);
+            }
+            else
+                rejected++;
+        }
+
+        double capacity = 1e9 / service_ns;
+        double goodput = good * 1e9 / duration_ns;
+        std::cout << "accepted = " << accepted
+            << ", rejected = " << rejected
+            << ", goodput = " << goodput << "/s (" << goodput * 100 / capacity << "% of capacity)"
+            << std::endl;
+        return goodput / capacity;
+    }
+};
+
+TEST(tools_common, admission_controller_overload)
+{
+    // no admission control: the queue keeps growing and almost all requests time out
+    {
+        overload_scenario s;
+        std::cout << "no admission controller: ";
+        ASSERT_LT(s.run(), 0.2);
+    }
+
+    // gradient: the concurrency limit converges to keep the latency near the baseline
+    {
+        std::vector<std::string> args;
+        gradient_admission_controller c(nullptr, args);
+        overload_scenario s;
+        s.accept = [&](int) { return c.try_acquire(); };
+        s.on_end = [&](uint64_t latency, uint64_t now) { c.release(latency, now); };
+        std::cout << "gradient_admission_controller: ";
+        ASSERT_GT(s.run(), 0.9);
+        ASSERT_GE(c.limit(), 4);
+        ASSERT_LT(c.limit(), 20);
+        ASSERT_EQ(1000000u, c.baseline_ns());
+    }
+
+    // codel: the queueing delay is bounded by about (target + interval), which must be
+    // below the client timeout
+    {
+        std::vector<std::string> args;
+        codel_admission_controller c(nullptr, args);
+        overload_scenario s;
+        s.accept = [&](int queue_length) { return c.accept(queue_length); };
+        s.on_begin = [&](uint64_t sojourn, uint64_t now) { c.on_dequeue(sojourn, now); };
+        std::cout << "codel_admission_controller: ";
+        ASSERT_GT(s.run(), 0.9);
+        ASSERT_GT(s.rejected, 0u);
+    }
+}
+
+TEST(tools_common, codel_admission_controller_burst)
+{
+    // a burst shorter than interval is absorbed without entering overloaded state
+    std::vector<std::string> args;
+    args.push_back("5");
+    args.push_back("100");
+    codel_admission_controller c(nullptr, args);
+
+    uint64_t ms = 1000000;
+    c.on_dequeue(10 * ms, 1000 * ms);
+    c.on_dequeue(10 * ms, 1050 * ms);
+    ASSERT_FALSE(c.overloaded());
+    c.on_dequeue(1 * ms, 1060 * ms);
+    c.on_dequeue(10 * ms, 1090 * ms);
+    ASSERT_FALSE(c.overloaded());
+
+    // standing queue for a whole interval
+    c.on_dequeue(10 * ms, 1200 * ms);
+    ASSERT_TRUE(c.overloaded());
+    ASSERT_FALSE(c.accept(10));
+
+    // leave when the queue drains
+    ASSERT_TRUE(c.accept(0));
+    ASSERT_FALSE(c.overloaded());
+}
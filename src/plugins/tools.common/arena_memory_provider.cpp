@@ -0,0 +1,531 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     memory provider with thread local arenas and size classes
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# include "arena_memory_provider.h"
+# include <dsn/tool-api/command.h>
+# include <atomic>
+# include <cstring>
+# include <mutex>
+# include <new>
+
+# ifdef __TITLE__
+# undef __TITLE__
+# endif
+# define __TITLE__ "memory.arena"
+
+namespace dsn {
+    namespace tools {
+
+        static const size_t   SPAN_SIZE = 64 * 1024;
+        static const size_t   SPAN_HEADER_SIZE = 64;
+        static const size_t   SEGMENT_SIZE = 32 * SPAN_SIZE;
+        static const size_t   MAX_SMALL_SIZE = 16 * 1024;
+        static const int      SIZE_CLASS_COUNT = 36;
+        static const uint32_t SPAN_MAGIC = 0xdeadf00d;
+        static const uint64_t LARGE_MAGIC = 0xdeadf00ddeadbeefULL;
+
+        struct arena;
+
+        struct free_object
+        {
+            free_object* next;
+        };
+
+        // at the beginning of each span, found by masking a pointer with the span alignment
+        struct span_header
+        {
+            uint32_t magic;
+            int32_t  size_class;
+            arena*   owner;
+        };
+
+        // right before each large allocation, which is from the system allocator
+        struct large_header
+        {
+            size_t   size;
+            uint64_t magic;
+        };
+
+        struct arena_class
+        {
+            // accessed by the owner thread only (the stats are also read by get_stats)
+            struct alignas(64)
+            {
+                free_object*          local;
+                char*                 bump;     // uncarved memory of the current span
+                char*                 bump_end;
+                std::atomic<uint64_t> allocations;
+                std::atomic<uint64_t> local_frees;
+                std::atomic<uint64_t> spans;
+            } own;
+
+            // accessed by other threads
+            struct alignas(64)
+            {
+                std::atomic<free_object*> head;
+                std::atomic<uint64_t>     frees;
+            } remote;
+        };
+
+        struct arena
+        {
+            arena_class classes[SIZE_CLASS_COUNT];
+            arena*      next_all;
+            arena*      next_orphan;
+        };
+
+        struct arena_globals
+        {
+            std::mutex lock;
+            arena*     all = nullptr;
+            arena*     orphans = nullptr;
+            char*      segment_cursor = nullptr;
+            char*      segment_end = nullptr;
+        };
+
+        static std::atomic<uint64_t> s_large_allocations(0);
+        static std::atomic<uint64_t> s_large_frees(0);
+
+        // never released as memory may be freed during process exit
+        static arena_globals* globals()
+        {
+            static arena_globals* g = new arena_globals();
+            return g;
+        }
+
+        static void* aligned_allocate(size_t sz, size_t alignment = SPAN_SIZE)
+        {
+            void* p;
+# ifdef _WIN32
+            p = _aligned_malloc(sz, alignment);
+# else
+            if (posix_memalign(&p, alignment, sz) != 0)
+                p = nullptr;
+# endif
+            dassert(p != nullptr, "cannot allocate %" PRIu64 " bytes", (uint64_t)sz);
+            return p;
+        }
+
+        //
+        // the segments (SEGMENT_SIZE aligned) are marked in a two level bitmap indexed by
+        // address / SEGMENT_SIZE, so that the small objects are told from the large ones
+        // without touching the memory around them
+        //
+        static const int SEGMENT_SHIFT = 21;
+        static const int SEGMENT_MAP_LEAF_BITS = 14;
+        static const int SEGMENT_MAP_ROOT_BITS = 48 - SEGMENT_SHIFT - SEGMENT_MAP_LEAF_BITS;
+        static_assert(SEGMENT_SIZE == ((size_t)1 << SEGMENT_SHIFT), "invalid SEGMENT_SHIFT");
+
+        struct segment_map_leaf
+        {
+            std::atomic<uint64_t> bits[((size_t)1 << SEGMENT_MAP_LEAF_BITS) / 64];
+        };
+        static std::atomic<segment_map_leaf*> s_segment_map[(size_t)1 << SEGMENT_MAP_ROOT_BITS];
+
+        // called with the globals lock held
+        static void mark_segment(char* segment)
+        {
+            uintptr_t key = (uintptr_t)segment >> SEGMENT_SHIFT;
+            dassert((key >> (SEGMENT_MAP_ROOT_BITS + SEGMENT_MAP_LEAF_BITS)) == 0,
+                "segment %p is out of the 48-bit address space", segment);
+
+            auto& root = s_segment_map[key >> SEGMENT_MAP_LEAF_BITS];
+            segment_map_leaf* leaf = root.load(std::memory_order_relaxed);
+            if (leaf == nullptr)
+            {
+                leaf = new segment_map_leaf();
+                for (auto& bits : leaf->bits)
+                    bits.store(0, std::memory_order_relaxed);
+                root.store(leaf, std::memory_order_release);
+            }
+
+            key &= ((uintptr_t)1 << SEGMENT_MAP_LEAF_BITS) - 1;
+            leaf->bits[key / 64].fetch_or((uint64_t)1 << (key % 64), std::memory_order_relaxed);
+        }
+
+        static inline bool in_segment(void* ptr)
+        {
+            uintptr_t key = (uintptr_t)ptr >> SEGMENT_SHIFT;
+            if ((key >> (SEGMENT_MAP_ROOT_BITS + SEGMENT_MAP_LEAF_BITS)) != 0)
+                return false;
+
+            segment_map_leaf* leaf = s_segment_map[key >> SEGMENT_MAP_LEAF_BITS].load(std::memory_order_acquire);
+            if (leaf == nullptr)
+                return false;
+
+            key &= ((uintptr_t)1 << SEGMENT_MAP_LEAF_BITS) - 1;
+            return (leaf->bits[key / 64].load(std::memory_order_relaxed) & ((uint64_t)1 << (key % 64))) != 0;
+        }
+
+        static char* new_span()
+        {
+            auto g = globals();
+            std::lock_guard<std::mutex> l(g->lock);
+            if (g->segment_cursor == g->segment_end)
+            {
+                g->segment_cursor = (char*)aligned_allocate(SEGMENT_SIZE, SEGMENT_SIZE);
+                g->segment_end = g->segment_cursor + SEGMENT_SIZE;
+                mark_segment(g->segment_cursor);
+            }
+
+            char* span = g->segment_cursor;
+            g->segment_cursor += SPAN_SIZE;
+            return span;
+        }
+
+        static inline span_header* span_of(void* ptr)
+        {
+            auto hdr = (span_header*)((uintptr_t)ptr & ~(uintptr_t)(SPAN_SIZE - 1));
+            dassert(hdr->magic == SPAN_MAGIC, "memory %p is not allocated by arena_memory_provider", ptr);
+            return hdr;
+        }
+
+        static inline large_header* large_of(void* ptr)
+        {
+            auto hdr = (large_header*)ptr - 1;
+            dassert(hdr->magic == LARGE_MAGIC, "memory %p is not allocated by arena_memory_provider", ptr);
+            return hdr;
+        }
+
+        //
+        // thread local arenas
+        //
+        static __thread arena* tls_arena;
+        static __thread bool   tls_arena_exited;
+
+        static void release_arena(arena* a)
+        {
+            auto g = globals();
+            std::lock_guard<std::mutex> l(g->lock);
+            a->next_orphan = g->orphans;
+            g->orphans = a;
+        }
+
+        struct tls_arena_releaser
+        {
+            bool touched;
+
+            ~tls_arena_releaser()
+            {
+                if (tls_arena != nullptr)
+                {
+                    release_arena(tls_arena);
+                    tls_arena = nullptr;
+                }
+                tls_arena_exited = true;
+            }
+        };
+
+        static thread_local tls_arena_releaser tls_arena_releaser_obj;
+
+        static arena* acquire_arena()
+        {
+            auto g = globals();
+            arena* a;
+            {
+                std::lock_guard<std::mutex> l(g->lock);
+                if (g->orphans != nullptr)
+                {
+                    a = g->orphans;
+                    g->orphans = a->next_orphan;
+                }
+                else
+                {
+                    // operator new does not honor the cache line alignment of
+                    // arena_class before C++17; arenas are reused but never freed
+                    a = new (aligned_allocate(sizeof(arena), alignof(arena))) arena();
+                    a->next_all = g->all;
+                    g->all = a;
+                }
+            }
+
+            // the arena is released at thread exit, or right after use when the
+            // thread local objects of this thread are already destroyed
+            if (!tls_arena_exited)
+                tls_arena_releaser_obj.touched = true;
+            tls_arena = a;
+            return a;
+        }
+
+        static inline void increase(std::atomic<uint64_t>& counter)
+        {
+            // single writer
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        static free_object* refill(arena* a, int cls)
+        {
+            auto& own = a->classes[cls].own;
+
+            // take back all objects freed by other threads
+            free_object* o = a->classes[cls].remote.head.exchange(nullptr, std::memory_order_acquire);
+            if (o != nullptr)
+            {
+                own.local = o->next;
+                return o;
+            }
+
+            size_t sz = arena_memory_provider::class_to_size(cls);
+            if (own.bump == nullptr || (size_t)(own.bump_end - own.bump) < sz)
+            {
+                char* span = new_span();
+                auto hdr = (span_header*)span;
+                hdr->magic = SPAN_MAGIC;
+                hdr->size_class = cls;
+                hdr->owner = a;
+
+                own.bump = span + SPAN_HEADER_SIZE;
+                own.bump_end = span + SPAN_SIZE;
+                increase(own.spans);
+            }
+
+            o = (free_object*)own.bump;
+            own.bump += sz;
+            return o;
+        }
+
+        static inline int log2_floor(size_t v)
+        {
+# ifdef _MSC_VER
+            int lg = 0;
+            while (v >>= 1)
+                lg++;
+            return lg;
+# else
+            return 63 - __builtin_clzll((unsigned long long)v);
+# endif
+        }
+
+        /*static*/ int arena_memory_provider::size_to_class(size_t sz)
+        {
+            if (sz <= 128)
+                return sz == 0 ? 0 : (int)((sz + 15) / 16) - 1;
+            if (sz > MAX_SMALL_SIZE)
+                return -1;
+
+            // sz in (2^lg, 2^(lg+1)], which is split into 4 classes
+            int lg = log2_floor(sz - 1);
+            int step = (int)((sz - 1 - ((size_t)1 << lg)) >> (lg - 2));
+            return 8 + (lg - 7) * 4 + step;
+        }
+
+        /*static*/ size_t arena_memory_provider::class_to_size(int cls)
+        {
+            if (cls < 8)
+                return (size_t)(cls + 1) * 16;
+
+            int lg = 7 + (cls - 8) / 4;
+            int step = (cls - 8) % 4;
+            return ((size_t)1 << lg) + (size_t)(step + 1) * ((size_t)1 << (lg - 2));
+        }
+
+        static safe_string mem_stats_command(const safe_vector<safe_string>& args)
+        {
+            std::vector<arena_memory_provider::size_class_stats> stats;
+            arena_memory_provider::get_stats(stats);
+
+            safe_sstream ss;
+            uint64_t total_span_bytes = 0;
+            for (auto& st : stats)
+            {
+                if (st.allocations == 0)
+                    continue;
+
+                uint64_t frees = st.local_frees + st.remote_frees;
+                if (st.object_size != 0)
+                    ss << "size " << st.object_size << ": ";
+                else
+                    ss << "large: ";
+                ss << "allocations = " << st.allocations
+                    << ", local frees = " << st.local_frees
+                    << ", remote frees = " << st.remote_frees
+                    << ", live = " << (st.allocations > frees ? st.allocations - frees : 0);
+                if (st.object_size != 0)
+                {
+                    ss << ", spans = " << st.spans;
+                    total_span_bytes += st.spans * SPAN_SIZE;
+                }
+                ss << std::endl;
+            }
+            ss << "total span bytes = " << total_span_bytes << std::endl;
+            return ss.str();
+        }
+
+        arena_memory_provider::arena_memory_provider()
+        {
+            static std::once_flag flag;
+            std::call_once(flag, []()
+            {
+                ::dsn::register_command("mem.stats",
+                    "mem.stats - query per size class stats of arena_memory_provider",
+                    "mem.stats",
+                    mem_stats_command
+                    );
+            });
+        }
+
+        void* arena_memory_provider::allocate(size_t sz)
+        {
+            int cls = size_to_class(sz);
+            if (cls < 0)
+            {
+                auto hdr = (large_header*)::malloc(sizeof(large_header) + sz);
+                dassert(hdr != nullptr, "cannot allocate %" PRIu64 " bytes", (uint64_t)sz);
+                hdr->size = sz;
+                hdr->magic = LARGE_MAGIC;
+                s_large_allocations.fetch_add(1, std::memory_order_relaxed);
+                return hdr + 1;
+            }
+
+            arena* a = tls_arena;
+            if (a == nullptr)
+                a = acquire_arena();
+
+            auto& own = a->classes[cls].own;
+            free_object* o = own.local;
+            if (o != nullptr)
+                own.local = o->next;
+            else
+                o = refill(a, cls);
+            increase(own.allocations);
+
+            if (tls_arena_exited)
+            {
+                release_arena(a);
+                tls_arena = nullptr;
+            }
+            return o;
+        }
+
+        void* arena_memory_provider::reallocate(void* ptr, size_t sz)
+        {
+            if (ptr == nullptr)
+                return allocate(sz);
+
+            size_t old_size;
+            if (in_segment(ptr))
+            {
+                auto hdr = span_of(ptr);
+                old_size = class_to_size(hdr->size_class);
+                if (sz <= old_size && size_to_class(sz) == hdr->size_class)
+                    return ptr;
+            }
+            else
+            {
+                old_size = large_of(ptr)->size;
+                if (size_to_class(sz) < 0)
+                {
+                    s_large_allocations.fetch_add(1, std::memory_order_relaxed);
+                    s_large_frees.fetch_add(1, std::memory_order_relaxed);
+
+                    auto hdr = (large_header*)::realloc(large_of(ptr), sizeof(large_header) + sz);
+                    dassert(hdr != nullptr, "cannot allocate %" PRIu64 " bytes", (uint64_t)sz);
+                    hdr->size = sz;
+                    return hdr + 1;
+                }
+            }
+
+            void* p = allocate(sz);
+            memcpy(p, ptr, sz < old_size ? sz : old_size);
+            deallocate(ptr);
+            return p;
+        }
+
+        void arena_memory_provider::deallocate(void* ptr)
+        {
+            if (ptr == nullptr)
+                return;
+
+            if (!in_segment(ptr))
+            {
+                s_large_frees.fetch_add(1, std::memory_order_relaxed);
+                ::free(large_of(ptr));
+                return;
+            }
+
+            auto hdr = span_of(ptr);
+            auto o = (free_object*)ptr;
+            auto& ac = hdr->owner->classes[hdr->size_class];
+            if (hdr->owner == tls_arena)
+            {
+                o->next = ac.own.local;
+                ac.own.local = o;
+                increase(ac.own.local_frees);
+            }
+            else
+            {
+                auto head = ac.remote.head.load(std::memory_order_relaxed);
+                do
+                {
+                    o->next = head;
+                } while (!ac.remote.head.compare_exchange_weak(head, o,
+                    std::memory_order_release, std::memory_order_relaxed));
+                ac.remote.frees.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        /*static*/ void arena_memory_provider::get_stats(/*out*/ std::vector<size_class_stats>& stats)
+        {
+            stats.clear();
+            stats.resize(SIZE_CLASS_COUNT + 1);
+            for (int i = 0; i < SIZE_CLASS_COUNT; i++)
+            {
+                memset(&stats[i], 0, sizeof(size_class_stats));
+                stats[i].object_size = class_to_size(i);
+            }
+
+            auto g = globals();
+            {
+                std::lock_guard<std::mutex> l(g->lock);
+                for (arena* a = g->all; a != nullptr; a = a->next_all)
+                {
+                    for (int i = 0; i < SIZE_CLASS_COUNT; i++)
+                    {
+                        auto& ac = a->classes[i];
+                        stats[i].allocations += ac.own.allocations.load(std::memory_order_relaxed);
+                        stats[i].local_frees += ac.own.local_frees.load(std::memory_order_relaxed);
+                        stats[i].remote_frees += ac.remote.frees.load(std::memory_order_relaxed);
+                        stats[i].spans += ac.own.spans.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            auto& large = stats[SIZE_CLASS_COUNT];
+            memset(&large, 0, sizeof(size_class_stats));
+            large.allocations = s_large_allocations.load(std::memory_order_relaxed);
+            large.local_frees = s_large_frees.load(std::memory_order_relaxed);
+        }
+    }
+}
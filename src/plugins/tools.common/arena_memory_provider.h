@@ -0,0 +1,84 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     memory provider with thread local arenas and size classes
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+#pragma once
+
+# include <dsn/tool_api.h>
+# include <vector>
+
+namespace dsn {
+    namespace tools {
+
+        //
+        // arena_memory_provider serves small allocations from thread local arenas without
+        // locking, to avoid allocator contention on many-core nodes:
+        // - sizes up to 16 KB are rounded up to one of the size classes (16 bytes apart up
+        //   to 128 bytes, then 4 classes per power of two), and each arena keeps a free
+        //   list and a span (64 KB aligned memory with a header) per size class
+        // - memory freed by another thread is pushed to the remote free list of the owner
+        //   arena (lock-free), which the owner takes back when its local free list is empty
+        // - the arena of an exited thread is adopted by the next new thread
+        // - larger allocations go to the system allocator (malloc) with a 16 byte header, and
+        //   are told from the small ones by a bitmap of the span segments
+        //
+        // spans are never returned to the system or moved between size classes.
+        //
+        class arena_memory_provider : public memory_provider
+        {
+        public:
+            struct size_class_stats
+            {
+                uint64_t object_size;   // 0 for allocations larger than the size classes
+                uint64_t allocations;
+                uint64_t local_frees;   // freed by the owner thread
+                uint64_t remote_frees;  // freed by other threads
+                uint64_t spans;
+            };
+
+            arena_memory_provider();
+
+            virtual void* allocate(size_t sz) override;
+            virtual void* reallocate(void* ptr, size_t sz) override;
+            virtual void  deallocate(void* ptr) override;
+
+            // stats of all arenas, one entry per size class and the last one for large allocations
+            static void get_stats(/*out*/ std::vector<size_class_stats>& stats);
+
+            // size class of an allocation, or -1 when it is large
+            static int size_to_class(size_t sz);
+            static size_t class_to_size(int cls);
+        };
+    }
+}
@@ -0,0 +1,137 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     Unit-test for arena_memory_provider.
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+#include "arena_memory_provider.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace dsn;
+using namespace dsn::tools;
+
+TEST(tools_common, arena_memory_size_class)
+{
+    EXPECT_EQ(0, arena_memory_provider::size_to_class(1));
+    EXPECT_EQ(0, arena_memory_provider::size_to_class(16));
+    EXPECT_EQ(1, arena_memory_provider::size_to_class(17));
+    EXPECT_EQ(7, arena_memory_provider::size_to_class(128));
+    EXPECT_EQ(-1, arena_memory_provider::size_to_class(16 * 1024 + 1));
+
+    // every size fits in its class, and classes are ascending with <= 25% waste above 128 bytes
+    for (size_t sz = 1; sz <= 16 * 1024; sz++)
+    {
+        int cls = arena_memory_provider::size_to_class(sz);
+        size_t csz = arena_memory_provider::class_to_size(cls);
+        ASSERT_LE(sz, csz);
+        ASSERT_EQ(0u, csz % 16);
+        if (cls > 0)
+        {
+            ASSERT_LT(arena_memory_provider::class_to_size(cls - 1), sz);
+        }
+        if (sz > 128)
+        {
+            ASSERT_LE(csz, sz + sz / 4 + 16);
+        }
+    }
+    EXPECT_EQ(16u * 1024, arena_memory_provider::class_to_size(arena_memory_provider::size_to_class(16 * 1024)));
+}
+
+TEST(tools_common, arena_memory_provider)
+{
+    arena_memory_provider provider;
+
+    std::vector<arena_memory_provider::size_class_stats> st0;
+    arena_memory_provider::get_stats(st0);
+    int cls = arena_memory_provider::size_to_class(100);
+    auto large = st0.size() - 1;
+
+    // local allocations and frees reuse the same memory
+    char* p1 = (char*)provider.allocate(100);
+    memset(p1, 1, 100);
+    provider.deallocate(p1);
+    char* p2 = (char*)provider.allocate(100);
+    EXPECT_EQ(p1, p2);
+
+    // reallocate within the same class keeps the memory
+    EXPECT_EQ(p2, provider.reallocate(p2, 110));
+    memset(p2, 2, 110);
+    char* p3 = (char*)provider.reallocate(p2, 1000);
+    EXPECT_NE(p2, p3);
+    EXPECT_EQ(2, p3[109]);
+    provider.deallocate(p3);
+
+    // large allocations, which are resized in place or moved between small and large
+    char* big = (char*)provider.allocate(100 * 1024);
+    memset(big, 3, 100 * 1024);
+    big = (char*)provider.reallocate(big, 200 * 1024);
+    EXPECT_EQ(3, big[100 * 1024 - 1]);
+    char* small = (char*)provider.reallocate(big, 50);
+    EXPECT_EQ(3, small[49]);
+    big = (char*)provider.reallocate(small, 20 * 1024);
+    EXPECT_EQ(3, big[49]);
+    provider.deallocate(big);
+
+    // objects freed by another thread return to the owner arena
+    std::vector<void*> objs;
+    for (int i = 0; i < 100; i++)
+        objs.push_back(provider.allocate(100));
+
+    std::thread t([&]()
+    {
+        for (auto p : objs)
+            provider.deallocate(p);
+    });
+    t.join();
+
+    std::vector<void*> objs2;
+    for (int i = 0; i < 100; i++)
+        objs2.push_back(provider.allocate(100));
+    std::sort(objs.begin(), objs.end());
+    std::sort(objs2.begin(), objs2.end());
+    EXPECT_EQ(objs, objs2);
+
+    for (auto p : objs2)
+        provider.deallocate(p);
+
+    std::vector<arena_memory_provider::size_class_stats> st1;
+    arena_memory_provider::get_stats(st1);
+    EXPECT_EQ(st0[cls].allocations + 202, st1[cls].allocations);
+    EXPECT_EQ(st0[cls].local_frees + 102, st1[cls].local_frees);
+    EXPECT_EQ(st0[cls].remote_frees + 100, st1[cls].remote_frees);
+    EXPECT_EQ(st0[large].allocations + 3, st1[large].allocations);
+    EXPECT_EQ(st0[large].local_frees + 3, st1[large].local_frees);
+}
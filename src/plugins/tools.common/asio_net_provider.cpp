@@ -57,9 +57,11 @@ namespace dsn {
 
             int io_service_worker_count = (int)dsn_config_get_value_uint64("network", "io_service_worker_count", 1,
                 "thread number for io service (timer and boost network)");
+            std::string affinity_cpus = dsn_config_get_value_string("network", "io_service_worker_affinity_cpus", "",
+                "what CPU cores the io service threads are pinned to, as a cpuset list (e.g., 0-3,64-67) or numa nodes (e.g., node:0), empty for not pinned");
             for (int i = 0; i < io_service_worker_count; i++)
             {
-                _workers.push_back(std::shared_ptr<std::thread>(new std::thread([this, ctx, i]()
+                _workers.push_back(std::shared_ptr<std::thread>(new std::thread([this, ctx, i, affinity_cpus]()
                 {
                     task::set_tls_dsn_context(node(), nullptr, ctx.queue);
 
@@ -67,6 +69,7 @@ namespace dsn {
                     char buffer[128];
                     sprintf(buffer, "%s.asio.%d", name, i);
                     task_worker::set_name(buffer);
+                    task_worker::pin_current_thread(affinity_cpus.c_str(), true);
 
                     boost::asio::io_service::work work(_io_service);
                     _io_service.run();
@@ -274,6 +277,8 @@ namespace dsn {
             _is_client = client_only;
             int io_service_worker_count = (int)dsn_config_get_value_uint64("network", "io_service_worker_count", 1,
                                                                    "thread number for io service (timer and boost network)");
+            std::string affinity_cpus = dsn_config_get_value_string("network", "io_service_worker_affinity_cpus", "",
+                "what CPU cores the io service threads are pinned to, as a cpuset list (e.g., 0-3,64-67) or numa nodes (e.g., node:0), empty for not pinned");
            
             dassert(channel == RPC_CHANNEL_UDP, "invalid given channel %s", channel.to_string());
 
@@ -314,7 +319,7 @@ namespace dsn {
 
             for (int i = 0; i < io_service_worker_count; i++)
             {
-                _workers.push_back(std::shared_ptr<std::thread>(new std::thread([this, ctx, i]()
+                _workers.push_back(std::shared_ptr<std::thread>(new std::thread([this, ctx, i, affinity_cpus]()
                 {
                     task::set_tls_dsn_context(node(), nullptr, ctx.queue);
 
@@ -322,6 +327,7 @@ namespace dsn {
                     char buffer[128];
                     sprintf(buffer, "%s.asio.udp.%d.%d", name, (int)(this->address().port()), i);
                     task_worker::set_name(buffer);
+                    task_worker::pin_current_thread(affinity_cpus.c_str(), true);
 
                     boost::asio::io_service::work work(_io_service);
                     _io_service.run();
@@ -0,0 +1,142 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     CoDel-style admission controller based on queueing sojourn time
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# include "codel_admission_controller.h"
+
+# ifdef __TITLE__
+# undef __TITLE__
+# endif
+# define __TITLE__ "admission.codel"
+
+namespace dsn
+{
+    namespace tools
+    {
+        codel_admission_controller::codel_admission_controller(task_queue* q, std::vector<std::string>& sargs)
+            : admission_controller(q, sargs), _first_above_ns(0), _overloaded(false)
+        {
+            int target_ms = sargs.size() > 0 ? atoi(sargs[0].c_str()) : 5;
+            int interval_ms = sargs.size() > 1 ? atoi(sargs[1].c_str()) : 100;
+            dassert(target_ms > 0 && interval_ms > 0,
+                "invalid arguments for codel_admission_controller: target_ms(%d) interval_ms(%d)",
+                target_ms, interval_ms
+                );
+
+            _target_ns = target_ms * 1000000ULL;
+            _interval_ns = interval_ms * 1000000ULL;
+
+            if (q != nullptr)
+            {
+                _sojourn_counter = perf_counter::get_counter(get_service_node_name(q->node()), "engine",
+                    (q->get_name() + ".admission.sojourn(ns)").c_str(), COUNTER_TYPE_NUMBER_PERCENTILES,
+                    "sojourn time of rpc requests in the queue", true);
+                _rejected_counter = perf_counter::get_counter(get_service_node_name(q->node()), "engine",
+                    (q->get_name() + ".admission.rejected").c_str(), COUNTER_TYPE_RATE,
+                    "rpc requests rejected by the admission controller", true);
+            }
+        }
+
+        codel_admission_controller::~codel_admission_controller()
+        {
+            if (_sojourn_counter != nullptr)
+            {
+                perf_counter::remove_counter(_sojourn_counter->full_name());
+                perf_counter::remove_counter(_rejected_counter->full_name());
+            }
+        }
+
+        bool codel_admission_controller::is_task_accepted(task* task)
+        {
+            if (accept(bound_queue()->count()))
+                return true;
+
+            if (_rejected_counter != nullptr)
+                _rejected_counter->increment();
+            return false;
+        }
+
+        void codel_admission_controller::on_task_begin(task* task)
+        {
+            if (task->spec().type != TASK_TYPE_RPC_REQUEST)
+                return;
+
+            uint64_t now = dsn_now_ns();
+            uint64_t sojourn = now - static_cast<rpc_request_task*>(task)->enqueue_ts_ns();
+            if (_sojourn_counter != nullptr)
+                _sojourn_counter->set(sojourn);
+            on_dequeue(sojourn, now);
+        }
+
+        bool codel_admission_controller::accept(int queue_length)
+        {
+            if (!overloaded())
+                return true;
+
+            // no more dequeue to update the state
+            if (queue_length <= 0)
+            {
+                utils::auto_lock<utils::ex_lock_nr_spin> l(_lock);
+                _first_above_ns = 0;
+                _overloaded.store(false, std::memory_order_relaxed);
+                return true;
+            }
+
+            return false;
+        }
+
+        void codel_admission_controller::on_dequeue(uint64_t sojourn_ns, uint64_t now_ns)
+        {
+            utils::auto_lock<utils::ex_lock_nr_spin> l(_lock);
+            if (sojourn_ns < _target_ns)
+            {
+                _first_above_ns = 0;
+                if (overloaded())
+                {
+                    _overloaded.store(false, std::memory_order_relaxed);
+                    dinfo("leave overloaded state, sojourn time = %" PRIu64 " ns", sojourn_ns);
+                }
+            }
+            else if (_first_above_ns == 0)
+            {
+                _first_above_ns = now_ns;
+            }
+            else if (!overloaded() && now_ns - _first_above_ns >= _interval_ns)
+            {
+                _overloaded.store(true, std::memory_order_relaxed);
+                dinfo("enter overloaded state, sojourn time = %" PRIu64 " ns", sojourn_ns);
+            }
+        }
+    }
+}
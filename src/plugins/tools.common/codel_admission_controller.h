@@ -0,0 +1,83 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     CoDel-style admission controller based on queueing sojourn time
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+#pragma once
+
+# include <dsn/tool_api.h>
+# include <dsn/utility/synchronize.h>
+# include <atomic>
+
+namespace dsn {
+    namespace tools {
+
+        //
+        // the sojourn time (from enqueue to execution) of each rpc request is checked when it
+        // is dequeued; when it stays above target for a whole interval, i.e., the queue is
+        // a standing queue rather than a burst, the controller enters the overloaded state and
+        // rejects new rpc requests, until a dequeued request has a sojourn time below target
+        // again or the queue becomes empty;
+        // so the queueing delay is bounded by about (target + interval) under overload, while bursts shorter
+        // than interval are still absorbed by the queue
+        //
+        // admission_controller_arguments (all optional, in order):
+        //   target_ms (5) interval_ms (100)
+        //
+        class codel_admission_controller : public admission_controller
+        {
+        public:
+            codel_admission_controller(task_queue* q, std::vector<std::string>& sargs);
+            ~codel_admission_controller();
+
+            virtual bool is_task_accepted(task* task) override;
+            virtual void on_task_begin(task* task) override;
+
+            // exposed for testing
+            bool accept(int queue_length);
+            void on_dequeue(uint64_t sojourn_ns, uint64_t now_ns);
+            bool overloaded() const { return _overloaded.load(std::memory_order_relaxed); }
+
+        private:
+            uint64_t               _target_ns;
+            uint64_t               _interval_ns;
+
+            utils::ex_lock_nr_spin _lock;
+            uint64_t               _first_above_ns; // 0 when the last sojourn time is below target
+            std::atomic<bool>      _overloaded;
+
+            perf_counter_ptr       _sojourn_counter;
+            perf_counter_ptr       _rejected_counter;
+        };
+    }
+}
@@ -0,0 +1,139 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     earliest-deadline-first task queue for rpc request pools
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# include "edf_task_queue.h"
+
+# ifdef __TITLE__
+# undef __TITLE__
+# endif
+# define __TITLE__ "task.queue.edf"
+
+namespace dsn
+{
+    namespace tools
+    {
+        edf_task_queue::edf_task_queue(task_worker_pool* pool, int index, task_queue* inner_provider)
+            : task_queue(pool, index, inner_provider)
+        {
+            _non_rpc_deadline_ns = dsn_config_get_value_uint64(
+                "components.edf_task_queue",
+                "non_rpc_deadline_ms",
+                0,
+                "virtual deadline (ms after enqueue) of non-rpc tasks and rpc requests without timeout "
+                "when they are compared with rpc requests of the same priority, 0 for always before rpc requests"
+                ) * 1000000ULL;
+
+            _shed_counter = perf_counter::get_counter(get_service_node_name(node()), "engine",
+                (get_name() + ".edf.shed").c_str(), COUNTER_TYPE_NUMBER,
+                "expired rpc requests dropped by the edf task queue", true);
+        }
+
+        edf_task_queue::~edf_task_queue()
+        {
+            perf_counter::remove_counter(_shed_counter->full_name());
+        }
+
+        void edf_task_queue::enqueue(task* task)
+        {
+            auto& sp = task->spec();
+            uint64_t now = dsn_now_ns();
+            uint64_t deadline_ns = now + _non_rpc_deadline_ns;
+            bool fifo = true;
+
+            if (sp.type == TASK_TYPE_RPC_REQUEST)
+            {
+                auto rtask = static_cast<rpc_request_task*>(task);
+                auto timeout_ms = rtask->get_request()->header->client.timeout_ms;
+                if (timeout_ms > 0)
+                {
+                    // the time spent before reaching this queue (e.g., in admission
+                    // controllers) also counts against the deadline
+                    uint64_t enqueue_ts = rtask->enqueue_ts_ns() != 0 ? rtask->enqueue_ts_ns() : now;
+                    deadline_ns = enqueue_ts + static_cast<uint64_t>(timeout_ms) * 1000000ULL;
+                    fifo = false;
+                }
+            }
+
+            {
+                utils::auto_lock<utils::ex_lock_nr_spin> l(_lock);
+                _scheduler.push(sp.priority, task, deadline_ns, fifo);
+            }
+
+            _sema.signal();
+        }
+
+        void edf_task_queue::shed(task* tsk)
+        {
+            auto rtask = static_cast<rpc_request_task*>(tsk);
+            ddebug("drop expired rpc request %s from %s with trace_id = %016" PRIx64,
+                tsk->spec().name.c_str(),
+                rtask->get_request()->header->from_address.to_string(),
+                rtask->get_request()->header->trace_id
+                );
+
+            _shed_counter->increment();
+            if (controller() != nullptr)
+                controller()->on_task_end(tsk);
+            tsk->spec().on_task_cancelled.execute(tsk);
+            tsk->release_ref(); // added in task::enqueue(pool)
+        }
+
+        task* edf_task_queue::dequeue(/*inout*/int& batch_size)
+        {
+            while (true)
+            {
+                _sema.wait();
+
+                task* t = nullptr;
+                bool expired;
+                {
+                    utils::auto_lock<utils::ex_lock_nr_spin> l(_lock);
+                    bool r = _scheduler.pop(dsn_now_ns(), t, expired);
+                    dassert(r, "semaphore and queue do not match");
+                }
+
+                if (!expired)
+                {
+                    batch_size = 1;
+                    return t;
+                }
+
+                // the worker only decreases the count for the returned tasks
+                decrease_count();
+                shed(t);
+            }
+        }
+    }
+}
@@ -0,0 +1,164 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     earliest-deadline-first task queue for rpc request pools
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+#pragma once
+
+# include <dsn/tool_api.h>
+# include <dsn/utility/synchronize.h>
+# include <queue>
+# include <deque>
+# include <vector>
+
+namespace dsn {
+    namespace tools {
+
+        //
+        // items are ordered by their absolute deadlines, except that fifo items keep
+        // their push order and are compared with the deadline items by the deadline of
+        // the fifo head; items of higher priority are always popped first
+        //
+        // not thread-safe
+        //
+        template<typename T>
+        class edf_scheduler
+        {
+        public:
+            edf_scheduler() : _seq(0), _count(0) {}
+
+            void push(int priority, const T& item, uint64_t deadline_ns, bool fifo)
+            {
+                entry e;
+                e.item = item;
+                e.deadline_ns = deadline_ns;
+                e.seq = ++_seq;
+
+                auto& level = _levels[priority];
+                if (fifo)
+                    level.fifo.push_back(e);
+                else
+                    level.deadlines.push(e);
+                _count++;
+            }
+
+            // return false when there is no item, otherwise expired tells whether the
+            // popped deadline item is due at now_ns, which fifo items never are
+            bool pop(uint64_t now_ns, /*out*/ T& item, /*out*/ bool& expired)
+            {
+                expired = false;
+                for (int i = TASK_PRIORITY_COUNT - 1; i >= 0; i--)
+                {
+                    auto& level = _levels[i];
+                    if (level.deadlines.empty() && level.fifo.empty())
+                        continue;
+
+                    _count--;
+                    if (level.deadlines.empty()
+                        || (!level.fifo.empty() && !later_deadline()(level.fifo.front(), level.deadlines.top())))
+                    {
+                        item = level.fifo.front().item;
+                        level.fifo.pop_front();
+                    }
+                    else
+                    {
+                        item = level.deadlines.top().item;
+                        expired = (level.deadlines.top().deadline_ns <= now_ns);
+                        level.deadlines.pop();
+                    }
+                    return true;
+                }
+                return false;
+            }
+
+            size_t size() const { return _count; }
+
+        private:
+            struct entry
+            {
+                T        item;
+                uint64_t deadline_ns;
+                uint64_t seq;
+            };
+
+            struct later_deadline
+            {
+                bool operator()(const entry& l, const entry& r) const
+                {
+                    return l.deadline_ns > r.deadline_ns
+                        || (l.deadline_ns == r.deadline_ns && l.seq > r.seq);
+                }
+            };
+
+            struct priority_level
+            {
+                std::priority_queue<entry, std::vector<entry>, later_deadline> deadlines;
+                std::deque<entry>                                             fifo;
+            };
+
+            priority_level _levels[TASK_PRIORITY_COUNT];
+            uint64_t       _seq;
+            size_t         _count;
+        };
+
+        //
+        // rpc requests are ordered by their absolute deadlines (the time the request task
+        // is enqueued + client timeout), and the ones already expired at dequeue time are
+        // dropped without execution, as their clients have already given up;
+        // other tasks (and rpc requests without timeout) keep FIFO order, with a virtual deadline
+        // of (enqueue time + [components.edf_task_queue] non_rpc_deadline_ms) when compared
+        // with rpc requests of the same priority;
+        // tasks with higher priority are always dequeued first
+        //
+        class edf_task_queue : public task_queue
+        {
+        public:
+            edf_task_queue(task_worker_pool* pool, int index, task_queue* inner_provider);
+            ~edf_task_queue();
+
+            virtual void     enqueue(task* task) override;
+            // always return 1 task so far
+            virtual task*    dequeue(/*inout*/int& batch_size) override;
+
+        private:
+            void  shed(task* tsk);
+
+        private:
+            utils::ex_lock_nr_spin _lock;
+            utils::semaphore       _sema;
+            edf_scheduler<task*>   _scheduler;
+            uint64_t               _non_rpc_deadline_ns;
+            perf_counter_ptr       _shed_counter;
+        };
+    }
+}
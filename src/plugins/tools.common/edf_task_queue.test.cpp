@@ -0,0 +1,103 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     Unit-test for edf_task_queue.
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+#include "edf_task_queue.h"
+#include <gtest/gtest.h>
+
+using namespace dsn;
+using namespace dsn::tools;
+
+TEST(tools_common, edf_scheduler_order)
+{
+    edf_scheduler<int> edf;
+    int v;
+    bool expired;
+    EXPECT_FALSE(edf.pop(0, v, expired));
+
+    // deadline items are popped by their deadlines, ties by push order
+    edf.push(TASK_PRIORITY_COMMON, 1, 300, false);
+    edf.push(TASK_PRIORITY_COMMON, 2, 100, false);
+    edf.push(TASK_PRIORITY_COMMON, 3, 200, false);
+    edf.push(TASK_PRIORITY_COMMON, 4, 100, false);
+
+    // fifo items keep their order, and the fifo head competes by its deadline
+    edf.push(TASK_PRIORITY_COMMON, 5, 250, true);
+    edf.push(TASK_PRIORITY_COMMON, 6, 0, true);
+
+    // higher priority first
+    edf.push(TASK_PRIORITY_HIGH, 7, 1000, false);
+    EXPECT_EQ(7u, edf.size());
+
+    int expected[] = { 7, 2, 4, 3, 5, 6, 1 };
+    for (int e : expected)
+    {
+        ASSERT_TRUE(edf.pop(0, v, expired));
+        EXPECT_EQ(e, v);
+        EXPECT_FALSE(expired);
+    }
+    EXPECT_EQ(0u, edf.size());
+    EXPECT_FALSE(edf.pop(0, v, expired));
+}
+
+TEST(tools_common, edf_scheduler_expired)
+{
+    edf_scheduler<int> edf;
+    int v;
+    bool expired;
+
+    // a request enqueued at 0 with 100 ns timeout is due at 100 even when it
+    // reaches the queue later; fifo items never expire
+    edf.push(TASK_PRIORITY_COMMON, 1, 100, false);
+    edf.push(TASK_PRIORITY_COMMON, 2, 500, false);
+    edf.push(TASK_PRIORITY_COMMON, 3, 0, true);
+
+    ASSERT_TRUE(edf.pop(200, v, expired));
+    EXPECT_EQ(3, v);
+    EXPECT_FALSE(expired);
+
+    ASSERT_TRUE(edf.pop(200, v, expired));
+    EXPECT_EQ(1, v);
+    EXPECT_TRUE(expired);
+
+    ASSERT_TRUE(edf.pop(200, v, expired));
+    EXPECT_EQ(2, v);
+    EXPECT_FALSE(expired);
+
+    // due exactly now
+    edf.push(TASK_PRIORITY_LOW, 4, 300, false);
+    ASSERT_TRUE(edf.pop(300, v, expired));
+    EXPECT_EQ(4, v);
+    EXPECT_TRUE(expired);
+}
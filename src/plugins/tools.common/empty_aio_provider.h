@@ -54,6 +54,7 @@ namespace dsn {
             virtual disk_aio* prepare_aio_context(aio_task* tsk) override;
 
             virtual void start(io_modifer& ctx) override {}
+            virtual bool vectored_write_supported() const override { return true; }
         };
     }
 }
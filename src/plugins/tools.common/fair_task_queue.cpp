@@ -0,0 +1,218 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     per-client fair task queue with deficit round robin and token bucket rate limiting
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# include "fair_task_queue.h"
+
+# ifdef __TITLE__
+# undef __TITLE__
+# endif
+# define __TITLE__ "task.queue.fair"
+
+namespace dsn
+{
+    namespace tools
+    {
+        // flow keys: the address value for requests from ipv4 addresses (host type bits = 01),
+        // (client id << 2) for requests with client ids (host type bits = 00), and a key with
+        // host type bits = 11 for local tasks, so that they never collide
+        static const uint64_t s_local_flow_key = 0x3;
+
+        fair_task_queue::fair_task_queue(task_worker_pool* pool, int index, task_queue* inner_provider)
+            : task_queue(pool, index, inner_provider), _last_sweep_ns(0)
+        {
+            uint32_t quantum = (uint32_t)dsn_config_get_value_uint64(
+                "components.fair_task_queue",
+                "drr_quantum",
+                1,
+                "deficit round robin quantum, i.e., the cost each flow can dequeue in one round"
+                );
+            dassert(quantum > 0, "[components.fair_task_queue] drr_quantum must be positive");
+
+            _cost_unit_bytes = (uint32_t)dsn_config_get_value_uint64(
+                "components.fair_task_queue",
+                "request_cost_unit_bytes",
+                0,
+                "the cost of a rpc request is (1 + body length / request_cost_unit_bytes), 0 for always 1"
+                );
+
+            for (int i = 0; i < TASK_PRIORITY_COUNT; i++)
+            {
+                _levels.emplace_back(new drr_scheduler<task*>(quantum));
+            }
+
+            auto& sp = pool_spec();
+            if (sp.client_rate_limit > 0)
+            {
+                uint64_t burst = sp.client_rate_burst == 0 ? sp.client_rate_limit : sp.client_rate_burst;
+                _client_idle_ns = (burst * 1000000000ULL) / sp.client_rate_limit + 1000000000ULL;
+            }
+            else
+            {
+                _client_idle_ns = 0;
+            }
+
+            _rejected_counter = perf_counter::get_counter(get_service_node_name(node()), "engine",
+                (get_name() + ".fair.rejected").c_str(), COUNTER_TYPE_NUMBER,
+                "rpc requests rejected by client_rate_limit", true);
+            _flow_counter = perf_counter::get_counter(get_service_node_name(node()), "engine",
+                (get_name() + ".fair.flows").c_str(), COUNTER_TYPE_NUMBER,
+                "flows with pending tasks in the fair task queue", true);
+        }
+
+        fair_task_queue::~fair_task_queue()
+        {
+            perf_counter::remove_counter(_rejected_counter->full_name());
+            perf_counter::remove_counter(_flow_counter->full_name());
+        }
+
+        /*static*/ uint64_t fair_task_queue::get_flow_key(task* tsk)
+        {
+            if (tsk->spec().type != TASK_TYPE_RPC_REQUEST)
+                return s_local_flow_key;
+
+            auto hdr = static_cast<rpc_request_task*>(tsk)->get_request()->header;
+            if (hdr->context.u.parameter_type == MSG_PARAM_CLIENT_ID)
+                return static_cast<uint64_t>(hdr->context.u.parameter) << 2;
+            else
+                return hdr->from_address.c_addr().u.value;
+        }
+
+        bool fair_task_queue::is_client_accepted(uint64_t key, uint64_t now_ns)
+        {
+            auto& sp = pool_spec();
+            utils::auto_lock<utils::ex_lock_nr_spin> l(_clients_lock);
+
+            // buckets idle for long are full again, so they are simply removed
+            if (now_ns - _last_sweep_ns > _client_idle_ns)
+            {
+                for (auto it = _clients.begin(); it != _clients.end();)
+                {
+                    if (now_ns - it->second->last_ns > _client_idle_ns)
+                        it = _clients.erase(it);
+                    else
+                        ++it;
+                }
+                _last_sweep_ns = now_ns;
+            }
+
+            auto& c = _clients[key];
+            if (c == nullptr)
+            {
+                c.reset(new client_bucket());
+                c->bucket.reset(sp.client_rate_limit, sp.client_rate_burst);
+            }
+            c->last_ns = now_ns;
+            return c->bucket.try_consume(now_ns);
+        }
+
+        void fair_task_queue::reject(task* tsk)
+        {
+            auto rtask = static_cast<rpc_request_task*>(tsk);
+            reply_busy(tsk);
+
+            dinfo("client exceeds client_rate_limit (%" PRIu64 "/s), reject message from %s with trace_id = %016" PRIx64,
+                pool_spec().client_rate_limit,
+                rtask->get_request()->header->from_address.to_string(),
+                rtask->get_request()->header->trace_id
+                );
+
+            _rejected_counter->increment();
+            if (controller() != nullptr)
+                controller()->on_task_end(tsk);
+            tsk->release_ref(); // added in task::enqueue(pool)
+        }
+
+        size_t fair_task_queue::flow_count() const
+        {
+            size_t flows = 0;
+            for (auto& level : _levels)
+                flows += level->flow_count();
+            return flows;
+        }
+
+        void fair_task_queue::enqueue(task* task)
+        {
+            auto& sp = task->spec();
+            uint64_t key = get_flow_key(task);
+
+            if (_client_idle_ns != 0 && sp.type == TASK_TYPE_RPC_REQUEST
+                && !is_client_accepted(key, dsn_now_ns()))
+            {
+                // the count has been increased in task_queue::enqueue_internal
+                decrease_count();
+                reject(task);
+                return;
+            }
+
+            uint32_t cost = 1;
+            if (_cost_unit_bytes > 0 && sp.type == TASK_TYPE_RPC_REQUEST)
+            {
+                cost += static_cast<rpc_request_task*>(task)->get_request()->header->body_length / _cost_unit_bytes;
+            }
+
+            size_t flows;
+            {
+                utils::auto_lock<utils::ex_lock_nr_spin> l(_lock);
+                _levels[sp.priority]->push(key, task, cost);
+                flows = flow_count();
+            }
+            _flow_counter->set(flows);
+
+            _sema.signal();
+        }
+
+        task* fair_task_queue::dequeue(/*inout*/int& batch_size)
+        {
+            _sema.wait();
+
+            task* t = nullptr;
+            size_t flows;
+            {
+                utils::auto_lock<utils::ex_lock_nr_spin> l(_lock);
+                for (int i = TASK_PRIORITY_COUNT - 1; i >= 0; i--)
+                {
+                    if (_levels[i]->pop(t))
+                        break;
+                }
+                flows = flow_count();
+            }
+            _flow_counter->set(flows);
+
+            dassert(t != nullptr, "semaphore and queue do not match");
+            batch_size = 1;
+            return t;
+        }
+    }
+}
@@ -0,0 +1,206 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     per-client fair task queue with deficit round robin and token bucket rate limiting
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+#pragma once
+
+# include <dsn/tool_api.h>
+# include <dsn/utility/synchronize.h>
+# include <dsn/utility/token_bucket.h>
+# include <unordered_map>
+# include <deque>
+# include <vector>
+# include <memory>
+
+namespace dsn {
+    namespace tools {
+
+        //
+        // deficit round robin among flows: each active flow gets quantum credits per round,
+        // and an item is popped from a flow only when its credits cover the item cost,
+        // so flows share the dequeue bandwidth in proportion to the cost (not the count) of
+        // their items; a flow is removed (and its credits are reset) once it becomes empty
+        //
+        // not thread-safe
+        //
+        template<typename T>
+        class drr_scheduler
+        {
+        public:
+            explicit drr_scheduler(uint32_t quantum) : _quantum(quantum), _count(0)
+            {
+                dassert(quantum > 0, "quantum must be positive");
+            }
+
+            ~drr_scheduler()
+            {
+                for (auto& kv : _flows)
+                    delete kv.second;
+                for (auto f : _free_flows)
+                    delete f;
+            }
+
+            void push(uint64_t key, const T& item, uint32_t cost)
+            {
+                flow* f;
+                auto it = _flows.find(key);
+                if (it == _flows.end())
+                {
+                    if (_free_flows.empty())
+                        f = new flow();
+                    else
+                    {
+                        f = _free_flows.back();
+                        _free_flows.pop_back();
+                    }
+                    f->key = key;
+                    f->deficit = _quantum;
+                    _flows.emplace(key, f);
+                    _active.push_back(f);
+                }
+                else
+                    f = it->second;
+
+                f->items.push_back(entry{ item, cost });
+                _count++;
+            }
+
+            // return false when there is no item
+            bool pop(/*out*/ T& item)
+            {
+                if (_count == 0)
+                    return false;
+
+                while (true)
+                {
+                    flow* f = _active.front();
+                    auto& e = f->items.front();
+                    if (f->deficit >= e.cost)
+                    {
+                        f->deficit -= e.cost;
+                        item = e.item;
+                        f->items.pop_front();
+                        _count--;
+
+                        if (f->items.empty())
+                        {
+                            _active.pop_front();
+                            _flows.erase(f->key);
+                            _free_flows.push_back(f);
+                        }
+                        return true;
+                    }
+
+                    // next round for this flow
+                    f->deficit += _quantum;
+                    _active.pop_front();
+                    _active.push_back(f);
+                }
+            }
+
+            size_t size() const { return _count; }
+            size_t flow_count() const { return _flows.size(); }
+
+        private:
+            struct entry
+            {
+                T        item;
+                uint32_t cost;
+            };
+
+            struct flow
+            {
+                uint64_t          key;
+                uint64_t          deficit;
+                std::deque<entry> items;
+            };
+
+            uint32_t                             _quantum;
+            size_t                               _count;
+            std::unordered_map<uint64_t, flow*>  _flows;
+            std::deque<flow*>                    _active;
+            std::vector<flow*>                   _free_flows;
+        };
+
+        //
+        // rpc requests are grouped into flows by their sources, i.e., the client id in the
+        // message context when its parameter_type is MSG_PARAM_CLIENT_ID, or the from address;
+        // non-rpc tasks belong to a single local flow;
+        // flows of the same priority are served with deficit round robin, where the cost of
+        // a request is (1 + body length / [components.fair_task_queue] request_cost_unit_bytes),
+        // so that a flooding client cannot starve the others;
+        // rpc requests from a client exceeding threadpool_spec.client_rate_limit are rejected
+        // with ERR_BUSY; tasks with higher priority are always dequeued first
+        //
+        class fair_task_queue : public task_queue
+        {
+        public:
+            fair_task_queue(task_worker_pool* pool, int index, task_queue* inner_provider);
+            ~fair_task_queue();
+
+            virtual void     enqueue(task* task) override;
+            // always return 1 task so far
+            virtual task*    dequeue(/*inout*/int& batch_size) override;
+
+            static uint64_t  get_flow_key(task* tsk);
+
+        private:
+            struct client_bucket
+            {
+                utils::token_bucket bucket;
+                uint64_t            last_ns;
+            };
+
+            bool  is_client_accepted(uint64_t key, uint64_t now_ns);
+            void  reject(task* tsk);
+            // flows with pending tasks of all priorities, called with _lock held
+            size_t flow_count() const;
+
+        private:
+            utils::ex_lock_nr_spin _lock;
+            utils::semaphore       _sema;
+            std::vector<std::unique_ptr<drr_scheduler<task*>>> _levels;
+            uint32_t               _cost_unit_bytes;
+
+            // per-client rate limiting
+            utils::ex_lock_nr_spin _clients_lock;
+            std::unordered_map<uint64_t, std::unique_ptr<client_bucket>> _clients;
+            uint64_t               _client_idle_ns; // after which the bucket is full again
+            uint64_t               _last_sweep_ns;
+
+            perf_counter_ptr       _rejected_counter;
+            perf_counter_ptr       _flow_counter;
+        };
+    }
+}
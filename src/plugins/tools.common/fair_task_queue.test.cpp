@@ -0,0 +1,136 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     Unit-test for deficit round robin and token bucket used by the fair task queue.
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+#include "fair_task_queue.h"
+#include <gtest/gtest.h>
+#include <map>
+
+using namespace dsn;
+using namespace dsn::tools;
+
+TEST(tools_common, drr_scheduler_fairness)
+{
+    drr_scheduler<int> drr(1);
+
+    // a flooding client (key 1) enqueues 1000 requests before two others enqueue 10 each
+    for (int i = 0; i < 1000; i++)
+        drr.push(1, 1, 1);
+    for (int i = 0; i < 10; i++)
+    {
+        drr.push(2, 2, 1);
+        drr.push(3, 3, 1);
+    }
+    EXPECT_EQ(1020u, drr.size());
+    EXPECT_EQ(3u, drr.flow_count());
+
+    // the small clients are all served within the first 30 dequeues
+    std::map<int, int> served;
+    int v;
+    for (int i = 0; i < 30; i++)
+    {
+        ASSERT_TRUE(drr.pop(v));
+        served[v]++;
+    }
+    EXPECT_EQ(10, served[1]);
+    EXPECT_EQ(10, served[2]);
+    EXPECT_EQ(10, served[3]);
+    EXPECT_EQ(1u, drr.flow_count());
+
+    while (drr.pop(v))
+        EXPECT_EQ(1, v);
+    EXPECT_EQ(0u, drr.size());
+    EXPECT_EQ(0u, drr.flow_count());
+}
+
+TEST(tools_common, drr_scheduler_cost)
+{
+    drr_scheduler<int> drr(4);
+
+    // flow 1 sends large requests (cost 4) and flow 2 small ones (cost 1),
+    // so flow 2 gets 4x the dequeues of flow 1
+    for (int i = 0; i < 100; i++)
+    {
+        drr.push(1, 1, 4);
+        drr.push(2, 2, 1);
+        drr.push(2, 2, 1);
+        drr.push(2, 2, 1);
+        drr.push(2, 2, 1);
+    }
+
+    std::map<int, int> served;
+    int v;
+    for (int i = 0; i < 250; i++)
+    {
+        ASSERT_TRUE(drr.pop(v));
+        served[v]++;
+    }
+    EXPECT_EQ(50, served[1]);
+    EXPECT_EQ(200, served[2]);
+}
+
+TEST(tools_common, token_bucket)
+{
+    const uint64_t s = 1000000000ULL;
+    utils::token_bucket unlimited;
+    EXPECT_TRUE(unlimited.unlimited());
+    for (int i = 0; i < 1000; i++)
+        EXPECT_TRUE(unlimited.try_consume(s));
+
+    // 100/s with a burst of 10
+    utils::token_bucket b(100, 10);
+    uint64_t now = s;
+    int accepted = 0;
+    for (int i = 0; i < 100; i++)
+        accepted += b.try_consume(now) ? 1 : 0;
+    EXPECT_EQ(10, accepted);
+
+    // 1000 requests evenly spread over 1 second, 100 tokens are refilled
+    accepted = 0;
+    for (int i = 0; i < 1000; i++)
+    {
+        now += s / 1000;
+        accepted += b.try_consume(now) ? 1 : 0;
+    }
+    EXPECT_GE(accepted, 99);
+    EXPECT_LE(accepted, 101);
+
+    // refill never exceeds the burst
+    now += 10 * s;
+    EXPECT_DOUBLE_EQ(10.0, b.available(now));
+
+    // burst defaults to the rate
+    utils::token_bucket d(50);
+    EXPECT_EQ(50u, d.burst());
+}
@@ -0,0 +1,186 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     concurrency-limit admission controller driven by the latency gradient
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# include "gradient_admission_controller.h"
+# include <algorithm>
+# include <cmath>
+# include <limits>
+
+# ifdef __TITLE__
+# undef __TITLE__
+# endif
+# define __TITLE__ "admission.gradient"
+
+namespace dsn
+{
+    namespace tools
+    {
+        gradient_admission_controller::gradient_admission_controller(task_queue* q, std::vector<std::string>& sargs)
+            : admission_controller(q, sargs), _inflight(0)
+        {
+            _min_limit = sargs.size() > 0 ? atoi(sargs[0].c_str()) : 4;
+            _max_limit = sargs.size() > 1 ? atoi(sargs[1].c_str()) : 1000;
+            int initial_limit = sargs.size() > 2 ? atoi(sargs[2].c_str()) : 20;
+            _tolerance = sargs.size() > 3 ? atof(sargs[3].c_str()) : 2.0;
+            _smoothing = sargs.size() > 4 ? atof(sargs[4].c_str()) : 0.2;
+            _update_interval_ns = (sargs.size() > 5 ? atoi(sargs[5].c_str()) : 100) * 1000000ULL;
+            _baseline_window_ns = (sargs.size() > 6 ? atoi(sargs[6].c_str()) : 10000) * 1000000ULL;
+
+            dassert(_min_limit > 0 && _min_limit <= initial_limit && initial_limit <= _max_limit
+                && _tolerance >= 1.0 && _smoothing > 0.0 && _smoothing <= 1.0
+                && _update_interval_ns > 0 && _baseline_window_ns >= _update_interval_ns,
+                "invalid arguments for gradient_admission_controller: min_limit(%d) initial_limit(%d) max_limit(%d) "
+                "tolerance(%lf) smoothing(%lf) update_interval_ms(%" PRIu64 ") baseline_window_ms(%" PRIu64 ")",
+                _min_limit, initial_limit, _max_limit, _tolerance, _smoothing,
+                _update_interval_ns / 1000000, _baseline_window_ns / 1000000
+                );
+
+            _limit.store(initial_limit);
+            _limit_f = initial_limit;
+            _window_start_ns = 0;
+            _window_sum_ns = 0;
+            _window_count = 0;
+            _baseline_window_start_ns = 0;
+            _current_min_ns = std::numeric_limits<uint64_t>::max();
+            _previous_min_ns = std::numeric_limits<uint64_t>::max();
+            _baseline_ns = 0;
+
+            if (q != nullptr)
+            {
+                _limit_counter = perf_counter::get_counter(get_service_node_name(q->node()), "engine",
+                    (q->get_name() + ".admission.limit").c_str(), COUNTER_TYPE_NUMBER,
+                    "concurrency limit of the gradient admission controller", true);
+                _rejected_counter = perf_counter::get_counter(get_service_node_name(q->node()), "engine",
+                    (q->get_name() + ".admission.rejected").c_str(), COUNTER_TYPE_RATE,
+                    "rpc requests rejected by the admission controller", true);
+                _limit_counter->set(initial_limit);
+            }
+        }
+
+        gradient_admission_controller::~gradient_admission_controller()
+        {
+            if (_limit_counter != nullptr)
+            {
+                perf_counter::remove_counter(_limit_counter->full_name());
+                perf_counter::remove_counter(_rejected_counter->full_name());
+            }
+        }
+
+        bool gradient_admission_controller::is_task_accepted(task* task)
+        {
+            if (try_acquire())
+                return true;
+
+            if (_rejected_counter != nullptr)
+                _rejected_counter->increment();
+            return false;
+        }
+
+        void gradient_admission_controller::on_task_end(task* task)
+        {
+            if (task->spec().type != TASK_TYPE_RPC_REQUEST)
+                return;
+
+            uint64_t now = dsn_now_ns();
+            release(now - static_cast<rpc_request_task*>(task)->enqueue_ts_ns(), now);
+        }
+
+        bool gradient_admission_controller::try_acquire()
+        {
+            if (_inflight.fetch_add(1, std::memory_order_relaxed) < _limit.load(std::memory_order_relaxed))
+                return true;
+
+            _inflight.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        void gradient_admission_controller::release(uint64_t latency_ns, uint64_t now_ns)
+        {
+            _inflight.fetch_sub(1, std::memory_order_relaxed);
+
+            utils::auto_lock<utils::ex_lock_nr_spin> l(_lock);
+            if (_window_start_ns == 0)
+            {
+                _window_start_ns = now_ns;
+                _baseline_window_start_ns = now_ns;
+            }
+
+            _window_sum_ns += latency_ns;
+            _window_count++;
+            _current_min_ns = std::min(_current_min_ns, latency_ns);
+
+            if (now_ns - _window_start_ns >= _update_interval_ns)
+            {
+                update_limit(now_ns);
+            }
+        }
+
+        // under _lock
+        void gradient_admission_controller::update_limit(uint64_t now_ns)
+        {
+            // the baseline follows the min of the current and the previous windows, so it
+            // can go up (e.g., after the workload changes) within two baseline windows
+            _baseline_ns = std::min(_current_min_ns, _previous_min_ns);
+            if (now_ns - _baseline_window_start_ns >= _baseline_window_ns)
+            {
+                _previous_min_ns = _current_min_ns;
+                _current_min_ns = std::numeric_limits<uint64_t>::max();
+                _baseline_window_start_ns = now_ns;
+            }
+
+            double avg_ns = static_cast<double>(_window_sum_ns) / static_cast<double>(_window_count);
+            double gradient = std::max(0.5, std::min(1.0,
+                _tolerance * static_cast<double>(std::max(_baseline_ns, (uint64_t)1)) / std::max(avg_ns, 1.0)));
+            double new_limit = _limit_f * gradient + std::sqrt(_limit_f);
+
+            // do not grow when the limit is not approached, otherwise it grows unboundedly
+            // under light load and does not protect the service when a burst comes
+            if (new_limit > _limit_f && inflight() < _limit_f / 2)
+                new_limit = _limit_f;
+
+            _limit_f = _limit_f * (1.0 - _smoothing) + new_limit * _smoothing;
+            _limit_f = std::max(static_cast<double>(_min_limit), std::min(static_cast<double>(_max_limit), _limit_f));
+
+            int limit = static_cast<int>(_limit_f);
+            _limit.store(limit, std::memory_order_relaxed);
+            if (_limit_counter != nullptr)
+                _limit_counter->set(limit);
+
+            _window_start_ns = now_ns;
+            _window_sum_ns = 0;
+            _window_count = 0;
+        }
+    }
+}
@@ -0,0 +1,105 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     concurrency-limit admission controller driven by the latency gradient
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+#pragma once
+
+# include <dsn/tool_api.h>
+# include <dsn/utility/synchronize.h>
+# include <atomic>
+
+namespace dsn {
+    namespace tools {
+
+        //
+        // rpc requests are rejected when the in-flight ones (queued or executing) reach the
+        // concurrency limit, which is adjusted every update interval:
+        //
+        //   gradient = clamp(tolerance * baseline_latency / avg_latency, 0.5, 1.0)
+        //   new_limit = limit * gradient + sqrt(limit)
+        //   limit = limit * (1 - smoothing) + new_limit * smoothing
+        //
+        // i.e., the limit grows additively while the latency (queueing + execution) stays
+        // within tolerance of the no-load baseline (the min latency of the recent baseline
+        // windows), and shrinks multiplicatively by the gradient when it does not;
+        //
+        // admission_controller_arguments (all optional, in order):
+        //   min_limit (4) max_limit (1000) initial_limit (20) tolerance (2.0) smoothing (0.2)
+        //   update_interval_ms (100) baseline_window_ms (10000)
+        //
+        class gradient_admission_controller : public admission_controller
+        {
+        public:
+            gradient_admission_controller(task_queue* q, std::vector<std::string>& sargs);
+            ~gradient_admission_controller();
+
+            virtual bool is_task_accepted(task* task) override;
+            virtual void on_task_end(task* task) override;
+
+            // exposed for testing
+            bool try_acquire();
+            void release(uint64_t latency_ns, uint64_t now_ns);
+            int  limit() const { return _limit.load(std::memory_order_relaxed); }
+            int  inflight() const { return _inflight.load(std::memory_order_relaxed); }
+            uint64_t baseline_ns() const { return _baseline_ns; }
+
+        private:
+            void update_limit(uint64_t now_ns);
+
+        private:
+            int              _min_limit;
+            int              _max_limit;
+            double           _tolerance;
+            double           _smoothing;
+            uint64_t         _update_interval_ns;
+            uint64_t         _baseline_window_ns;
+
+            std::atomic<int> _inflight;
+            std::atomic<int> _limit;
+
+            utils::ex_lock_nr_spin _lock;
+            double           _limit_f;
+            uint64_t         _window_start_ns;
+            uint64_t         _window_sum_ns;
+            uint64_t         _window_count;
+            uint64_t         _baseline_window_start_ns;
+            uint64_t         _current_min_ns;  // min latency of the current baseline window
+            uint64_t         _previous_min_ns; // min latency of the previous baseline window
+            uint64_t         _baseline_ns;
+
+            perf_counter_ptr _limit_counter;
+            perf_counter_ptr _rejected_counter;
+        };
+    }
+}
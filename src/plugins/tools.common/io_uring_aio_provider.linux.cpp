@@ -0,0 +1,544 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     aio provider based on linux io_uring
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# include "io_uring_aio_provider.linux.h"
+
+# ifdef DSN_HAS_IO_URING
+
+# include <sys/mman.h>
+# include <sys/syscall.h>
+# include <fcntl.h>
+# include <unistd.h>
+# include <cstring>
+# include <thread>
+
+# ifdef __TITLE__
+# undef __TITLE__
+# endif
+# define __TITLE__ "aio.provider.io_uring"
+
+namespace dsn {
+    namespace tools {
+
+        static int sys_io_uring_setup(unsigned entries, struct io_uring_params* p)
+        {
+            return (int)syscall(__NR_io_uring_setup, entries, p);
+        }
+
+        static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+        {
+            return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0);
+        }
+
+        static int sys_io_uring_register(int fd, unsigned opcode, const void* arg, unsigned nr_args)
+        {
+            return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+        }
+
+        io_uring_aio_provider::io_uring_aio_provider(disk_engine* disk, aio_provider* inner_provider)
+            : aio_provider(disk, inner_provider), _ring_fd(-1),
+            _sq_ring(nullptr), _sq_ring_bytes(0), _sqes(nullptr), _sqes_bytes(0),
+            _cq_ring(nullptr), _cq_ring_bytes(0), _fixed_io_count(0)
+        {
+            unsigned entries = (unsigned)dsn_config_get_value_uint64("aio", "uring_entries", 256,
+                "submission queue size of the io_uring, the completion queue is twice as large");
+            unsigned fixed_count = (unsigned)dsn_config_get_value_uint64("aio", "uring_fixed_buffer_count", 64,
+                "max transient memory blocks registered to the io_uring as fixed buffers, 0 for disabled");
+            _flush_datasync = dsn_config_get_value_bool("aio", "uring_flush_datasync", false,
+                "whether file flushes use fdatasync instead of fsync, which skips the metadata not needed for reading the data back");
+
+            if (!setup(entries))
+            {
+                dwarn("io_uring is not available, file io is done synchronously");
+                return;
+            }
+
+            if (fixed_count > 0)
+                setup_fixed_buffers(fixed_count);
+        }
+
+        io_uring_aio_provider::~io_uring_aio_provider()
+        {
+            if (_ring_fd < 0)
+                return;
+
+            if (_sqes != nullptr)
+                munmap(_sqes, _sqes_bytes);
+            if (_cq_ring != nullptr && _cq_ring != _sq_ring)
+                munmap(_cq_ring, _cq_ring_bytes);
+            if (_sq_ring != nullptr)
+                munmap(_sq_ring, _sq_ring_bytes);
+            ::close(_ring_fd);
+        }
+
+        bool io_uring_aio_provider::setup(unsigned entries)
+        {
+            struct io_uring_params p;
+            memset(&p, 0, sizeof(p));
+            int fd = sys_io_uring_setup(entries, &p);
+            if (fd < 0)
+            {
+                derror("io_uring_setup failed, err = %s", strerror(errno));
+                return false;
+            }
+
+            _sq_ring_bytes = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+            _cq_ring_bytes = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+            bool single_mmap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if (single_mmap)
+            {
+                _sq_ring_bytes = std::max(_sq_ring_bytes, _cq_ring_bytes);
+                _cq_ring_bytes = _sq_ring_bytes;
+            }
+
+            _sq_ring = mmap(nullptr, _sq_ring_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+            _cq_ring = single_mmap ? _sq_ring
+                : mmap(nullptr, _cq_ring_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            _sqes_bytes = p.sq_entries * sizeof(struct io_uring_sqe);
+            void* sqes = mmap(nullptr, _sqes_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+            if (_sq_ring == MAP_FAILED || _cq_ring == MAP_FAILED || sqes == MAP_FAILED)
+            {
+                derror("mmap io_uring failed, err = %s", strerror(errno));
+                if (sqes != MAP_FAILED)
+                    munmap(sqes, _sqes_bytes);
+                if (_cq_ring != MAP_FAILED && _cq_ring != _sq_ring)
+                    munmap(_cq_ring, _cq_ring_bytes);
+                if (_sq_ring != MAP_FAILED)
+                    munmap(_sq_ring, _sq_ring_bytes);
+                _sq_ring = _cq_ring = nullptr;
+                ::close(fd);
+                return false;
+            }
+
+            char* sq = (char*)_sq_ring;
+            _sq_head = (unsigned*)(sq + p.sq_off.head);
+            _sq_tail = (unsigned*)(sq + p.sq_off.tail);
+            _sq_mask = *(unsigned*)(sq + p.sq_off.ring_mask);
+            _sq_entries = *(unsigned*)(sq + p.sq_off.ring_entries);
+            _sq_array = (unsigned*)(sq + p.sq_off.array);
+            _sqes = (struct io_uring_sqe*)sqes;
+
+            char* cq = (char*)_cq_ring;
+            _cq_head = (unsigned*)(cq + p.cq_off.head);
+            _cq_tail = (unsigned*)(cq + p.cq_off.tail);
+            _cq_mask = *(unsigned*)(cq + p.cq_off.ring_mask);
+            _cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+
+            _ring_fd = fd;
+            return true;
+        }
+
+        void io_uring_aio_provider::setup_fixed_buffers(unsigned count)
+        {
+# ifdef IORING_RSRC_REGISTER_SPARSE
+            // a sparse table, whose slots are filled when transient memory blocks are allocated
+            struct io_uring_rsrc_register reg;
+            memset(&reg, 0, sizeof(reg));
+            reg.nr = count;
+            reg.flags = IORING_RSRC_REGISTER_SPARSE;
+            if (sys_io_uring_register(_ring_fd, IORING_REGISTER_BUFFERS2, &reg, sizeof(reg)) < 0)
+            {
+                dwarn("io_uring fixed buffers are disabled as registration failed, err = %s", strerror(errno));
+                return;
+            }
+
+            utils::auto_lock<utils::ex_lock_nr> l(_fixed_lock);
+            for (int i = (int)count - 1; i >= 0; i--)
+                _free_fixed_slots.push_back(i);
+# else
+            dwarn("io_uring fixed buffers are not supported by the kernel headers");
+# endif
+        }
+
+        void io_uring_aio_provider::on_transient_block(void* ptr, size_t size, bool allocated)
+        {
+# ifdef IORING_RSRC_REGISTER_SPARSE
+            if (_ring_fd < 0)
+                return;
+
+            utils::auto_lock<utils::ex_lock_nr> l(_fixed_lock);
+            int index;
+            struct iovec iov;
+            if (allocated)
+            {
+                if (_free_fixed_slots.empty())
+                    return;
+
+                index = _free_fixed_slots.back();
+                iov.iov_base = ptr;
+                iov.iov_len = size;
+            }
+            else
+            {
+                auto it = _fixed_buffers.find((uintptr_t)ptr);
+                if (it == _fixed_buffers.end())
+                    return;
+
+                index = it->second.index;
+                iov.iov_base = nullptr;
+                iov.iov_len = 0;
+            }
+
+            struct io_uring_rsrc_update2 up;
+            memset(&up, 0, sizeof(up));
+            up.offset = (unsigned)index;
+            up.data = (uint64_t)(uintptr_t)&iov;
+            up.nr = 1;
+            int ret = sys_io_uring_register(_ring_fd, IORING_REGISTER_BUFFERS_UPDATE, &up, sizeof(up));
+
+            if (allocated)
+            {
+                // e.g., RLIMIT_MEMLOCK is exceeded, the block simply uses the non-fixed ops
+                if (ret < 0)
+                {
+                    dinfo("register fixed buffer failed, err = %s", strerror(errno));
+                    return;
+                }
+                _free_fixed_slots.pop_back();
+                _fixed_buffers[(uintptr_t)ptr] = fixed_buffer{ size, index };
+            }
+            else
+            {
+                dassert(ret >= 0, "unregister fixed buffer failed, err = %s", strerror(errno));
+                _fixed_buffers.erase((uintptr_t)ptr);
+                _free_fixed_slots.push_back(index);
+            }
+# endif
+        }
+
+        int io_uring_aio_provider::fixed_buffer_count() const
+        {
+            utils::auto_lock<utils::ex_lock_nr> l(_fixed_lock);
+            return (int)_fixed_buffers.size();
+        }
+
+        int io_uring_aio_provider::fixed_buffer_capacity() const
+        {
+            utils::auto_lock<utils::ex_lock_nr> l(_fixed_lock);
+            return (int)(_fixed_buffers.size() + _free_fixed_slots.size());
+        }
+
+        int io_uring_aio_provider::find_fixed_buffer(const void* ptr, size_t size)
+        {
+            utils::auto_lock<utils::ex_lock_nr> l(_fixed_lock);
+            if (_fixed_buffers.empty())
+                return -1;
+
+            auto it = _fixed_buffers.upper_bound((uintptr_t)ptr);
+            if (it == _fixed_buffers.begin())
+                return -1;
+
+            --it;
+            if ((uintptr_t)ptr + size <= it->first + it->second.size)
+                return it->second.index;
+            else
+                return -1;
+        }
+
+        void io_uring_aio_provider::start(io_modifer& ctx)
+        {
+            if (_ring_fd < 0)
+                return;
+
+            std::string affinity_cpus = dsn_config_get_value_string("aio", "event_thread_affinity_cpus", "",
+                "what CPU cores the aio completion thread is pinned to, as a cpuset list (e.g., 0-3) or numa nodes (e.g., node:0), empty for not pinned");
+            new std::thread([this, ctx, affinity_cpus]()
+            {
+                task::set_tls_dsn_context(node(), nullptr, ctx.queue);
+                task_worker::pin_current_thread(affinity_cpus.c_str(), true);
+                get_event();
+            });
+        }
+
+        dsn_handle_t io_uring_aio_provider::open(const char* file_name, int flag, int pmode)
+        {
+            dsn_handle_t fh = (dsn_handle_t)(uintptr_t)::open(file_name, flag, pmode);
+            if (fh == DSN_INVALID_FILE_HANDLE)
+            {
+                derror("create file failed, err = %s", strerror(errno));
+            }
+            return fh;
+        }
+
+        error_code io_uring_aio_provider::close(dsn_handle_t fh)
+        {
+            if (fh == DSN_INVALID_FILE_HANDLE || ::close((int)(uintptr_t)(fh)) == 0)
+            {
+                return ERR_OK;
+            }
+            else
+            {
+                derror("close file failed, err = %s", strerror(errno));
+                return ERR_FILE_OPERATION_FAILED;
+            }
+        }
+
+        error_code io_uring_aio_provider::flush(dsn_handle_t fh)
+        {
+            return flush_internal(fh, _flush_datasync);
+        }
+
+        error_code io_uring_aio_provider::flush_data(dsn_handle_t fh)
+        {
+            return flush_internal(fh, true);
+        }
+
+        void io_uring_aio_provider::writeback_hint(dsn_handle_t fh, uint64_t offset, uint64_t size)
+        {
+            if (fh != DSN_INVALID_FILE_HANDLE)
+            {
+                ::sync_file_range((int)(uintptr_t)(fh), (off64_t)offset, (off64_t)size, SYNC_FILE_RANGE_WRITE);
+            }
+        }
+
+        error_code io_uring_aio_provider::flush_internal(dsn_handle_t fh, bool datasync)
+        {
+            if (fh == DSN_INVALID_FILE_HANDLE)
+                return ERR_OK;
+
+            int fd = (int)(uintptr_t)(fh);
+            int res;
+            if (_ring_fd >= 0)
+            {
+                sync_op_context ctx;
+                ctx.res = 0;
+                submit(IORING_OP_FSYNC, fd, nullptr, 0, 0, -1, datasync ? IORING_FSYNC_DATASYNC : 0,
+                    (uint64_t)(uintptr_t)&ctx | SYNC_OP_TAG);
+                ctx.evt.wait();
+                res = ctx.res;
+            }
+            else
+            {
+                res = (datasync ? ::fdatasync(fd) : ::fsync(fd)) == 0 ? 0 : -errno;
+            }
+
+            if (res == 0)
+            {
+                return ERR_OK;
+            }
+            else
+            {
+                derror("flush file failed, err = %s", strerror(-res));
+                return ERR_FILE_OPERATION_FAILED;
+            }
+        }
+
+        disk_aio* io_uring_aio_provider::prepare_aio_context(aio_task* tsk)
+        {
+            auto r = new uring_disk_aio_context;
+            r->tsk = tsk;
+            return r;
+        }
+
+        void io_uring_aio_provider::aio(aio_task* aio_tsk)
+        {
+            auto aio = (uring_disk_aio_context*)aio_tsk->aio();
+            const struct iovec* iov = &aio->iov;
+            int iovcnt = 1;
+            if (aio->type == AIO_Write && !aio_tsk->_unmerged_write_buffers.empty())
+            {
+                auto& buffers = aio_tsk->_unmerged_write_buffers;
+                aio->iovs.resize(buffers.size());
+                for (size_t i = 0; i < buffers.size(); i++)
+                {
+                    aio->iovs[i].iov_base = buffers[i].buffer;
+                    aio->iovs[i].iov_len = (size_t)buffers[i].size;
+                }
+                iov = aio->iovs.data();
+                iovcnt = (int)aio->iovs.size();
+            }
+            else
+            {
+                aio->iov.iov_base = aio->buffer;
+                aio->iov.iov_len = aio->buffer_size;
+            }
+
+            if (_ring_fd < 0)
+            {
+                sync_aio(aio, iov, iovcnt);
+                return;
+            }
+
+            int fd = static_cast<int>((ssize_t)aio->file);
+            int fixed_index = iovcnt == 1 ? find_fixed_buffer(iov->iov_base, iov->iov_len) : -1;
+            uint8_t opcode;
+            switch (aio->type)
+            {
+            case AIO_Read:
+                opcode = fixed_index >= 0 ? IORING_OP_READ_FIXED : IORING_OP_READV;
+                break;
+            case AIO_Write:
+                opcode = fixed_index >= 0 ? IORING_OP_WRITE_FIXED : IORING_OP_WRITEV;
+                break;
+            default:
+                derror("unknown aio type %u", static_cast<int>(aio->type));
+                complete_io(aio_tsk, ERR_FILE_OPERATION_FAILED, 0);
+                return;
+            }
+
+            if (fixed_index >= 0)
+            {
+                _fixed_io_count.fetch_add(1, std::memory_order_relaxed);
+                submit(opcode, fd, iov->iov_base, (uint32_t)iov->iov_len, aio->file_offset, fixed_index, 0, (uint64_t)(uintptr_t)aio);
+            }
+            else
+                submit(opcode, fd, iov, (uint32_t)iovcnt, aio->file_offset, -1, 0, (uint64_t)(uintptr_t)aio);
+        }
+
+        void io_uring_aio_provider::sync_aio(uring_disk_aio_context* aio, const struct iovec* iov, int iovcnt)
+        {
+            int fd = static_cast<int>((ssize_t)aio->file);
+            ssize_t ret;
+            switch (aio->type)
+            {
+            case AIO_Read:
+                ret = ::preadv(fd, iov, iovcnt, (off_t)aio->file_offset);
+                break;
+            case AIO_Write:
+                ret = ::pwritev(fd, iov, iovcnt, (off_t)aio->file_offset);
+                break;
+            default:
+                derror("unknown aio type %u", static_cast<int>(aio->type));
+                ret = -1;
+                errno = EINVAL;
+                break;
+            }
+            complete_aio(aio, ret >= 0 ? (int)ret : -errno);
+        }
+
+        void io_uring_aio_provider::submit(uint8_t opcode, int fd, const void* addr, uint32_t len, uint64_t offset,
+            int fixed_index, uint32_t op_flags, uint64_t user_data)
+        {
+            utils::auto_lock<utils::ex_lock_nr> l(_sq_lock);
+
+            unsigned tail = *_sq_tail;
+            unsigned head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+            while (tail - head >= _sq_entries)
+            {
+                // queued entries are not consumed by the kernel yet (e.g., the completion
+                // queue overflows), retry until the completion thread reaps some events
+                sys_io_uring_enter(_ring_fd, tail - head, 0, 0);
+                std::this_thread::yield();
+                head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+            }
+
+            unsigned index = tail & _sq_mask;
+            struct io_uring_sqe* sqe = &_sqes[index];
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = opcode;
+            sqe->fd = fd;
+            sqe->off = offset;
+            sqe->addr = (uint64_t)(uintptr_t)addr;
+            sqe->len = len;
+            sqe->fsync_flags = op_flags;
+            if (fixed_index >= 0)
+                sqe->buf_index = (uint16_t)fixed_index;
+            sqe->user_data = user_data;
+
+            _sq_array[index] = index;
+            __atomic_store_n(_sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+            // entries left in the queue on EBUSY/EAGAIN are submitted by the next enter,
+            // including the one of the completion thread
+            int ret = sys_io_uring_enter(_ring_fd, tail + 1 - head, 0, 0);
+            if (ret < 0 && errno != EINTR && errno != EBUSY && errno != EAGAIN)
+            {
+                dassert(false, "io_uring_enter failed, err = %s", strerror(errno));
+            }
+        }
+
+        void io_uring_aio_provider::get_event()
+        {
+            const char* name = ::dsn::tools::get_service_node_name(node());
+            char buffer[128];
+            sprintf(buffer, "%s.aio", name);
+            task_worker::set_name(buffer);
+
+            while (true)
+            {
+                unsigned pending = __atomic_load_n(_sq_tail, __ATOMIC_ACQUIRE) - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+                int ret = sys_io_uring_enter(_ring_fd, pending, 1, IORING_ENTER_GETEVENTS);
+                if (ret < 0 && errno != EINTR)
+                {
+                    dwarn("io_uring_enter returns %d, err = %s", ret, strerror(errno));
+                }
+
+                unsigned head = *_cq_head;
+                unsigned tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+                while (head != tail)
+                {
+                    struct io_uring_cqe* cqe = &_cqes[head & _cq_mask];
+                    uint64_t user_data = cqe->user_data;
+                    int res = cqe->res;
+                    head++;
+
+                    // release the slot before completing, as completions may submit new ios
+                    __atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+
+                    if (user_data & SYNC_OP_TAG)
+                    {
+                        auto ctx = (sync_op_context*)(uintptr_t)(user_data & ~SYNC_OP_TAG);
+                        ctx->res = res;
+                        ctx->evt.notify();
+                    }
+                    else
+                    {
+                        complete_aio((uring_disk_aio_context*)(uintptr_t)user_data, res);
+                    }
+                }
+            }
+        }
+
+        void io_uring_aio_provider::complete_aio(uring_disk_aio_context* aio, int res)
+        {
+            error_code ec;
+            uint32_t bytes = 0;
+            if (res < 0)
+            {
+                derror("aio error, err = %s", strerror(-res));
+                ec = ERR_FILE_OPERATION_FAILED;
+            }
+            else
+            {
+                bytes = (uint32_t)res;
+                ec = bytes > 0 ? ERR_OK : ERR_HANDLE_EOF;
+            }
+
+            complete_io(aio->tsk, ec, bytes);
+        }
+    }
+} // end namespace dsn::tools
+
+# endif
@@ -0,0 +1,157 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     aio provider based on linux io_uring
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# pragma once
+
+# if defined(__linux__) && defined(__has_include)
+# if __has_include(<linux/io_uring.h>)
+# define DSN_HAS_IO_URING 1
+# endif
+# endif
+
+# ifdef DSN_HAS_IO_URING
+
+# include <dsn/tool_api.h>
+# include <dsn/utility/synchronize.h>
+# include <linux/io_uring.h>
+# include <sys/uio.h>
+# include <atomic>
+# include <map>
+# include <vector>
+
+namespace dsn {
+    namespace tools {
+
+        //
+        // io_uring_aio_provider submits reads, writes and flushes to an io_uring, which
+        // is asynchronous for both buffered and direct (O_DIRECT) files, unlike libaio
+        // which blocks in io_submit on buffered files:
+        // - submissions are serialized by a lock, each one enters the kernel at once, and
+        //   one thread reaps the completions
+        // - buffers inside transient memory blocks (see on_transient_block) use the
+        //   registered fixed buffer ops, which save pinning the pages for every io
+        // - batched and vector writes are issued as one WRITEV over all the buffers
+        // - when io_uring is not available (e.g., old kernels or blocked by seccomp),
+        //   io is done synchronously with preadv/pwritev
+        //
+        class io_uring_aio_provider : public aio_provider
+        {
+        public:
+            io_uring_aio_provider(disk_engine* disk, aio_provider* inner_provider);
+            ~io_uring_aio_provider();
+
+            virtual dsn_handle_t open(const char* file_name, int flag, int pmode) override;
+            virtual error_code close(dsn_handle_t fh) override;
+            virtual error_code flush(dsn_handle_t fh) override;
+            virtual error_code flush_data(dsn_handle_t fh) override;
+            virtual void    writeback_hint(dsn_handle_t fh, uint64_t offset, uint64_t size) override;
+            virtual void    aio(aio_task* aio) override;
+            virtual disk_aio* prepare_aio_context(aio_task* tsk) override;
+
+            virtual void start(io_modifer& ctx) override;
+            virtual void on_transient_block(void* ptr, size_t size, bool allocated) override;
+            virtual bool vectored_write_supported() const override { return true; }
+
+            struct uring_disk_aio_context : public disk_aio
+            {
+                struct iovec iov;
+                std::vector<struct iovec> iovs; // for vectored writes
+                aio_task* tsk;
+            };
+
+            bool is_uring_enabled() const { return _ring_fd >= 0; }
+            int  fixed_buffer_count() const;
+            int  fixed_buffer_capacity() const; // 0 when fixed buffers are not supported
+            uint64_t fixed_io_count() const { return _fixed_io_count.load(std::memory_order_relaxed); }
+
+        private:
+            // completion of flushes, whose user_data is tagged with SYNC_OP_TAG
+            struct sync_op_context
+            {
+                utils::notify_event evt;
+                int                 res;
+            };
+
+            static const uint64_t SYNC_OP_TAG = 1;
+
+            bool setup(unsigned entries);
+            void setup_fixed_buffers(unsigned count);
+            void submit(uint8_t opcode, int fd, const void* addr, uint32_t len, uint64_t offset,
+                        int fixed_index, uint32_t op_flags, uint64_t user_data);
+            int  find_fixed_buffer(const void* ptr, size_t size);
+            void get_event();
+            void complete_aio(uring_disk_aio_context* aio, int res);
+            error_code flush_internal(dsn_handle_t fh, bool datasync);
+            void sync_aio(uring_disk_aio_context* aio, const struct iovec* iov, int iovcnt);
+
+        private:
+            int                 _ring_fd;
+            bool                _flush_datasync;
+
+            // submission queue, protected by _sq_lock
+            utils::ex_lock_nr   _sq_lock;
+            void*               _sq_ring;
+            size_t              _sq_ring_bytes;
+            unsigned*           _sq_head;
+            unsigned*           _sq_tail;
+            unsigned            _sq_mask;
+            unsigned            _sq_entries;
+            unsigned*           _sq_array;
+            struct io_uring_sqe* _sqes;
+            size_t              _sqes_bytes;
+
+            // completion queue, only accessed by the completion thread
+            void*               _cq_ring;
+            size_t              _cq_ring_bytes;
+            unsigned*           _cq_head;
+            unsigned*           _cq_tail;
+            unsigned            _cq_mask;
+            struct io_uring_cqe* _cqes;
+
+            // registered fixed buffers, base address -> (size, index)
+            struct fixed_buffer
+            {
+                size_t size;
+                int    index;
+            };
+            mutable utils::ex_lock_nr _fixed_lock;
+            std::map<uintptr_t, fixed_buffer> _fixed_buffers;
+            std::vector<int>    _free_fixed_slots;
+            std::atomic<uint64_t> _fixed_io_count;
+        };
+    }
+}
+
+# endif
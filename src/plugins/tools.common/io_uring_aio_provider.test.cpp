@@ -0,0 +1,160 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     Unit-test for io_uring_aio_provider.
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+#include "io_uring_aio_provider.linux.h"
+
+#ifdef DSN_HAS_IO_URING
+
+#include <gtest/gtest.h>
+#include <dsn/service_api_cpp.h>
+#include <dsn/tool_api.h>
+#include <dsn/cpp/test_utils.h>
+#include <cstring>
+#include <iostream>
+#include <list>
+
+using namespace ::dsn;
+using namespace ::dsn::tools;
+
+// reported loudly instead of passing silently when (part of) the test cannot run
+static void report_io_uring_skip(const char* reason)
+{
+    std::cout << "[  SKIPPED ] tools_common.io_uring_aio_provider: " << reason << std::endl;
+    dwarn("tools_common.io_uring_aio_provider is skipped: %s", reason);
+}
+
+TEST(tools_common, io_uring_aio_provider)
+{
+    // if in dsn_mimic_app() and disk_io_mode == IOE_PER_QUEUE
+    if (task::get_current_disk() == nullptr)
+    {
+        report_io_uring_skip("no disk engine on this thread");
+        return;
+    }
+
+    auto provider = dynamic_cast<io_uring_aio_provider*>(aio_provider::get_current());
+    if (provider == nullptr)
+    {
+        report_io_uring_skip("[core] aio_factory_name is not dsn::tools::io_uring_aio_provider");
+        return;
+    }
+    if (!provider->is_uring_enabled())
+    {
+        report_io_uring_skip("io_uring is not available");
+        return;
+    }
+
+    const int block = 4096;
+    const int count = 64;
+
+    // the buffers are larger than the default transient memory block (tls_trans_memory_KB),
+    // so they are in a new block, which is registered as a fixed buffer when it is allocated
+    const uint32_t buffer_bytes = 2 * 1024 * 1024;
+    char* buffer = (char*)dsn_transient_malloc(buffer_bytes);
+    char* data = buffer;
+    char* rdata = buffer + buffer_bytes / 2;
+    for (int i = 0; i < block * count; i++)
+        data[i] = (char)(i * 31 + i / block);
+    memset(rdata, 0, block * count);
+
+    bool fixed = provider->fixed_buffer_capacity() > 0;
+    if (fixed)
+    {
+        EXPECT_GT(provider->fixed_buffer_count(), 0);
+    }
+    else
+    {
+        report_io_uring_skip("fixed buffers are not supported, only the non-fixed ops are tested");
+    }
+    uint64_t fixed_ios = provider->fixed_io_count();
+
+    auto fp = dsn_file_open("tmp.io_uring", O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0666);
+    ASSERT_TRUE(fp != nullptr);
+
+    // concurrent writes, so that several sqes are in flight
+    std::list<task_ptr> tasks;
+    for (int i = 0; i < count; i++)
+    {
+        auto t = ::dsn::file::write(fp, data + i * block, block, (uint64_t)i * block,
+            LPC_AIO_TEST, nullptr, dsn::empty_callback);
+        tasks.push_back(t);
+    }
+    for (auto& t : tasks)
+    {
+        t->wait();
+        EXPECT_EQ(ERR_OK, t->error());
+        EXPECT_EQ((size_t)block, t->io_size());
+    }
+
+    EXPECT_EQ(ERR_OK, dsn_file_flush(fp));
+
+    // read back in reverse order
+    tasks.clear();
+    for (int i = count - 1; i >= 0; i--)
+    {
+        auto t = ::dsn::file::read(fp, rdata + i * block, block, (uint64_t)i * block,
+            LPC_AIO_TEST, nullptr, dsn::empty_callback);
+        tasks.push_back(t);
+    }
+    for (auto& t : tasks)
+    {
+        t->wait();
+        EXPECT_EQ(ERR_OK, t->error());
+        EXPECT_EQ((size_t)block, t->io_size());
+    }
+    EXPECT_EQ(0, memcmp(data, rdata, block * count));
+
+    // the writes and reads in the transient block are done with the fixed ops
+    if (fixed)
+    {
+        EXPECT_GE(provider->fixed_io_count(), fixed_ios + 2 * count);
+    }
+
+    // reading past the end of file, with a buffer not in any transient block
+    char small[16];
+    auto t = ::dsn::file::read(fp, small, (int)sizeof(small), (uint64_t)block * count,
+        LPC_AIO_TEST, nullptr, dsn::empty_callback);
+    t->wait();
+    EXPECT_EQ(ERR_HANDLE_EOF, t->error());
+    EXPECT_EQ(0u, t->io_size());
+
+    EXPECT_EQ(ERR_OK, dsn_file_close(fp));
+    ::remove("tmp.io_uring");
+
+    // the block is unregistered when it is returned to the heap
+    dsn_transient_free(buffer);
+}
+
+#endif
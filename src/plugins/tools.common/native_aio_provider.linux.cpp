@@ -38,6 +38,9 @@
 
 # include <fcntl.h>
 # include <cstdlib>
+# include <algorithm>
+# include <memory>
+# include <thread>
 
 # ifdef __TITLE__
 # undef __TITLE__
@@ -48,11 +51,28 @@ namespace dsn {
     namespace tools {
 
         native_linux_aio_provider::native_linux_aio_provider(disk_engine* disk, aio_provider* inner_provider)
-            : aio_provider(disk, inner_provider)
+            : aio_provider(disk, inner_provider), _submit_blocked(false), _submitting(false),
+            _inflight(0), _reaped_count(0)
         {
+            _max_events = (int)dsn_config_get_value_uint64("aio", "native_aio_max_events", 128,
+                "max in-flight iocbs of each native linux aio context (io_setup)");
+            _submit_batch_size = (int)dsn_config_get_value_uint64("aio", "native_aio_submit_batch_size", 64,
+                "max iocbs submitted by one io_submit call");
+            _reap_batch_size = (int)dsn_config_get_value_uint64("aio", "native_aio_reap_batch_size", 64,
+                "max events reaped by one io_getevents call");
+            _completion_threads = (int)dsn_config_get_value_uint64("aio", "native_aio_completion_threads", 1,
+                "how many threads reap completions from each native linux aio context");
+
+            _max_events = std::max(_max_events, 1);
+            _submit_batch_size = std::max(std::min(_submit_batch_size, _max_events), 1);
+            _reap_batch_size = std::max(std::min(_reap_batch_size, _max_events), 1);
+            _completion_threads = std::max(_completion_threads, 1);
+
+            _pending.reserve(_submit_batch_size);
+            _submitting_cbs.reserve(_submit_batch_size);
 
             memset(&_ctx, 0, sizeof(_ctx));
-            auto ret = io_setup(128, &_ctx); // 128 concurrent events
+            auto ret = io_setup(_max_events, &_ctx);
             dassert(ret == 0, "io_setup error, ret = %d", ret);
         }
 
@@ -64,11 +84,17 @@ namespace dsn {
 
         void native_linux_aio_provider::start(io_modifer& ctx)
         {
-            new std::thread([this, ctx]()
+            std::string affinity_cpus = dsn_config_get_value_string("aio", "event_thread_affinity_cpus", "",
+                "what CPU cores the aio completion thread is pinned to, as a cpuset list (e.g., 0-3) or numa nodes (e.g., node:0), empty for not pinned");
+            for (int i = 0; i < _completion_threads; i++)
             {
-                task::set_tls_dsn_context(node(), nullptr, ctx.queue);
-                get_event();
-            });
+                new std::thread([this, ctx, affinity_cpus, i]()
+                {
+                    task::set_tls_dsn_context(node(), nullptr, ctx.queue);
+                    task_worker::pin_current_thread(affinity_cpus.c_str(), true);
+                    get_event(i);
+                });
+            }
         }
 
         dsn_handle_t native_linux_aio_provider::open(const char* file_name, int flag, int pmode)
@@ -107,6 +133,27 @@ namespace dsn {
             }
         }
 
+        error_code native_linux_aio_provider::flush_data(dsn_handle_t fh)
+        {
+            if (fh == DSN_INVALID_FILE_HANDLE || ::fdatasync((int)(uintptr_t)(fh)) == 0)
+            {
+                return ERR_OK;
+            }
+            else
+            {
+                derror("flush file data failed, err = %s", strerror(errno));
+                return ERR_FILE_OPERATION_FAILED;
+            }
+        }
+
+        void native_linux_aio_provider::writeback_hint(dsn_handle_t fh, uint64_t offset, uint64_t size)
+        {
+            if (fh != DSN_INVALID_FILE_HANDLE)
+            {
+                ::sync_file_range((int)(uintptr_t)(fh), (off64_t)offset, (off64_t)size, SYNC_FILE_RANGE_WRITE);
+            }
+        }
+
         disk_aio* native_linux_aio_provider::prepare_aio_context(aio_task* tsk)
         {
             auto r = new linux_disk_aio_context;
@@ -122,36 +169,69 @@ namespace dsn {
             err.end_tracking();
         }
 
-        void native_linux_aio_provider::get_event()
+        void native_linux_aio_provider::get_event(int index)
         {
-            struct io_event events[1];
+            std::unique_ptr<struct io_event[]> events(new struct io_event[_reap_batch_size]);
             int ret;
 
             const char* name = ::dsn::tools::get_service_node_name(node());
             char buffer[128];
-            sprintf(buffer, "%s.aio", name);
+            if (_completion_threads > 1)
+                sprintf(buffer, "%s.aio.%d", name, index);
+            else
+                sprintf(buffer, "%s.aio", name);
             task_worker::set_name(buffer);
 
             while (true)
             {
-                ret = io_getevents(_ctx, 1, 1, events, NULL);
-                if (ret > 0) // should be 1
-                {
-                    dassert(ret == 1, "");
-                    struct iocb *io = events[0].obj;
-                    complete_aio(io, static_cast<int>(events[0].res), static_cast<int>(events[0].res2));
-                }
-                else
+                ret = reap_events(events.get());
+                if (ret < 0 && ret != -EINTR)
                 {
                     dwarn("io_getevents returns %d, you probably want to try on another machine:-(", ret);
                 }
             }
         }
 
+        int native_linux_aio_provider::reap_events(struct io_event* events)
+        {
+            int ret = io_getevents(_ctx, 1, _reap_batch_size, events, NULL);
+            if (ret <= 0)
+                return ret;
+
+            _inflight.fetch_sub(ret);
+            for (int i = 0; i < ret; i++)
+            {
+                struct iocb *io = events[i].obj;
+                complete_aio(io, static_cast<int>(events[i].res), static_cast<int>(events[i].res2));
+            }
+
+            // the reaped events make room in the context, so resubmit the iocbs
+            // deferred by a full context (see submit_pending)
+            _reaped_count.fetch_add(ret);
+            bool resubmit;
+            {
+                utils::auto_lock<utils::ex_lock_nr_spin> l(_pending_lock);
+                resubmit = _submit_blocked;
+                _submit_blocked = false;
+            }
+            if (resubmit)
+            {
+                submit_pending();
+            }
+            return ret;
+        }
+
         void native_linux_aio_provider::complete_aio(struct iocb* io, int bytes, int err)
         {
             linux_disk_aio_context* aio = CONTAINING_RECORD(io, linux_disk_aio_context, cb);
             error_code ec;
+            if (err == 0 && bytes < 0)
+            {
+                // res carries the negative errno on failure
+                err = -bytes;
+                bytes = 0;
+            }
+
             if (err != 0)
             {
                 derror("aio error, err = %s", strerror(err));
@@ -175,11 +255,116 @@ namespace dsn {
             }
         }
 
+        void native_linux_aio_provider::submit(struct iocb* cb)
+        {
+            {
+                utils::auto_lock<utils::ex_lock_nr_spin> l(_pending_lock);
+                _pending.push_back(cb);
+            }
+            submit_pending();
+        }
+
+        void native_linux_aio_provider::submit_pending()
+        {
+            while (true)
+            {
+                bool expected = false;
+                if (!_submitting.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                {
+                    // the current submitter picks up what we queued
+                    return;
+                }
+
+                while (true)
+                {
+                    _submitting_cbs.clear();
+                    {
+                        utils::auto_lock<utils::ex_lock_nr_spin> l(_pending_lock);
+                        if (_pending.empty() || _submit_blocked)
+                            break;
+                        _submitting_cbs.swap(_pending);
+                    }
+
+                    for (size_t i = 0; i < _submitting_cbs.size();)
+                    {
+                        int count = std::min((int)(_submitting_cbs.size() - i), _submit_batch_size);
+                        uint64_t reaped = _reaped_count.load();
+                        int done = submit_batch(&_submitting_cbs[i], count);
+                        i += done;
+                        if (done == count)
+                            continue;
+
+                        // the context is full; we may be running on the only completion
+                        // thread (e.g., resubmitting from a completion callback), so we
+                        // must not wait here, instead the rest are requeued in order and
+                        // resubmitted by the completion thread after it reaps events
+                        {
+                            utils::auto_lock<utils::ex_lock_nr_spin> l(_pending_lock);
+                            _pending.insert(_pending.begin(), _submitting_cbs.begin() + i, _submitting_cbs.end());
+                            _submit_blocked = true;
+                        }
+
+                        // events reaped after our io_submit may have missed the flag above,
+                        // in which case we retry by ourselves
+                        if (_reaped_count.load() != reaped)
+                        {
+                            utils::auto_lock<utils::ex_lock_nr_spin> l(_pending_lock);
+                            _submit_blocked = false;
+                        }
+                        break;
+                    }
+                }
+
+                _submitting.store(false, std::memory_order_release);
+
+                // iocbs queued after our last check but before the flag is cleared
+                // are not picked up by their submitters, so check once more
+                utils::auto_lock<utils::ex_lock_nr_spin> l(_pending_lock);
+                if (_pending.empty() || _submit_blocked)
+                    return;
+            }
+        }
+
+        int native_linux_aio_provider::submit_batch(struct iocb** cbs, int count)
+        {
+            int done = 0;
+            while (done < count)
+            {
+                int ret = submit_iocbs(cbs + done, count - done);
+                if (ret > 0)
+                {
+                    _inflight.fetch_add(ret);
+                    done += ret;
+                }
+                else if (ret == -EINTR)
+                {
+                    continue;
+                }
+                else if (ret == -EAGAIN && _inflight.load() > 0)
+                {
+                    // context full, the rest are submitted after some events are reaped
+                    break;
+                }
+                else
+                {
+                    // the first iocb is bad, or the context is out of resource while
+                    // nothing is in flight to be reaped, fail it and go on with the rest
+                    derror("io_submit error, ret = %d", ret);
+                    complete_aio(cbs[done], 0, ret < 0 ? -ret : EIO);
+                    done++;
+                }
+            }
+            return done;
+        }
+
+        int native_linux_aio_provider::submit_iocbs(struct iocb** cbs, int count)
+        {
+            return io_submit(_ctx, count, cbs);
+        }
+
         error_code native_linux_aio_provider::aio_internal(aio_task* aio_tsk, bool async, /*out*/ uint32_t* pbytes /*= nullptr*/)
         {
-            struct iocb *cbs[1];
             linux_disk_aio_context * aio;
-            int ret;
 
             aio = (linux_disk_aio_context *)aio_tsk->aio();
 
@@ -193,7 +378,21 @@ namespace dsn {
                 io_prep_pread(&aio->cb, static_cast<int>((ssize_t)aio->file), aio->buffer, aio->buffer_size, aio->file_offset);
                 break;
             case AIO_Write:
-                io_prep_pwrite(&aio->cb, static_cast<int>((ssize_t)aio->file), aio->buffer, aio->buffer_size, aio->file_offset);
+                if (!aio_tsk->_unmerged_write_buffers.empty())
+                {
+                    auto& buffers = aio_tsk->_unmerged_write_buffers;
+                    aio->iovs.resize(buffers.size());
+                    for (size_t i = 0; i < buffers.size(); i++)
+                    {
+                        aio->iovs[i].iov_base = buffers[i].buffer;
+                        aio->iovs[i].iov_len = (size_t)buffers[i].size;
+                    }
+                    io_prep_pwritev(&aio->cb, static_cast<int>((ssize_t)aio->file), aio->iovs.data(), (int)aio->iovs.size(), aio->file_offset);
+                }
+                else
+                {
+                    io_prep_pwrite(&aio->cb, static_cast<int>((ssize_t)aio->file), aio->buffer, aio->buffer_size, aio->file_offset);
+                }
                 break;
             default:
                 derror("unknown aio type %u", static_cast<int>(aio->type));
@@ -206,44 +405,22 @@ namespace dsn {
                 aio->bytes = 0;
             }
 
-            cbs[0] = &aio->cb;
-            ret = io_submit(_ctx, 1, cbs);
+            submit(&aio->cb);
 
-            if (ret != 1)
+            if (async)
             {
-                if (ret < 0)
-                    derror("io_submit error, ret = %d", ret);
-                else
-                    derror("could not sumbit IOs, ret = %d", ret);
-
-                if (async)
-                {
-                    complete_io(aio_tsk, ERR_FILE_OPERATION_FAILED, 0);
-                }
-                else
-                {
-                    delete aio->evt;
-                    aio->evt = nullptr;
-                }
-                return ERR_FILE_OPERATION_FAILED;
+                return ERR_IO_PENDING;
             }
-            else 
+            else
             {
-                if (async)
-                {
-                    return ERR_IO_PENDING;
-                }
-                else
+                aio->evt->wait();
+                delete aio->evt;
+                aio->evt = nullptr;
+                if (pbytes != nullptr)
                 {
-                    aio->evt->wait();
-                    delete aio->evt;
-                    aio->evt = nullptr;
-                    if (pbytes != nullptr)
-                    {
-                        *pbytes = aio->bytes;
-                    }
-                    return aio->err;
+                    *pbytes = aio->bytes;
                 }
+                return aio->err;
             }
         }
     }
@@ -41,12 +41,15 @@
 # include <dsn/tool_api.h>
 # include <dsn/utility/synchronize.h>
 # include <queue>
+# include <vector>
+# include <atomic>
 # include <cinttypes>     /* uint64_t */
 # include <cstring>       /* memset() */
 # include <cstdio>        /* for perror() */
 # include <sys/syscall.h> /* for __NR_* definitions */
 # include <libaio.h>
 # include <fcntl.h>       /* O_RDWR */
+# include <sys/uio.h>     /* struct iovec */
 
 namespace dsn {
     namespace tools {
@@ -60,14 +63,18 @@ namespace dsn {
             virtual dsn_handle_t open(const char* file_name, int flag, int pmode) override;
             virtual error_code close(dsn_handle_t fh) override;
             virtual error_code flush(dsn_handle_t fh) override;
+            virtual error_code flush_data(dsn_handle_t fh) override;
+            virtual void    writeback_hint(dsn_handle_t fh, uint64_t offset, uint64_t size) override;
             virtual void    aio(aio_task* aio) override;
             virtual disk_aio* prepare_aio_context(aio_task* tsk) override;
 
             virtual void start(io_modifer& ctx) override;
+            virtual bool vectored_write_supported() const override { return true; }
 
             struct linux_disk_aio_context : public disk_aio
             {
                 struct iocb cb;
+                std::vector<struct iovec> iovs; // for vectored writes
                 aio_task* tsk;
                 native_linux_aio_provider* this_;
                 utils::notify_event* evt;
@@ -78,10 +85,40 @@ namespace dsn {
         protected:
             error_code aio_internal(aio_task* aio, bool async, /*out*/ uint32_t* pbytes = nullptr);
             void complete_aio(struct iocb* io, int bytes, int err);
-            void get_event();
+            void get_event(int index);
+
+            // wait for and complete at least one event, then resubmit the iocbs
+            // deferred by a full context; returns what io_getevents returns
+            int reap_events(struct io_event* events);
+
+            // queue the iocb and submit all queued iocbs in batches, see submit_pending
+            void submit(struct iocb* cb);
+            void submit_pending();
+
+            // returns how many iocbs are submitted or failed, less than count when
+            // the context is full
+            int submit_batch(struct iocb** cbs, int count);
+
+            // io_submit, virtual for fault injection in tests
+            virtual int submit_iocbs(struct iocb** cbs, int count);
 
         private:
             io_context_t _ctx;
+            int          _max_events;         // max in-flight iocbs of the context
+            int          _submit_batch_size;  // max iocbs per io_submit
+            int          _reap_batch_size;    // max events per io_getevents
+            int          _completion_threads;
+
+            // iocbs waiting for submission; whoever wins _submitting submits
+            // them all, so iocbs queued meanwhile ride on the same syscall
+            ::dsn::utils::ex_lock_nr_spin _pending_lock;
+            std::vector<struct iocb*>     _pending;
+            std::vector<struct iocb*>     _submitting_cbs; // owned by the current submitter
+            bool                          _submit_blocked; // context full, wait for reaping
+            std::atomic<bool>             _submitting;
+
+            std::atomic<int64_t>          _inflight;       // submitted but not reaped iocbs
+            std::atomic<uint64_t>         _reaped_count;
         };
     }
 }
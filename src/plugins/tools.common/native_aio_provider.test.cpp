@@ -0,0 +1,159 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     Unit-test for native_linux_aio_provider.
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+#ifdef __linux__
+
+#include "native_aio_provider.linux.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <unistd.h>
+
+using namespace ::dsn;
+using namespace ::dsn::tools;
+
+class native_aio_provider_for_test : public native_linux_aio_provider
+{
+public:
+    native_aio_provider_for_test()
+        : native_linux_aio_provider(nullptr, nullptr), eagain_calls(0), submit_calls(0)
+    {
+    }
+
+    // the completion is notified through the event instead of the disk engine
+    linux_disk_aio_context* prepare_write(int fd, char* buffer, uint32_t size, uint64_t offset)
+    {
+        auto aio = new linux_disk_aio_context;
+        aio->tsk = nullptr;
+        aio->this_ = this;
+        aio->evt = new utils::notify_event();
+        aio->err = ERR_OK;
+        aio->bytes = 0;
+        io_prep_pwrite(&aio->cb, fd, buffer, size, offset);
+        return aio;
+    }
+
+    using native_linux_aio_provider::submit;
+    using native_linux_aio_provider::reap_events;
+
+    int eagain_calls; // how many of the following io_submit calls fail with -EAGAIN
+    int submit_calls;
+
+protected:
+    virtual int submit_iocbs(struct iocb** cbs, int count) override
+    {
+        submit_calls++;
+        if (eagain_calls > 0)
+        {
+            eagain_calls--;
+            return -EAGAIN;
+        }
+        return native_linux_aio_provider::submit_iocbs(cbs, count);
+    }
+};
+
+TEST(tools_common, native_aio_provider_eagain)
+{
+    // no completion thread is started, the events are reaped by this thread
+    native_aio_provider_for_test p;
+    std::unique_ptr<struct io_event[]> events(new struct io_event[1024]);
+
+    int fd = ::open("tmp.native_aio", O_RDWR | O_CREAT | O_TRUNC, 0666);
+    ASSERT_TRUE(fd >= 0);
+
+    char data[4][512];
+    for (int i = 0; i < 4; i++)
+        memset(data[i], 'a' + i, sizeof(data[i]));
+
+    auto a = p.prepare_write(fd, data[0], 512, 0);
+    p.submit(&a->cb);
+    EXPECT_EQ(1, p.submit_calls);
+
+    // the context is full while a is in flight, so b is deferred instead of
+    // waiting in the submitter, and c is queued behind it without io_submit
+    p.eagain_calls = 1;
+    auto b = p.prepare_write(fd, data[1], 512, 512);
+    p.submit(&b->cb);
+    EXPECT_EQ(2, p.submit_calls);
+    auto c = p.prepare_write(fd, data[2], 512, 1024);
+    p.submit(&c->cb);
+    EXPECT_EQ(2, p.submit_calls);
+    EXPECT_FALSE(b->evt->wait_for(0));
+    EXPECT_FALSE(c->evt->wait_for(0));
+
+    // reaping a resubmits b and c with one io_submit
+    int reaped = 0;
+    while (reaped < 3)
+    {
+        int ret = p.reap_events(events.get());
+        ASSERT_GT(ret, 0);
+        reaped += ret;
+    }
+    EXPECT_EQ(3, p.submit_calls);
+
+    for (auto aio : { a, b, c })
+    {
+        aio->evt->wait();
+        EXPECT_EQ(ERR_OK, aio->err);
+        EXPECT_EQ(512u, aio->bytes);
+    }
+
+    char rdata[1536];
+    EXPECT_EQ((ssize_t)sizeof(rdata), ::pread(fd, rdata, sizeof(rdata), 0));
+    EXPECT_EQ(0, memcmp(rdata, data, sizeof(rdata)));
+
+    // out of resource with nothing in flight, the io fails as nothing can be reaped
+    p.eagain_calls = 1;
+    auto d = p.prepare_write(fd, data[3], 512, 1536);
+    p.submit(&d->cb);
+    d->evt->wait();
+    EXPECT_EQ(ERR_FILE_OPERATION_FAILED, d->err);
+
+    // still usable afterwards
+    auto e = p.prepare_write(fd, data[3], 512, 1536);
+    p.submit(&e->cb);
+    EXPECT_EQ(1, p.reap_events(events.get()));
+    e->evt->wait();
+    EXPECT_EQ(ERR_OK, e->err);
+
+    for (auto aio : { a, b, c, d, e })
+    {
+        delete aio->evt;
+        delete aio;
+    }
+    ::close(fd);
+    ::remove("tmp.native_aio");
+}
+
+#endif
@@ -95,7 +95,9 @@ namespace dsn {
             new counter_info({ "rpc.client.latency", "rpccl" }, RPC_CLIENT_NON_TIMEOUT_LATENCY_NS,  COUNTER_TYPE_NUMBER_PERCENTILES,    "RPC.CLIENT(ns)",  "ns"),
             new counter_info({ "rpc.client.timeout", "rpcto" }, RPC_CLIENT_TIMEOUT_THROUGHPUT,      COUNTER_TYPE_RATE,                  "TIMEOUT(#/s)",    "#/s"),
             new counter_info({ "task.inqueue", "tiq" },         TASK_IN_QUEUE,                      COUNTER_TYPE_NUMBER,                "InQueue(#)",      "#"),
-            new counter_info({ "task.exec#", "tec" },           TASK_EXEC_COUNT,                    COUNTER_TYPE_NUMBER,                "Exec(#)",         "#")
+            new counter_info({ "task.exec#", "tec" },           TASK_EXEC_COUNT,                    COUNTER_TYPE_NUMBER,                "Exec(#)",         "#"),
+            new counter_info({ "memory.live", "ml" },           MEMORY_LIVE_BYTES,                  COUNTER_TYPE_NUMBER,                "MEM.LIVE(B)",     "B"),
+            new counter_info({ "memory.alloc", "ma" },          MEMORY_ALLOC_RATE,                  COUNTER_TYPE_RATE,                  "MEM.ALLOC(B/s)",  "B/s")
         };
 
         // call normal task
@@ -470,6 +472,14 @@ namespace dsn {
                     "whether to profile the cancelled times of a task"))
                     s_spec_profilers[i].ptr[TASK_CANCELLED] = perf_counter::get_counter("tools", "profiler", (name + std::string(".cancelled#")).c_str(), COUNTER_TYPE_NUMBER, "cancelled times of a specific task type", true);
 
+                // maintained by the core when [core] memory_accounting_sample_bytes is set
+                if (dsn_config_get_value_bool(section_name.c_str(), "profiler::memory", true,
+                    "whether to profile the memory allocated by this kind of tasks"))
+                {
+                    s_spec_profilers[i].ptr[MEMORY_LIVE_BYTES] = perf_counter::get_counter("core", "memory", (name + std::string(".live(bytes)")).c_str(), COUNTER_TYPE_NUMBER, "live bytes of the sampled memory allocations", true);
+                    s_spec_profilers[i].ptr[MEMORY_ALLOC_RATE] = perf_counter::get_counter("core", "memory", (name + std::string(".alloc(bytes/s)")).c_str(), COUNTER_TYPE_RATE, "bytes of the sampled memory allocations per second", true);
+                }
+
                 if (spec->type == dsn_task_type_t::TASK_TYPE_RPC_REQUEST)
                 {
                     if (dsn_config_get_value_bool(section_name.c_str(), "profiler::latency.server", true,
@@ -61,6 +61,8 @@ namespace dsn {
             RPC_CLIENT_TIMEOUT_THROUGHPUT,
             TASK_IN_QUEUE,
             TASK_EXEC_COUNT,
+            MEMORY_LIVE_BYTES,
+            MEMORY_ALLOC_RATE,
 
             PREF_COUNTER_COUNT,
             PREF_COUNTER_INVALID
@@ -41,10 +41,16 @@
 # include "native_aio_provider.win.h"
 # include "native_aio_provider.posix.h"
 # include "native_aio_provider.linux.h"
+# include "io_uring_aio_provider.linux.h"
 # include "simple_perf_counter.h"
 # include "simple_perf_counter_v2_atomic.h"
 # include "simple_perf_counter_v2_fast.h"
 # include "simple_task_queue.h"
+# include "edf_task_queue.h"
+# include "arena_memory_provider.h"
+# include "fair_task_queue.h"
+# include "gradient_admission_controller.h"
+# include "codel_admission_controller.h"
 # include "simple_logger.h"
 # include "empty_aio_provider.h"
 # include "dsn_message_parser.h"
@@ -63,6 +69,7 @@ namespace dsn {
         {
             register_component_provider<env_provider>("dsn::env_provider");
             register_component_provider<memory_provider>("dsn::default_memory_provider");
+            register_component_provider<arena_memory_provider>("dsn::tools::arena_memory_provider");
             register_component_provider<task_worker>("dsn::task_worker");
             register_component_provider<screen_logger>("dsn::tools::screen_logger");
             register_component_provider<simple_logger>("dsn::tools::simple_logger");
@@ -73,6 +80,10 @@ namespace dsn {
             register_component_provider<asio_network_provider>("dsn::tools::asio_network_provider");
             register_component_provider<asio_udp_provider>("dsn::tools::asio_udp_provider");
             register_component_provider<simple_task_queue>("dsn::tools::simple_task_queue");
+            register_component_provider<edf_task_queue>("dsn::tools::edf_task_queue");
+            register_component_provider<fair_task_queue>("dsn::tools::fair_task_queue");
+            register_component_provider<gradient_admission_controller>("dsn::tools::gradient_admission_controller");
+            register_component_provider<codel_admission_controller>("dsn::tools::codel_admission_controller");
             register_component_provider<simple_timer_service>("dsn::tools::simple_timer_service");
             
             register_message_header_parser<dsn_message_parser>(NET_HDR_DSN, {"RDSN"});
@@ -85,6 +96,9 @@ namespace dsn {
 #elif defined(__linux__)
             register_component_provider<native_linux_aio_provider>("dsn::tools::native_aio_provider");
             register_component_provider<native_posix_aio_provider>("dsn::tools::posix_aio_provider");
+# ifdef DSN_HAS_IO_URING
+            register_component_provider<io_uring_aio_provider>("dsn::tools::io_uring_aio_provider");
+# endif
 #else
             register_component_provider<native_posix_aio_provider>("dsn::tools::native_aio_provider");
 #endif
@@ -0,0 +1,520 @@
+/**
+ * Autogenerated by compile_thrift.py
+ *
+ * DO NOT EDIT UNLESS YOU ARE SURE THAT YOU KNOW WHAT YOU ARE DOING
+ *  @generated
+ */
+# pragma once
+# include "nfs_types.h"
+# include <dsn/cpp/serialization_helper/thrift_binary_codec.h>
+
+namespace dsn {
+
+    template<>
+    struct thrift_binary_codec< ::dsn::service::copy_request>
+    {
+        static const bool enabled = true;
+
+        static void write(binary_writer& w, const ::dsn::service::copy_request& v)
+        {
+            thrift_binary::write_field(w, 1, v.source);
+            thrift_binary::write_field(w, 2, v.source_dir);
+            thrift_binary::write_field(w, 3, v.dst_dir);
+            thrift_binary::write_field(w, 4, v.file_name);
+            thrift_binary::write_field(w, 5, v.offset);
+            thrift_binary::write_field(w, 6, v.size);
+            thrift_binary::write_field(w, 7, v.is_last);
+            thrift_binary::write_field(w, 8, v.overwrite);
+            thrift_binary::write_field_stop(w);
+        }
+
+        static void read(binary_reader& r, /*out*/ ::dsn::service::copy_request& v)
+        {
+            ::apache::thrift::protocol::TType type;
+            int16_t id;
+            while (thrift_binary::read_field_begin(r, type, id))
+            {
+                switch (id)
+                {
+                case 1:
+                    if (thrift_binary::read_field(r, type, v.source))
+                        v.__isset.source = true;
+                    break;
+                case 2:
+                    if (thrift_binary::read_field(r, type, v.source_dir))
+                        v.__isset.source_dir = true;
+                    break;
+                case 3:
+                    if (thrift_binary::read_field(r, type, v.dst_dir))
+                        v.__isset.dst_dir = true;
+                    break;
+                case 4:
+                    if (thrift_binary::read_field(r, type, v.file_name))
+                        v.__isset.file_name = true;
+                    break;
+                case 5:
+                    if (thrift_binary::read_field(r, type, v.offset))
+                        v.__isset.offset = true;
+                    break;
+                case 6:
+                    if (thrift_binary::read_field(r, type, v.size))
+                        v.__isset.size = true;
+                    break;
+                case 7:
+                    if (thrift_binary::read_field(r, type, v.is_last))
+                        v.__isset.is_last = true;
+                    break;
+                case 8:
+                    if (thrift_binary::read_field(r, type, v.overwrite))
+                        v.__isset.overwrite = true;
+                    break;
+                default:
+                    thrift_binary::skip(r, type);
+                    break;
+                }
+            }
+        }
+    };
+
+    template<>
+    struct thrift_binary_codec< ::dsn::service::copy_response>
+    {
+        static const bool enabled = true;
+
+        static void write(binary_writer& w, const ::dsn::service::copy_response& v)
+        {
+            thrift_binary::write_field(w, 1, v.error);
+            thrift_binary::write_field(w, 2, v.file_content);
+            thrift_binary::write_field(w, 3, v.offset);
+            thrift_binary::write_field(w, 4, v.size);
+            thrift_binary::write_field_stop(w);
+        }
+
+        static void read(binary_reader& r, /*out*/ ::dsn::service::copy_response& v)
+        {
+            ::apache::thrift::protocol::TType type;
+            int16_t id;
+            while (thrift_binary::read_field_begin(r, type, id))
+            {
+                switch (id)
+                {
+                case 1:
+                    if (thrift_binary::read_field(r, type, v.error))
+                        v.__isset.error = true;
+                    break;
+                case 2:
+                    if (thrift_binary::read_field(r, type, v.file_content))
+                        v.__isset.file_content = true;
+                    break;
+                case 3:
+                    if (thrift_binary::read_field(r, type, v.offset))
+                        v.__isset.offset = true;
+                    break;
+                case 4:
+                    if (thrift_binary::read_field(r, type, v.size))
+                        v.__isset.size = true;
+                    break;
+                default:
+                    thrift_binary::skip(r, type);
+                    break;
+                }
+            }
+        }
+    };
+
+    template<>
+    struct thrift_binary_codec< ::dsn::service::get_file_size_request>
+    {
+        static const bool enabled = true;
+
+        static void write(binary_writer& w, const ::dsn::service::get_file_size_request& v)
+        {
+            thrift_binary::write_field(w, 1, v.source);
+            thrift_binary::write_field(w, 2, v.dst_dir);
+            thrift_binary::write_field(w, 3, v.file_list);
+            thrift_binary::write_field(w, 4, v.source_dir);
+            thrift_binary::write_field(w, 5, v.overwrite);
+            thrift_binary::write_field_stop(w);
+        }
+
+        static void read(binary_reader& r, /*out*/ ::dsn::service::get_file_size_request& v)
+        {
+            ::apache::thrift::protocol::TType type;
+            int16_t id;
+            while (thrift_binary::read_field_begin(r, type, id))
+            {
+                switch (id)
+                {
+                case 1:
+                    if (thrift_binary::read_field(r, type, v.source))
+                        v.__isset.source = true;
+                    break;
+                case 2:
+                    if (thrift_binary::read_field(r, type, v.dst_dir))
+                        v.__isset.dst_dir = true;
+                    break;
+                case 3:
+                    if (thrift_binary::read_field(r, type, v.file_list))
+                        v.__isset.file_list = true;
+                    break;
+                case 4:
+                    if (thrift_binary::read_field(r, type, v.source_dir))
+                        v.__isset.source_dir = true;
+                    break;
+                case 5:
+                    if (thrift_binary::read_field(r, type, v.overwrite))
+                        v.__isset.overwrite = true;
+                    break;
+                default:
+                    thrift_binary::skip(r, type);
+                    break;
+                }
+            }
+        }
+    };
+
+    template<>
+    struct thrift_binary_codec< ::dsn::service::get_file_size_response>
+    {
+        static const bool enabled = true;
+
+        static void write(binary_writer& w, const ::dsn::service::get_file_size_response& v)
+        {
+            thrift_binary::write_field(w, 1, v.error);
+            thrift_binary::write_field(w, 2, v.file_list);
+            thrift_binary::write_field(w, 3, v.size_list);
+            thrift_binary::write_field_stop(w);
+        }
+
+        static void read(binary_reader& r, /*out*/ ::dsn::service::get_file_size_response& v)
+        {
+            ::apache::thrift::protocol::TType type;
+            int16_t id;
+            while (thrift_binary::read_field_begin(r, type, id))
+            {
+                switch (id)
+                {
+                case 1:
+                    if (thrift_binary::read_field(r, type, v.error))
+                        v.__isset.error = true;
+                    break;
+                case 2:
+                    if (thrift_binary::read_field(r, type, v.file_list))
+                        v.__isset.file_list = true;
+                    break;
+                case 3:
+                    if (thrift_binary::read_field(r, type, v.size_list))
+                        v.__isset.size_list = true;
+                    break;
+                default:
+                    thrift_binary::skip(r, type);
+                    break;
+                }
+            }
+        }
+    };
+}
+
+namespace dsn { namespace service {
+
+    typedef struct _copy_request_view__isset {
+        _copy_request_view__isset() : source(false), source_dir(false), dst_dir(false), file_name(false), offset(false), size(false), is_last(false), overwrite(false) {}
+        bool source;
+        bool source_dir;
+        bool dst_dir;
+        bool file_name;
+        bool offset;
+        bool size;
+        bool is_last;
+        bool overwrite;
+    } _copy_request_view__isset;
+
+    struct copy_request_view
+    {
+        explicit copy_request_view(::dsn::request_arena* /*arena*/ = ::dsn::request_arena::current())
+            : offset(0), size(0), is_last(false), overwrite(false)
+        {
+        }
+
+        ::dsn::string_view source_dir_view() const { return ::dsn::string_view(source_dir); }
+        ::dsn::string_view dst_dir_view() const { return ::dsn::string_view(dst_dir); }
+        ::dsn::string_view file_name_view() const { return ::dsn::string_view(file_name); }
+
+        ::dsn::rpc_address source;
+        ::dsn::blob source_dir;
+        ::dsn::blob dst_dir;
+        ::dsn::blob file_name;
+        int64_t offset;
+        int32_t size;
+        bool is_last;
+        bool overwrite;
+
+        _copy_request_view__isset __isset;
+    };
+
+    typedef struct _copy_response_view__isset {
+        _copy_response_view__isset() : error(false), file_content(false), offset(false), size(false) {}
+        bool error;
+        bool file_content;
+        bool offset;
+        bool size;
+    } _copy_response_view__isset;
+
+    struct copy_response_view
+    {
+        explicit copy_response_view(::dsn::request_arena* /*arena*/ = ::dsn::request_arena::current())
+            : offset(0), size(0)
+        {
+        }
+
+        ::dsn::error_code error;
+        ::dsn::blob file_content;
+        int64_t offset;
+        int32_t size;
+
+        _copy_response_view__isset __isset;
+    };
+
+    typedef struct _get_file_size_request_view__isset {
+        _get_file_size_request_view__isset() : source(false), dst_dir(false), file_list(false), source_dir(false), overwrite(false) {}
+        bool source;
+        bool dst_dir;
+        bool file_list;
+        bool source_dir;
+        bool overwrite;
+    } _get_file_size_request_view__isset;
+
+    struct get_file_size_request_view
+    {
+        explicit get_file_size_request_view(::dsn::request_arena* arena = ::dsn::request_arena::current())
+            : file_list(::dsn::arena_allocator< ::dsn::blob>(arena)), overwrite(false)
+        {
+        }
+
+        ::dsn::string_view dst_dir_view() const { return ::dsn::string_view(dst_dir); }
+        ::dsn::string_view source_dir_view() const { return ::dsn::string_view(source_dir); }
+
+        ::dsn::rpc_address source;
+        ::dsn::blob dst_dir;
+        ::dsn::arena_vector< ::dsn::blob> file_list;
+        ::dsn::blob source_dir;
+        bool overwrite;
+
+        _get_file_size_request_view__isset __isset;
+    };
+
+    typedef struct _get_file_size_response_view__isset {
+        _get_file_size_response_view__isset() : error(false), file_list(false), size_list(false) {}
+        bool error;
+        bool file_list;
+        bool size_list;
+    } _get_file_size_response_view__isset;
+
+    struct get_file_size_response_view
+    {
+        explicit get_file_size_response_view(::dsn::request_arena* arena = ::dsn::request_arena::current())
+            : error(0), file_list(::dsn::arena_allocator< ::dsn::blob>(arena)), size_list(::dsn::arena_allocator< int64_t>(arena))
+        {
+        }
+
+        int32_t error;
+        ::dsn::arena_vector< ::dsn::blob> file_list;
+        ::dsn::arena_vector< int64_t> size_list;
+
+        _get_file_size_response_view__isset __isset;
+    };
+} }
+
+namespace dsn {
+
+    template<>
+    struct thrift_binary_codec< ::dsn::service::copy_request_view>
+    {
+        static const bool enabled = true;
+
+        static void read(binary_reader& r, /*out*/ ::dsn::service::copy_request_view& v)
+        {
+            ::apache::thrift::protocol::TType type;
+            int16_t id;
+            while (thrift_binary::read_field_begin(r, type, id))
+            {
+                switch (id)
+                {
+                case 1:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_STRUCT, v.source))
+                        v.__isset.source = true;
+                    break;
+                case 2:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_STRING, v.source_dir))
+                        v.__isset.source_dir = true;
+                    break;
+                case 3:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_STRING, v.dst_dir))
+                        v.__isset.dst_dir = true;
+                    break;
+                case 4:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_STRING, v.file_name))
+                        v.__isset.file_name = true;
+                    break;
+                case 5:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_I64, v.offset))
+                        v.__isset.offset = true;
+                    break;
+                case 6:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_I32, v.size))
+                        v.__isset.size = true;
+                    break;
+                case 7:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_BOOL, v.is_last))
+                        v.__isset.is_last = true;
+                    break;
+                case 8:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_BOOL, v.overwrite))
+                        v.__isset.overwrite = true;
+                    break;
+                default:
+                    thrift_binary::skip(r, type);
+                    break;
+                }
+            }
+        }
+    };
+
+    template<>
+    struct thrift_binary_codec< ::dsn::service::copy_response_view>
+    {
+        static const bool enabled = true;
+
+        static void read(binary_reader& r, /*out*/ ::dsn::service::copy_response_view& v)
+        {
+            ::apache::thrift::protocol::TType type;
+            int16_t id;
+            while (thrift_binary::read_field_begin(r, type, id))
+            {
+                switch (id)
+                {
+                case 1:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_STRUCT, v.error))
+                        v.__isset.error = true;
+                    break;
+                case 2:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_STRUCT, v.file_content))
+                        v.__isset.file_content = true;
+                    break;
+                case 3:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_I64, v.offset))
+                        v.__isset.offset = true;
+                    break;
+                case 4:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_I32, v.size))
+                        v.__isset.size = true;
+                    break;
+                default:
+                    thrift_binary::skip(r, type);
+                    break;
+                }
+            }
+        }
+    };
+
+    template<>
+    struct thrift_binary_codec< ::dsn::service::get_file_size_request_view>
+    {
+        static const bool enabled = true;
+
+        static void read(binary_reader& r, /*out*/ ::dsn::service::get_file_size_request_view& v)
+        {
+            ::apache::thrift::protocol::TType type;
+            int16_t id;
+            while (thrift_binary::read_field_begin(r, type, id))
+            {
+                switch (id)
+                {
+                case 1:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_STRUCT, v.source))
+                        v.__isset.source = true;
+                    break;
+                case 2:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_STRING, v.dst_dir))
+                        v.__isset.dst_dir = true;
+                    break;
+                case 3:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_LIST, v.file_list))
+                        v.__isset.file_list = true;
+                    break;
+                case 4:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_STRING, v.source_dir))
+                        v.__isset.source_dir = true;
+                    break;
+                case 5:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_BOOL, v.overwrite))
+                        v.__isset.overwrite = true;
+                    break;
+                default:
+                    thrift_binary::skip(r, type);
+                    break;
+                }
+            }
+        }
+    };
+
+    template<>
+    struct thrift_binary_codec< ::dsn::service::get_file_size_response_view>
+    {
+        static const bool enabled = true;
+
+        static void read(binary_reader& r, /*out*/ ::dsn::service::get_file_size_response_view& v)
+        {
+            ::apache::thrift::protocol::TType type;
+            int16_t id;
+            while (thrift_binary::read_field_begin(r, type, id))
+            {
+                switch (id)
+                {
+                case 1:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_I32, v.error))
+                        v.__isset.error = true;
+                    break;
+                case 2:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_LIST, v.file_list))
+                        v.__isset.file_list = true;
+                    break;
+                case 3:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_LIST, v.size_list))
+                        v.__isset.size_list = true;
+                    break;
+                default:
+                    thrift_binary::skip(r, type);
+                    break;
+                }
+            }
+        }
+    };
+}
+
+namespace dsn { namespace service {
+
+    inline void unmarshall(::dsn::binary_reader& reader, copy_request_view& value, dsn_msg_serialize_format fmt)
+    {
+        dassert(fmt == DSF_THRIFT_BINARY, "copy_request_view can only be decoded from DSF_THRIFT_BINARY");
+        ::dsn::thrift_binary::unmarshall(reader, value);
+    }
+
+    inline void unmarshall(::dsn::binary_reader& reader, copy_response_view& value, dsn_msg_serialize_format fmt)
+    {
+        dassert(fmt == DSF_THRIFT_BINARY, "copy_response_view can only be decoded from DSF_THRIFT_BINARY");
+        ::dsn::thrift_binary::unmarshall(reader, value);
+    }
+
+    inline void unmarshall(::dsn::binary_reader& reader, get_file_size_request_view& value, dsn_msg_serialize_format fmt)
+    {
+        dassert(fmt == DSF_THRIFT_BINARY, "get_file_size_request_view can only be decoded from DSF_THRIFT_BINARY");
+        ::dsn::thrift_binary::unmarshall(reader, value);
+    }
+
+    inline void unmarshall(::dsn::binary_reader& reader, get_file_size_response_view& value, dsn_msg_serialize_format fmt)
+    {
+        dassert(fmt == DSF_THRIFT_BINARY, "get_file_size_response_view can only be decoded from DSF_THRIFT_BINARY");
+        ::dsn::thrift_binary::unmarshall(reader, value);
+    }
+} }
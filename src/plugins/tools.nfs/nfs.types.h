@@ -1,5 +1,6 @@
 #pragma once
 #include "nfs_types.h"
+#include "nfs.codec.h"
 #include <dsn/service_api_cpp.h>
 #include <dsn/cpp/serialization.h>
 
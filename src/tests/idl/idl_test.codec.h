@@ -0,0 +1,201 @@
+/**
+ * Autogenerated by compile_thrift.py
+ *
+ * DO NOT EDIT UNLESS YOU ARE SURE THAT YOU KNOW WHAT YOU ARE DOING
+ *  @generated
+ */
+# pragma once
+# include "idl_test_types.h"
+# include <dsn/cpp/serialization_helper/thrift_binary_codec.h>
+
+namespace dsn {
+
+    template<>
+    struct thrift_binary_codec< ::dsn::idl::test::test_thrift_item>
+    {
+        static const bool enabled = true;
+
+        static void write(binary_writer& w, const ::dsn::idl::test::test_thrift_item& v)
+        {
+            thrift_binary::write_field(w, 1, v.bool_item);
+            thrift_binary::write_field(w, 2, v.byte_item);
+            thrift_binary::write_field(w, 3, v.i16_item);
+            thrift_binary::write_field(w, 4, v.i32_item);
+            thrift_binary::write_field(w, 5, v.i64_item);
+            thrift_binary::write_field(w, 6, v.double_item);
+            thrift_binary::write_field(w, 7, v.string_item);
+            thrift_binary::write_field(w, 8, v.list_i32_item);
+            thrift_binary::write_field(w, 9, v.set_i32_item);
+            thrift_binary::write_field(w, 10, v.map_i32_item);
+            thrift_binary::write_field_stop(w);
+        }
+
+        static void read(binary_reader& r, /*out*/ ::dsn::idl::test::test_thrift_item& v)
+        {
+            ::apache::thrift::protocol::TType type;
+            int16_t id;
+            while (thrift_binary::read_field_begin(r, type, id))
+            {
+                switch (id)
+                {
+                case 1:
+                    if (thrift_binary::read_field(r, type, v.bool_item))
+                        v.__isset.bool_item = true;
+                    break;
+                case 2:
+                    if (thrift_binary::read_field(r, type, v.byte_item))
+                        v.__isset.byte_item = true;
+                    break;
+                case 3:
+                    if (thrift_binary::read_field(r, type, v.i16_item))
+                        v.__isset.i16_item = true;
+                    break;
+                case 4:
+                    if (thrift_binary::read_field(r, type, v.i32_item))
+                        v.__isset.i32_item = true;
+                    break;
+                case 5:
+                    if (thrift_binary::read_field(r, type, v.i64_item))
+                        v.__isset.i64_item = true;
+                    break;
+                case 6:
+                    if (thrift_binary::read_field(r, type, v.double_item))
+                        v.__isset.double_item = true;
+                    break;
+                case 7:
+                    if (thrift_binary::read_field(r, type, v.string_item))
+                        v.__isset.string_item = true;
+                    break;
+                case 8:
+                    if (thrift_binary::read_field(r, type, v.list_i32_item))
+                        v.__isset.list_i32_item = true;
+                    break;
+                case 9:
+                    if (thrift_binary::read_field(r, type, v.set_i32_item))
+                        v.__isset.set_i32_item = true;
+                    break;
+                case 10:
+                    if (thrift_binary::read_field(r, type, v.map_i32_item))
+                        v.__isset.map_i32_item = true;
+                    break;
+                default:
+                    thrift_binary::skip(r, type);
+                    break;
+                }
+            }
+        }
+    };
+}
+
+namespace dsn { namespace idl { namespace test {
+
+    typedef struct _test_thrift_item_view__isset {
+        _test_thrift_item_view__isset() : bool_item(false), byte_item(false), i16_item(false), i32_item(false), i64_item(false), double_item(false), string_item(false), list_i32_item(false), set_i32_item(false), map_i32_item(false) {}
+        bool bool_item;
+        bool byte_item;
+        bool i16_item;
+        bool i32_item;
+        bool i64_item;
+        bool double_item;
+        bool string_item;
+        bool list_i32_item;
+        bool set_i32_item;
+        bool map_i32_item;
+    } _test_thrift_item_view__isset;
+
+    struct test_thrift_item_view
+    {
+        explicit test_thrift_item_view(::dsn::request_arena* arena = ::dsn::request_arena::current())
+            : bool_item(false), byte_item(0), i16_item(0), i32_item(0), i64_item(0), double_item(0), list_i32_item(::dsn::arena_allocator< int32_t>(arena)), set_i32_item(::dsn::arena_allocator< int32_t>(arena)), map_i32_item(::dsn::arena_allocator< std::pair< int32_t, int32_t> >(arena))
+        {
+        }
+
+        ::dsn::string_view string_item_view() const { return ::dsn::string_view(string_item); }
+
+        bool bool_item;
+        int8_t byte_item;
+        int16_t i16_item;
+        int32_t i32_item;
+        int64_t i64_item;
+        double double_item;
+        ::dsn::blob string_item;
+        ::dsn::arena_vector< int32_t> list_i32_item;
+        ::dsn::arena_vector< int32_t> set_i32_item;
+        ::dsn::arena_vector< std::pair< int32_t, int32_t> > map_i32_item;
+
+        _test_thrift_item_view__isset __isset;
+    };
+} } }
+
+namespace dsn {
+
+    template<>
+    struct thrift_binary_codec< ::dsn::idl::test::test_thrift_item_view>
+    {
+        static const bool enabled = true;
+
+        static void read(binary_reader& r, /*out*/ ::dsn::idl::test::test_thrift_item_view& v)
+        {
+            ::apache::thrift::protocol::TType type;
+            int16_t id;
+            while (thrift_binary::read_field_begin(r, type, id))
+            {
+                switch (id)
+                {
+                case 1:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_BOOL, v.bool_item))
+                        v.__isset.bool_item = true;
+                    break;
+                case 2:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_BYTE, v.byte_item))
+                        v.__isset.byte_item = true;
+                    break;
+                case 3:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_I16, v.i16_item))
+                        v.__isset.i16_item = true;
+                    break;
+                case 4:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_I32, v.i32_item))
+                        v.__isset.i32_item = true;
+                    break;
+                case 5:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_I64, v.i64_item))
+                        v.__isset.i64_item = true;
+                    break;
+                case 6:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_DOUBLE, v.double_item))
+                        v.__isset.double_item = true;
+                    break;
+                case 7:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_STRING, v.string_item))
+                        v.__isset.string_item = true;
+                    break;
+                case 8:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_LIST, v.list_i32_item))
+                        v.__isset.list_i32_item = true;
+                    break;
+                case 9:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_SET, v.set_i32_item))
+                        v.__isset.set_i32_item = true;
+                    break;
+                case 10:
+                    if (thrift_binary::read_field_as(r, type, ::apache::thrift::protocol::T_MAP, v.map_i32_item))
+                        v.__isset.map_i32_item = true;
+                    break;
+                default:
+                    thrift_binary::skip(r, type);
+                    break;
+                }
+            }
+        }
+    };
+}
+
+namespace dsn { namespace idl { namespace test {
+
+    inline void unmarshall(::dsn::binary_reader& reader, test_thrift_item_view& value, dsn_msg_serialize_format fmt)
+    {
+        dassert(fmt == DSF_THRIFT_BINARY, "test_thrift_item_view can only be decoded from DSF_THRIFT_BINARY");
+        ::dsn::thrift_binary::unmarshall(reader, value);
+    }
+} } }
@@ -37,17 +37,52 @@
 # include <gtest/gtest.h>
 # include <dsn/cpp/serialization.h>
 
+# include <dsn/cpp/serialization_helper/dsn.layer2.types.h>
+# include <dsn/cpp/request_arena.h>
+
 # include "idl_test.types.h"
 
+# include <atomic>
+# include <cstring>
 # include <iostream>
+# include <new>
+# include <set>
 # include <vector>
 # include "stdlib.h"
 
+// counts the heap allocations of the process, to check that the view types
+// (see compile_thrift.py) are decoded without heap allocations
+static std::atomic<uint64_t> s_heap_allocations(0);
+
+void* operator new(size_t size)
+{
+    s_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = ::malloc(size == 0 ? 1 : size);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return ::operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    ::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    ::free(p);
+}
+
 //#define DSN_IDL_TESTS_DEBUG
 
 enum Language {lang_cpp, lang_csharp};
 enum IDL{idl_protobuf, idl_thrift};
-enum Format{format_binary, format_json};
+enum Format{format_binary, format_json, format_compact};
 
 std::string file(const std::string &val)
 {
@@ -191,6 +226,10 @@ void thrift_basic_type_serialization_checker(const std::vector<T> &data, Format
         {
             dsn::marshall_thrift_binary(writer, input);
         }
+        else if (fmt == format_compact)
+        {
+            dsn::marshall_thrift_compact(writer, input);
+        }
         else
         {
             dsn::marshall_thrift_json(writer, input);
@@ -201,6 +240,10 @@ void thrift_basic_type_serialization_checker(const std::vector<T> &data, Format
         {
             dsn::unmarshall_thrift_binary(reader, output);
         }
+        else if (fmt == format_compact)
+        {
+            dsn::unmarshall_thrift_compact(reader, output);
+        }
         else
         {
             dsn::unmarshall_thrift_json(reader, output);
@@ -252,6 +295,10 @@ void check_thrift_generated_type_serialization(const dsn::idl::test::test_thrift
     {
         dsn::marshall_thrift_binary(writer, input);
     }
+    else if (fmt == format_compact)
+    {
+        dsn::marshall_thrift_compact(writer, input);
+    }
     else
     {
         dsn::marshall_thrift_json(writer, input);
@@ -262,6 +309,10 @@ void check_thrift_generated_type_serialization(const dsn::idl::test::test_thrift
     {
         dsn::unmarshall_thrift_binary(reader, output);
     }
+    else if (fmt == format_compact)
+    {
+        dsn::unmarshall_thrift_compact(reader, output);
+    }
     else
     {
         dsn::unmarshall_thrift_json(reader, output);
@@ -277,18 +328,9 @@ void check_thrift_generated_type_serialization(const dsn::idl::test::test_thrift
     EXPECT_DOUBLE_EQ(input.double_item, output.double_item);
 }
 
-void test_thrift_generated_type_serialization(Format fmt)
+void fill_thrift_item(dsn::idl::test::test_thrift_item& item)
 {
     const int container_n = 10;
-    dsn::idl::test::test_thrift_item item;
-
-    item.bool_item = false;
-    item.byte_item = 0;
-    item.i16_item = 0;
-    item.i32_item = 0;
-    item.i64_item = 0;
-    item.double_item = 0.0;
-    check_thrift_generated_type_serialization(item, fmt);
 
     item.bool_item = true;
     item.byte_item = std::numeric_limits<int8_t>::max();
@@ -309,7 +351,168 @@ void test_thrift_generated_type_serialization(Format fmt)
     {
         item.map_i32_item[i] = i * 2;
     }
+}
+
+void test_thrift_generated_type_serialization(Format fmt)
+{
+    dsn::idl::test::test_thrift_item item;
+
+    item.bool_item = false;
+    item.byte_item = 0;
+    item.i16_item = 0;
+    item.i32_item = 0;
+    item.i64_item = 0;
+    item.double_item = 0.0;
     check_thrift_generated_type_serialization(item, fmt);
+
+    fill_thrift_item(item);
+    check_thrift_generated_type_serialization(item, fmt);
+}
+
+// the generated codec (see compile_thrift.py) must produce the same bytes as TBinaryProtocol
+void test_thrift_binary_codec_compatibility(const dsn::idl::test::test_thrift_item &input)
+{
+    dsn::binary_writer codec_writer, proto_writer;
+    dsn::marshall_thrift_binary(codec_writer, input);
+    dsn::marshall_thrift_binary_protocol(proto_writer, input);
+
+    dsn::blob codec_buffer = codec_writer.get_buffer();
+    dsn::blob proto_buffer = proto_writer.get_buffer();
+    ASSERT_EQ(proto_buffer.length(), codec_buffer.length());
+    EXPECT_EQ(0, memcmp(proto_buffer.data(), codec_buffer.data(), codec_buffer.length()));
+
+    dsn::idl::test::test_thrift_item output1, output2;
+    dsn::binary_reader codec_reader(proto_buffer);
+    dsn::unmarshall_thrift_binary(codec_reader, output1);
+    EXPECT_TRUE(input == output1);
+    EXPECT_EQ(0, codec_reader.get_remaining_size());
+
+    dsn::binary_reader proto_reader(codec_buffer);
+    dsn::unmarshall_thrift_binary_protocol(proto_reader, output2);
+    EXPECT_TRUE(input == output2);
+    EXPECT_EQ(0, proto_reader.get_remaining_size());
+}
+
+// decodes the view twice from the same arena, where the first round allocates the arena
+// chunks, which are kept by reset for the second round, as for the requests of a thread;
+// returns the heap allocations of the second round
+template<typename TView, typename TCheck>
+uint64_t decode_thrift_view(const dsn::blob& buffer, TCheck check)
+{
+    dsn::request_arena arena;
+    uint64_t allocations = 0;
+    for (int round = 0; round < 2; round++)
+    {
+        {
+            dsn::binary_reader reader(buffer);
+            uint64_t before = s_heap_allocations.load();
+            TView view(&arena);
+            dsn::thrift_binary::unmarshall(reader, view);
+            allocations = s_heap_allocations.load() - before;
+
+            EXPECT_EQ(0, reader.get_remaining_size());
+            check(view);
+        }
+        arena.reset();
+    }
+    return allocations;
+}
+
+void test_thrift_view_decoding(const dsn::idl::test::test_thrift_item &input)
+{
+    // the buffer of the writer is shared, as the buffers of the rpc messages, so that
+    // the string fields reference it without copy
+    dsn::binary_writer writer;
+    dsn::marshall_thrift_binary(writer, input);
+
+    auto allocations = decode_thrift_view<dsn::idl::test::test_thrift_item_view>(writer.get_buffer(),
+        [&input](const dsn::idl::test::test_thrift_item_view& view)
+        {
+            EXPECT_EQ(input.bool_item, view.bool_item);
+            EXPECT_EQ(input.byte_item, view.byte_item);
+            EXPECT_EQ(input.i16_item, view.i16_item);
+            EXPECT_EQ(input.i32_item, view.i32_item);
+            EXPECT_EQ(input.i64_item, view.i64_item);
+            EXPECT_DOUBLE_EQ(input.double_item, view.double_item);
+            EXPECT_EQ(input.string_item, view.string_item_view().to_string());
+            EXPECT_TRUE(input.string_item == view.string_item_view());
+            EXPECT_EQ(input.list_i32_item, std::vector<int32_t>(view.list_i32_item.begin(), view.list_i32_item.end()));
+            EXPECT_EQ(input.set_i32_item, std::set<int32_t>(view.set_i32_item.begin(), view.set_i32_item.end()));
+            EXPECT_EQ(input.map_i32_item, (std::map<int32_t, int32_t>(view.map_i32_item.begin(), view.map_i32_item.end())));
+            EXPECT_TRUE(view.__isset.map_i32_item);
+        });
+    EXPECT_EQ(0u, allocations);
+}
+
+void test_thrift_nested_view_decoding()
+{
+    dsn::configuration_query_by_index_response resp;
+    resp.err = dsn::ERR_OK;
+    resp.app_id = 3;
+    resp.partition_count = 8;
+    resp.is_stateful = true;
+    for (int i = 0; i < 8; i++)
+    {
+        dsn::partition_configuration pc;
+        pc.pid = dsn::gpid(3, i);
+        pc.ballot = i * 10;
+        pc.primary = dsn::rpc_address("127.0.0.1", 34801 + i);
+        pc.secondaries.push_back(dsn::rpc_address("127.0.0.1", 34811 + i));
+        pc.secondaries.push_back(dsn::rpc_address("127.0.0.1", 34821 + i));
+        resp.partitions.push_back(pc);
+    }
+
+    dsn::binary_writer writer;
+    dsn::marshall_thrift_binary(writer, resp);
+
+    auto allocations = decode_thrift_view<dsn::configuration_query_by_index_response_view>(writer.get_buffer(),
+        [&resp](const dsn::configuration_query_by_index_response_view& view)
+        {
+            EXPECT_STREQ(resp.err.to_string(), view.err.to_string());
+            EXPECT_EQ(resp.app_id, view.app_id);
+            EXPECT_EQ(resp.partition_count, view.partition_count);
+            EXPECT_EQ(resp.is_stateful, view.is_stateful);
+            ASSERT_EQ(resp.partitions.size(), view.partitions.size());
+            for (size_t i = 0; i < resp.partitions.size(); i++)
+            {
+                auto& pc = resp.partitions[i];
+                auto& pcv = view.partitions[i];
+                EXPECT_EQ(pc.pid, pcv.pid);
+                EXPECT_EQ(pc.ballot, pcv.ballot);
+                EXPECT_EQ(pc.primary, pcv.primary);
+                EXPECT_EQ(pc.secondaries, std::vector<dsn::rpc_address>(pcv.secondaries.begin(), pcv.secondaries.end()));
+                EXPECT_TRUE(pcv.last_drops.empty());
+
+                // the nested containers are in the same arena
+                EXPECT_EQ(view.partitions.get_allocator().arena(), pcv.secondaries.get_allocator().arena());
+            }
+        });
+    EXPECT_EQ(0u, allocations);
+
+    dsn::app_info info;
+    info.app_name = "simple_kv";
+    info.app_type = "simple_kv.instance0";
+    info.envs["replica.slow_query_threshold"] = std::string(100, 'x');
+    info.envs["manual_compact.disabled"] = "true";
+
+    dsn::binary_writer info_writer;
+    dsn::marshall_thrift_binary(info_writer, info);
+
+    allocations = decode_thrift_view<dsn::app_info_view>(info_writer.get_buffer(),
+        [&info](const dsn::app_info_view& view)
+        {
+            EXPECT_EQ(info.app_name, view.app_name_view().to_string());
+            EXPECT_EQ(info.app_type, view.app_type_view().to_string());
+            ASSERT_EQ(info.envs.size(), view.envs.size());
+            auto it = info.envs.begin();
+            for (auto& kv : view.envs)
+            {
+                EXPECT_TRUE(it->first == dsn::string_view(kv.first));
+                EXPECT_TRUE(it->second == dsn::string_view(kv.second));
+                ++it;
+            }
+        });
+    EXPECT_EQ(0u, allocations);
 }
 
 void check_protobuf_generated_type_serialization(const dsn::idl::test::test_protobuf_item &input, Format fmt)
@@ -437,6 +640,53 @@ TEST(thrift_helper, cpp_json_generated_type_serialization)
     test_thrift_generated_type_serialization(format_json);
 }
 
+TEST(thrift_helper, cpp_compact_basic_type_serialization)
+{
+    test_thrift_basic_type_serialization(format_compact);
+}
+
+TEST(thrift_helper, cpp_compact_generated_type_serialization)
+{
+    test_thrift_generated_type_serialization(format_compact);
+}
+
+TEST(thrift_helper, cpp_binary_codec_compatibility)
+{
+    dsn::idl::test::test_thrift_item item;
+    test_thrift_binary_codec_compatibility(item);
+
+    fill_thrift_item(item);
+    test_thrift_binary_codec_compatibility(item);
+
+    for (int i = 0; i < 1000; i++)
+    {
+        item.list_i32_item.push_back(i * 31 - 7);
+    }
+    item.string_item.assign(4096, 'x');
+    test_thrift_binary_codec_compatibility(item);
+}
+
+TEST(thrift_helper, cpp_binary_view_decoding)
+{
+    dsn::idl::test::test_thrift_item item;
+    test_thrift_view_decoding(item);
+
+    fill_thrift_item(item);
+    test_thrift_view_decoding(item);
+
+    for (int i = 0; i < 1000; i++)
+    {
+        item.list_i32_item.push_back(i * 31 - 7);
+    }
+    item.string_item.assign(4096, 'x');
+    test_thrift_view_decoding(item);
+}
+
+TEST(thrift_helper, cpp_binary_nested_view_decoding)
+{
+    test_thrift_nested_view_decoding();
+}
+
 TEST(thrift_helper, cpp_binary_code_generation)
 {
     EXPECT_TRUE(test_code_generation(lang_cpp, idl_thrift, format_binary));
@@ -490,9 +740,17 @@ GTEST_API_ int main(int argc, char **argv)
         return 1;
     }
 
-    const char* args[] = { "dsn.idl.test", "--gtest_filter=thrift_helper.*" };
-    int args_count = static_cast<int>(sizeof(args) / sizeof(const char*));
-    ::testing::InitGoogleTest(&args_count, (char**)&args[0]);
+    // e.g., dsn.idl.tests --gtest_filter=perf_idl.* for the serialization benchmark
+    if (argc > 1)
+    {
+        ::testing::InitGoogleTest(&argc, argv);
+    }
+    else
+    {
+        const char* args[] = { "dsn.idl.test", "--gtest_filter=thrift_helper.*" };
+        int args_count = static_cast<int>(sizeof(args) / sizeof(const char*));
+        ::testing::InitGoogleTest(&args_count, (char**)&args[0]);
+    }
 
     return RUN_ALL_TESTS();
 }
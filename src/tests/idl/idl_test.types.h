@@ -4,6 +4,7 @@
 
 
 # include "idl_test_types.h" 
+# include "idl_test.codec.h"
 # include "idl_test.pb.h"
 
 namespace dsn { namespace idl { namespace test { 
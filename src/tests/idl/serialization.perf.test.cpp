@@ -0,0 +1,149 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ * 
+ * -=- Robust Distributed System Nucleus (rDSN) -=- 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     Benchmark of marshalling/unmarshalling generated types with the supported
+ *     serialization formats, run with --gtest_filter=perf_idl.*
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+# include <dsn/cpp/utils.h>
+# include <dsn/cpp/serialization.h>
+# include <gtest/gtest.h>
+# include "idl_test.types.h"
+# include <chrono>
+# include <iostream>
+
+using namespace ::dsn;
+using namespace ::dsn::idl::test;
+
+static void fill_perf_item(test_thrift_item& item, int container_n)
+{
+    item.bool_item = true;
+    item.byte_item = 100;
+    item.i16_item = 10000;
+    item.i32_item = 1000000;
+    item.i64_item = 100000000000LL;
+    item.double_item = 123.321;
+    item.string_item.assign(64, 'x');
+    for (int i = 0; i < container_n; i++)
+    {
+        item.list_i32_item.push_back(i * 7);
+        item.set_i32_item.insert(i);
+        item.map_i32_item[i] = i * 2;
+    }
+}
+
+static void fill_perf_item(test_protobuf_item& item, int container_n)
+{
+    item.set_bool_item(true);
+    item.set_int32_item(1000000);
+    item.set_int64_item(100000000000LL);
+    item.set_uint32_item(1000000);
+    item.set_uint64_item(100000000000LL);
+    item.set_float_item(123.321f);
+    item.set_double_item(123.321);
+    item.set_string_item(std::string(64, 'x'));
+    for (int i = 0; i < container_n; i++)
+    {
+        item.add_repeated_int32_item(i * 7);
+        (*item.mutable_map_int32_item())[i] = i * 2;
+    }
+}
+
+//
+// TMarshaller/TUnmarshaller are (writer, value) and (reader, value) callables,
+// so that the TBinaryProtocol path which is not reachable through a
+// dsn_msg_serialize_format can be measured as well
+//
+template<typename T, typename TMarshaller, typename TUnmarshaller>
+static void serialization_testcase(const char* name, const T& input, TMarshaller&& m, TUnmarshaller&& u)
+{
+    const int rounds = 10000;
+
+    binary_writer probe;
+    m(probe, input);
+    blob data = probe.get_buffer();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++)
+    {
+        binary_writer writer;
+        m(writer, input);
+    }
+    auto marshall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++)
+    {
+        T output;
+        binary_reader reader(data);
+        u(reader, output);
+    }
+    auto unmarshall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << name
+        << ": bytes = " << data.length()
+        << ", marshall = " << marshall_ns / rounds << " ns/op"
+        << ", unmarshall = " << unmarshall_ns / rounds << " ns/op"
+        << std::endl;
+}
+
+template<typename T>
+static void serialization_testcase(const char* name, const T& input, dsn_msg_serialize_format fmt)
+{
+    serialization_testcase(name, input,
+        [fmt](binary_writer& w, const T& v) { marshall(w, v, fmt); },
+        [fmt](binary_reader& r, T& v) { unmarshall(r, v, fmt); }
+        );
+}
+
+TEST(perf_idl, serialization)
+{
+    for (int container_n : { 10, 1000 })
+    {
+        std::cout << "containers with " << container_n << " elements" << std::endl;
+
+        test_thrift_item titem;
+        fill_perf_item(titem, container_n);
+        serialization_testcase("DSF_THRIFT_BINARY (generated codec)", titem, DSF_THRIFT_BINARY);
+        serialization_testcase("DSF_THRIFT_BINARY (TBinaryProtocol)", titem,
+            [](binary_writer& w, const test_thrift_item& v) { marshall_thrift_binary_protocol(w, v); },
+            [](binary_reader& r, test_thrift_item& v) { unmarshall_thrift_binary_protocol(r, v); }
+            );
+        serialization_testcase("DSF_THRIFT_COMPACT", titem, DSF_THRIFT_COMPACT);
+        serialization_testcase("DSF_THRIFT_JSON", titem, DSF_THRIFT_JSON);
+
+        test_protobuf_item pitem;
+        fill_perf_item(pitem, container_n);
+        serialization_testcase("DSF_PROTOC_BINARY", pitem, DSF_PROTOC_BINARY);
+        serialization_testcase("DSF_PROTOC_JSON", pitem, DSF_PROTOC_JSON);
+    }
+}